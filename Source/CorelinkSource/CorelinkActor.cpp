@@ -3,6 +3,32 @@
 
 #include "CorelinkActor.h"
 
+// Frames kept for interpolation.
+static const int POSE_TIMELINE_FRAMES = 16;
+// Render clock jumps to the pose clock when it drifts further than this, e.g. after a stall.
+static const double POSE_RESYNC_SECONDS = 0.25;
+// Share of the drift corrected every tick.
+static const double POSE_SLEW = 0.05;
+
+// Stale and drop callbacks carry no user data, so they reach the demux of the playing actor through this.
+static std::atomic<CorelinkDLL::Pose::pose_demux*> activeDemux(nullptr);
+
+static void StaticRelease(const STREAM_ID& stream) {
+	CorelinkDLL::Pose::pose_demux* demux = activeDemux.load();
+	if (demux != nullptr) {
+		demux->release(stream);
+	}
+}
+
+// Capture time of a pose on the sender clock in seconds. Text poses carry none and use the arrival time.
+static double PoseTime(const CorelinkDLL::Pose::pose_sample& pose) {
+	return (pose.timestamp != 0 ? pose.timestamp : pose.received) * 1e-6;
+}
+
+CorelinkPerformer::CorelinkPerformer(int frames, double maxExtrapolation) :
+	generation(0), lastSequence(0), timeline(0, frames, maxExtrapolation), playTime(0)
+{}
+
 static void StaticPrint(const STREAM_ID& recv, const STREAM_ID& send, const char* msg, const int& msgLen) {
 	UE_LOG(LogTemp, Warning, TEXT("(Static) From %d to %d: %s"), recv, send, UTF8_TO_TCHAR(std::string(msg, msgLen).c_str()));
 }
@@ -16,20 +42,33 @@ ACorelinkActor::ACorelinkActor()
 {
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
+	ServerIP = TEXT("216.165.12.41");
+	ServerPort = 20010;
+	MaxJoints = 128;
+	PoseFrame = 0;
+	MaxPerformers = 16;
+	PerformerSlots = 0;
+	PerformerCount = 0;
+	poseDemux = nullptr;
+	InterpolationDelay = 0.05f;
+	MaxExtrapolation = 0.1f;
 	Corelink::DLLInit::Init();
 }
 
 
 ACorelinkActor::~ACorelinkActor()
 {
+	delete poseDemux;
+	poseDemux = nullptr;
 }
 
 void ACorelinkActor::Print(const STREAM_ID& recv, const STREAM_ID& send, const char* msg, const int& msgLen)
 {
 	//UE_LOG(LogTemp, Warning, TEXT("(Member) From %d to %d, #%d: %s"), recv, send, ++counter, UTF8_TO_TCHAR(std::string(msg, msgLen).c_str()));
 	//GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Yellow, UTF8_TO_TCHAR(std::string(msg, msgLen).c_str()));
-	CorelinkVar = UTF8_TO_TCHAR(std::string(msg, msgLen).c_str());
-	CorelinkFloat += 0.1;
+	// UPROPERTYs belong to the game thread, Tick copies the pose into them.
+	CORELINK_WRAPPER_TRACE("pose publish", send);
+	poseDemux->publish(send, msg, msgLen, !CorelinkDLL::Pose::pose_frame::isFrame(msg, msgLen));
 }
 
 // Called when the game starts or when spawned
@@ -39,6 +78,9 @@ void ACorelinkActor::BeginPlay()
 	counter = 0;
 
 	Super::BeginPlay();
+#ifdef CORELINK_TRACE
+	Corelink::Trace::setThreadName("game");
+#endif
 
 	last = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
 
@@ -53,6 +95,11 @@ void ACorelinkActor::BeginPlay()
 	sendStream2 = nullptr;
 	recvStream1 = nullptr;
 	recvStream2 = nullptr;
+
+	delete poseDemux;
+	poseDemux = new CorelinkDLL::Pose::pose_demux(MaxPerformers, MaxJoints, POSE_TIMELINE_FRAMES);
+	performers.clear();
+	activeDemux.store(poseDemux);
 	
 	try {
 		// set update and subscribe first
@@ -68,12 +115,15 @@ void ACorelinkActor::BeginPlay()
 			UE_LOG(LogTemp, Warning, TEXT("setOnSubscribe sendID:%d recvID:%d"), recvID, sendID);
 		};
 		Corelink::DLLInit::setOnSubscribe(lambdaS);
+
+		// free the pose slot of senders that went away.
+		Corelink::DLLInit::setOnStale(&StaticRelease);
+		Corelink::DLLInit::setOnDrop(&StaticRelease);
 		UE_LOG(LogTemp, Warning, TEXT("%s"), UTF8_TO_TCHAR("setOnUpdate setOnSubscribe"));
 
-		Corelink::Client::connect("216.165.12.41", 20010);
+		Corelink::Client::connect(TCHAR_TO_UTF8(*ServerIP), ServerPort);
 		//The old client cannot solve the ip
 		//Corelink::Client::connect("corelink.hsrn.nyu.edu", 20010);
-		//Corelink::Client::connect("127.0.0.1", 20010);
 
 		//sendStream1 = new Corelink::SendStream(Corelink::Client::createSender("Holodeck", "distance", "Testing corelink sender in unreal", true, true, Corelink::Const::STREAM_STATE_SEND_UDP));
 		//sendStream2 = new Corelink::SendStream(Corelink::Client::createSender("Chalktalk", "testing", "Testing corelink sender in unreal", true, true, Corelink::Const::STREAM_STATE_UDP));
@@ -106,6 +156,7 @@ void ACorelinkActor::BeginDestroy()
 {
 	success = false;
 	Corelink::Client::cleanup();
+	activeDemux.store(nullptr);
 	UE_LOG(LogTemp, Warning, TEXT("%s"), UTF8_TO_TCHAR("Cleaned up"));
 	Super::BeginDestroy();
 }
@@ -114,6 +165,24 @@ void ACorelinkActor::BeginDestroy()
 void ACorelinkActor::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
+
+	if (poseDemux != nullptr) {
+		CORELINK_WRAPPER_TRACE("pose pickup", PerformerSlots);
+		// slots released since the last tick are no longer read below.
+		poseDemux->collect();
+		PerformerSlots = poseDemux->getSlotCount();
+		PerformerCount = 0;
+		while ((int32) performers.size() < PerformerSlots) {
+			performers.emplace_back(new CorelinkPerformer(POSE_TIMELINE_FRAMES, MaxExtrapolation));
+		}
+		JointPositions.Reset();
+		for (int32 slot = 0; slot < PerformerSlots; ++slot) {
+			TickPerformer(slot, DeltaTime);
+			if (JointPositions.Num() == 0 && performers[slot]->joints.Num() > 0) {
+				JointPositions = performers[slot]->joints;
+			}
+		}
+	}
 	/*
 	long long t = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
 	std::vector<int> streams;
@@ -144,3 +213,74 @@ void ACorelinkActor::Tick(float DeltaTime)
 	*/
 }
 
+void ACorelinkActor::TickPerformer(int32 Slot, float DeltaTime)
+{
+	CorelinkPerformer& performer = *performers[Slot];
+	if (poseDemux->getState(Slot) != CorelinkDLL::Pose::pose_demux::SLOT_ACTIVE) {
+		performer.joints.Reset();
+		return;
+	}
+	++PerformerCount;
+	// another sender took the slot, acquire drops the poses of the previous one.
+	if (performer.generation != poseDemux->getGeneration(Slot)) {
+		performer.generation = poseDemux->getGeneration(Slot);
+		performer.lastSequence = 0;
+		performer.timeline.reset(0);
+		performer.joints.Reset();
+	}
+
+	// every frame since the last tick goes into the timeline, not only the newest.
+	const CorelinkDLL::Pose::pose_sample* frame;
+	while ((frame = poseDemux->next(Slot)) != nullptr) {
+		if (frame->joints > 0) {
+			if (performer.timeline.getJoints() != frame->joints) {
+				performer.timeline.reset(frame->joints);
+			}
+			performer.timeline.push(PoseTime(*frame), frame->positions.data());
+		}
+		poseDemux->pop(Slot);
+	}
+
+	bool fresh = poseDemux->acquire(Slot);
+	const CorelinkDLL::Pose::pose_sample& pose = poseDemux->latest(Slot);
+	if (fresh && pose.joints > 0) {
+		// usually pushed from the history already, the timeline drops it as a duplicate then.
+		if (performer.timeline.getJoints() != pose.joints) {
+			performer.timeline.reset(pose.joints);
+		}
+		performer.timeline.push(PoseTime(pose), pose.positions.data());
+		PoseFrame = (int32) pose.frame;
+		CorelinkVar = UTF8_TO_TCHAR(pose.raw.c_str());
+		if (performer.lastSequence != 0) {
+			CorelinkFloat += 0.1 * (pose.sequence - performer.lastSequence);
+		}
+		performer.lastSequence = pose.sequence;
+	}
+	if (performer.timeline.size() == 0) {
+		return;
+	}
+
+	double target = performer.timeline.newestTime() - InterpolationDelay;
+	int joints = performer.timeline.getJoints();
+	performer.playTime += DeltaTime;
+	if (FMath::Abs(performer.playTime - target) > POSE_RESYNC_SECONDS) {
+		performer.playTime = target;
+	}
+	else {
+		performer.playTime += (target - performer.playTime) * POSE_SLEW;
+	}
+	sampledPositions.resize(joints * 3);
+	performer.timeline.sample(performer.playTime, sampledPositions.data());
+	performer.joints.SetNum(joints, false);
+	for (int i = 0; i < joints; ++i) {
+		performer.joints[i] = FVector(sampledPositions[i * 3], sampledPositions[i * 3 + 1], sampledPositions[i * 3 + 2]);
+	}
+}
+
+TArray<FVector> ACorelinkActor::GetPerformerJoints(int32 Slot) const
+{
+	if (Slot < 0 || Slot >= (int32) performers.size()) {
+		return TArray<FVector>();
+	}
+	return performers[Slot]->joints;
+}
@@ -7,6 +7,21 @@
 #include "CorelinkUnrealWrapper.h"
 #include "CorelinkActor.generated.h"
 
+// Playback state of one sender of the pose demux.
+struct CorelinkPerformer
+{
+	// Generation of the demux slot the state belongs to.
+	uint32 generation;
+	uint64 lastSequence;
+	// Received poses by sender timestamp, sampled on the render clock.
+	CorelinkDLL::Pose::pose_timeline timeline;
+	// Render clock in seconds on the sender time base, advanced by DeltaTime.
+	double playTime;
+	TArray<FVector> joints;
+
+	CorelinkPerformer(int frames, double maxExtrapolation);
+};
+
 UCLASS()
 class CORELINKSOURCE_API ACorelinkActor : public AActor
 {
@@ -16,6 +31,12 @@ class CORELINKSOURCE_API ACorelinkActor : public AActor
 	Corelink::RecvStream* recvStream1;
 	Corelink::RecvStream* recvStream2;
 
+	// Written by the listener thread, read in Tick. One slot per sender.
+	CorelinkDLL::Pose::pose_demux* poseDemux;
+	// Indexed like the slots of poseDemux.
+	std::vector<std::unique_ptr<CorelinkPerformer>> performers;
+	std::vector<float> sampledPositions;
+
 	bool success;
 	int counter;
 	long long last;
@@ -25,19 +46,68 @@ public:
 	ACorelinkActor();
 	~ACorelinkActor();
 
+	// Called on the listener thread. Only hands the message to poseDemux.
 	void Print(const STREAM_ID& recv, const STREAM_ID& send, const char* msg, const int& msgLen);
 
+	// Last received message. Updated in Tick.
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Corelink Actor")
 	FString CorelinkVar;
 
+	// Grows by 0.1 for every received pose. Updated in Tick.
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Corelink Actor")
 	float CorelinkFloat;
 
+	// Corelink server to connect to, 127.0.0.1 for tools/server. Read in BeginPlay.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Corelink Actor")
+	FString ServerIP;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Corelink Actor")
+	int32 ServerPort;
+
+	// Joints kept per pose, larger poses are dropped. Read in BeginPlay.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Corelink Actor")
+	int32 MaxJoints;
+
+	// Senders tracked at the same time, others are dropped until one goes stale. Read in BeginPlay.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Corelink Actor")
+	int32 MaxPerformers;
+
+	// Performer slots to walk with GetPerformerJoints. Updated in Tick.
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Corelink Actor")
+	int32 PerformerSlots;
+
+	// Senders currently sending poses. Updated in Tick.
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Corelink Actor")
+	int32 PerformerCount;
+
+	// Seconds the render clock stays behind the newest pose so there are two frames to blend between.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Corelink Actor")
+	float InterpolationDelay;
+
+	// Longest dropout in seconds the pose keeps moving along its last velocity before it holds.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Corelink Actor")
+	float MaxExtrapolation;
+
+	// Joint positions of the performer in the lowest slot, sampled at the render clock. Updated in Tick.
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Corelink Actor")
+	TArray<FVector> JointPositions;
+
+	// Frame number of the newest pose, 0 for text poses. Updated in Tick.
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Corelink Actor")
+	int32 PoseFrame;
+
+	// Joint positions of the performer in a slot, sampled at the render clock. Empty if the slot is free.
+	UFUNCTION(BlueprintCallable, Category = "Corelink Actor")
+	TArray<FVector> GetPerformerJoints(int32 Slot) const;
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 	virtual void BeginDestroy() override;
 
+	// Takes the poses of a demux slot published since the last tick and samples its timeline.
+	void TickPerformer(int32 Slot, float DeltaTime);
+
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
@@ -22,6 +22,9 @@ public class CorelinkSource : ModuleRules
 		
 		PrivateIncludePaths.Add("include");
 
+		// Uncomment to compile the hot path trace points, see Corelink::Trace
+		// PublicDefinitions.Add("CORELINK_TRACE=1");
+
 		bEnableExceptions = true;
 		bUseRTTI = false;
 	}
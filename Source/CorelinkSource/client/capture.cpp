@@ -0,0 +1,127 @@
+#include "corelink/client/capture.h"
+#include "corelink/client/core.h"
+#include "corelink/objects/init.h"
+#include "corelink/objects/streams/comm_data_send_base.h"
+#include "corelink/objects/streams/comm_data_recv_base.h"
+
+namespace CorelinkDLL {
+    /**
+     * Replay opened by startReplay. nullptr while none is open.
+     */
+    static std::unique_ptr<CorelinkDLL::Object::Capture::capture_replay> replay;
+
+    /**
+     * Guards the replay pointer. Never held while a replay is opened or destroyed, so the getters never wait on a join.
+     */
+    static std::mutex replayLock;
+
+    void stopReplayHelper() {
+        std::unique_ptr<CorelinkDLL::Object::Capture::capture_replay> old;
+        {
+            std::lock_guard<std::mutex> lck(replayLock);
+            old = std::move(replay);
+        }
+        // destroying the replay joins its thread, done after unlocking since the sink may call the getters.
+        old.reset();
+    }
+
+    EXPORTED void startCapture(const char* path, int segmentSize, int& errorID) {
+        std::string error;
+        errorID = 0;
+        if (path == nullptr || segmentSize < 0) {
+            errorID = addError("capture.cpp startCapture", "invalid capture path or segment size", ERROR_CODE_VALUE);
+            return;
+        }
+        if (!CorelinkDLL::Object::Capture::capture_recorder::start(path, segmentSize, error)) {
+            errorID = addError("capture.cpp startCapture", error.c_str(), ERROR_CODE_STATE);
+        }
+    }
+
+    EXPORTED void stopCapture() {
+        CorelinkDLL::Object::Capture::capture_recorder::stop();
+    }
+
+    EXPORTED unsigned long long getCaptureDropCount() {
+        return CorelinkDLL::Object::Capture::capture_recorder::getDropped();
+    }
+
+    EXPORTED void startReplay(const char* path, int protocol, int ref, const STREAM_ID& streamID, int pacing, double speed,
+            long long startTime, int& errorID) {
+        CorelinkDLL::Object::Capture::capture_replay::Sink sink;
+        std::unique_ptr<CorelinkDLL::Object::Capture::capture_replay> next, old;
+        std::string error;
+        int index;
+        errorID = 0;
+        if (!initData.clientInit) {
+            errorID = addError("capture.cpp startReplay", "client not initialized", ERROR_CODE_STATE);
+            return;
+        }
+        if (path == nullptr || pacing < REPLAY_PACING_ORIGINAL || pacing > REPLAY_PACING_ASAP || (pacing == REPLAY_PACING_SCALED && !(speed > 0))) {
+            errorID = addError("capture.cpp startReplay", "invalid capture path, pacing or speed", ERROR_CODE_VALUE);
+            return;
+        }
+        if (client->streamIsType(streamID, STREAM_STATE_RECV) && (index = streamStateToBitIndex(protocol & STREAM_STATE_RECV)) >= 0) {
+            CorelinkDLL::Object::Stream::comm_data_recv_base* recv = (CorelinkDLL::Object::Stream::comm_data_recv_base*) client->dataStreams[index];
+            STREAM_ID target = streamID;
+            sink = [recv, ref, target](const CorelinkDLL::Object::Capture::replay_record& record) {
+                recv->injectMsg(ref, target, record.sendID, record.data, record.hdrLen, record.msgLen);
+            };
+        }
+        else if (client->streamIsType(streamID, STREAM_STATE_SEND) && (index = streamStateToBitIndex(protocol & STREAM_STATE_SEND)) >= 0) {
+            CorelinkDLL::Object::Stream::comm_data_send_base* send = (CorelinkDLL::Object::Stream::comm_data_send_base*) client->dataStreams[index];
+            STREAM_ID target = streamID;
+            sink = [send, ref, target](const CorelinkDLL::Object::Capture::replay_record& record) {
+                send->sendMsg(ref, target, -1, record.data + record.hdrLen, record.msgLen, record.data, record.hdrLen, false);
+            };
+        }
+        else {
+            errorID = addError("capture.cpp startReplay", "stream not found", ERROR_CODE_VALUE);
+            return;
+        }
+
+        next.reset(new CorelinkDLL::Object::Capture::capture_replay());
+        if (!next->open(path, error)) {
+            errorID = addError("capture.cpp startReplay", error.c_str(), ERROR_CODE_VALUE);
+            return;
+        }
+        if (startTime != 0 && !next->seek(startTime)) {
+            errorID = addError("capture.cpp startReplay", "no packets after the start time", ERROR_CODE_VALUE);
+            return;
+        }
+
+        // stops the old replay before playing the new one, joining it outside the lock.
+        stopReplayHelper();
+        {
+            std::lock_guard<std::mutex> lck(replayLock);
+            // a concurrent startReplay may have set a replay since, it is destroyed with old after unlocking.
+            old = std::move(replay);
+            replay = std::move(next);
+            replay->start(sink, pacing, speed);
+        }
+    }
+
+    EXPORTED void stopReplay() {
+        stopReplayHelper();
+    }
+
+    EXPORTED bool isReplayPlaying() {
+        std::lock_guard<std::mutex> lck(replayLock);
+        return replay != nullptr && replay->isPlaying();
+    }
+
+    EXPORTED unsigned long long getReplayCount() {
+        std::lock_guard<std::mutex> lck(replayLock);
+        return replay == nullptr ? 0 : replay->getReplayed();
+    }
+
+    EXPORTED long long getReplayPosition() {
+        std::lock_guard<std::mutex> lck(replayLock);
+        return replay == nullptr ? 0 : replay->getPosition();
+    }
+
+    EXPORTED void getReplayRange(long long& first, long long& last) {
+        std::lock_guard<std::mutex> lck(replayLock);
+        first = replay == nullptr ? 0 : replay->getFirstTime();
+        last = replay == nullptr ? 0 : replay->getLastTime();
+    }
+}
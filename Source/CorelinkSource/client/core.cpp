@@ -1,4 +1,5 @@
 #include "corelink/client/core.h"
+#include "corelink/client/capture.h"
 #include "corelink/objects/init.h"
 
 namespace CorelinkDLL {
@@ -28,24 +29,24 @@ namespace CorelinkDLL {
         return client->mainComm->sendRecv(msg, len, commID);
     }
 
-    bool getJsonResponse(const std::string& fileName, const std::string& funcName, const std::string& msg,
+    bool getJsonResponse(const char* location, const std::string& msg,
             rapidjson::Document& json, const int& commID, int& errorID, bool checkToken) {
-        std::stringstream errorMsg;
+        rapidjson::Value::ConstMemberIterator message;
         errorID = 0;
         if (checkToken && client->token.size() == 0) {
-            errorMsg << fileName << " " << funcName << ": " << "no token set";
-            errorID = addError(errorMsg.str(), ERROR_CODE_NO_TOKEN);
+            errorID = addError(location, "no token set", ERROR_CODE_NO_TOKEN);
             return false;
         }
         json = mainCommSendRecv((char*) msg.c_str(),msg.size(), commID);
         if (json.MemberCount() == 0) {
-            errorMsg << fileName << " " << funcName << ": " << "Invalid Server response";
-            errorID = addError(errorMsg.str(), ERROR_CODE_COMM);
+            errorID = addError(location, "Invalid Server response", ERROR_CODE_COMM);
             return false;
         }
         if (json["statusCode"].GetInt() != 0) {
-            errorMsg << fileName << " " << funcName << ": " << std::string(json["message"].GetString(), json["message"].GetStringLength());
-            errorID = addError(errorMsg.str(), ERROR_CODE_COMM);
+            // the location is kept apart so the server message gets the whole record.
+            message = json.FindMember("message");
+            errorID = addError(location,
+                message != json.MemberEnd() && message->value.IsString() ? message->value.GetString() : "server error", ERROR_CODE_COMM);
             return false;
         }
         return true;
@@ -62,7 +63,7 @@ namespace CorelinkDLL {
             << ",\"ID\":" << commID
             << ",\"username\":\"" << safeString(client->data.username.c_str(), client->data.username.size())
             << "\",\"password\":\"" << safeString(client->data.password.c_str(), client->data.password.size()) << "\"}";
-        if (getJsonResponse("core.cpp", "commConnect", ss.str(), json, commID, errorID, false)) {
+        if (getJsonResponse("core.cpp commConnect", ss.str(), json, commID, errorID, false)) {
             jsonData = json["token"];
             client->token = std::string(jsonData.GetString(), jsonData.GetStringLength());
             jsonData = json["IP"];
@@ -84,7 +85,7 @@ namespace CorelinkDLL {
         ss << "{\"function\":\"auth\""
             << ",\"ID\":" << commID
             << ",\"token\":\"" << token << "\"}";
-        if (getJsonResponse("core.cpp", "commConnect", ss.str(), json, commID, errorID, false)) {
+        if (getJsonResponse("core.cpp commConnect", ss.str(), json, commID, errorID, false)) {
             jsonData = json["token"];
             client->token = std::string(jsonData.GetString(), jsonData.GetStringLength());
             jsonData = json["IP"];
@@ -104,7 +105,7 @@ namespace CorelinkDLL {
         errorID = 0;
 
         if (initData.clientInit) {
-            errorID = addError("core.cpp corelinkConnect: client already initialized", ERROR_CODE_STATE);
+            errorID = addError("core.cpp corelinkConnect", "client already initialized", ERROR_CODE_STATE);
             return;
         }
 
@@ -114,7 +115,7 @@ namespace CorelinkDLL {
 
         wsOk = WSAStartup(MAKEWORD(2, 0), &data);
         if (wsOk != 0) {
-            errorID = addError("core.cpp corelinkConnect: winsock initialization error: " + std::to_string(wsOk), ERROR_CODE_SOCKET);
+            errorID = addError("core.cpp corelinkConnect", "winsock initialization error", ERROR_CODE_SOCKET, wsOk);
             return;
         }
     #endif
@@ -126,6 +127,8 @@ namespace CorelinkDLL {
      */
     void corelinkCleanupHelper() {
         initData.clientInit = false;
+        // the replay may still be feeding the streams removed below.
+        stopReplayHelper();
 
         if (client != nullptr) {
             client->data.initState = 0;
@@ -251,7 +254,7 @@ namespace CorelinkDLL {
         int commID, errorID;
         commID = mainCommGetCommID();
         //stream not owned by client, do nothing.
-        if (client->mapStreamData.find(streamID) == client->mapStreamData.end()) { return false; }
+        if (client->getStreamState(streamID) == STREAM_STATE_NONE) { return false; }
 
         ss << "{\"function\":\"disconnect\""
             << ",\"ID\":" << commID
@@ -259,10 +262,10 @@ namespace CorelinkDLL {
             << ",\"streamIDs\":[" << streamID
             << "],\"token\":\"" << client->token << "\"}";
         
-        success = getJsonResponse("core.cpp", "commDisconnect", ss.str(), json, commID, errorID);
+        success = getJsonResponse("core.cpp commDisconnect", ss.str(), json, commID, errorID);
         ss.clear();
         if (errorID != 0) {
-            delete[] getError(errorID, commID);
+            discardError(errorID);
             return false;
         }
         client->rmStream(streamID);
@@ -12,13 +12,11 @@ namespace CorelinkDLL {
     }
 
     EXPORTED const char* getStreamData(const STREAM_ID& streamID, int& len) {
-        std::unordered_map<STREAM_ID, CorelinkDLL::Object::Stream::stream_data>::iterator iter;
-        if ((iter = client->mapStreamData.find(streamID)) == client->mapStreamData.end()) { 
-            len = 0;
-            return nullptr;
-        }
-        len = (int) iter->second.streamData.size();
-        return iter->second.streamData.c_str();
+        return client->acquireStreamData(streamID, len);
+    }
+
+    EXPORTED void releaseStreamData(const char* data) {
+        CorelinkDLL::Object::client_main::releaseStreamData(data);
     }
 
     EXPORTED int getStreamDataLen(const STREAM_ID& streamID) {
@@ -32,19 +30,64 @@ namespace CorelinkDLL {
 
     EXPORTED bool sendMsg(int protocol, int ref, const STREAM_ID& streamID, int federationID, const char* msg, int msgLen) {
         return ((CorelinkDLL::Object::Stream::comm_data_send_base*) client->dataStreams[streamStateToBitIndex(protocol & STREAM_STATE_SEND)])
-            ->sendMsg(ref, streamID, federationID, std::string(msg, msgLen));
+            ->sendMsg(ref, streamID, federationID, msg, msgLen);
     }
 
     EXPORTED bool sendMsgJson(int protocol, int ref, const STREAM_ID& streamID, int federationID, const char* msg, int msgLen, const char* json, int jsonLen, bool serverCheck) {
         return ((CorelinkDLL::Object::Stream::comm_data_send_base*) client->dataStreams[streamStateToBitIndex(protocol & STREAM_STATE_SEND)])
-            ->sendMsg(ref, streamID, federationID, std::string(msg, msgLen), std::string(json, jsonLen), serverCheck);
+            ->sendMsg(ref, streamID, federationID, msg, msgLen, json, jsonLen, serverCheck);
+    }
+
+    EXPORTED bool setSendCodec(int protocol, int ref, const STREAM_ID& streamID, int codec, int keyInterval) {
+        if (!client->streamIsType(streamID, STREAM_STATE_SEND)) { return false; }
+        return ((CorelinkDLL::Object::Stream::comm_data_send_base*) client->dataStreams[streamStateToBitIndex(protocol & STREAM_STATE_SEND)])
+            ->setCodec(ref, streamID, codec, keyInterval);
+    }
+
+    EXPORTED bool setSendDirect(int protocol, int ref, const STREAM_ID& streamID, bool enable) {
+        if (!client->streamIsType(streamID, STREAM_STATE_SEND)) { return false; }
+        return ((CorelinkDLL::Object::Stream::comm_data_send_base*) client->dataStreams[streamStateToBitIndex(protocol & STREAM_STATE_SEND)])
+            ->setDirectSend(ref, streamID, enable);
+    }
+
+    EXPORTED int getSendQueueDepth(int protocol) {
+        CorelinkDLL::Object::Stream::comm_data_send_base* sender;
+        int index = streamStateToBitIndex(protocol & STREAM_STATE_SEND);
+        if (index < 0) { return -1; }
+        sender = (CorelinkDLL::Object::Stream::comm_data_send_base*) client->dataStreams[index];
+        return sender == nullptr ? -1 : sender->getQueueDepth();
     }
 
     EXPORTED void* setOnRecv(int protocol, int ref, const STREAM_ID& streamID, CorelinkDLL::Object::Stream::Callback func, void* funcData) {
         if (!client->streamIsType(streamID, STREAM_STATE_RECV)) { return nullptr; }
         return ((CorelinkDLL::Object::Stream::comm_data_recv_base*) client->dataStreams[streamStateToBitIndex(protocol & STREAM_STATE_RECV)])->setRecvCallback(ref, streamID, func, funcData);
     }
+
+    EXPORTED void* setOnRecvInline(int protocol, int ref, const STREAM_ID& streamID, CorelinkDLL::Object::Stream::Callback func,
+        CorelinkDLL::Object::Stream::CallbackConstruct construct, CorelinkDLL::Object::Stream::CallbackDestroy destroy, void* src, bool& found) {
+        found = false;
+        if (!client->streamIsType(streamID, STREAM_STATE_RECV)) { return nullptr; }
+        return ((CorelinkDLL::Object::Stream::comm_data_recv_base*) client->dataStreams[streamStateToBitIndex(protocol & STREAM_STATE_RECV)])->setRecvCallbackInline(ref, streamID, func, construct, destroy, src, found);
+    }
     
+    EXPORTED bool setRecvPolling(int protocol, int ref, const STREAM_ID& streamID, int capacity) {
+        if (!client->streamIsType(streamID, STREAM_STATE_RECV)) { return false; }
+        return ((CorelinkDLL::Object::Stream::comm_data_recv_base*) client->dataStreams[streamStateToBitIndex(protocol & STREAM_STATE_RECV)])
+            ->setRecvPolling(ref, streamID, capacity);
+    }
+
+    EXPORTED int pollMessages(int protocol, int ref, const STREAM_ID& streamID, CorelinkDLL::Object::Stream::recv_message* out, int max) {
+        if (!client->streamIsType(streamID, STREAM_STATE_RECV)) { return -1; }
+        return ((CorelinkDLL::Object::Stream::comm_data_recv_base*) client->dataStreams[streamStateToBitIndex(protocol & STREAM_STATE_RECV)])
+            ->pollMessages(ref, streamID, out, max);
+    }
+
+    EXPORTED unsigned long long getPollDropCount(int protocol, int ref, const STREAM_ID& streamID) {
+        if (!client->streamIsType(streamID, STREAM_STATE_RECV)) { return 0; }
+        return ((CorelinkDLL::Object::Stream::comm_data_recv_base*) client->dataStreams[streamStateToBitIndex(protocol & STREAM_STATE_RECV)])
+            ->getPollDropped(ref, streamID);
+    }
+
     EXPORTED bool isSendStream(int streamID) {
         return client->streamIsType(streamID, STREAM_STATE_SEND);
     }
@@ -70,20 +113,19 @@ namespace CorelinkDLL {
 
     EXPORTED void getClientStreamsPushed(int& commID) {
         std::vector<int> streams;
-        char* data;
+        CorelinkDLL::Object::packet_buffer buffer;
         int* dataCasted;
         int len;
         streams = client->getStreams();
         len = streams.size() * sizeof(int);
-        data = new char[len];
-        dataCasted = (int*) data;
+        buffer = CorelinkDLL::Object::packet_pool::instance().acquire(len);
+        dataCasted = (int*) buffer.data();
         for (int i = 0; i < streams.size(); ++i) {
             dataCasted[i] = streams[i];
         }
         dataCasted = nullptr;
         commID = mainCommGetCommID();
-        client->data.msgHandler.add(std::string(data, len), commID);
-        delete[] data;
+        client->data.msgHandler.add(std::move(buffer), commID);
     }
 
     EXPORTED char* getClientStreamSources(int streamID) {
@@ -103,19 +145,18 @@ namespace CorelinkDLL {
 
     EXPORTED void getClientStreamSourcesPushed(int streamID, int& commID) {
         std::vector<int> streams;
-        char* data;
+        CorelinkDLL::Object::packet_buffer buffer;
         int* dataCasted;
         int len;
         streams = client->getStreamSources(streamID);
         len = streams.size() * sizeof(int);
-        data = new char[len];
-        dataCasted = (int*) data;
+        buffer = CorelinkDLL::Object::packet_pool::instance().acquire(len);
+        dataCasted = (int*) buffer.data();
         for (int i = 0; i < streams.size(); ++i) {
             dataCasted[i] = streams[i];
         }
         dataCasted = nullptr;
         commID = mainCommGetCommID();
-        client->data.msgHandler.add(std::string(data, len), commID);
-        delete[] data;
+        client->data.msgHandler.add(std::move(buffer), commID);
     }
 }
\ No newline at end of file
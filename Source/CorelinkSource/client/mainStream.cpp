@@ -2,7 +2,7 @@
 
 namespace CorelinkDLL {
     void addCommData(const std::vector<std::string>& data, const int& commID) {
-        std::string compactString;
+        CorelinkDLL::Object::packet_buffer compactString;
         char* compactStringPtr;
         int* compactStringPtrCasted;
         int lenData, lenHeader;
@@ -11,7 +11,8 @@ namespace CorelinkDLL {
             lenData += (int) val.size();
         }
         lenHeader = sizeof(int) * ((int)data.size() + 1);
-        compactStringPtr = new char[lenHeader + lenData];
+        compactString = CorelinkDLL::Object::packet_pool::instance().acquire(lenHeader + lenData);
+        compactStringPtr = compactString.data();
         compactStringPtrCasted = (int*) compactStringPtr;
         
         lenData = 0;
@@ -22,13 +23,12 @@ namespace CorelinkDLL {
             lenData += compactStringPtrCasted[i + 1];
         }
         compactStringPtrCasted = nullptr;
-        compactString = std::string(compactStringPtr, lenHeader + lenData);
-        delete[] compactStringPtr;
-        client->data.msgHandler.add(compactString, commID);
+        compactStringPtr = nullptr;
+        client->data.msgHandler.add(std::move(compactString), commID);
     }
 
     void addCommData(const std::string& data, const int& commID) {
-        client->data.msgHandler.add(data, commID);
+        client->data.msgHandler.add(data.c_str(), (int) data.size(), commID);
     }
 
     int getStreamState(const char* proto, const char* dir) {
@@ -46,12 +46,12 @@ namespace CorelinkDLL {
     }
 
     EXPORTED char* getCommData(const int& commID, int& len) {
-        std::string data;
+        CorelinkDLL::Object::packet_buffer data;
         char* buffer;
         data = client->data.msgHandler.get(commID);
-        len = (int) data.size();
+        len = data.size();
         buffer = new char[len];
-        memcpy(buffer, data.c_str(), len);
+        memcpy(buffer, data.data(), len);
         return buffer;
     }
 
@@ -65,6 +65,20 @@ namespace CorelinkDLL {
         return success;
     }
 
+    EXPORTED const char* lendCommData(const int& commID, int& len) {
+        const CorelinkDLL::Object::packet_buffer* data = client->data.msgHandler.lend(commID);
+        if (data == nullptr) {
+            len = -1;
+            return nullptr;
+        }
+        len = data->size();
+        return data->data();
+    }
+
+    EXPORTED void releaseCommData(const int& commID) {
+        client->data.msgHandler.release(commID);
+    }
+
     EXPORTED void commListFunctions(int& commID, int& errorID) {
         rapidjson::Document json;
         std::stringstream ss;
@@ -73,7 +87,7 @@ namespace CorelinkDLL {
         ss << "{\"function\":\"listFunctions\""
             << ",\"ID\":" << commID
             << ",\"token\":\"" << client->token << "\"}";
-        if (getJsonResponse("mainStream.cpp", "commListFunctions", ss.str(), json, commID, errorID)) {
+        if (getJsonResponse("mainStream.cpp commListFunctions", ss.str(), json, commID, errorID)) {
             std::vector<std::string> data = std::vector<std::string>();
             rapidjson::Value::Array jsonData = json["functionList"].GetArray();
             data.resize(jsonData.Size());
@@ -97,7 +111,7 @@ namespace CorelinkDLL {
             << ",\"ID\":" << commID
             << ",\"functionName\":\"" << safeString(func)
             << "\",\"token\":\"" << client->token << "\"}";
-        if (getJsonResponse("mainStream.cpp", "commGetFunctionInfo", ss.str(), json, commID, errorID)) {
+        if (getJsonResponse("mainStream.cpp commGetFunctionInfo", ss.str(), json, commID, errorID)) {
             std::vector<std::string> data = std::vector<std::string>();
             rapidjson::Value jsonData;
             rapidjson::Value tmp;
@@ -119,7 +133,7 @@ namespace CorelinkDLL {
         ss << "{\"function\":\"listWorkspaces\""
             << ",\"ID\":" << commID
             << ",\"token\":\"" << client->token << "\"}";
-        if (getJsonResponse("mainStream.cpp", "commListWorkspaces", ss.str(), json, commID, errorID)) {
+        if (getJsonResponse("mainStream.cpp commListWorkspaces", ss.str(), json, commID, errorID)) {
             std::vector<std::string> data = std::vector<std::string>();
             rapidjson::Value::Array jsonData = json["workspaceList"].GetArray();
             data.resize(jsonData.Size());
@@ -141,8 +155,8 @@ namespace CorelinkDLL {
             << ",\"ID\":" << commID
             << ",\"workspace\":\"" << safeString(workspace)
             << "\",\"token\":\"" << client->token << "\"}";
-        success = getJsonResponse("mainStream.cpp", "commAddWorkspace", ss.str(), json, commID, errorID);
-        if (errorID != 0) { delete[] getError(errorID, commID);}
+        success = getJsonResponse("mainStream.cpp commAddWorkspace", ss.str(), json, commID, errorID);
+        if (errorID != 0) { discardError(errorID); }
         ss.clear();
         return success;
     }
@@ -157,8 +171,8 @@ namespace CorelinkDLL {
             << ",\"ID\":" << commID
             << ",\"workspace\":\"" << safeString(workspace)
             << "\",\"token\":\"" << client->token << "\"}";
-        success = getJsonResponse("mainStream.cpp", "commRmWorkspace", ss.str(), json, commID, errorID);
-        if (errorID != 0) { delete[] getError(errorID, commID);}
+        success = getJsonResponse("mainStream.cpp commRmWorkspace", ss.str(), json, commID, errorID);
+        if (errorID != 0) { discardError(errorID); }
         ss.clear();
         return success;
     }
@@ -185,7 +199,7 @@ namespace CorelinkDLL {
         rapidjson::Document jsonRes;
         rapidjson::StringBuffer bufferRes;
         rapidjson::Writer<rapidjson::StringBuffer> writerRes(bufferRes);
-        if (getJsonResponse("mainStream.cpp", "commGeneric", buffer.GetString(), jsonRes, commID, errorID)) {
+        if (getJsonResponse("mainStream.cpp commGeneric", buffer.GetString(), jsonRes, commID, errorID)) {
             jsonRes.RemoveMember("ID");
             json.RemoveMember("statusCode");
             jsonRes.Accept(writerRes);
@@ -219,7 +233,7 @@ namespace CorelinkDLL {
             }
         }
         ss << "],\"token\":\"" << client->token << "\"}";
-        if (getJsonResponse("mainStream.cpp", "commListStreams", ss.str(), json, commID, errorID)) {
+        if (getJsonResponse("mainStream.cpp commListStreams", ss.str(), json, commID, errorID)) {
             std::vector<std::string> data = std::vector<std::string>();
             int streamID;
             rapidjson::Value::Array jsonData = json["senderList"].GetArray();
@@ -242,7 +256,7 @@ namespace CorelinkDLL {
             << ",\"ID\":" << commID
             << ",\"streamID\":" << streamID
             << ",\"token\":\"" << client->token << "\"}";
-        if (getJsonResponse("mainStream.cpp", "commGetStreamInfo", ss.str(), json, commID, errorID)) {
+        if (getJsonResponse("mainStream.cpp commGetStreamInfo", ss.str(), json, commID, errorID)) {
             std::string data;
             std::vector<std::string> type = std::vector<std::string>();
             rapidjson::Value jsonData;
@@ -279,7 +293,7 @@ namespace CorelinkDLL {
         rapidjson::Document json;
         protocol = protocol & STREAM_STATE_SEND & client->data.initState;
         if (!isPow2(protocol)) {
-            errorID = addError("mainStream.cpp commAddSender: Invalid protocol value", ERROR_CODE_VALUE);
+            errorID = addError("mainStream.cpp commAddSender", "Invalid protocol value", ERROR_CODE_VALUE);
             return;
         }
         commID = mainCommGetCommID();
@@ -296,7 +310,7 @@ namespace CorelinkDLL {
             << "\",\"proto\":\"" << streamStateName(protocol)
             << "\"}";
 
-        if (getJsonResponse("mainStream.cpp", "commAddSender", ss.str(), json, commID, errorID)) {
+        if (getJsonResponse("mainStream.cpp commAddSender", ss.str(), json, commID, errorID)) {
             int tmpVal;
             CorelinkDLL::Object::Stream::stream_data stream = CorelinkDLL::Object::Stream::stream_data(
                 json["streamID"].GetInt(), protocol, json["MTU"].GetInt(),
@@ -318,7 +332,7 @@ namespace CorelinkDLL {
         std::vector<std::string> typesVec;
         protocol = protocol & STREAM_STATE_RECV & client->data.initState;
         if (!isPow2(protocol)) {
-            errorID = addError("mainStream.cpp commAddReceiver: Invalid protocol value", ERROR_CODE_VALUE);
+            errorID = addError("mainStream.cpp commAddReceiver", "Invalid protocol value", ERROR_CODE_VALUE);
             return;
         }
         commID = mainCommGetCommID();
@@ -345,7 +359,7 @@ namespace CorelinkDLL {
             << ",\"token\":\"" << client->token
             << "\",\"proto\":\"" << streamStateName(protocol)
             << "\"}";
-        if (getJsonResponse("mainStream.cpp", "commAddReceiver", ss.str(), json, commID, errorID)) {
+        if (getJsonResponse("mainStream.cpp commAddReceiver", ss.str(), json, commID, errorID)) {
             std::unordered_set<int> sources = std::unordered_set<int>();
             rapidjson::SizeType jsonSize;
             int port;
@@ -380,8 +394,8 @@ namespace CorelinkDLL {
             << ",\"receiverID\":\"" << receiverID
             << "\",\"streamIDs\":[\"" << senderID
             << "\"],\"token\":\"" << client->token << "\"}";
-        success = getJsonResponse("mainStream.cpp", "commSubscribe", ss.str(), json, commID, errorID);
-        if (errorID != 0) { delete[] getError(errorID, commID);}
+        success = getJsonResponse("mainStream.cpp commSubscribe", ss.str(), json, commID, errorID);
+        if (errorID != 0) { discardError(errorID); }
         ss.clear();
         client->addSource(receiverID, senderID);
         return success;
@@ -398,8 +412,8 @@ namespace CorelinkDLL {
             << ",\"receiverID\":\"" << receiverID
             << "\",\"streamIDs\":[\"" << senderID
             << "\"],\"token\":\"" << client->token << "\"}";
-        success = getJsonResponse("mainStream.cpp", "commSubscribe", ss.str(), json, commID, errorID);
-        if (errorID != 0) { delete[] getError(errorID, commID);}
+        success = getJsonResponse("mainStream.cpp commSubscribe", ss.str(), json, commID, errorID);
+        if (errorID != 0) { discardError(errorID); }
         ss.clear();
         client->rmSource(receiverID, senderID);
         return success;
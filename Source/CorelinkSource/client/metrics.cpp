@@ -0,0 +1,94 @@
+#include "corelink/client/metrics.h"
+
+namespace CorelinkDLL {
+    typedef CorelinkDLL::Object::Generic::latency_histogram latency_histogram;
+
+    EXPORTED void* createHistogram() {
+        return new latency_histogram();
+    }
+
+    EXPORTED void destroyHistogram(void* histogram) {
+        delete (latency_histogram*) histogram;
+    }
+
+    EXPORTED void recordHistogram(void* histogram, unsigned long long value) {
+        ((latency_histogram*) histogram)->record(value);
+    }
+
+    EXPORTED void mergeHistogram(void* histogram, const void* other) {
+        ((latency_histogram*) histogram)->merge(*(const latency_histogram*) other);
+    }
+
+    EXPORTED void resetHistogram(void* histogram) {
+        ((latency_histogram*) histogram)->reset();
+    }
+
+    EXPORTED unsigned long long getHistogramCount(const void* histogram) {
+        return ((const latency_histogram*) histogram)->getCount();
+    }
+
+    EXPORTED double getHistogramMean(const void* histogram) {
+        return ((const latency_histogram*) histogram)->getMean();
+    }
+
+    EXPORTED unsigned long long getHistogramMin(const void* histogram) {
+        return ((const latency_histogram*) histogram)->getMin();
+    }
+
+    EXPORTED unsigned long long getHistogramMax(const void* histogram) {
+        return ((const latency_histogram*) histogram)->getMax();
+    }
+
+    EXPORTED unsigned long long getHistogramPercentile(const void* histogram, double percent) {
+        return ((const latency_histogram*) histogram)->getPercentile(percent);
+    }
+
+    EXPORTED char* exportHistogram(const void* histogram, int& len) {
+        std::string data;
+        char* buffer;
+        ((const latency_histogram*) histogram)->serialize(data);
+        len = (int) data.size();
+        buffer = new char[len];
+        memcpy(buffer, data.c_str(), len);
+        return buffer;
+    }
+
+    EXPORTED int exportHistogramStr(const void* histogram, char* buffer, int bufferLen) {
+        std::string data;
+        ((const latency_histogram*) histogram)->serialize(data);
+        if ((int) data.size() <= bufferLen) {
+            memcpy(buffer, data.c_str(), data.size());
+        }
+        return (int) data.size();
+    }
+
+    EXPORTED bool importHistogram(void* histogram, const char* data, int len) {
+        return ((latency_histogram*) histogram)->deserialize(data, len);
+    }
+
+    EXPORTED char* snapshotMetrics(int& len) {
+        std::string data;
+        char* buffer;
+        CorelinkDLL::Object::metrics_registry::instance().snapshot(data);
+        len = (int) data.size();
+        buffer = new char[len];
+        memcpy(buffer, data.c_str(), len);
+        return buffer;
+    }
+
+    EXPORTED int snapshotMetricsStr(char* buffer, int bufferLen) {
+        std::string data;
+        CorelinkDLL::Object::metrics_registry::instance().snapshot(data);
+        if ((int) data.size() <= bufferLen) {
+            memcpy(buffer, data.c_str(), data.size());
+        }
+        return (int) data.size();
+    }
+
+    EXPORTED bool getMetricValue(const char* name, long long& value) {
+        std::int64_t read;
+        if (name == nullptr || !CorelinkDLL::Object::metrics_registry::instance().getValue(name, read)) { return false; }
+        value = (long long) read;
+        return true;
+    }
+}
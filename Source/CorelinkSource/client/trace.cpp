@@ -0,0 +1,59 @@
+#include "corelink/client/trace.h"
+#include "corelink/objects/init.h"
+
+#include <cerrno>
+
+namespace CorelinkDLL {
+    EXPORTED bool isTraceAvailable() {
+#ifdef CORELINK_TRACE
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    EXPORTED void startTrace() {
+        CorelinkDLL::Object::tracer::instance().start();
+    }
+
+    EXPORTED void stopTrace() {
+        CorelinkDLL::Object::tracer::instance().stop();
+    }
+
+    EXPORTED bool isTraceEnabled() {
+        return CorelinkDLL::Object::tracer::isEnabled();
+    }
+
+    EXPORTED unsigned long long exportTrace(const char* path, int& errorID) {
+        std::string json;
+        unsigned long long lost;
+        std::FILE* file;
+        errorID = 0;
+        if (path == nullptr) {
+            errorID = addError("trace.cpp exportTrace", "invalid trace path", ERROR_CODE_VALUE);
+            return 0;
+        }
+        lost = CorelinkDLL::Object::tracer::instance().exportChrome(json);
+        if ((file = std::fopen(path, "wb")) == nullptr) {
+            errorID = addError("trace.cpp exportTrace", "could not open trace file", ERROR_CODE_STATE, errno);
+            return lost;
+        }
+        if (std::fwrite(json.data(), 1, json.size(), file) != json.size()) {
+            errorID = addError("trace.cpp exportTrace", "could not write trace file", ERROR_CODE_STATE, errno);
+        }
+        std::fclose(file);
+        return lost;
+    }
+
+    EXPORTED long long getTraceTime() {
+        return CorelinkDLL::Object::tracer::now();
+    }
+
+    EXPORTED void addTraceEvent(const char* name, long long start, long long duration, long long arg) {
+        CorelinkDLL::Object::tracer::instance().add(name, start, duration, arg);
+    }
+
+    EXPORTED void setTraceThreadName(const char* name) {
+        CorelinkDLL::Object::tracer::instance().setThreadName(name);
+    }
+}
@@ -26,6 +26,13 @@ namespace CorelinkDLL {
     EXPORTED const int CALLBACK_STALE = (int)ServerCallback::STALE;
     EXPORTED const int CALLBACK_SUBSCRIBE = (int)ServerCallback::SUBSCRIBE;
     EXPORTED const int CALLBACK_UPDATE = (int)ServerCallback::UPDATE;
+
+    EXPORTED const int CODEC_NONE = (int)StreamCodec::NONE;
+    EXPORTED const int CODEC_XOR_DELTA = (int)StreamCodec::XOR_DELTA;
+
+    EXPORTED const int REPLAY_PACING_ORIGINAL = (int)ReplayPacing::ORIGINAL;
+    EXPORTED const int REPLAY_PACING_SCALED = (int)ReplayPacing::SCALED;
+    EXPORTED const int REPLAY_PACING_ASAP = (int)ReplayPacing::ASAP;
 }
 
 namespace CorelinkDLL {
@@ -6,4 +6,24 @@ namespace CorelinkDLL {
         setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (SOCK_PTR)&recvBufferSize, sizeof(recvBufferSize));
         setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (SOCK_PTR)& recvTimeout, sizeof(recvTimeout));
     }
+
+    bool setSocketNonBlocking(SOCKET& sock) {
+    # ifdef _WIN32
+        u_long mode = 1;
+        return ioctlsocket(sock, FIONBIO, &mode) == 0;
+    # else
+        int flags = fcntl(sock, F_GETFL, 0);
+        return flags != -1 && fcntl(sock, F_SETFL, flags | O_NONBLOCK) == 0;
+    # endif
+    }
+
+    bool waitSocketWritable(SOCKET sock, int timeoutMs) {
+        fd_set writeSet;
+        timeval timeout;
+        FD_ZERO(&writeSet);
+        FD_SET(sock, &writeSet);
+        timeout.tv_sec = timeoutMs / 1000;
+        timeout.tv_usec = (timeoutMs % 1000) * 1000;
+        return select((int) sock + 1, nullptr, &writeSet, nullptr, &timeout) > 0;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,246 @@
+#include "corelink/objects/capture/capture_recorder.h"
+#include "corelink/objects/generics/epoch_manager.h"
+
+# ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+# endif
+
+namespace CorelinkDLL {
+    namespace Object {
+        namespace Capture {
+            static const std::uint64_t RECORD_ALIGN = 8;
+            static const std::uint32_t SEGMENT_PAGE_SIZE = 4096;
+            /// Longest the rolling thread sleeps if a wake up from a listener got lost.
+            static const std::chrono::milliseconds ROLL_INTERVAL(10);
+
+            std::atomic<capture_recorder*> capture_recorder::active(nullptr);
+            std::mutex capture_recorder::controlLock;
+            std::atomic<unsigned long long> capture_recorder::dropped(0);
+
+            static std::int64_t captureTime() {
+                return (std::int64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+            }
+
+            bool capture_recorder::start(const std::string& path, int segmentSize, std::string& error) {
+                capture_recorder* recorder;
+                std::lock_guard<std::mutex> lck(controlLock);
+                if (active.load(std::memory_order_acquire) != nullptr) {
+                    error = "capture already running";
+                    return false;
+                }
+                if (segmentSize == 0) {
+                    segmentSize = SEGMENT_SIZE_DEFAULT;
+                }
+                if (segmentSize < SEGMENT_SIZE_MIN) {
+                    error = "segment size too small";
+                    return false;
+                }
+                recorder = new capture_recorder(path, (std::uint32_t) segmentSize);
+                recorder->current.store(recorder->openSegment(error), std::memory_order_relaxed);
+                if (recorder->current.load(std::memory_order_relaxed) == nullptr) {
+                    delete recorder;
+                    return false;
+                }
+                recorder->running.store(true, std::memory_order_relaxed);
+                recorder->roller = std::thread(&capture_recorder::roll, recorder);
+                dropped.store(0, std::memory_order_relaxed);
+                active.store(recorder, std::memory_order_release);
+                return true;
+            }
+
+            void capture_recorder::stop() {
+                capture_recorder* recorder;
+                std::lock_guard<std::mutex> lck(controlLock);
+                recorder = active.exchange(nullptr, std::memory_order_acq_rel);
+                if (recorder == nullptr) { return; }
+                // listeners that saw the recorder are done with it after this.
+                CorelinkDLL::Object::Generic::epoch_manager::instance().synchronize();
+                delete recorder;
+            }
+
+            unsigned long long capture_recorder::getDropped() {
+                return dropped.load(std::memory_order_relaxed);
+            }
+
+            std::string capture_recorder::segmentPath(const std::string& path, std::uint32_t index) {
+                char suffix[32];
+                snprintf(suffix, sizeof(suffix), ".%06u.clcap", index);
+                return path + suffix;
+            }
+
+            capture_recorder::capture_recorder(const std::string& path, std::uint32_t segmentSize) :
+                path(path), segmentSize(segmentSize), highWater(segmentSize - segmentSize / 4), current(nullptr), spare(nullptr),
+                nextIndex(0), running(false)
+            {}
+
+            capture_recorder::~capture_recorder() {
+                {
+                    std::lock_guard<std::mutex> lck(this->rollLock);
+                    this->running.store(false, std::memory_order_relaxed);
+                }
+                this->rollSignal.notify_one();
+                if (this->roller.joinable()) {
+                    this->roller.join();
+                }
+                if (this->current.load(std::memory_order_relaxed) != nullptr) {
+                    closeSegment(this->current.load(std::memory_order_relaxed), true);
+                }
+                if (this->spare != nullptr) {
+                    closeSegment(this->spare, false);
+                }
+            }
+
+            void capture_recorder::captureActive(const STREAM_ID& recvID, const STREAM_ID& sendID, const char* data, int hdrLen, int msgLen) {
+                CorelinkDLL::Object::Generic::epoch_manager::read_guard guard;
+                capture_recorder* recorder = active.load(std::memory_order_acquire);
+                if (recorder == nullptr) { return; }
+                recorder->record(recvID, sendID, data, hdrLen, msgLen);
+            }
+
+            void capture_recorder::record(const STREAM_ID& recvID, const STREAM_ID& sendID, const char* data, int hdrLen, int msgLen) {
+                std::int64_t timestamp = captureTime();
+                std::uint64_t size = (sizeof(capture_record_header) + hdrLen + msgLen + RECORD_ALIGN - 1) & ~(RECORD_ALIGN - 1);
+                segment* seg = this->current.load(std::memory_order_acquire);
+                std::uint64_t start = seg->reserved.fetch_add(size, std::memory_order_relaxed);
+                capture_record_header* record;
+
+                if (start < this->highWater && start + size >= this->highWater) {
+                    this->rollSignal.notify_one();
+                }
+                if (start + size > seg->size) {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                record = (capture_record_header*)(seg->base + start);
+                record->hdrLen = (std::uint32_t) hdrLen;
+                record->msgLen = (std::uint32_t) msgLen;
+                record->recvID = (std::int32_t) recvID;
+                record->sendID = (std::int32_t) sendID;
+                record->reserved = 0;
+                record->timestamp = timestamp;
+                memcpy(record + 1, data, hdrLen + msgLen);
+                // readers of a live segment stop at the first record without a size.
+                ((std::atomic<std::uint32_t>*) &record->size)->store((std::uint32_t) size, std::memory_order_release);
+            }
+
+            capture_recorder::segment* capture_recorder::openSegment(std::string& error) {
+                segment* seg = new segment();
+                capture_segment_header* header;
+                seg->size = this->segmentSize;
+                seg->index = this->nextIndex;
+                seg->reserved.store(sizeof(capture_segment_header), std::memory_order_relaxed);
+                seg->path = segmentPath(this->path, seg->index);
+#ifdef _WIN32
+                seg->file = CreateFileA(seg->path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+                if (seg->file == INVALID_HANDLE_VALUE) {
+                    error = "could not create " + seg->path;
+                    delete seg;
+                    return nullptr;
+                }
+                seg->mapping = CreateFileMappingA(seg->file, nullptr, PAGE_READWRITE, 0, seg->size, nullptr);
+                seg->base = seg->mapping == nullptr ? nullptr : (char*) MapViewOfFile(seg->mapping, FILE_MAP_WRITE, 0, 0, seg->size);
+                if (seg->base == nullptr) {
+                    error = "could not map " + seg->path;
+                    if (seg->mapping != nullptr) {
+                        CloseHandle(seg->mapping);
+                    }
+                    CloseHandle(seg->file);
+                    DeleteFileA(seg->path.c_str());
+                    delete seg;
+                    return nullptr;
+                }
+#else
+                seg->file = open(seg->path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+                if (seg->file < 0) {
+                    error = "could not create " + seg->path;
+                    delete seg;
+                    return nullptr;
+                }
+                seg->base = nullptr;
+                if (ftruncate(seg->file, seg->size) == 0) {
+                    void* base = mmap(nullptr, seg->size, PROT_READ | PROT_WRITE, MAP_SHARED, seg->file, 0);
+                    seg->base = base == MAP_FAILED ? nullptr : (char*) base;
+                }
+                if (seg->base == nullptr) {
+                    error = "could not map " + seg->path;
+                    close(seg->file);
+                    unlink(seg->path.c_str());
+                    delete seg;
+                    return nullptr;
+                }
+#endif
+                // take the write faults here instead of on the listener threads.
+                for (std::uint32_t offset = 0; offset < seg->size; offset += SEGMENT_PAGE_SIZE) {
+                    ((volatile char*) seg->base)[offset] = 0;
+                }
+                header = (capture_segment_header*) seg->base;
+                header->magic = capture_segment_header::MAGIC;
+                header->version = capture_segment_header::VERSION;
+                header->headerSize = (std::uint16_t) sizeof(capture_segment_header);
+                header->index = seg->index;
+                header->startTime = captureTime();
+                header->dataSize = 0;
+                ++this->nextIndex;
+                return seg;
+            }
+
+            void capture_recorder::closeSegment(segment* seg, bool keep) {
+                std::uint64_t used = seg->reserved.load(std::memory_order_acquire);
+                if (used > seg->size) {
+                    used = seg->size;
+                }
+                ((capture_segment_header*) seg->base)->dataSize = used - sizeof(capture_segment_header);
+#ifdef _WIN32
+                LARGE_INTEGER length;
+                UnmapViewOfFile(seg->base);
+                CloseHandle(seg->mapping);
+                length.QuadPart = (LONGLONG) used;
+                if (keep && SetFilePointerEx(seg->file, length, nullptr, FILE_BEGIN)) {
+                    SetEndOfFile(seg->file);
+                }
+                CloseHandle(seg->file);
+                if (!keep) {
+                    DeleteFileA(seg->path.c_str());
+                }
+#else
+                int trimmed;
+                munmap(seg->base, seg->size);
+                // if trimming fails the file keeps its zeroed tail, readers stop at the first empty record anyway.
+                trimmed = keep ? ftruncate(seg->file, (off_t) used) : 0;
+                (void) trimmed;
+                close(seg->file);
+                if (!keep) {
+                    unlink(seg->path.c_str());
+                }
+#endif
+                delete seg;
+            }
+
+            void capture_recorder::roll() {
+                std::string error;
+                segment* seg;
+                std::unique_lock<std::mutex> lck(this->rollLock);
+                while (this->running.load(std::memory_order_relaxed)) {
+                    if (this->spare == nullptr) {
+                        lck.unlock();
+                        this->spare = this->openSegment(error);
+                        lck.lock();
+                    }
+                    seg = this->current.load(std::memory_order_relaxed);
+                    if (this->spare != nullptr && seg->reserved.load(std::memory_order_relaxed) >= this->highWater) {
+                        this->current.store(this->spare, std::memory_order_release);
+                        this->spare = nullptr;
+                        lck.unlock();
+                        CorelinkDLL::Object::Generic::epoch_manager::instance().synchronize();
+                        closeSegment(seg, true);
+                        lck.lock();
+                        continue;
+                    }
+                    this->rollSignal.wait_for(lck, ROLL_INTERVAL);
+                }
+            }
+        }
+    }
+}
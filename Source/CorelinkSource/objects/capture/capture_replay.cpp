@@ -0,0 +1,278 @@
+#include "corelink/objects/capture/capture_replay.h"
+#include <algorithm>
+#include <limits>
+
+# ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+# endif
+
+namespace CorelinkDLL {
+    namespace Object {
+        namespace Capture {
+            /// Waits shorter than this spin instead of sleeping.
+            static const std::chrono::microseconds REPLAY_SPIN(2000);
+            /// Longest single sleep, so stop() is not held up by a long gap in the capture.
+            static const std::chrono::milliseconds REPLAY_MAX_SLEEP(10);
+
+            capture_replay::capture_replay() :
+                segments(), index(), recordCount(0), firstTime(0), lastTime(0), curSegment(0), curOffset(0),
+                playing(false), stopping(false), replayed(0), position(0)
+            {}
+
+            capture_replay::~capture_replay() {
+                this->close();
+            }
+
+            bool capture_replay::open(const std::string& path, std::string& error) {
+                segment seg;
+                this->close();
+                while (mapSegment(capture_recorder::segmentPath(path, (std::uint32_t) this->segments.size()), seg)) {
+                    this->segments.push_back(seg);
+                }
+                if (this->segments.empty()) {
+                    error = "no capture segments at " + capture_recorder::segmentPath(path, 0);
+                    return false;
+                }
+                this->buildIndex();
+                this->curSegment = 0;
+                this->curOffset = this->segments[0].start;
+                return true;
+            }
+
+            void capture_replay::close() {
+                this->stop();
+                for (segment& seg : this->segments) {
+                    unmapSegment(seg);
+                }
+                this->segments.clear();
+                this->index.clear();
+                this->recordCount = 0;
+                this->firstTime = 0;
+                this->lastTime = 0;
+                this->curSegment = 0;
+                this->curOffset = 0;
+            }
+
+            std::uint64_t capture_replay::getRecordCount() const {
+                return this->recordCount;
+            }
+
+            std::int64_t capture_replay::getFirstTime() const {
+                return this->firstTime;
+            }
+
+            std::int64_t capture_replay::getLastTime() const {
+                return this->lastTime;
+            }
+
+            bool capture_replay::seek(std::int64_t time) {
+                std::vector<index_entry>::const_iterator it;
+                std::uint32_t segIndex;
+                std::uint64_t offset;
+                replay_record record;
+                if (this->index.empty()) { return false; }
+                // last entry whose earlier records all came before time.
+                it = std::partition_point(this->index.begin(), this->index.end(),
+                    [time](const index_entry& entry) { return entry.maxTime < time; });
+                if (it != this->index.begin()) {
+                    --it;
+                }
+                this->curSegment = it->segment;
+                this->curOffset = it->offset;
+                while (true) {
+                    segIndex = this->curSegment;
+                    offset = this->curOffset;
+                    if (!this->next(record)) { return false; }
+                    if (record.timestamp >= time) {
+                        this->curSegment = segIndex;
+                        this->curOffset = offset;
+                        return true;
+                    }
+                }
+            }
+
+            bool capture_replay::next(replay_record& record) {
+                const capture_record_header* header;
+                while (this->curSegment < this->segments.size()) {
+                    const segment& seg = this->segments[this->curSegment];
+                    if (this->curOffset < seg.end) {
+                        header = (const capture_record_header*)(seg.base + this->curOffset);
+                        record.timestamp = header->timestamp;
+                        record.recvID = (STREAM_ID) header->recvID;
+                        record.sendID = (STREAM_ID) header->sendID;
+                        record.data = (const char*)(header + 1);
+                        record.hdrLen = (int) header->hdrLen;
+                        record.msgLen = (int) header->msgLen;
+                        this->curOffset += header->size;
+                        return true;
+                    }
+                    if (++this->curSegment < this->segments.size()) {
+                        this->curOffset = this->segments[this->curSegment].start;
+                    }
+                }
+                return false;
+            }
+
+            bool capture_replay::start(const Sink& sink, int pacing, double speed) {
+                if (this->playing.load(std::memory_order_acquire)) { return false; }
+                if (pacing < (int) ReplayPacing::ORIGINAL || pacing >= (int) ReplayPacing::LAST ||
+                    (pacing == (int) ReplayPacing::SCALED && !(speed > 0))) {
+                    return false;
+                }
+                if (this->player.joinable()) {
+                    this->player.join();
+                }
+                this->stopping.store(false, std::memory_order_relaxed);
+                this->replayed.store(0, std::memory_order_relaxed);
+                this->position.store(0, std::memory_order_relaxed);
+                this->playing.store(true, std::memory_order_release);
+                this->player = std::thread(&capture_replay::play, this, sink, pacing, pacing == (int) ReplayPacing::SCALED ? speed : 1.0);
+                return true;
+            }
+
+            void capture_replay::stop() {
+                this->stopping.store(true, std::memory_order_relaxed);
+                if (this->player.joinable()) {
+                    this->player.join();
+                }
+                this->stopping.store(false, std::memory_order_relaxed);
+            }
+
+            bool capture_replay::isPlaying() const {
+                return this->playing.load(std::memory_order_acquire);
+            }
+
+            std::uint64_t capture_replay::getReplayed() const {
+                return this->replayed.load(std::memory_order_relaxed);
+            }
+
+            std::int64_t capture_replay::getPosition() const {
+                return this->position.load(std::memory_order_relaxed);
+            }
+
+            bool capture_replay::mapSegment(const std::string& path, segment& seg) {
+                const capture_segment_header* header;
+                seg.base = nullptr;
+                seg.size = 0;
+#ifdef _WIN32
+                LARGE_INTEGER length;
+                seg.file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+                if (seg.file == INVALID_HANDLE_VALUE) { return false; }
+                seg.mapping = nullptr;
+                if (GetFileSizeEx(seg.file, &length) && length.QuadPart >= (LONGLONG) sizeof(capture_segment_header)) {
+                    seg.size = (std::uint64_t) length.QuadPart;
+                    seg.mapping = CreateFileMappingA(seg.file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                }
+                if (seg.mapping != nullptr) {
+                    seg.base = (const char*) MapViewOfFile(seg.mapping, FILE_MAP_READ, 0, 0, 0);
+                }
+                if (seg.base == nullptr) {
+                    if (seg.mapping != nullptr) {
+                        CloseHandle(seg.mapping);
+                    }
+                    CloseHandle(seg.file);
+                    return false;
+                }
+#else
+                struct stat info;
+                void* base;
+                seg.file = ::open(path.c_str(), O_RDONLY);
+                if (seg.file < 0) { return false; }
+                if (fstat(seg.file, &info) != 0 || info.st_size < (off_t) sizeof(capture_segment_header)) {
+                    ::close(seg.file);
+                    return false;
+                }
+                seg.size = (std::uint64_t) info.st_size;
+                base = mmap(nullptr, seg.size, PROT_READ, MAP_PRIVATE, seg.file, 0);
+                if (base == MAP_FAILED) {
+                    ::close(seg.file);
+                    return false;
+                }
+                seg.base = (const char*) base;
+#endif
+                header = (const capture_segment_header*) seg.base;
+                if (header->magic != capture_segment_header::MAGIC || header->version != capture_segment_header::VERSION ||
+                    header->headerSize < sizeof(capture_segment_header) || header->headerSize > seg.size) {
+                    unmapSegment(seg);
+                    return false;
+                }
+                seg.start = header->headerSize;
+                seg.end = seg.start;
+                return true;
+            }
+
+            void capture_replay::unmapSegment(segment& seg) {
+                if (seg.base == nullptr) { return; }
+#ifdef _WIN32
+                UnmapViewOfFile(seg.base);
+                CloseHandle(seg.mapping);
+                CloseHandle(seg.file);
+#else
+                munmap((void*) seg.base, seg.size);
+                ::close(seg.file);
+#endif
+                seg.base = nullptr;
+            }
+
+            void capture_replay::buildIndex() {
+                const capture_record_header* header;
+                std::int64_t maxTime = std::numeric_limits<std::int64_t>::min();
+                std::uint64_t offset;
+                for (std::uint32_t i = 0; i < this->segments.size(); ++i) {
+                    segment& seg = this->segments[i];
+                    offset = seg.start;
+                    while (seg.size - offset >= sizeof(capture_record_header)) {
+                        header = (const capture_record_header*)(seg.base + offset);
+                        // an empty or torn record ends the segment.
+                        if (header->size < sizeof(capture_record_header) || header->size > seg.size - offset ||
+                            (std::uint64_t) header->hdrLen + header->msgLen > header->size - sizeof(capture_record_header)) {
+                            break;
+                        }
+                        if (this->recordCount % INDEX_INTERVAL == 0) {
+                            this->index.push_back(index_entry{ maxTime, i, offset });
+                        }
+                        if (this->recordCount == 0) {
+                            this->firstTime = header->timestamp;
+                        }
+                        maxTime = std::max(maxTime, header->timestamp);
+                        ++this->recordCount;
+                        offset += header->size;
+                    }
+                    seg.end = offset;
+                }
+                this->lastTime = this->recordCount > 0 ? maxTime : 0;
+            }
+
+            void capture_replay::play(Sink sink, int pacing, double speed) {
+                replay_record record;
+                std::chrono::steady_clock::time_point wallStart, target, now;
+                std::int64_t timeStart = 0;
+                bool first = true;
+                while (!this->stopping.load(std::memory_order_relaxed) && this->next(record)) {
+                    if (pacing != (int) ReplayPacing::ASAP) {
+                        if (first) {
+                            wallStart = std::chrono::steady_clock::now();
+                            timeStart = record.timestamp;
+                            first = false;
+                        }
+                        target = wallStart + std::chrono::nanoseconds((long long) ((record.timestamp - timeStart) / speed));
+                        while (!this->stopping.load(std::memory_order_relaxed) && (now = std::chrono::steady_clock::now()) < target) {
+                            if (target - now > REPLAY_SPIN) {
+                                std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(target - now - REPLAY_SPIN / 2, REPLAY_MAX_SLEEP));
+                            }
+                            else {
+                                std::this_thread::yield();
+                            }
+                        }
+                        if (this->stopping.load(std::memory_order_relaxed)) { break; }
+                    }
+                    sink(record);
+                    this->position.store(record.timestamp, std::memory_order_relaxed);
+                    this->replayed.fetch_add(1, std::memory_order_relaxed);
+                }
+                this->playing.store(false, std::memory_order_release);
+            }
+        }
+    }
+}
@@ -1,4 +1,5 @@
 #include "corelink/objects/client_main.h"
+#include "corelink/objects/generics/epoch_manager.h"
 
 #include "corelink/objects/streams/comm_main_tcp.h"
 
@@ -20,6 +21,7 @@ namespace CorelinkDLL {
             this->clientIP = "";
 
             this->mainComm = nullptr;
+            this->snapshot.store(new CorelinkDLL::Object::Stream::stream_snapshot(), std::memory_order_relaxed);
 
             this->mainComm = new CorelinkDLL::Object::Stream::comm_main_tcp(this);
             // this->mainComm = new CorelinkDLL::Object::Stream::comm_main_ws(this);
@@ -36,6 +38,7 @@ namespace CorelinkDLL {
                 delete this->mainComm;
                 this->mainComm = nullptr;
             }
+            CorelinkDLL::Object::Generic::epoch_manager::instance().retire(this->snapshot.exchange(nullptr));
         }
 
         void client_main::initDataStreams(const std::string& effectiveIP, int& errorID) {
@@ -78,56 +81,93 @@ namespace CorelinkDLL {
             }
         }
 
+        void client_main::publishSnapshot(CorelinkDLL::Object::Stream::stream_snapshot* next) {
+            CorelinkDLL::Object::Generic::epoch_manager::instance().retire(this->snapshot.exchange(next, std::memory_order_acq_rel));
+        }
+
         void client_main::addStream(const CorelinkDLL::Object::Stream::stream_data& streamData, int protocol, int port) {
+            CorelinkDLL::Object::Stream::stream_snapshot* next;
             if (this->dataStreams[streamData.stateIndex] != nullptr) {
                 std::lock_guard<std::mutex> lck(this->streamLock);
                 this->mapStreamData[streamData.streamID] = streamData;
+                for (const int& sourceID : streamData.sources) {
+                    this->sourceTargets[sourceID].insert(streamData.streamID);
+                }
                 this->dataStreams[streamData.stateIndex]->addStream(streamData.streamID, this->serverIPEffective, port);
+                // the ref never changes while the stream exists, so it is stored with the record.
+                next = new CorelinkDLL::Object::Stream::stream_snapshot(*this->snapshot.load(std::memory_order_relaxed));
+                next->add(CorelinkDLL::Object::Stream::stream_record::create(streamData,
+                    this->dataStreams[streamData.stateIndex]->getStreamRef(streamData.streamID)));
+                this->publishSnapshot(next);
             }
         }
 
         void client_main::rmStream(const STREAM_ID& streamID) {
             std::unordered_map<STREAM_ID, CorelinkDLL::Object::Stream::stream_data>::iterator iter;
+            CorelinkDLL::Object::Stream::stream_snapshot* next;
             std::lock_guard<std::mutex> lck(this->streamLock);
             if ((iter = this->mapStreamData.find(streamID)) == this->mapStreamData.end()) { return; }
+            // readers stop seeing the stream before its data stream goes away.
+            next = new CorelinkDLL::Object::Stream::stream_snapshot(*this->snapshot.load(std::memory_order_relaxed));
+            next->remove(streamID);
+            this->publishSnapshot(next);
             this->dataStreams[iter->second.stateIndex]->rmStream(streamID);
+            for (const int& sourceID : iter->second.sources) {
+                this->rmTarget(sourceID, streamID);
+            }
             this->mapStreamData.erase(iter);
         }
 
         int client_main::getStreamRef(const STREAM_ID& streamID) {
-            std::unordered_map<STREAM_ID, CorelinkDLL::Object::Stream::stream_data>::iterator iter;
-            std::lock_guard<std::mutex> lck(this->streamLock);
-            if ((iter = this->mapStreamData.find(streamID)) == this->mapStreamData.end()) { return -1; }
-            return this->dataStreams[iter->second.stateIndex]->getStreamRef(streamID);
+            CorelinkDLL::Object::Generic::epoch_manager::read_guard guard;
+            const CorelinkDLL::Object::Stream::stream_record* record = this->snapshot.load(std::memory_order_acquire)->find(streamID);
+            return record == nullptr ? -1 : record->ref;
         }
 
         int client_main::getStreamState(const STREAM_ID& streamID) {
-            std::unordered_map<STREAM_ID, CorelinkDLL::Object::Stream::stream_data>::iterator iter;
-            std::lock_guard<std::mutex> lck(this->streamLock);
-            if ((iter = this->mapStreamData.find(streamID)) == this->mapStreamData.end()) { return STREAM_STATE_NONE; }
-            return iter->second.state;
+            CorelinkDLL::Object::Generic::epoch_manager::read_guard guard;
+            const CorelinkDLL::Object::Stream::stream_record* record = this->snapshot.load(std::memory_order_acquire)->find(streamID);
+            return record == nullptr ? STREAM_STATE_NONE : record->state;
         }
 
         std::string client_main::getStreamData(const STREAM_ID& streamID) {
-            std::unordered_map<STREAM_ID, CorelinkDLL::Object::Stream::stream_data>::iterator iter;
-            std::lock_guard<std::mutex> lck(this->streamLock);
-            if ((iter = this->mapStreamData.find(streamID)) == this->mapStreamData.end()) { return ""; }
-            return iter->second.streamData;
+            CorelinkDLL::Object::Generic::epoch_manager::read_guard guard;
+            const CorelinkDLL::Object::Stream::stream_record* record = this->snapshot.load(std::memory_order_acquire)->find(streamID);
+            return record == nullptr ? "" : std::string(record->data(), record->dataLen);
+        }
+
+        const char* client_main::acquireStreamData(const STREAM_ID& streamID, int& len) {
+            CorelinkDLL::Object::Generic::epoch_manager::read_guard guard;
+            CorelinkDLL::Object::Stream::stream_record* record = (CorelinkDLL::Object::Stream::stream_record*)
+                this->snapshot.load(std::memory_order_acquire)->find(streamID);
+            if (record == nullptr) {
+                len = 0;
+                return nullptr;
+            }
+            // the snapshot keeps the record alive until the guard is gone, the new reference keeps it after.
+            record->acquire();
+            len = record->dataLen;
+            return record->data();
+        }
+
+        void client_main::releaseStreamData(const char* data) {
+            if (data == nullptr) { return; }
+            CorelinkDLL::Object::Stream::stream_record::fromData(data)->release();
         }
 
         bool client_main::streamIsType(const STREAM_ID& streamID, int streamState) {
-            std::unordered_map<STREAM_ID, CorelinkDLL::Object::Stream::stream_data>::iterator iter;
-            std::lock_guard<std::mutex> lck(this->streamLock);
-            if ((iter = this->mapStreamData.find(streamID)) == this->mapStreamData.end()) { return false; }
-            return (iter->second.state & streamState) > 0;
+            CorelinkDLL::Object::Generic::epoch_manager::read_guard guard;
+            const CorelinkDLL::Object::Stream::stream_record* record = this->snapshot.load(std::memory_order_acquire)->find(streamID);
+            return record != nullptr && (record->state & streamState) > 0;
         }
         
         std::vector<int> client_main::getStreams() {
             std::vector<int> streams = std::vector<int>();
-            std::lock_guard<std::mutex> lck(this->streamLock);
-            streams.reserve(this->mapStreamData.size());
-            for (const std::pair<STREAM_ID, CorelinkDLL::Object::Stream::stream_data>& streamData : this->mapStreamData) {
-                streams.push_back(streamData.second.streamID);
+            CorelinkDLL::Object::Generic::epoch_manager::read_guard guard;
+            const CorelinkDLL::Object::Stream::stream_snapshot* current = this->snapshot.load(std::memory_order_acquire);
+            streams.reserve(current->getStreams().size());
+            for (const std::pair<const STREAM_ID, CorelinkDLL::Object::Stream::stream_record*>& stream : current->getStreams()) {
+                streams.push_back(stream.first);
             }
             return streams;
         }
@@ -144,23 +184,73 @@ namespace CorelinkDLL {
             std::lock_guard<std::mutex> lck(this->streamLock);
             if ((iter = this->mapStreamData.find(targetID)) == this->mapStreamData.end()) { return; }
             iter->second.sources.insert(sourceID);
+            this->sourceTargets[sourceID].insert(targetID);
         }
 
-        void client_main::rmSource(const STREAM_ID& sourceID) {
+        void client_main::rmSourceUnlocked(const STREAM_ID& sourceID, std::vector<std::pair<STREAM_ID, STREAM_ID>>& removed) {
+            std::unordered_map<STREAM_ID, std::unordered_set<STREAM_ID>>::iterator targets;
             std::unordered_map<STREAM_ID, CorelinkDLL::Object::Stream::stream_data>::iterator iter;
-            std::lock_guard<std::mutex> lck(this->streamLock);
-            iter = this->mapStreamData.begin();
-            while (iter != this->mapStreamData.end()) {
-                iter->second.sources.erase(sourceID);
-                ++iter;
+            if ((targets = this->sourceTargets.find(sourceID)) == this->sourceTargets.end()) { return; }
+            for (const STREAM_ID& targetID : targets->second) {
+                if ((iter = this->mapStreamData.find(targetID)) != this->mapStreamData.end()) {
+                    iter->second.sources.erase(sourceID);
+                    removed.emplace_back(targetID, sourceID);
+                }
             }
+            this->sourceTargets.erase(targets);
+        }
+
+        void client_main::resetSources(const std::vector<std::pair<STREAM_ID, STREAM_ID>>& removed) {
+            int state;
+            int ref;
+            for (const std::pair<STREAM_ID, STREAM_ID>& item : removed) {
+                state = this->getStreamState(item.first);
+                if ((state & STREAM_STATE_RECV) == 0 || this->dataStreams[streamStateToBitIndex(state)] == nullptr) { continue; }
+                if ((ref = this->getStreamRef(item.first)) < 0) { continue; }
+                ((CorelinkDLL::Object::Stream::comm_data_recv_base*) this->dataStreams[streamStateToBitIndex(state)])->resetSource(ref, item.first, item.second);
+            }
+        }
+
+        void client_main::rmTarget(const STREAM_ID& sourceID, const STREAM_ID& targetID) {
+            std::unordered_map<STREAM_ID, std::unordered_set<STREAM_ID>>::iterator targets;
+            if ((targets = this->sourceTargets.find(sourceID)) == this->sourceTargets.end()) { return; }
+            targets->second.erase(targetID);
+            if (targets->second.empty()) {
+                this->sourceTargets.erase(targets);
+            }
+        }
+
+        void client_main::rmSource(const STREAM_ID& sourceID) {
+            std::vector<std::pair<STREAM_ID, STREAM_ID>> removed;
+            {
+                std::lock_guard<std::mutex> lck(this->streamLock);
+                this->rmSourceUnlocked(sourceID, removed);
+            }
+            this->resetSources(removed);
+        }
+
+        void client_main::rmSources(const std::vector<STREAM_ID>& sourceIDs) {
+            std::vector<std::pair<STREAM_ID, STREAM_ID>> removed;
+            {
+                std::lock_guard<std::mutex> lck(this->streamLock);
+                for (const STREAM_ID& sourceID : sourceIDs) {
+                    this->rmSourceUnlocked(sourceID, removed);
+                }
+            }
+            this->resetSources(removed);
         }
 
         void client_main::rmSource(const STREAM_ID& targetID, const STREAM_ID& sourceID) {
             std::unordered_map<STREAM_ID, CorelinkDLL::Object::Stream::stream_data>::iterator iter;
-            std::lock_guard<std::mutex> lck(this->streamLock);
-            if ((iter = this->mapStreamData.find(targetID)) == this->mapStreamData.end()) { return; }
-            iter->second.sources.erase(sourceID);
+            std::vector<std::pair<STREAM_ID, STREAM_ID>> removed;
+            {
+                std::lock_guard<std::mutex> lck(this->streamLock);
+                if ((iter = this->mapStreamData.find(targetID)) == this->mapStreamData.end()) { return; }
+                iter->second.sources.erase(sourceID);
+                this->rmTarget(sourceID, targetID);
+            }
+            removed.emplace_back(targetID, sourceID);
+            this->resetSources(removed);
         }
     }
 }
\ No newline at end of file
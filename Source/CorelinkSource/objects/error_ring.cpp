@@ -0,0 +1,97 @@
+#include "corelink/objects/error_ring.h"
+
+namespace CorelinkDLL {
+    namespace Object {
+        int error_record::format(char* buffer) const {
+            static const char SYS_ERROR_PREFIX[] = " Error code: ";
+            char number[16];
+            int locationLen = this->location == nullptr ? 0 : (int) strlen(this->location);
+            int numberLen = this->sysError == 0 ? 0 : snprintf(number, sizeof(number), "%d", this->sysError);
+            int len = 0;
+
+            if (locationLen > 0) {
+                if (buffer != nullptr) {
+                    memcpy(buffer, this->location, locationLen);
+                    memcpy(buffer + locationLen, ": ", 2);
+                }
+                len += locationLen + 2;
+            }
+            if (buffer != nullptr) { memcpy(buffer + len, this->msg, this->msgLen); }
+            len += this->msgLen;
+            if (numberLen > 0) {
+                if (buffer != nullptr) {
+                    memcpy(buffer + len, SYS_ERROR_PREFIX, sizeof(SYS_ERROR_PREFIX) - 1);
+                    memcpy(buffer + len + sizeof(SYS_ERROR_PREFIX) - 1, number, numberLen);
+                }
+                len += (int) sizeof(SYS_ERROR_PREFIX) - 1 + numberLen;
+            }
+            // wrapper reads the error code from the last char.
+            if (buffer != nullptr) { buffer[len] = (char) this->code; }
+            return len + 1;
+        }
+
+        error_ring::error_ring() : nextID(0), dropped(0) {
+            for (int i = 0; i < RING_SIZE; ++i) {
+                this->slots[i].seq.store(0, std::memory_order_relaxed);
+                this->slots[i].consumedID.store(0, std::memory_order_relaxed);
+                this->slots[i].record.id = 0;
+            }
+        }
+
+        unsigned int error_ring::add(const char* location, const char* msg, int msgLen, int code, int sysError) {
+            unsigned int id;
+            unsigned int seq;
+            // 0 means no error to the wrapper.
+            while ((id = this->nextID.fetch_add(1, std::memory_order_relaxed) + 1) == 0) {}
+            slot& current = this->slots[id % RING_SIZE];
+
+            // claim the slot, another writer may still be on it if the ring wrapped around.
+            seq = current.seq.load(std::memory_order_relaxed);
+            while ((seq & 1) != 0 || !current.seq.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                std::this_thread::yield();
+                seq = current.seq.load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_release);
+
+            if (current.record.id != 0 && current.consumedID.load(std::memory_order_relaxed) != current.record.id) {
+                this->dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (msgLen > error_record::MESSAGE_SIZE) { msgLen = error_record::MESSAGE_SIZE; }
+            current.record.id = id;
+            current.record.code = code;
+            current.record.location = location;
+            current.record.sysError = sysError;
+            current.record.timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            current.record.msgLen = msgLen < 0 ? 0 : msgLen;
+            memcpy(current.record.msg, msg, current.record.msgLen);
+
+            current.seq.store(seq + 2, std::memory_order_release);
+            return id;
+        }
+
+        bool error_ring::get(unsigned int id, error_record& record, bool consume) {
+            slot& current = this->slots[id % RING_SIZE];
+            unsigned int seqBefore, seqAfter;
+            if (id == 0) { return false; }
+            do {
+                while (((seqBefore = current.seq.load(std::memory_order_acquire)) & 1) != 0) {
+                    std::this_thread::yield();
+                }
+                record = current.record;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                seqAfter = current.seq.load(std::memory_order_relaxed);
+            } while (seqBefore != seqAfter);
+
+            if (record.id != id) { return false; }
+            if (consume) {
+                current.consumedID.store(id, std::memory_order_relaxed);
+            }
+            return true;
+        }
+
+        unsigned long long error_ring::getDropped() const {
+            return this->dropped.load(std::memory_order_relaxed);
+        }
+    }
+}
@@ -0,0 +1 @@
+#include "corelink/objects/generics/concurrent_stream_map.h"
@@ -0,0 +1,154 @@
+#include "corelink/objects/generics/epoch_manager.h"
+
+namespace CorelinkDLL {
+    namespace Object {
+        namespace Generic {
+            /**
+             * Reader slot of the current thread. Released when the thread exits.
+             */
+            struct epoch_thread_state {
+                int slot;
+                /// Number of nested guards.
+                int depth;
+                epoch_thread_state() : slot(-1), depth(0) {}
+                ~epoch_thread_state() {
+                    if (this->slot >= 0) {
+                        epoch_manager::instance().releaseSlot(this->slot);
+                    }
+                }
+            };
+
+            static thread_local epoch_thread_state threadState;
+
+            epoch_manager::read_guard::read_guard() {
+                epoch_manager::instance().enter();
+            }
+
+            epoch_manager::read_guard::~read_guard() {
+                epoch_manager::instance().leave();
+            }
+
+            epoch_manager& epoch_manager::instance() {
+                static epoch_manager manager;
+                return manager;
+            }
+
+            epoch_manager::epoch_manager() : globalEpoch(1), overflowReaders(0) {
+                for (int i = 0; i < MAX_READERS; ++i) {
+                    this->readers[i].epoch.store(0, std::memory_order_relaxed);
+                    this->readers[i].used.store(false, std::memory_order_relaxed);
+                }
+            }
+
+            epoch_manager::~epoch_manager() {
+                std::lock_guard<std::mutex> lck(this->limboLock);
+                for (const retired_ptr& retired : this->limbo) {
+                    retired.deleter(retired.ptr);
+                }
+                this->limbo.clear();
+            }
+
+            void epoch_manager::enter() {
+                epoch_thread_state& state = threadState;
+                if (state.depth++ > 0) { return; }
+                if (state.slot < 0) {
+                    state.slot = this->claimSlot();
+                }
+                if (state.slot < 0) {
+                    this->overflowReaders.fetch_add(1, std::memory_order_seq_cst);
+                    return;
+                }
+                this->readers[state.slot].epoch.store(this->globalEpoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+                // the announcement must be visible before any pointer is read.
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+
+            void epoch_manager::leave() {
+                epoch_thread_state& state = threadState;
+                if (--state.depth > 0) { return; }
+                if (state.slot < 0) {
+                    this->overflowReaders.fetch_sub(1, std::memory_order_release);
+                    return;
+                }
+                this->readers[state.slot].epoch.store(0, std::memory_order_release);
+            }
+
+            int epoch_manager::claimSlot() {
+                bool expected;
+                for (int i = 0; i < MAX_READERS; ++i) {
+                    expected = false;
+                    if (!this->readers[i].used.load(std::memory_order_relaxed) &&
+                        this->readers[i].used.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                        return i;
+                    }
+                }
+                return -1;
+            }
+
+            void epoch_manager::releaseSlot(int slot) {
+                this->readers[slot].epoch.store(0, std::memory_order_release);
+                this->readers[slot].used.store(false, std::memory_order_release);
+            }
+
+            void epoch_manager::retire(void* ptr, Deleter deleter) {
+                if (ptr == nullptr) { return; }
+                unsigned long long epoch = this->globalEpoch.fetch_add(1, std::memory_order_seq_cst);
+                {
+                    std::lock_guard<std::mutex> lck(this->limboLock);
+                    this->limbo.push_back(retired_ptr{ ptr, deleter, epoch });
+                }
+                this->collect();
+            }
+
+            void epoch_manager::collect() {
+                std::vector<retired_ptr> ready;
+                unsigned long long minEpoch = ~0ull;
+                unsigned long long epoch;
+                std::size_t kept = 0;
+
+                // pairs with the fence in enter so unlinked memory is either seen as unlinked or its reader is seen.
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (this->overflowReaders.load(std::memory_order_seq_cst) > 0) { return; }
+                for (int i = 0; i < MAX_READERS; ++i) {
+                    epoch = this->readers[i].epoch.load(std::memory_order_seq_cst);
+                    if (epoch != 0 && epoch < minEpoch) {
+                        minEpoch = epoch;
+                    }
+                }
+
+                {
+                    std::lock_guard<std::mutex> lck(this->limboLock);
+                    for (std::size_t i = 0; i < this->limbo.size(); ++i) {
+                        if (this->limbo[i].epoch < minEpoch) {
+                            ready.push_back(this->limbo[i]);
+                        }
+                        else {
+                            this->limbo[kept++] = this->limbo[i];
+                        }
+                    }
+                    this->limbo.resize(kept);
+                }
+                // deleters run without the lock so they may retire more memory.
+                for (const retired_ptr& retired : ready) {
+                    retired.deleter(retired.ptr);
+                }
+            }
+
+            void epoch_manager::synchronize() {
+                unsigned long long epoch = this->globalEpoch.fetch_add(1, std::memory_order_seq_cst);
+                unsigned long long seen;
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                for (int i = 0; i < MAX_READERS; ++i) {
+                    seen = this->readers[i].epoch.load(std::memory_order_seq_cst);
+                    while (seen != 0 && seen <= epoch) {
+                        std::this_thread::yield();
+                        seen = this->readers[i].epoch.load(std::memory_order_seq_cst);
+                    }
+                }
+                while (this->overflowReaders.load(std::memory_order_seq_cst) > 0) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,162 @@
+#include "corelink/objects/generics/latency_histogram.h"
+
+#include <cmath>
+
+namespace CorelinkDLL {
+    namespace Object {
+        namespace Generic {
+            /// Bytes of MAGIC, VERSION and SUB_BITS at the start of an export.
+            static const int EXPORT_HEADER_SIZE = 6;
+
+            static void writeVarint(std::string& out, std::uint64_t value) {
+                while (value >= 0x80) {
+                    out += (char) ((value & 0x7F) | 0x80);
+                    value >>= 7;
+                }
+                out += (char) value;
+            }
+
+            /**
+             * @return False if the varint is truncated or longer than 64 bits.
+             */
+            static bool readVarint(const unsigned char*& data, const unsigned char* end, std::uint64_t& value) {
+                value = 0;
+                for (int shift = 0; shift < 64 && data < end; shift += 7) {
+                    value |= (std::uint64_t) (*data & 0x7F) << shift;
+                    if ((*data++ & 0x80) == 0) { return true; }
+                }
+                return false;
+            }
+
+            latency_histogram::latency_histogram() {
+                for (int i = 0; i < BUCKETS; ++i) {
+                    this->counts[i].store(0, std::memory_order_relaxed);
+                }
+            }
+
+            void latency_histogram::merge(const latency_histogram& other) {
+                std::uint64_t count;
+                for (int i = 0; i < BUCKETS; ++i) {
+                    if ((count = other.counts[i].load(std::memory_order_relaxed)) > 0) {
+                        this->counts[i].fetch_add(count, std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            void latency_histogram::reset() {
+                for (int i = 0; i < BUCKETS; ++i) {
+                    this->counts[i].store(0, std::memory_order_relaxed);
+                }
+            }
+
+            std::uint64_t latency_histogram::getCount() const {
+                std::uint64_t total = 0;
+                for (int i = 0; i < BUCKETS; ++i) {
+                    total += this->counts[i].load(std::memory_order_relaxed);
+                }
+                return total;
+            }
+
+            double latency_histogram::getMean() const {
+                std::uint64_t count, total = 0;
+                double sum = 0;
+                for (int i = 0; i < BUCKETS; ++i) {
+                    if ((count = this->counts[i].load(std::memory_order_relaxed)) == 0) { continue; }
+                    total += count;
+                    sum += count * ((double) bucketLow(i) + bucketHigh(i)) / 2;
+                }
+                return total == 0 ? 0 : sum / total;
+            }
+
+            std::uint64_t latency_histogram::getMin() const {
+                for (int i = 0; i < BUCKETS; ++i) {
+                    if (this->counts[i].load(std::memory_order_relaxed) > 0) { return bucketLow(i); }
+                }
+                return 0;
+            }
+
+            std::uint64_t latency_histogram::getMax() const {
+                for (int i = BUCKETS - 1; i >= 0; --i) {
+                    if (this->counts[i].load(std::memory_order_relaxed) > 0) { return bucketHigh(i); }
+                }
+                return 0;
+            }
+
+            std::uint64_t latency_histogram::getPercentile(double percent) const {
+                std::uint64_t snapshot[BUCKETS];
+                std::uint64_t total = 0, rank, seen = 0;
+                int last = 0;
+                for (int i = 0; i < BUCKETS; ++i) {
+                    snapshot[i] = this->counts[i].load(std::memory_order_relaxed);
+                    total += snapshot[i];
+                }
+                if (total == 0) { return 0; }
+                percent = percent < 0 ? 0 : percent > 100 ? 100 : percent;
+                // smallest rank with at least percent of the values at or below it.
+                rank = (std::uint64_t) std::ceil(percent / 100.0 * total);
+                if (rank == 0) { rank = 1; }
+                for (int i = 0; i < BUCKETS; ++i) {
+                    if (snapshot[i] == 0) { continue; }
+                    last = i;
+                    seen += snapshot[i];
+                    if (seen >= rank) { return bucketHigh(i); }
+                }
+                return bucketHigh(last);
+            }
+
+            void latency_histogram::serialize(std::string& out) const {
+                std::uint64_t count;
+                int previous = -1;
+                out.clear();
+                for (int i = 0; i < 4; ++i) {
+                    out += (char) ((MAGIC >> (i * 8)) & 0xFF);
+                }
+                out += (char) VERSION;
+                out += (char) SUB_BITS;
+                for (int i = 0; i < BUCKETS; ++i) {
+                    if ((count = this->counts[i].load(std::memory_order_relaxed)) == 0) { continue; }
+                    writeVarint(out, (std::uint64_t) (i - previous - 1));
+                    writeVarint(out, count);
+                    previous = i;
+                }
+            }
+
+            bool latency_histogram::deserialize(const char* data, int len) {
+                const unsigned char* p = (const unsigned char*) data;
+                const unsigned char* end = p + len;
+                std::vector<std::pair<int, std::uint64_t>> entries;
+                std::uint64_t gap, count;
+                std::uint32_t magic;
+                int index = -1;
+                if (data == nullptr || len < EXPORT_HEADER_SIZE) { return false; }
+                magic = (std::uint32_t) p[0] | ((std::uint32_t) p[1] << 8) | ((std::uint32_t) p[2] << 16) | ((std::uint32_t) p[3] << 24);
+                if (magic != MAGIC || p[4] != VERSION || p[5] != SUB_BITS) { return false; }
+                p += EXPORT_HEADER_SIZE;
+                while (p < end) {
+                    if (!readVarint(p, end, gap) || !readVarint(p, end, count) || gap >= (std::uint64_t) (BUCKETS - 1 - index)) {
+                        return false;
+                    }
+                    index += (int) gap + 1;
+                    entries.push_back(std::pair<int, std::uint64_t>(index, count));
+                }
+                for (const std::pair<int, std::uint64_t>& entry : entries) {
+                    this->counts[entry.first].fetch_add(entry.second, std::memory_order_relaxed);
+                }
+                return true;
+            }
+
+            std::uint64_t latency_histogram::bucketLow(int index) {
+                int shift = (index >> SUB_BITS) - 1;
+                if (shift <= 0) { return (std::uint64_t) index; }
+                return ((std::uint64_t) SUB_COUNT + (index & (SUB_COUNT - 1))) << shift;
+            }
+
+            std::uint64_t latency_histogram::bucketHigh(int index) {
+                int shift = (index >> SUB_BITS) - 1;
+                if (shift <= 0) { return (std::uint64_t) index; }
+                // wraps to 2^64 - 1 for the last bucket.
+                return bucketLow(index) + ((std::uint64_t) 1 << shift) - 1;
+            }
+        }
+    }
+}
@@ -1,4 +1,5 @@
 #include "corelink/objects/init.h"
+#include "corelink/objects/metrics_registry.h"
 
 namespace CorelinkDLL {
     CorelinkDLL::Object::initialization_data initData;
@@ -104,27 +105,83 @@ namespace CorelinkDLL {
 }
 
 namespace CorelinkDLL {
+    /**
+     * Errors passed to the wrapper. Outlives client init and cleanup.
+     */
+    static CorelinkDLL::Object::error_ring errorRing;
+
+    /**
+     * Counter name of each ErrorCode.
+     */
+    static const char* const errorMetricNames[] = {
+        "errors.unknown", "errors.state", "errors.value", "errors.socket", "errors.comm", "errors.notoken"
+    };
+
+    /**
+     * Counts the error in the metrics registry.
+     */
+    static void countError(int errorCode) {
+        static const std::vector<std::shared_ptr<CorelinkDLL::Object::metric_counter>> counters = []() {
+            std::vector<std::shared_ptr<CorelinkDLL::Object::metric_counter>> created;
+            for (int i = 0; i < (int) ErrorCode::LAST; ++i) {
+                created.push_back(CorelinkDLL::Object::metrics_registry::instance().counter(errorMetricNames[i]));
+            }
+            return created;
+        }();
+        if (errorCode < 0 || errorCode >= (int) counters.size()) { errorCode = ERROR_CODE_NONE; }
+        counters[errorCode]->add(1);
+    }
+
+    unsigned int addError(const char* location, const char* msg, int errorCode, int sysError) {
+        countError(errorCode);
+        return errorRing.add(location, msg, (int) strlen(msg), errorCode, sysError);
+    }
+
     unsigned int addError(const std::string& error, int errorCode) {
-        return initData.msgHandler.add(error + char(errorCode));
+        countError(errorCode);
+        return errorRing.add(nullptr, error.c_str(), (int) error.size(), errorCode, 0);
     }
 
     EXPORTED char* getError(const unsigned int& errorID, int& errorLen) {
-        std::string error;
+        CorelinkDLL::Object::error_record record;
         char* buffer;
-        error = initData.msgHandler.get(errorID);
-        errorLen = (int) error.size();
+        if (!errorRing.get(errorID, record, true)) {
+            errorLen = 0;
+            return nullptr;
+        }
+        errorLen = record.format(nullptr);
         buffer = new char[errorLen];
-        memcpy(buffer, error.c_str(), errorLen);
+        record.format(buffer);
         return buffer;
     }
 
     EXPORTED int getErrorLen(const unsigned int& errorID) {
-        return initData.msgHandler.getLen(errorID);
+        CorelinkDLL::Object::error_record record;
+        return errorRing.get(errorID, record, false) ? record.format(nullptr) : -1;
     }
     
     EXPORTED bool getErrorStr(const unsigned int& errorID, char* buffer) {
-        bool success = initData.msgHandler.getStr(errorID, buffer);
-        initData.msgHandler.remove(errorID);
-        return success;
+        CorelinkDLL::Object::error_record record;
+        if (!errorRing.get(errorID, record, true)) { return false; }
+        record.format(buffer);
+        return true;
+    }
+
+    EXPORTED bool getErrorInfo(const unsigned int& errorID, int& code, int& sysError, long long& timestamp) {
+        CorelinkDLL::Object::error_record record;
+        if (!errorRing.get(errorID, record, false)) { return false; }
+        code = record.code;
+        sysError = record.sysError;
+        timestamp = record.timestamp;
+        return true;
+    }
+
+    EXPORTED void discardError(const unsigned int& errorID) {
+        CorelinkDLL::Object::error_record record;
+        errorRing.get(errorID, record, true);
+    }
+
+    EXPORTED unsigned long long getErrorDropCount() {
+        return errorRing.getDropped();
     }
 }
\ No newline at end of file
@@ -0,0 +1,192 @@
+#include "corelink/objects/metrics_registry.h"
+
+namespace CorelinkDLL {
+    namespace Object {
+        std::atomic<int> metric_counter::nextShard(0);
+
+        metric_counter::metric_counter() {
+            for (int i = 0; i < SHARDS; ++i) {
+                this->shards[i].value.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        std::int64_t metric_counter::get() const {
+            std::int64_t total = 0;
+            for (int i = 0; i < SHARDS; ++i) {
+                total += this->shards[i].value.load(std::memory_order_relaxed);
+            }
+            return total;
+        }
+
+        metric_gauge::metric_gauge() : value(0) {}
+
+        void metric_gauge::set(std::int64_t value) {
+            this->value.store(value, std::memory_order_relaxed);
+        }
+
+        void metric_gauge::add(std::int64_t value) {
+            this->value.fetch_add(value, std::memory_order_relaxed);
+        }
+
+        std::int64_t metric_gauge::get() const {
+            return this->value.load(std::memory_order_relaxed);
+        }
+
+        metrics_registry& metrics_registry::instance() {
+            static metrics_registry registry;
+            return registry;
+        }
+
+        std::shared_ptr<metric_counter> metrics_registry::counter(const std::string& name) {
+            std::lock_guard<std::mutex> lck(this->lock);
+            std::map<std::string, metric_entry>::iterator iter = this->metrics.find(name);
+            if (iter == this->metrics.end()) {
+                metric_entry& entry = this->metrics[name];
+                entry.kind = MetricKind::COUNTER;
+                entry.counter = std::make_shared<metric_counter>();
+                return entry.counter;
+            }
+            return iter->second.kind == MetricKind::COUNTER ? iter->second.counter : std::make_shared<metric_counter>();
+        }
+
+        std::shared_ptr<metric_gauge> metrics_registry::gauge(const std::string& name) {
+            std::lock_guard<std::mutex> lck(this->lock);
+            std::map<std::string, metric_entry>::iterator iter = this->metrics.find(name);
+            if (iter == this->metrics.end()) {
+                metric_entry& entry = this->metrics[name];
+                entry.kind = MetricKind::GAUGE;
+                entry.gauge = std::make_shared<metric_gauge>();
+                return entry.gauge;
+            }
+            return iter->second.kind == MetricKind::GAUGE ? iter->second.gauge : std::make_shared<metric_gauge>();
+        }
+
+        std::shared_ptr<CorelinkDLL::Object::Generic::latency_histogram> metrics_registry::histogram(const std::string& name) {
+            std::lock_guard<std::mutex> lck(this->lock);
+            std::map<std::string, metric_entry>::iterator iter = this->metrics.find(name);
+            if (iter == this->metrics.end()) {
+                metric_entry& entry = this->metrics[name];
+                entry.kind = MetricKind::HISTOGRAM;
+                entry.histogram = std::make_shared<CorelinkDLL::Object::Generic::latency_histogram>();
+                return entry.histogram;
+            }
+            return iter->second.kind == MetricKind::HISTOGRAM ? iter->second.histogram :
+                std::make_shared<CorelinkDLL::Object::Generic::latency_histogram>();
+        }
+
+        void metrics_registry::addSampler(const std::string& name, Sampler sampler) {
+            metric_entry entry;
+            entry.kind = MetricKind::SAMPLER;
+            entry.sampler = std::move(sampler);
+            std::lock_guard<std::mutex> lck(this->lock);
+            this->metrics[name] = std::move(entry);
+        }
+
+        void metrics_registry::remove(const std::string& name) {
+            std::lock_guard<std::mutex> lck(this->lock);
+            this->metrics.erase(name);
+        }
+
+        void metrics_registry::removePrefix(const std::string& prefix) {
+            std::lock_guard<std::mutex> lck(this->lock);
+            std::map<std::string, metric_entry>::iterator iter = this->metrics.lower_bound(prefix);
+            while (iter != this->metrics.end() && iter->first.compare(0, prefix.size(), prefix) == 0) {
+                iter = this->metrics.erase(iter);
+            }
+        }
+
+        bool metrics_registry::getValue(const std::string& name, std::int64_t& value) {
+            std::lock_guard<std::mutex> lck(this->lock);
+            std::map<std::string, metric_entry>::iterator iter = this->metrics.find(name);
+            if (iter == this->metrics.end()) { return false; }
+            switch (iter->second.kind) {
+            case MetricKind::COUNTER:
+                value = iter->second.counter->get();
+                return true;
+            case MetricKind::GAUGE:
+                value = iter->second.gauge->get();
+                return true;
+            case MetricKind::SAMPLER:
+                value = iter->second.sampler();
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        void metrics_registry::snapshot(std::string& out) {
+            rapidjson::StringBuffer buffer;
+            rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+            std::lock_guard<std::mutex> lck(this->lock);
+
+            writer.StartObject();
+            writer.Key("time");
+            writer.Int64(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+            writer.Key("counters");
+            writer.StartObject();
+            for (const std::pair<const std::string, metric_entry>& metric : this->metrics) {
+                if (metric.second.kind != MetricKind::COUNTER) { continue; }
+                writer.Key(metric.first.c_str(), (rapidjson::SizeType) metric.first.size());
+                writer.Int64(metric.second.counter->get());
+            }
+            writer.EndObject();
+            writer.Key("gauges");
+            writer.StartObject();
+            for (const std::pair<const std::string, metric_entry>& metric : this->metrics) {
+                if (metric.second.kind != MetricKind::GAUGE && metric.second.kind != MetricKind::SAMPLER) { continue; }
+                writer.Key(metric.first.c_str(), (rapidjson::SizeType) metric.first.size());
+                writer.Int64(metric.second.kind == MetricKind::GAUGE ? metric.second.gauge->get() : metric.second.sampler());
+            }
+            writer.EndObject();
+            writer.Key("histograms");
+            writer.StartObject();
+            for (const std::pair<const std::string, metric_entry>& metric : this->metrics) {
+                if (metric.second.kind != MetricKind::HISTOGRAM) { continue; }
+                const CorelinkDLL::Object::Generic::latency_histogram& histogram = *metric.second.histogram;
+                writer.Key(metric.first.c_str(), (rapidjson::SizeType) metric.first.size());
+                writer.StartObject();
+                writer.Key("count");
+                writer.Uint64(histogram.getCount());
+                writer.Key("mean");
+                writer.Double(histogram.getMean());
+                writer.Key("min");
+                writer.Uint64(histogram.getMin());
+                writer.Key("p50");
+                writer.Uint64(histogram.getPercentile(50));
+                writer.Key("p90");
+                writer.Uint64(histogram.getPercentile(90));
+                writer.Key("p99");
+                writer.Uint64(histogram.getPercentile(99));
+                writer.Key("max");
+                writer.Uint64(histogram.getMax());
+                writer.EndObject();
+            }
+            writer.EndObject();
+            writer.EndObject();
+            out.assign(buffer.GetString(), buffer.GetSize());
+        }
+
+        stream_counters::stream_counters() : packets(std::make_shared<metric_counter>()),
+            bytes(std::make_shared<metric_counter>()), drops(std::make_shared<metric_counter>()) {}
+
+        void stream_counters::attach(const STREAM_ID& streamID) {
+            std::string prefix = "stream." + std::to_string(streamID) + ".";
+            metrics_registry& registry = metrics_registry::instance();
+            this->packets = registry.counter(prefix + "packets");
+            this->bytes = registry.counter(prefix + "bytes");
+            this->drops = registry.counter(prefix + "drops");
+        }
+
+        void stream_counters::detach(const STREAM_ID& streamID) {
+            metrics_registry::instance().removePrefix("stream." + std::to_string(streamID) + ".");
+        }
+
+        thread_metric::thread_metric(const char* role) : gauge(metrics_registry::instance().gauge(std::string("threads.") + role)) {
+            this->gauge->add(1);
+        }
+
+        thread_metric::~thread_metric() {
+            this->gauge->add(-1);
+        }
+    }
+}
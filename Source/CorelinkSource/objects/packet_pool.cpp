@@ -0,0 +1,209 @@
+#include "corelink/objects/packet_pool.h"
+
+#include <new>
+
+namespace CorelinkDLL {
+    namespace Object {
+        packet_pool::thread_cache::thread_cache() : closed(false) {
+            for (int i = 0; i < CLASSES; ++i) {
+                this->heads[i] = nullptr;
+                this->counts[i] = 0;
+            }
+        }
+
+        packet_pool::thread_cache::~thread_cache() {
+            packet_pool& pool = packet_pool::instance();
+            for (int i = 0; i < CLASSES; ++i) {
+                pool.flush(*this, i, 0);
+            }
+            this->closed = true;
+        }
+
+        packet_pool& packet_pool::instance() {
+            static packet_pool pool;
+            return pool;
+        }
+
+        packet_pool::packet_pool() {
+            metrics_registry& registry = metrics_registry::instance();
+            this->hits = registry.counter("pool.hits");
+            this->misses = registry.counter("pool.misses");
+            this->oversize = registry.counter("pool.oversize");
+            this->released = std::make_shared<metric_counter>();
+            this->blocks = registry.gauge("pool.blocks");
+            this->bytes = registry.gauge("pool.bytes");
+            registry.addSampler("pool.in_use", [this]() { return this->getInUse(); });
+        }
+
+        packet_pool::~packet_pool() {
+            packet_block* block;
+            metrics_registry::instance().remove("pool.in_use");
+            for (int i = 0; i < CLASSES; ++i) {
+                while ((block = this->shared[i].head) != nullptr) {
+                    this->shared[i].head = block->next;
+                    this->deallocate(block);
+                }
+                this->shared[i].count = 0;
+            }
+        }
+
+        packet_pool::thread_cache& packet_pool::localCache() {
+            static thread_local thread_cache cache;
+            return cache;
+        }
+
+        int packet_pool::cacheLimit(int sizeClass) {
+            int limit = CACHE_BYTES / classSize(sizeClass);
+            if (limit > CACHE_LIMIT) { return CACHE_LIMIT; }
+            return limit < 2 ? 2 : limit;
+        }
+
+        packet_buffer packet_pool::acquire(int len) {
+            packet_block* block;
+            int sizeClass = 0;
+            if (len < 0) { len = 0; }
+            while (sizeClass < CLASSES && len > classSize(sizeClass)) { ++sizeClass; }
+            if (sizeClass == CLASSES) {
+                block = this->allocate(-1, len);
+                this->oversize->add(1);
+            }
+            else {
+                thread_cache& cache = localCache();
+                if (cache.heads[sizeClass] == nullptr && !cache.closed) {
+                    this->refill(cache, sizeClass);
+                }
+                if ((block = cache.heads[sizeClass]) != nullptr) {
+                    cache.heads[sizeClass] = block->next;
+                    --cache.counts[sizeClass];
+                    this->hits->add(1);
+                }
+                else {
+                    block = this->allocate(sizeClass, classSize(sizeClass));
+                    this->misses->add(1);
+                }
+            }
+            block->refs.store(1, std::memory_order_relaxed);
+            block->length = len;
+            block->next = nullptr;
+            return packet_buffer(block);
+        }
+
+        packet_buffer packet_pool::acquire(const char* data, int len) {
+            packet_buffer buffer = this->acquire(len);
+            if (buffer.size() > 0) {
+                memcpy(buffer.data(), data, buffer.size());
+            }
+            return buffer;
+        }
+
+        std::int64_t packet_pool::getInUse() const {
+            return this->hits->get() + this->misses->get() + this->oversize->get() - this->released->get();
+        }
+
+        packet_block* packet_pool::allocate(int sizeClass, int capacity) {
+            packet_block* block = new (::operator new(sizeof(packet_block) + capacity)) packet_block();
+            block->sizeClass = sizeClass;
+            block->capacity = capacity;
+            if (sizeClass >= 0) {
+                this->blocks->add(1);
+                this->bytes->add(capacity);
+            }
+            return block;
+        }
+
+        void packet_pool::deallocate(packet_block* block) {
+            if (block->sizeClass >= 0) {
+                this->blocks->add(-1);
+                this->bytes->add(-block->capacity);
+            }
+            block->~packet_block();
+            ::operator delete(block);
+        }
+
+        void packet_pool::recycle(packet_block* block) {
+            int sizeClass = block->sizeClass;
+            this->released->add(1);
+            if (sizeClass < 0) {
+                this->deallocate(block);
+                return;
+            }
+            thread_cache& cache = localCache();
+            block->next = cache.heads[sizeClass];
+            cache.heads[sizeClass] = block;
+            ++cache.counts[sizeClass];
+            if (cache.closed) {
+                this->flush(cache, sizeClass, 0);
+            }
+            else if (cache.counts[sizeClass] > cacheLimit(sizeClass)) {
+                // keep half so the next few frees do not flush again.
+                this->flush(cache, sizeClass, cacheLimit(sizeClass) / 2);
+            }
+        }
+
+        void packet_pool::flush(thread_cache& cache, int sizeClass, int keep) {
+            shared_list& list = this->shared[sizeClass];
+            packet_block* first;
+            packet_block* last;
+            int moved = cache.counts[sizeClass] - keep;
+            int room;
+            if (moved <= 0) { return; }
+            if (keep == 0) {
+                first = cache.heads[sizeClass];
+                cache.heads[sizeClass] = nullptr;
+            }
+            else {
+                last = cache.heads[sizeClass];
+                for (int i = 1; i < keep; ++i) { last = last->next; }
+                first = last->next;
+                last->next = nullptr;
+            }
+            cache.counts[sizeClass] = keep;
+            last = first;
+            for (int i = 1; i < moved; ++i) { last = last->next; }
+            {
+                std::lock_guard<std::mutex> lck(list.lock);
+                // the shared list only has to cover threads trading blocks, whatever does not fit is freed.
+                room = cacheLimit(sizeClass) * SHARED_CACHES - list.count;
+                if (room >= moved) {
+                    last->next = list.head;
+                    list.head = first;
+                    list.count += moved;
+                    first = nullptr;
+                }
+                else if (room > 0) {
+                    last = first;
+                    for (int i = 1; i < room; ++i) { last = last->next; }
+                    packet_block* excess = last->next;
+                    last->next = list.head;
+                    list.head = first;
+                    list.count += room;
+                    first = excess;
+                }
+            }
+            while (first != nullptr) {
+                last = first;
+                first = first->next;
+                this->deallocate(last);
+            }
+        }
+
+        void packet_pool::refill(thread_cache& cache, int sizeClass) {
+            shared_list& list = this->shared[sizeClass];
+            packet_block* last;
+            int batch = cacheLimit(sizeClass) / 2;
+            int taken = 1;
+            std::lock_guard<std::mutex> lck(list.lock);
+            if (list.head == nullptr) { return; }
+            last = list.head;
+            while (taken < batch && last->next != nullptr) {
+                last = last->next;
+                ++taken;
+            }
+            cache.heads[sizeClass] = list.head;
+            cache.counts[sizeClass] = taken;
+            list.head = last->next;
+            list.count -= taken;
+            last->next = nullptr;
+        }
+    }
+}
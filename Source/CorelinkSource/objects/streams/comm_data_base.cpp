@@ -4,17 +4,18 @@ namespace CorelinkDLL {
     namespace Object {
         namespace Stream {
             // TODO: validate if the target parameter is necessary/how is it used. (alternative would be passing json string for server data)
-            std::string comm_data_base::packageSend(const STREAM_ID& stream, const int& federationID, const std::string& msg, const std::string& json, bool serverCheck) {
+            CorelinkDLL::Object::packet_buffer comm_data_base::packageSend(const STREAM_ID& stream, const int& federationID, const char* msg, int msgLen,
+                    const char* json, int jsonLen, bool serverCheck) {
+                CorelinkDLL::Object::packet_buffer buffer;
                 char* package;
-                int len;
                 int lenHead;
                 int lenData;
                 
-                lenHead = (int) json.size();
-                lenData = (int) msg.size();
+                lenHead = jsonLen;
+                lenData = msgLen;
 
-                len = 8 + lenHead + lenData;
-                package = new char[len];
+                buffer = CorelinkDLL::Object::packet_pool::instance().acquire(PACKET_HEADER_SIZE + lenHead + lenData);
+                package = buffer.data();
 
                 // header size + set high bit if necessary
                 package[0] = (char)(lenHead >> 0);
@@ -28,13 +29,10 @@ namespace CorelinkDLL {
                 package[6] = (char)(federationID >> 0);
                 package[7] = (char)(federationID >> 8);
                 // header
-                memcpy(package + 8, json.c_str(), lenHead);
+                memcpy(package + PACKET_HEADER_SIZE, json, lenHead);
                 // data
-                memcpy(package + 8 + lenHead, msg.c_str(), lenData);
-                
-                std::string ret(package, len);
-                delete[] package;
-                return ret;
+                memcpy(package + PACKET_HEADER_SIZE + lenHead, msg, lenData);
+                return buffer;
             }
         }
     }
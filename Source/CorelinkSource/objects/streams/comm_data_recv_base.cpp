@@ -1,25 +1,41 @@
 #include "corelink/objects/streams/comm_data_recv_base.h"
+#include "corelink/objects/trace_ring.h"
 
 namespace CorelinkDLL {
     namespace Object {
         namespace Stream {
-            recv_stream_data_base::recv_stream_data_base(){
+            recv_stream_data_base::recv_stream_data_base() : injecting(0), polling(false) {
                 funcPointer = nullptr;
                 funcExtra = nullptr;
+                funcSlotDestroy = nullptr;
             }
 
-            recv_stream_data_base::recv_stream_data_base(const recv_stream_data_base& rhs) {
+            recv_stream_data_base::recv_stream_data_base(const recv_stream_data_base& rhs) : counters(rhs.counters), injecting(0), polling(false) {
+                this->funcSlotDestroy = nullptr;
+                if (rhs.funcSlotDestroy != nullptr) {
+                    this->funcPointer = nullptr;
+                    this->funcExtra = nullptr;
+                    return;
+                }
                 this->funcPointer = rhs.funcPointer;
                 this->funcExtra = rhs.funcExtra;
             }
 
             recv_stream_data_base::~recv_stream_data_base() {
+                clearSlot();
                 funcPointer = nullptr;
                 funcExtra = nullptr;
             }
 
             recv_stream_data_base& recv_stream_data_base::operator=(const recv_stream_data_base& rhs) {
                 std::lock_guard<std::mutex> lck(this->funcLock);
+                clearSlot();
+                this->counters = rhs.counters;
+                if (rhs.funcSlotDestroy != nullptr) {
+                    this->funcPointer = nullptr;
+                    this->funcExtra = nullptr;
+                    return *this;
+                }
                 this->funcPointer = rhs.funcPointer;
                 this->funcExtra = rhs.funcExtra;
                 return *this;
@@ -29,6 +45,13 @@ namespace CorelinkDLL {
                 std::lock_guard<std::mutex> lck(this->funcLock);
                 std::lock_guard<std::mutex> lckRhs(rhs.funcLock);
                 
+                clearSlot();
+                this->counters = rhs.counters;
+                if (rhs.funcSlotDestroy != nullptr) {
+                    this->funcPointer = nullptr;
+                    this->funcExtra = nullptr;
+                    return *this;
+                }
                 this->funcPointer = std::move(rhs.funcPointer);
                 this->funcExtra = std::move(rhs.funcExtra);
                 rhs.funcPointer = nullptr;
@@ -39,24 +62,150 @@ namespace CorelinkDLL {
             void* recv_stream_data_base::changeFunc(Callback _funcPointer, void* _funcExtra){
                 void* data;
                 std::lock_guard<std::mutex> lck(this->funcLock);
-                data = this->funcExtra;
+                data = clearSlot() ? nullptr : this->funcExtra;
                 this->funcPointer = _funcPointer;
                 this->funcExtra = _funcExtra;
                 return data;
             }
 
+            void* recv_stream_data_base::changeFuncInline(Callback _funcPointer, CallbackConstruct construct, CallbackDestroy destroy, void* src) {
+                void* data;
+                std::lock_guard<std::mutex> lck(this->funcLock);
+                data = clearSlot() ? nullptr : this->funcExtra;
+                construct(this->funcSlot, src);
+                this->funcSlotDestroy = destroy;
+                this->funcPointer = _funcPointer;
+                this->funcExtra = this->funcSlot;
+                return data;
+            }
+
+            bool recv_stream_data_base::clearSlot() {
+                if (this->funcSlotDestroy == nullptr) { return false; }
+                this->funcSlotDestroy(this->funcSlot);
+                this->funcSlotDestroy = nullptr;
+                this->funcPointer = nullptr;
+                this->funcExtra = nullptr;
+                return true;
+            }
+
             void recv_stream_data_base::callFunc(const STREAM_ID& recvID, const STREAM_ID& sendID, const char* data, const int& jsonLen, const int& msgLen) {
+                int headLen = jsonLen;
+                int frameLen = msgLen;
+                bool polled;
+                CORELINK_TRACE_SCOPE_ARG("dispatch", sendID);
+                this->counters.count(jsonLen + msgLen);
+                CorelinkDLL::Object::Capture::capture_recorder::capture(recvID, sendID, data, jsonLen, msgLen);
+                std::lock_guard<std::mutex> lck(this->funcLock);
+                polled = this->polling.load(std::memory_order_relaxed);
+                if (!polled && this->funcPointer == nullptr) { return; }
+                if (stream_codec::parseHeader(data, jsonLen) != CODEC_NONE &&
+                    (data = this->decoder.decode(sendID, data, headLen, frameLen)) == nullptr) {
+                    this->counters.drops->add(1);
+                    return;
+                }
+                if (polled) {
+                    CORELINK_TRACE_SCOPE("poll push");
+                    if (!this->ring->push(recvID, sendID, data, headLen, frameLen)) {
+                        this->counters.drops->add(1);
+                    }
+                    return;
+                }
+                CORELINK_TRACE_SCOPE("callback");
+                this->funcPointer(recvID, sendID, data, headLen, frameLen, this->funcExtra);
+            }
+
+            void recv_stream_data_base::resetSource(const STREAM_ID& sendID) {
+                std::lock_guard<std::mutex> lck(this->funcLock);
+                this->decoder.reset(sendID);
+            }
+
+            void recv_stream_data_base::setPolling(int capacity) {
                 std::lock_guard<std::mutex> lck(this->funcLock);
-                if (this->funcPointer != nullptr){
-                    this->funcPointer(recvID, sendID, data, jsonLen, msgLen, this->funcExtra);
+                if (capacity <= 0) {
+                    this->polling.store(false, std::memory_order_release);
+                    return;
                 }
+                // the poller may hold views into the current ring, so it is never replaced.
+                if (this->ring == nullptr) {
+                    this->ring.reset(new recv_ring(capacity));
+                }
+                this->polling.store(true, std::memory_order_release);
+            }
+
+            recv_ring* recv_stream_data_base::getRing() {
+                if (!this->polling.load(std::memory_order_acquire)) { return nullptr; }
+                return this->ring.get();
             }
 
-            comm_data_recv_base::comm_data_recv_base() : streamMap(nullptr) {}
+            comm_data_recv_base::comm_data_recv_base() : streamMap() {}
 
             void* comm_data_recv_base::setRecvCallback(int ref, const STREAM_ID& streamID, Callback recvCallback, void* callbackData) {
-                if (this->streamMap.getStream(ref) != streamID) { return nullptr; }
-                return this->streamMap.at(ref)->changeFunc(recvCallback, callbackData);
+                CorelinkDLL::Object::Generic::epoch_manager::read_guard guard;
+                recv_stream_data_base** streamData = this->streamMap.get(ref, streamID);
+                if (streamData == nullptr) { return nullptr; }
+                return (*streamData)->changeFunc(recvCallback, callbackData);
+            }
+
+            bool comm_data_recv_base::setRecvPolling(int ref, const STREAM_ID& streamID, int capacity) {
+                CorelinkDLL::Object::Generic::epoch_manager::read_guard guard;
+                recv_stream_data_base** streamData = this->streamMap.get(ref, streamID);
+                if (streamData == nullptr) { return false; }
+                (*streamData)->setPolling(capacity);
+                return true;
+            }
+
+            int comm_data_recv_base::pollMessages(int ref, const STREAM_ID& streamID, recv_message* out, int max) {
+                CorelinkDLL::Object::Generic::epoch_manager::read_guard guard;
+                recv_stream_data_base** streamData = this->streamMap.get(ref, streamID);
+                recv_ring* ring;
+                if (streamData == nullptr || (ring = (*streamData)->getRing()) == nullptr) { return -1; }
+                return ring->poll(out, max);
+            }
+
+            unsigned long long comm_data_recv_base::getPollDropped(int ref, const STREAM_ID& streamID) {
+                CorelinkDLL::Object::Generic::epoch_manager::read_guard guard;
+                recv_stream_data_base** streamData = this->streamMap.get(ref, streamID);
+                recv_ring* ring;
+                if (streamData == nullptr || (ring = (*streamData)->getRing()) == nullptr) { return 0; }
+                return ring->getDropped();
+            }
+
+            bool comm_data_recv_base::injectMsg(int ref, const STREAM_ID& streamID, const STREAM_ID& sendID, const char* data, int jsonLen, int msgLen) {
+                recv_stream_data_base* streamData;
+                {
+                    CorelinkDLL::Object::Generic::epoch_manager::read_guard guard;
+                    recv_stream_data_base** found = this->streamMap.get(ref, streamID);
+                    if (found == nullptr) { return false; }
+                    streamData = *found;
+                    streamData->injecting.fetch_add(1, std::memory_order_acquire);
+                }
+                // the callback may run long or roll a capture, which waits for every guard to leave.
+                streamData->callFunc(streamID, sendID, data, jsonLen, msgLen);
+                streamData->injecting.fetch_sub(1, std::memory_order_release);
+                return true;
+            }
+
+            void comm_data_recv_base::waitInjected(recv_stream_data_base* streamData) {
+                // callers that found the stream before it was unlinked have taken their count once their guard is gone.
+                CorelinkDLL::Object::Generic::epoch_manager::instance().synchronize();
+                while (streamData->injecting.load(std::memory_order_acquire) != 0) {
+                    std::this_thread::yield();
+                }
+            }
+
+            void comm_data_recv_base::resetSource(int ref, const STREAM_ID& streamID, const STREAM_ID& sendID) {
+                CorelinkDLL::Object::Generic::epoch_manager::read_guard guard;
+                recv_stream_data_base** streamData = this->streamMap.get(ref, streamID);
+                if (streamData == nullptr) { return; }
+                (*streamData)->resetSource(sendID);
+            }
+
+            void* comm_data_recv_base::setRecvCallbackInline(int ref, const STREAM_ID& streamID, Callback recvCallback, CallbackConstruct construct, CallbackDestroy destroy, void* src, bool& found) {
+                CorelinkDLL::Object::Generic::epoch_manager::read_guard guard;
+                recv_stream_data_base** streamData = this->streamMap.get(ref, streamID);
+                found = streamData != nullptr;
+                if (!found) { return nullptr; }
+                return (*streamData)->changeFuncInline(recvCallback, construct, destroy, src);
             }
         }
     }
@@ -1,5 +1,6 @@
 #include "corelink/objects/streams/comm_data_recv_tcp.h"
 #include "corelink/objects/streams/tcp_recv_handler.h"
+#include "corelink/objects/trace_ring.h"
 
 namespace CorelinkDLL {
     namespace Object {
@@ -44,10 +45,15 @@ namespace CorelinkDLL {
             comm_data_recv_tcp::~comm_data_recv_tcp() {}
 
             void comm_data_recv_tcp::addStream(const STREAM_ID& streamID, const std::string& ip, int port) {
-                this->streamMap.addObject(streamID, new recv_stream_data_tcp(ip, port));
-                int ref = this->streamMap.getStreamRedirect(streamID);
-                CorelinkDLL::setRecvSocketOpts(((recv_stream_data_tcp*)this->streamMap.at(ref))->sock);
-                ((recv_stream_data_tcp*)this->streamMap.at(ref))->listener = std::thread(&comm_data_recv_tcp::recvFunc, this, ref);
+                recv_stream_data_tcp* streamData = new recv_stream_data_tcp(ip, port);
+                streamData->counters.attach(streamID);
+                if (this->streamMap.addObject(streamID, streamData) == -1) {
+                    closesocket(streamData->sock);
+                    delete streamData;
+                    return;
+                }
+                CorelinkDLL::setRecvSocketOpts(streamData->sock);
+                streamData->listener = std::thread(&comm_data_recv_tcp::recvFunc, this, streamData, streamID);
             }
 
             int comm_data_recv_tcp::getStreamRef(const STREAM_ID& streamID) {
@@ -56,7 +62,16 @@ namespace CorelinkDLL {
 
             void comm_data_recv_tcp::rmStream(const STREAM_ID& streamID) {
                 int ref = this->streamMap.getStreamRedirect(streamID);
-                recv_stream_data_tcp* streamData = (recv_stream_data_tcp*)this->streamMap.at(ref);
+                recv_stream_data_tcp* streamData;
+                {
+                    CorelinkDLL::Object::Generic::epoch_manager::read_guard guard;
+                    recv_stream_data_base** found = this->streamMap.get(ref, streamID);
+                    if (found == nullptr) { return; }
+                    streamData = (recv_stream_data_tcp*) *found;
+                }
+                // unlink first so no new caller can reach the stream while it shuts down.
+                this->streamMap.rmObjectIndex(ref);
+                CorelinkDLL::Object::stream_counters::detach(streamID);
                 SOCKET sock = streamData->sock;
                 streamData->sock = INVALID_SOCKET;
                 shutdown(sock, SD_BOTH);
@@ -64,33 +79,34 @@ namespace CorelinkDLL {
                 if (streamData->listener.joinable()) {
                     streamData->listener.join();
                 }
-                this->streamMap.rmObjectIndex(ref);
-                delete streamData;
+                waitInjected(streamData);
+                CorelinkDLL::Object::Generic::epoch_manager::instance().retire(streamData);
             }
 
-            void comm_data_recv_tcp::recvFunc(int ref) {
-                recv_stream_data_tcp* streamData = (recv_stream_data_tcp*)this->streamMap.at(ref);
+            void comm_data_recv_tcp::recvFunc(recv_stream_data_tcp* streamData, STREAM_ID streamID) {
+                CORELINK_TRACE_THREAD("tcp recv");
+                CorelinkDLL::Object::thread_metric threadMetric("tcp_recv");
                 tcp_recv_handler recvHandler = tcp_recv_handler(streamData->sock);
-                STREAM_ID streamID = this->streamMap.getStream(ref);
 
                 int bytesRecieved;
-                char* tmpArr;
-                unsigned char* dataArr;
+                CorelinkDLL::Object::packet_buffer body;
+                unsigned char dataArr[4];
                 int source;
                 int hdrLen;
                 int msgLen;
                 int totLen;
 
-                std::string package = packageSend(streamID, 0, "");
+                CorelinkDLL::Object::packet_buffer package = packageSend(streamID, 0, "", 0);
                 msgLen = 0;
                 while (streamData->sock != INVALID_SOCKET && msgLen < package.size()) {
-                    totLen = send(streamData->sock, package.c_str() + msgLen, package.size() - msgLen, 0);
+                    totLen = send(streamData->sock, package.data() + msgLen, package.size() - msgLen, 0);
                     if (totLen == -1) {
                         //something went wrong. silent failure
                         return;
                     }
                     msgLen += totLen;
                 }
+                package.reset();
                 
                 totLen = -1;
                 rapidjson::Document json;
@@ -98,25 +114,25 @@ namespace CorelinkDLL {
 
                 while (streamData->sock != INVALID_SOCKET) {
                     if (totLen == -1 && recvHandler.size() > 4) {
-                        dataArr = (unsigned char*)recvHandler.getData(4);
+                        recvHandler.getData((char*) dataArr, 4);
                         hdrLen = dataArr[0] + (dataArr[1] << 8);
                         msgLen = dataArr[2] + (dataArr[3] << 8);
                         totLen = hdrLen + msgLen + 4;
-                        delete[] dataArr;
                     }
 
                     if (totLen > 0 && totLen <= recvHandler.size()) {
-                        dataArr = (unsigned char*)recvHandler.getData(4, 0);
+                        CORELINK_TRACE_SCOPE_ARG("tcp packet", totLen);
+                        recvHandler.getData((char*) dataArr, 4);
                         source = dataArr[0] + (dataArr[1] << 8) + (dataArr[2] << 16) + (dataArr[3] << 24);
-                        tmpArr = recvHandler.getData(hdrLen + msgLen, 0);
+                        body = recvHandler.getData(hdrLen + msgLen, 0);
                         // take off high bit 
-                        streamData->callFunc(streamID, source, tmpArr, hdrLen & 32767, msgLen);
-                        delete[] dataArr;
-                        delete[] tmpArr;
+                        streamData->callFunc(streamID, source, body.data(), hdrLen & 32767, msgLen);
+                        body.reset();
                         totLen = -1;
                         continue;
                     }
                     recvHandler.recvData(bytesRecieved);
+                    CORELINK_TRACE_INSTANT("tcp recv", bytesRecieved);
                 }
             }
         }
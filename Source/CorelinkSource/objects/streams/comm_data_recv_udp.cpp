@@ -1,4 +1,5 @@
 #include "corelink/objects/streams/comm_data_recv_udp.h"
+#include "corelink/objects/trace_ring.h"
 
 namespace CorelinkDLL {
     namespace Object {
@@ -41,9 +42,14 @@ namespace CorelinkDLL {
             comm_data_recv_udp::~comm_data_recv_udp() {}
 
             void comm_data_recv_udp::addStream(const STREAM_ID& streamID, const std::string& ip, int port) {
-                this->streamMap.addObject(streamID, new recv_stream_data_udp(port));
-                int ref = this->streamMap.getStreamRedirect(streamID);
-                ((recv_stream_data_udp*)this->streamMap.at(ref))->listener = std::thread(&comm_data_recv_udp::recvFunc, this, ref, ip);
+                recv_stream_data_udp* streamData = new recv_stream_data_udp(port);
+                streamData->counters.attach(streamID);
+                if (this->streamMap.addObject(streamID, streamData) == -1) {
+                    closesocket(streamData->sock);
+                    delete streamData;
+                    return;
+                }
+                streamData->listener = std::thread(&comm_data_recv_udp::recvFunc, this, streamData, streamID, ip);
             }
 
             int comm_data_recv_udp::getStreamRef(const STREAM_ID& streamID) {
@@ -52,7 +58,16 @@ namespace CorelinkDLL {
 
             void comm_data_recv_udp::rmStream(const STREAM_ID& streamID) {
                 int ref = this->streamMap.getStreamRedirect(streamID);
-                recv_stream_data_udp* streamData = (recv_stream_data_udp*)this->streamMap.at(ref);
+                recv_stream_data_udp* streamData;
+                {
+                    CorelinkDLL::Object::Generic::epoch_manager::read_guard guard;
+                    recv_stream_data_base** found = this->streamMap.get(ref, streamID);
+                    if (found == nullptr) { return; }
+                    streamData = (recv_stream_data_udp*) *found;
+                }
+                // unlink first so no new caller can reach the stream while it shuts down.
+                this->streamMap.rmObjectIndex(ref);
+                CorelinkDLL::Object::stream_counters::detach(streamID);
                 SOCKET sock = streamData->sock;
                 streamData->sock = INVALID_SOCKET;
                 streamData->nsPort = INVALID_PORT;
@@ -61,22 +76,22 @@ namespace CorelinkDLL {
                 if (streamData->listener.joinable()) {
                     streamData->listener.join();
                 }
-                this->streamMap.rmObjectIndex(ref);
-                delete streamData;
+                waitInjected(streamData);
+                CorelinkDLL::Object::Generic::epoch_manager::instance().retire(streamData);
             }
 
-            void comm_data_recv_udp::recvFunc(int ref, const std::string& ip) {
-                recv_stream_data_udp* streamData = (recv_stream_data_udp*)this->streamMap.at(ref);
-                STREAM_ID streamID = this->streamMap.getStream(ref);
-
+            void comm_data_recv_udp::recvFunc(recv_stream_data_udp* streamData, STREAM_ID streamID, const std::string& ip) {
+                CORELINK_TRACE_THREAD("udp recv");
+                CorelinkDLL::Object::thread_metric threadMetric("udp_recv");
                 sockaddr_in hint;
                 hint.sin_family = AF_INET;
                 inet_pton(AF_INET, ip.c_str(), &hint.sin_addr);
                 hint.sin_port = streamData->nsPort;
 
                 socklen_t addrlen = sizeof(hint);
-                std::string package = packageSend(streamID, 0, "");
-                sendto(streamData->sock, package.c_str(), package.size(), 0, (sockaddr*)&hint, addrlen);
+                CorelinkDLL::Object::packet_buffer package = packageSend(streamID, 0, "", 0);
+                sendto(streamData->sock, package.data(), package.size(), 0, (sockaddr*)&hint, addrlen);
+                package.reset();
 
                 int bytesRecieved;
                 char* buffer;
@@ -100,10 +115,15 @@ namespace CorelinkDLL {
                 while ((sock = streamData->sock) != INVALID_SOCKET) {
                     bytesRecieved = recvfrom(sock, buffer, SOCKET_RECV_BUFFER_SIZE, 0, (sockaddr*)&hint, &addrlen);
                     if (bytesRecieved <= 0) { continue; }
+                    CORELINK_TRACE_SCOPE_ARG("udp packet", bytesRecieved);
                     hdrLen = bufferCasted[0] + (bufferCasted[1] << 8);
                     msgLen = bufferCasted[2] + (bufferCasted[3] << 8);
 
-                    if (hdrLen + msgLen + 8 != bytesRecieved) { continue; }
+                    if (hdrLen + msgLen + 8 != bytesRecieved) {
+                        CORELINK_TRACE_INSTANT("udp invalid", bytesRecieved);
+                        streamData->counters.drops->add(1);
+                        continue;
+                    }
                     source = bufferCasted[4] + (bufferCasted[5] << 8) + (bufferCasted[6] << 16) + (bufferCasted[7] << 24);
                     // take off high bit
                     streamData->callFunc(streamID, source, buffer + 8, hdrLen & 32767, msgLen);
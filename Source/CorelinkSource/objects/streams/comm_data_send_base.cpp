@@ -1 +1,29 @@
-#include "corelink/objects/streams/comm_data_send_base.h"
\ No newline at end of file
+#include "corelink/objects/streams/comm_data_send_base.h"
+
+namespace CorelinkDLL {
+    namespace Object {
+        namespace Stream {
+            CorelinkDLL::Object::packet_buffer comm_data_send_base::packageSendCodec(const std::shared_ptr<stream_encoder>& encoder, const STREAM_ID& streamID, const int& federationID,
+                    const char* msg, int msgLen, const char* json, int jsonLen, bool serverCheck) {
+                // the codec frame would not fit the 16 bit data length, such messages go out raw.
+                if (!encoder || msgLen > stream_codec::MAX_MESSAGE_SIZE) {
+                    return packageSend(streamID, federationID, msg, msgLen, json, jsonLen, serverCheck);
+                }
+                // frames are copied into the package, reusing the strings keeps their capacity between messages.
+                static thread_local std::string frame;
+                static thread_local std::string frameJson;
+                encoder->encode(msg, msgLen, json, jsonLen, frame, frameJson);
+                return packageSend(streamID, federationID, frame.c_str(), (int) frame.size(), frameJson.c_str(), (int) frameJson.size(), serverCheck);
+            }
+
+            std::shared_ptr<stream_encoder> comm_data_send_base::createEncoder(int codec, int keyInterval) {
+                if (codec <= CODEC_NONE || codec >= (int) StreamCodec::LAST) { return std::shared_ptr<stream_encoder>(nullptr); }
+                return std::make_shared<stream_encoder>(codec, keyInterval);
+            }
+
+            bool comm_data_send_base::setDirectSend(int, const STREAM_ID&, bool) {
+                return false;
+            }
+        }
+    }
+}
@@ -1,17 +1,20 @@
 #include "corelink/objects/streams/comm_data_send_tcp.h"
+#include "corelink/objects/trace_ring.h"
 
 namespace CorelinkDLL {
     namespace Object {
         namespace Stream {
             comm_data_send_tcp::comm_data_send_tcp() {
                 this->running = true;
+                CorelinkDLL::Object::metrics_registry::instance().addSampler("send.tcp.queue", [this]() { return (std::int64_t) this->sendQueue.size(); });
                 this->sendThread = std::thread(&comm_data_send_tcp::sendFunc, this);
             }
 
             comm_data_send_tcp::~comm_data_send_tcp() {
+                CorelinkDLL::Object::metrics_registry::instance().remove("send.tcp.queue");
                 this->running = false;
                 this->sendQueue.clear();
-                this->sendQueue.enqueue(std::pair<SOCKET, std::string>(INVALID_SOCKET, ""));
+                this->sendQueue.enqueue(std::pair<SOCKET, CorelinkDLL::Object::packet_buffer>(INVALID_SOCKET, CorelinkDLL::Object::packet_buffer()));
                 if (this->sendThread.joinable()) {
                     this->sendThread.join();
                 }
@@ -19,7 +22,9 @@ namespace CorelinkDLL {
             }
 
             void comm_data_send_tcp::addStream(const STREAM_ID& streamID, const std::string& ip, int port) {
-                this->streamMap.addObject(streamID, DataSenderTCP(ip, port));
+                DataSenderTCP sender(ip, port);
+                sender.counters.attach(streamID);
+                this->streamMap.addObject(streamID, sender);
             }
 
             int comm_data_send_tcp::getStreamRef(const STREAM_ID& streamID) {
@@ -28,40 +33,67 @@ namespace CorelinkDLL {
 
             void comm_data_send_tcp::rmStream(const STREAM_ID& streamID) {
                 int ref = this->streamMap.getStreamRedirect(streamID);
-                closesocket(this->streamMap.at(ref).sock);
+                {
+                    CorelinkDLL::Object::Generic::epoch_manager::read_guard guard;
+                    const DataSenderTCP* sender = this->streamMap.get(ref, streamID);
+                    if (sender == nullptr) { return; }
+                    closesocket(sender->sock);
+                }
                 this->streamMap.rmObjectIndex(ref);
+                CorelinkDLL::Object::stream_counters::detach(streamID);
             }
             
-            bool comm_data_send_tcp::sendMsg(int ref, const STREAM_ID& streamID, const int& federationID, const std::string& msg) {
-                if (this->streamMap.getStream(ref) == streamID) {
-                    this->sendQueue.enqueue(std::pair<int, std::string>(this->streamMap.at(ref).sock,
-                        packageSend(streamID, federationID, msg)));
-                    return true;
-                }
-                return false;
+            bool comm_data_send_tcp::sendMsg(int ref, const STREAM_ID& streamID, const int& federationID, const char* msg, int msgLen) {
+                CorelinkDLL::Object::Generic::epoch_manager::read_guard guard;
+                const DataSenderTCP* sender = this->streamMap.get(ref, streamID);
+                if (sender == nullptr) { return false; }
+                CORELINK_TRACE_SCOPE_ARG("tcp send", streamID);
+                CorelinkDLL::Object::packet_buffer package = packageSendCodec(std::atomic_load(&sender->encoder), streamID, federationID, msg, msgLen);
+                sender->counters.count((int) package.size() - PACKET_HEADER_SIZE);
+                this->sendQueue.enqueue(std::pair<SOCKET, CorelinkDLL::Object::packet_buffer>(sender->sock, std::move(package)));
+                return true;
             }
 
-            bool comm_data_send_tcp::sendMsg(int ref, const STREAM_ID& streamID, const int& federationID, const std::string& msg, const std::string& json, bool serverCheck) {
-                if (this->streamMap.getStream(ref) == streamID) {
-                    this->sendQueue.enqueue(std::pair<int, std::string>(this->streamMap.at(ref).sock,
-                        packageSend(streamID, federationID, msg, json, serverCheck)));
-                    return true;
-                }
-                return false;
+            bool comm_data_send_tcp::sendMsg(int ref, const STREAM_ID& streamID, const int& federationID, const char* msg, int msgLen,
+                    const char* json, int jsonLen, bool serverCheck) {
+                CorelinkDLL::Object::Generic::epoch_manager::read_guard guard;
+                const DataSenderTCP* sender = this->streamMap.get(ref, streamID);
+                if (sender == nullptr) { return false; }
+                CORELINK_TRACE_SCOPE_ARG("tcp send", streamID);
+                CorelinkDLL::Object::packet_buffer package = packageSendCodec(std::atomic_load(&sender->encoder), streamID, federationID, msg, msgLen, json, jsonLen, serverCheck);
+                sender->counters.count((int) package.size() - PACKET_HEADER_SIZE);
+                this->sendQueue.enqueue(std::pair<SOCKET, CorelinkDLL::Object::packet_buffer>(sender->sock, std::move(package)));
+                return true;
+            }
+
+            bool comm_data_send_tcp::setCodec(int ref, const STREAM_ID& streamID, int codec, int keyInterval) {
+                CorelinkDLL::Object::Generic::epoch_manager::read_guard guard;
+                DataSenderTCP* sender = this->streamMap.get(ref, streamID);
+                if (sender == nullptr) { return false; }
+                std::atomic_store(&sender->encoder, createEncoder(codec, keyInterval));
+                return true;
+            }
+
+            int comm_data_send_tcp::getQueueDepth() {
+                return (int) this->sendQueue.size();
             }
 
             void comm_data_send_tcp::sendFunc() {
-                std::pair<SOCKET, std::string> message;
+                CORELINK_TRACE_THREAD("tcp send");
+                CorelinkDLL::Object::thread_metric threadMetric("tcp_send");
+                std::pair<SOCKET, CorelinkDLL::Object::packet_buffer> message;
                 int sendOk;
                 while (this->running) {
                     message = this->sendQueue.dequeue();
                     int curr = 0;
                     if (message.first == INVALID_SOCKET) { continue; }
+                    CORELINK_TRACE_SCOPE_ARG("socket send", message.second.size());
                     while (curr < message.second.size()) {
-                        sendOk = send(message.first, message.second.c_str() + curr, message.second.size() - curr, 0);
+                        sendOk = send(message.first, message.second.data() + curr, message.second.size() - curr, 0);
                         if (sendOk == SOCKET_ERROR) { break; }
                         curr += sendOk;
                     }
+                    message.second.reset();
                 }
             }
         }
@@ -1,4 +1,5 @@
 #include "corelink/objects/streams/comm_data_send_udp.h"
+#include "corelink/objects/trace_ring.h"
 
 namespace CorelinkDLL {
     namespace Object {
@@ -6,20 +7,29 @@ namespace CorelinkDLL {
             comm_data_send_udp::comm_data_send_udp(const std::string& ip, int& errorID) {
                 this->sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
                 if (this->sock == INVALID_SOCKET) {
-                    errorID = addError("comm_data_send_udp.cpp comm_data_send_udp: Socket error " + std::to_string(SOCKET_ERROR_CODE), ERROR_CODE_SOCKET);
+                    errorID = addError("comm_data_send_udp.cpp comm_data_send_udp", "Socket error", ERROR_CODE_SOCKET, SOCKET_ERROR_CODE);
                     return;
                 }
-                this->sendThread = std::thread(&comm_data_send_udp::sendFunc, this, ip);
+                // direct sends must not stall the caller, the send thread waits on the socket instead.
+                if (!setSocketNonBlocking(this->sock)) {
+                    errorID = addError("comm_data_send_udp.cpp comm_data_send_udp", "Non-blocking error", ERROR_CODE_SOCKET, SOCKET_ERROR_CODE);
+                }
+                memset(&this->serverHint, 0, sizeof(this->serverHint));
+                this->serverHint.sin_family = AF_INET;
+                inet_pton(AF_INET, ip.c_str(), &this->serverHint.sin_addr);
+                CorelinkDLL::Object::metrics_registry::instance().addSampler("send.udp.queue", [this]() { return (std::int64_t) this->sendQueue.size(); });
+                this->sendThread = std::thread(&comm_data_send_udp::sendFunc, this);
             }
 
             comm_data_send_udp::~comm_data_send_udp() {
+                CorelinkDLL::Object::metrics_registry::instance().remove("send.udp.queue");
                 if (this->sock != INVALID_SOCKET) {
                     SOCKET _sock = this->sock;
                     this->sock = INVALID_SOCKET;
                     closesocket(_sock);
                 }
                 this->sendQueue.clear();
-                this->sendQueue.enqueue(std::pair<int, std::string>(INVALID_PORT, ""));
+                this->sendQueue.enqueue(QueuedMsg{ INVALID_PORT, CorelinkDLL::Object::packet_buffer(), nullptr });
                 if (this->sendThread.joinable()) {
                     this->sendThread.join();
                 }
@@ -27,7 +37,10 @@ namespace CorelinkDLL {
             }
 
             void comm_data_send_udp::addStream(const STREAM_ID& streamID, const std::string&, int port) {
-                this->streamMap.addObject(streamID, DataSenderUDP(port));
+                DataSenderUDP sender(port);
+                sender.counters.attach(streamID);
+                sender.direct->drops = sender.counters.drops;
+                this->streamMap.addObject(streamID, sender);
             }
 
             int comm_data_send_udp::getStreamRef(const STREAM_ID& streamID) {
@@ -35,46 +48,96 @@ namespace CorelinkDLL {
             }
 
             void comm_data_send_udp::rmStream(const STREAM_ID& streamID) {
-                this->streamMap.rmObjectIndex(streamID);
+                this->streamMap.rmObjectID(streamID);
+                CorelinkDLL::Object::stream_counters::detach(streamID);
             }
 
-            bool comm_data_send_udp::sendMsg(int ref, const STREAM_ID& streamID, const int& federationID, const std::string& msg) {
-                if (this->streamMap.getStream(ref) == streamID) {
-                    this->sendQueue.enqueue(std::pair<int, std::string>(this->streamMap.at(ref).nsPort,
-                        packageSend(streamID, federationID, msg)));
-                    return true;
-                }
-                return false;
+            bool comm_data_send_udp::sendMsg(int ref, const STREAM_ID& streamID, const int& federationID, const char* msg, int msgLen) {
+                CorelinkDLL::Object::Generic::epoch_manager::read_guard guard;
+                const DataSenderUDP* sender = this->streamMap.get(ref, streamID);
+                if (sender == nullptr) { return false; }
+                CORELINK_TRACE_SCOPE_ARG("udp send", streamID);
+                this->send(*sender, packageSendCodec(std::atomic_load(&sender->encoder), streamID, federationID, msg, msgLen));
+                return true;
             }
 
-            bool comm_data_send_udp::sendMsg(int ref, const STREAM_ID& streamID, const int& federationID, const std::string& msg, const std::string& json, bool serverCheck) {
-                if (this->streamMap.getStream(ref) == streamID) {
-                    this->sendQueue.enqueue(std::pair<int, std::string>(this->streamMap.at(ref).nsPort,
-                        packageSend(streamID, federationID, msg, json, serverCheck)));
-                    return true;
-                }
-                return false;
+            bool comm_data_send_udp::sendMsg(int ref, const STREAM_ID& streamID, const int& federationID, const char* msg, int msgLen,
+                    const char* json, int jsonLen, bool serverCheck) {
+                CorelinkDLL::Object::Generic::epoch_manager::read_guard guard;
+                const DataSenderUDP* sender = this->streamMap.get(ref, streamID);
+                if (sender == nullptr) { return false; }
+                CORELINK_TRACE_SCOPE_ARG("udp send", streamID);
+                this->send(*sender, packageSendCodec(std::atomic_load(&sender->encoder), streamID, federationID, msg, msgLen, json, jsonLen, serverCheck));
+                return true;
+            }
+
+            bool comm_data_send_udp::setCodec(int ref, const STREAM_ID& streamID, int codec, int keyInterval) {
+                CorelinkDLL::Object::Generic::epoch_manager::read_guard guard;
+                DataSenderUDP* sender = this->streamMap.get(ref, streamID);
+                if (sender == nullptr) { return false; }
+                std::atomic_store(&sender->encoder, createEncoder(codec, keyInterval));
+                return true;
+            }
+
+            bool comm_data_send_udp::setDirectSend(int ref, const STREAM_ID& streamID, bool enable) {
+                CorelinkDLL::Object::Generic::epoch_manager::read_guard guard;
+                DataSenderUDP* sender = this->streamMap.get(ref, streamID);
+                if (sender == nullptr) { return false; }
+                sender->direct->enabled.store(enable, std::memory_order_relaxed);
+                return true;
             }
 
-            void comm_data_send_udp::sendFunc(const std::string& serverIP) {
+            int comm_data_send_udp::getQueueDepth() {
+                return (int) this->sendQueue.size();
+            }
+
+            void comm_data_send_udp::send(const DataSenderUDP& sender, CorelinkDLL::Object::packet_buffer&& package) {
+                DirectState& direct = *sender.direct;
                 sockaddr_in hint;
-                int hintLen;
-                std::pair<int, std::string> message;
                 int sendOk;
+                sender.counters.count((int) package.size() - PACKET_HEADER_SIZE);
+                if (direct.enabled.load(std::memory_order_relaxed) && direct.queued.load(std::memory_order_acquire) == 0) {
+                    hint = this->serverHint;
+                    hint.sin_port = sender.nsPort;
+                    CORELINK_TRACE_SCOPE_ARG("sendto", package.size());
+                    sendOk = sendto(this->sock, package.data(), package.size(), 0, (sockaddr*)&hint, sizeof(hint));
+                    if (sendOk >= 0 || !SOCKET_WOULD_BLOCK(SOCKET_ERROR_CODE)) {
+                        // other send errors lose the datagram, counted like the queued path.
+                        if (sendOk < 0) { direct.drops->add(1); }
+                        return;
+                    }
+                }
+                // socket buffer is full or the stream is not direct, later messages queue behind this one.
+                CORELINK_TRACE_INSTANT("udp queue", package.size());
+                direct.queued.fetch_add(1, std::memory_order_relaxed);
+                this->sendQueue.enqueue(QueuedMsg{ sender.nsPort, std::move(package), sender.direct });
+            }
 
-                hint.sin_family = AF_INET;
-                inet_pton(AF_INET, serverIP.c_str(), &hint.sin_addr);
-                hintLen = sizeof(hint);
+            void comm_data_send_udp::sendFunc() {
+                CORELINK_TRACE_THREAD("udp send");
+                CorelinkDLL::Object::thread_metric threadMetric("udp_send");
+                sockaddr_in hint = this->serverHint;
+                QueuedMsg message;
+                int sendOk;
 
                 while (this->sock != INVALID_SOCKET) {
                     message = sendQueue.dequeue();
-                    if (message.first == INVALID_PORT) {
+                    if (message.nsPort == INVALID_PORT) {
                         continue;
                     }
-                    hint.sin_port = message.first;
-                    sendOk = sendto(sock, message.second.c_str(), message.second.size(), 0, (sockaddr*)&hint, hintLen);
-                    if (sendOk == SOCKET_ERROR) {
-                        // TODO: Do error handling
+                    hint.sin_port = message.nsPort;
+                    CORELINK_TRACE_SCOPE_ARG("sendto", message.msg.size());
+                    sendOk = sendto(this->sock, message.msg.data(), message.msg.size(), 0, (sockaddr*)&hint, sizeof(hint));
+                    // socket is non-blocking, wait for room in the send buffer.
+                    while (sendOk < 0 && SOCKET_WOULD_BLOCK(SOCKET_ERROR_CODE) && this->sock != INVALID_SOCKET) {
+                        waitSocketWritable(this->sock, 100);
+                        sendOk = sendto(this->sock, message.msg.data(), message.msg.size(), 0, (sockaddr*)&hint, sizeof(hint));
+                    }
+                    // hand the buffer back now instead of holding it until the next message.
+                    message.msg.reset();
+                    message.direct->queued.fetch_sub(1, std::memory_order_release);
+                    if (sendOk < 0) {
+                        message.direct->drops->add(1);
                         continue;
                     }
                 }
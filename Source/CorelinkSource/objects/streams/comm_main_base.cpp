@@ -1,15 +1,20 @@
 #include "corelink/objects/streams/comm_main_base.h"
+#include "corelink/objects/trace_ring.h"
 
 namespace CorelinkDLL {
     namespace Object {
         namespace Stream {
             comm_main_base::comm_main_base(client_main* clientRef) :
-                clientRef(clientRef), responseHandler(std::shared_ptr<rapidjson::Document>(nullptr))
+                clientRef(clientRef), responseHandler(std::shared_ptr<rapidjson::Document>(nullptr)),
+                inflight(metrics_registry::instance().gauge("control.inflight")),
+                roundTrip(metrics_registry::instance().histogram("control.rtt"))
             {
+                metrics_registry::instance().addSampler("control.callback.queue", [this]() { return (std::int64_t) this->callbackQueue.size(); });
                 this->threadCallback = std::thread(&comm_main_base::callbackThread, this);
             }
 
             comm_main_base::~comm_main_base() {
+                metrics_registry::instance().remove("control.callback.queue");
                 this->clientRef = nullptr;
                 this->callbackQueue.clear();
                 this->callbackQueue.enqueue(std::shared_ptr<rapidjson::Document>(nullptr));
@@ -26,16 +31,46 @@ namespace CorelinkDLL {
             rapidjson::Document comm_main_base::sendRecv(char* msg, int len, const int& commID) {
                 rapidjson::Document recvJson;
                 std::shared_ptr<rapidjson::Document> response;
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                CORELINK_TRACE_SCOPE_ARG("control request", commID);
                 recvJson.SetObject();
 
                 if (!sendMsg(msg, len)) { return recvJson; }
+                this->inflight->add(1);
                 response = responseHandler.get(commID);
+                this->inflight->add(-1);
+                this->roundTrip->record((std::uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
                 if (response) {
                     recvJson.CopyFrom(*response, recvJson.GetAllocator());
                 }
                 return recvJson;
             }
 
+            /**
+             * Checks the function of a server callback message.
+             */
+            static ServerCallback jsonToCallback(const rapidjson::Value& json) {
+                rapidjson::Value::ConstMemberIterator iter;
+                if (!json.IsObject() || (iter = json.FindMember("function")) == json.MemberEnd() || !iter->value.IsString()) {
+                    return ServerCallback::LAST;
+                }
+                return strToCallback(iter->value.GetString());
+            }
+
+            /**
+             * Reads a stream id member of a server callback message.
+             * Records an error if it is missing, the message should be skipped then.
+             */
+            static bool readStreamID(const rapidjson::Value& json, const char* name, STREAM_ID& out) {
+                rapidjson::Value::ConstMemberIterator iter = json.FindMember(name);
+                if (iter == json.MemberEnd() || !iter->value.IsInt()) {
+                    addError("comm_main_base.cpp callbackThread", "server callback without a valid stream id", ERROR_CODE_COMM);
+                    return false;
+                }
+                out = iter->value.GetInt();
+                return true;
+            }
+
             void comm_main_base::callbackThread() {
                 client_main* _clientRef;
                 void (*callbackRef1)(const int&);
@@ -44,34 +79,55 @@ namespace CorelinkDLL {
                 rapidjson::Document recvJson;
                 rapidjson::Value jsonData;
                 // int tmpVal;
-                // STREAM_ID streamID1;
-                // STREAM_ID streamID2;
                 ServerCallback callback;
+                STREAM_ID streamID1;
+                STREAM_ID streamID2;
+                std::vector<STREAM_ID> staleIDs;
+                CORELINK_TRACE_THREAD("server callback");
+                thread_metric threadMetric("control_callback");
 
                 while ((_clientRef = this->clientRef) != nullptr) {
                     jsonPtr = this->callbackQueue.dequeue();
                     if (!jsonPtr) { continue; }
+                    CORELINK_TRACE_SCOPE("server callback");
                     recvJson.CopyFrom(*jsonPtr, recvJson.GetAllocator());
                     jsonPtr.reset();
                     
-                    callback = strToCallback(recvJson["function"].GetString());
+                    callback = jsonToCallback(recvJson);
                     if (callback == ServerCallback::LAST) { continue; }
 
                     switch (callback) {
                     case ServerCallback::DROPPED://update sender when reciever listening is destroyed
+                        if (!readStreamID(recvJson, "streamID", streamID1)) { break; }
                         if ((callbackRef1 = _clientRef->data.onDropHandler) != nullptr) {
-                            callbackRef1(recvJson["streamID"].GetInt());
+                            callbackRef1(streamID1);
                         }
                         break;
                     case ServerCallback::STALE://reciever identify when a send stream is dead
+                        staleIDs.clear();
+                        if (readStreamID(recvJson, "streamID", streamID1)) {
+                            staleIDs.push_back(streamID1);
+                        }
+                        // senders usually go stale together (server restart), so remove the queued ones under a single lock.
+                        while (true) {
+                            this->callbackQueue.front(jsonPtr, std::shared_ptr<rapidjson::Document>(nullptr));
+                            if (!jsonPtr || jsonToCallback(*jsonPtr) != ServerCallback::STALE) { break; }
+                            if (readStreamID(*this->callbackQueue.dequeue(), "streamID", streamID1)) {
+                                staleIDs.push_back(streamID1);
+                            }
+                        }
+                        jsonPtr.reset();
                         if ((callbackRef1 = _clientRef->data.onStaleHandler) != nullptr) {
-                            callbackRef1(recvJson["streamID"].GetInt());
+                            for (const STREAM_ID& staleID : staleIDs) {
+                                callbackRef1(staleID);
+                            }
                         }
-                        _clientRef->rmSource(recvJson["streamID"].GetInt());
+                        _clientRef->rmSources(staleIDs);
                         break;
                     case ServerCallback::SUBSCRIBE://update a sender when reciever subscribes
+                        if (!readStreamID(recvJson, "senderID", streamID1) || !readStreamID(recvJson, "receiverID", streamID2)) { break; }
                         if ((callbackRef2 = _clientRef->data.onSubscribeHandler) != nullptr) {
-                            callbackRef2(recvJson["senderID"].GetInt(), recvJson["receiverID"].GetInt());
+                            callbackRef2(streamID1, streamID2);
                         }
                         /*
                         jsonData = recvJson["type"];
@@ -98,8 +154,9 @@ namespace CorelinkDLL {
                         callbackRef(data, CALLBACK_SUBSCRIBE);*/
                         break;
                     case ServerCallback::UPDATE:
+                        if (!readStreamID(recvJson, "receiverID", streamID1) || !readStreamID(recvJson, "streamID", streamID2)) { break; }
                         if ((callbackRef2 = _clientRef->data.onUpdateHandler) != nullptr) {
-                            callbackRef2(recvJson["receiverID"].GetInt(), recvJson["streamID"].GetInt());
+                            callbackRef2(streamID1, streamID2);
                         }
                         /*
                         data = new const char*[5];
@@ -1,5 +1,6 @@
 #include "corelink/objects/streams/comm_main_tcp.h"
 #include "corelink/objects/streams/tcp_recv_handler.h"
+#include "corelink/objects/trace_ring.h"
 
 namespace CorelinkDLL {
     namespace Object {
@@ -41,12 +42,12 @@ namespace CorelinkDLL {
 
             std::string comm_main_tcp::connectServer(const std::string& ip, const int& port, int& errorID) {
                 if (this->sock != INVALID_SOCKET) {
-                    errorID = addError("comm_main_tcp.cpp connectServer: Already Connected.", ERROR_CODE_STATE);
+                    errorID = addError("comm_main_tcp.cpp connectServer", "Already Connected.", ERROR_CODE_STATE);
                     return "";
                 }
                 this->sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
                 if (this->sock == INVALID_SOCKET) {
-                    errorID = addError("comm_main_tcp.cpp connectServer: could not initialize socket. Error code: " + std::to_string(SOCKET_ERROR_CODE), ERROR_CODE_SOCKET);
+                    errorID = addError("comm_main_tcp.cpp connectServer", "could not initialize socket.", ERROR_CODE_SOCKET, SOCKET_ERROR_CODE);
                     return "";
                 }
                 CorelinkDLL::setRecvSocketOpts(this->sock);
@@ -55,7 +56,7 @@ namespace CorelinkDLL {
                 inet_pton(AF_INET, ip.c_str(), &this->serverHint.sin_addr);
 
                 if (connect(this->sock, (sockaddr*)&this->serverHint, sizeof(this->serverHint)) == SOCKET_ERROR) {
-                    errorID = addError("comm_main_tcp.cpp connectServer: could not connect to server. Error code: " + std::to_string(SOCKET_ERROR_CODE), ERROR_CODE_SOCKET);
+                    errorID = addError("comm_main_tcp.cpp connectServer", "could not connect to server.", ERROR_CODE_SOCKET, SOCKET_ERROR_CODE);
                     closesocket(this->sock);
                     this->sock = INVALID_SOCKET;
                     return "";
@@ -71,8 +72,10 @@ namespace CorelinkDLL {
                 int msgLen;
                 int bytesRecv;
                 char* msgRecv;
-                char* str;
+                CorelinkDLL::Object::packet_buffer str;
                 std::shared_ptr<rapidjson::Document> json;
+                CORELINK_TRACE_THREAD("control recv");
+                CorelinkDLL::Object::thread_metric threadMetric("control_recv");
 
                 counter = 0;
                 msgLen = 0;
@@ -87,11 +90,12 @@ namespace CorelinkDLL {
                         else if (msgRecv[i] == '}') {
                             if (--counter == 0) {
                                 msgLen = msgLen + i + 1;
+                                CORELINK_TRACE_SCOPE_ARG("control message", msgLen);
                                 str = recvHandler.getData(msgLen, 1);
                                 json = std::make_shared<rapidjson::Document>();
                                 json->SetObject();
                                 // assumes only using valid json string
-                                json->Parse(str, msgLen);
+                                json->Parse(str.data(), msgLen);
                                 msgLen = - i - 1;
                                 // push to receiver
                                 if (json->FindMember("ID") != json->MemberEnd()) {
@@ -100,11 +104,10 @@ namespace CorelinkDLL {
                                 }
                                 // push to handler
                                 else {
-                                    // this->recvCallback(json.get());
+                                    this->callbackQueue.enqueue(json);
                                     json.reset();
                                 }
-                                delete[] str;
-                                str = nullptr;
+                                str.reset();
                             }
                         }
                     }
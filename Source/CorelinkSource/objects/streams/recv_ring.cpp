@@ -0,0 +1,65 @@
+#include "corelink/objects/streams/recv_ring.h"
+
+namespace CorelinkDLL {
+    namespace Object {
+        namespace Stream {
+            recv_ring::recv_ring(int capacity) :
+                slots(), mask(0), head(0), tail(0), cachedTail(0), readTail(0), pending(0), dropped(0)
+            {
+                unsigned int size = 2;
+                while ((int) size < capacity) { size <<= 1; }
+                this->slots.resize(size);
+                this->mask = size - 1;
+            }
+
+            bool recv_ring::push(const STREAM_ID& recvID, const STREAM_ID& sendID, const char* data, int hdrLen, int msgLen) {
+                unsigned int index = this->head.load(std::memory_order_relaxed);
+                if (index - this->cachedTail > this->mask) {
+                    this->cachedTail = this->tail.load(std::memory_order_acquire);
+                    if (index - this->cachedTail > this->mask) {
+                        this->dropped.fetch_add(1, std::memory_order_relaxed);
+                        return false;
+                    }
+                }
+                slot& item = this->slots[index & this->mask];
+                item.recvID = recvID;
+                item.sendID = sendID;
+                item.hdrLen = hdrLen;
+                item.msgLen = msgLen;
+                item.buffer.assign(data, data + hdrLen + msgLen);
+                this->head.store(index + 1, std::memory_order_release);
+                return true;
+            }
+
+            int recv_ring::poll(recv_message* out, int max) {
+                unsigned int index, available;
+                int count = 0;
+                if (this->pending > 0) {
+                    this->readTail += this->pending;
+                    this->pending = 0;
+                    this->tail.store(this->readTail, std::memory_order_release);
+                }
+                index = this->head.load(std::memory_order_acquire);
+                available = index - this->readTail;
+                for (unsigned int i = 0; i < available && count < max; ++i, ++count) {
+                    const slot& item = this->slots[(this->readTail + i) & this->mask];
+                    out[count].recvID = item.recvID;
+                    out[count].sendID = item.sendID;
+                    out[count].data = item.buffer.data();
+                    out[count].hdrLen = item.hdrLen;
+                    out[count].msgLen = item.msgLen;
+                }
+                this->pending = count;
+                return count;
+            }
+
+            int recv_ring::getCapacity() const {
+                return (int) this->slots.size();
+            }
+
+            unsigned long long recv_ring::getDropped() const {
+                return this->dropped.load(std::memory_order_relaxed);
+            }
+        }
+    }
+}
@@ -0,0 +1,189 @@
+#include "corelink/objects/streams/stream_codec.h"
+
+namespace CorelinkDLL {
+    namespace Object {
+        namespace Stream {
+            static const char CODEC_HEADER_PREFIX[] = "{\"codec\":";
+            static const int CODEC_HEADER_PREFIX_LEN = sizeof(CODEC_HEADER_PREFIX) - 1;
+
+            static void writeVarint(std::string& out, unsigned int val) {
+                while (val >= 128) {
+                    out.push_back((char)((val & 127) | 128));
+                    val >>= 7;
+                }
+                out.push_back((char)val);
+            }
+
+            static bool readVarint(const unsigned char* data, int dataLen, int& index, unsigned int& val) {
+                int shift = 0;
+                val = 0;
+                while (index < dataLen && shift < 32) {
+                    val |= (unsigned int)(data[index] & 127) << shift;
+                    if ((data[index++] & 128) == 0) { return true; }
+                    shift += 7;
+                }
+                return false;
+            }
+
+            void stream_codec::header(int codec, const char* json, int jsonLen, std::string& out) {
+                int start;
+                int next;
+                out.assign(CODEC_HEADER_PREFIX, CODEC_HEADER_PREFIX_LEN);
+                out.append(std::to_string(codec));
+                // keep the members of the user json after the codec id.
+                for (start = 0; start < jsonLen && json[start] != '{'; ++start) {}
+                for (next = start + 1; next < jsonLen &&
+                    (json[next] == ' ' || json[next] == '\t' || json[next] == '\r' || json[next] == '\n'); ++next) {}
+                if (next < jsonLen && json[next] != '}') {
+                    out.push_back(',');
+                    out.append(json + next, jsonLen - next);
+                    return;
+                }
+                out.push_back('}');
+            }
+
+            int stream_codec::parseHeader(const char* json, int jsonLen) {
+                int codec = 0;
+                int i;
+                if (jsonLen <= CODEC_HEADER_PREFIX_LEN || memcmp(json, CODEC_HEADER_PREFIX, CODEC_HEADER_PREFIX_LEN) != 0) {
+                    return CODEC_NONE;
+                }
+                for (i = CODEC_HEADER_PREFIX_LEN; i < jsonLen && json[i] >= '0' && json[i] <= '9'; ++i) {
+                    codec = codec * 10 + (json[i] - '0');
+                }
+                if (i == CODEC_HEADER_PREFIX_LEN || codec <= CODEC_NONE || codec >= (int) StreamCodec::LAST) { return CODEC_NONE; }
+                return codec;
+            }
+
+            void stream_codec::stripHeader(const char* json, int jsonLen, std::string& out) {
+                int i;
+                for (i = CODEC_HEADER_PREFIX_LEN; i < jsonLen && json[i] >= '0' && json[i] <= '9'; ++i) {}
+                if (i < jsonLen && json[i] == ',') { ++i; }
+                out.assign(1, '{');
+                out.append(json + i, jsonLen - i);
+            }
+
+            void stream_codec::xorEncode(const char* key, int keyLen, const char* msg, int msgLen, std::string& out) {
+                int i = 0;
+                int zeroRun, litStart;
+                // byte of msg XOR key. Bytes past the end of the key are XORed against 0.
+                auto xorAt = [&](int index) { return (char)(msg[index] ^ (index < keyLen ? key[index] : 0)); };
+                while (i < msgLen) {
+                    zeroRun = 0;
+                    while (i < msgLen && xorAt(i) == 0) {
+                        ++zeroRun;
+                        ++i;
+                    }
+                    // literal run ends on the next pair of unchanged bytes.
+                    litStart = i;
+                    while (i < msgLen && !(xorAt(i) == 0 && (i + 1 == msgLen || xorAt(i + 1) == 0))) {
+                        ++i;
+                    }
+                    writeVarint(out, zeroRun);
+                    writeVarint(out, i - litStart);
+                    for (int j = litStart; j < i; ++j) {
+                        out.push_back(xorAt(j));
+                    }
+                }
+            }
+
+            bool stream_codec::xorDecode(const char* key, int keyLen, const char* data, int dataLen, char* out, int msgLen) {
+                const unsigned char* dataCasted = (const unsigned char*) data;
+                unsigned int zeroRun, litRun;
+                int index = 0;
+                int pos = 0;
+                while (pos < msgLen) {
+                    if (!readVarint(dataCasted, dataLen, index, zeroRun) || !readVarint(dataCasted, dataLen, index, litRun)) { return false; }
+                    if (zeroRun > (unsigned int)(msgLen - pos) || litRun > (unsigned int)(msgLen - pos) - zeroRun ||
+                        litRun > (unsigned int)(dataLen - index)) {
+                        return false;
+                    }
+                    for (unsigned int j = 0; j < zeroRun; ++j, ++pos) {
+                        out[pos] = pos < keyLen ? key[pos] : 0;
+                    }
+                    for (unsigned int j = 0; j < litRun; ++j, ++pos) {
+                        out[pos] = data[index++] ^ (pos < keyLen ? key[pos] : 0);
+                    }
+                }
+                return index == dataLen;
+            }
+
+            stream_encoder::stream_encoder(int codec, int keyInterval) :
+                codec(codec), keyInterval(keyInterval < 1 ? 1 : keyInterval), sinceKey(0), keySeq(0), keyFrame()
+            {}
+
+            int stream_encoder::getCodec() const {
+                return codec;
+            }
+
+            void stream_encoder::encode(const char* msg, int msgLen, const char* json, int jsonLen, std::string& frame, std::string& frameJson) {
+                stream_codec::header(codec, json, jsonLen, frameJson);
+                frame.clear();
+                frame.resize(stream_codec::FRAME_HEADER_SIZE);
+                frame[3] = (char)(msgLen >> 0);
+                frame[4] = (char)(msgLen >> 8);
+
+                std::lock_guard<std::mutex> lck(this->lock);
+                if (this->sinceKey > 0 && this->sinceKey < this->keyInterval) {
+                    stream_codec::xorEncode(this->keyFrame.c_str(), (int) this->keyFrame.size(), msg, msgLen, frame);
+                    // deltas bigger than the message are better off as the next keyframe.
+                    if ((int) frame.size() < stream_codec::FRAME_HEADER_SIZE + msgLen) {
+                        ++this->sinceKey;
+                        frame[0] = (char) stream_codec::FRAME_DELTA;
+                        frame[1] = (char)(this->keySeq >> 0);
+                        frame[2] = (char)(this->keySeq >> 8);
+                        return;
+                    }
+                    frame.resize(stream_codec::FRAME_HEADER_SIZE);
+                }
+                ++this->keySeq;
+                this->sinceKey = 1;
+                this->keyFrame.assign(msg, msgLen);
+                frame[0] = (char) stream_codec::FRAME_KEY;
+                frame[1] = (char)(this->keySeq >> 0);
+                frame[2] = (char)(this->keySeq >> 8);
+                frame.append(msg, msgLen);
+            }
+
+            stream_decoder::stream_decoder() : sources(), frame(), json() {}
+
+            const char* stream_decoder::decode(const STREAM_ID& source, const char* data, int& jsonLen, int& msgLen) {
+                const unsigned char* frameData = (const unsigned char*)(data + jsonLen);
+                unsigned short seq;
+                int origLen;
+                if (msgLen < stream_codec::FRAME_HEADER_SIZE) { return nullptr; }
+                seq = (unsigned short)(frameData[1] + (frameData[2] << 8));
+                origLen = frameData[3] + (frameData[4] << 8);
+
+                source_state& state = this->sources[source];
+                stream_codec::stripHeader(data, jsonLen, this->json);
+                this->frame.resize(this->json.size() + origLen);
+                memcpy(&this->frame[0], this->json.c_str(), this->json.size());
+
+                if (frameData[0] == stream_codec::FRAME_KEY) {
+                    if (origLen != msgLen - stream_codec::FRAME_HEADER_SIZE) { return nullptr; }
+                    state.keyFrame.assign((const char*) frameData + stream_codec::FRAME_HEADER_SIZE, origLen);
+                    state.keySeq = seq;
+                    state.valid = true;
+                    memcpy(&this->frame[0] + this->json.size(), state.keyFrame.c_str(), origLen);
+                }
+                // lost the keyframe, wait for the next one.
+                else if (frameData[0] != stream_codec::FRAME_DELTA || !state.valid || state.keySeq != seq) {
+                    return nullptr;
+                }
+                else if (!stream_codec::xorDecode(state.keyFrame.c_str(), (int) state.keyFrame.size(),
+                        (const char*) frameData + stream_codec::FRAME_HEADER_SIZE, msgLen - stream_codec::FRAME_HEADER_SIZE,
+                        &this->frame[0] + this->json.size(), origLen)) {
+                    return nullptr;
+                }
+                jsonLen = (int) this->json.size();
+                msgLen = origLen;
+                return this->frame.c_str();
+            }
+
+            void stream_decoder::reset(const STREAM_ID& source) {
+                this->sources.erase(source);
+            }
+        }
+    }
+}
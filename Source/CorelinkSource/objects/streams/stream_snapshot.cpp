@@ -0,0 +1,79 @@
+#include "corelink/objects/streams/stream_snapshot.h"
+
+namespace CorelinkDLL {
+    namespace Object {
+        namespace Stream {
+            stream_record::stream_record(const stream_data& streamData, int ref) :
+                streamID(streamData.streamID), state(streamData.state), stateIndex(streamData.stateIndex), ref(ref),
+                dataLen((int) streamData.streamData.size()), refs(1)
+            {}
+
+            stream_record* stream_record::create(const stream_data& streamData, int ref) {
+                // record and compacted data share one allocation.
+                char* memory = new char[sizeof(stream_record) + streamData.streamData.size() + 1];
+                stream_record* record = new (memory) stream_record(streamData, ref);
+                memcpy(memory + sizeof(stream_record), streamData.streamData.c_str(), streamData.streamData.size() + 1);
+                return record;
+            }
+
+            stream_record* stream_record::fromData(const char* data) {
+                return (stream_record*)(data - sizeof(stream_record));
+            }
+
+            const char* stream_record::data() const {
+                return (const char*) this + sizeof(stream_record);
+            }
+
+            void stream_record::acquire() {
+                this->refs.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            void stream_record::release() {
+                if (this->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    this->~stream_record();
+                    delete[] (char*) this;
+                }
+            }
+
+            stream_snapshot::stream_snapshot() : streams() {}
+
+            stream_snapshot::stream_snapshot(const stream_snapshot& rhs) : streams(rhs.streams) {
+                for (const std::pair<const STREAM_ID, stream_record*>& stream : this->streams) {
+                    stream.second->acquire();
+                }
+            }
+
+            stream_snapshot::~stream_snapshot() {
+                for (const std::pair<const STREAM_ID, stream_record*>& stream : this->streams) {
+                    stream.second->release();
+                }
+            }
+
+            const stream_record* stream_snapshot::find(const STREAM_ID& streamID) const {
+                std::unordered_map<STREAM_ID, stream_record*>::const_iterator iter;
+                return (iter = this->streams.find(streamID)) == this->streams.end() ? nullptr : iter->second;
+            }
+
+            void stream_snapshot::add(stream_record* record) {
+                std::unordered_map<STREAM_ID, stream_record*>::iterator iter;
+                if ((iter = this->streams.find(record->streamID)) != this->streams.end()) {
+                    iter->second->release();
+                    iter->second = record;
+                    return;
+                }
+                this->streams[record->streamID] = record;
+            }
+
+            void stream_snapshot::remove(const STREAM_ID& streamID) {
+                std::unordered_map<STREAM_ID, stream_record*>::iterator iter;
+                if ((iter = this->streams.find(streamID)) == this->streams.end()) { return; }
+                iter->second->release();
+                this->streams.erase(iter);
+            }
+
+            const std::unordered_map<STREAM_ID, stream_record*>& stream_snapshot::getStreams() const {
+                return this->streams;
+            }
+        }
+    }
+}
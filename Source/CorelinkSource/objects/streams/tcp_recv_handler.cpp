@@ -45,19 +45,23 @@ namespace CorelinkDLL {
                 return ret;
             }
 
-            char* tcp_recv_handler::getData(int len, int buffer) {
-                if (len > size()) { return nullptr; }
+            CorelinkDLL::Object::packet_buffer tcp_recv_handler::getData(int len, int buffer) {
+                CorelinkDLL::Object::packet_buffer output;
+                if (len > size()) { return output; }
+                output = CorelinkDLL::Object::packet_pool::instance().acquire(len + buffer);
+                memset(output.data() + len, 0, buffer);
+                getData(output.data(), len);
+                return output;
+            }
+
+            bool tcp_recv_handler::getData(char* output, int len) {
+                if (len > size()) { return false; }
                 int tmp;
-                char* output;
-                tmp = len + buffer;
-                output = new char[tmp];
-                for (int i = len; i < tmp; ++i) {
-                    output[i] = 0;
-                }
-                // buffer is now free to use as temporary variable. Use to store current index.
+                int buffer;
                 tmp = BLOCK_SIZE - backIndex;
                 tmp = tmp < len ? tmp : len;
                 memcpy(output, data[backBlock] + backIndex, tmp);
+                // amount of data copied so far.
                 buffer = tmp;
                 backIndex += tmp;
                 if (backIndex == BLOCK_SIZE) {
@@ -79,7 +83,7 @@ namespace CorelinkDLL {
                 if (size() == 0) {
                     backBlock = currBlock = backIndex = currIndex = 0;
                 }
-                return output;
+                return true;
             }
 
             void tcp_recv_handler::resize() {
@@ -0,0 +1,207 @@
+#include "corelink/objects/trace_ring.h"
+
+#include <algorithm>
+
+namespace CorelinkDLL {
+    namespace Object {
+        /**
+         * Ring and name of the current thread. The tracer keeps the ring alive once the thread exits.
+         */
+        struct trace_thread_state {
+            std::shared_ptr<trace_ring> ring;
+            const char* name;
+            trace_thread_state() : name(nullptr) {}
+        };
+
+        static thread_local trace_thread_state threadState;
+
+        trace_ring::trace_ring(int tid, const char* name) : head(0), startHead(0), tid(tid), name(name) {
+            for (int i = 0; i < RING_SIZE; ++i) {
+                this->slots[i].name.store(nullptr, std::memory_order_relaxed);
+                this->slots[i].start.store(0, std::memory_order_relaxed);
+                this->slots[i].duration.store(0, std::memory_order_relaxed);
+                this->slots[i].arg.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        void trace_ring::add(const char* name, std::int64_t start, std::int64_t duration, std::int64_t arg) {
+            std::uint64_t index = this->head.load(std::memory_order_relaxed);
+            slot& target = this->slots[index % RING_SIZE];
+            // a copy that reads any of the stores below then sees head at index or later, and drops the slot.
+            std::atomic_thread_fence(std::memory_order_release);
+            target.name.store(name, std::memory_order_relaxed);
+            target.start.store(start, std::memory_order_relaxed);
+            target.duration.store(duration, std::memory_order_relaxed);
+            target.arg.store(arg, std::memory_order_relaxed);
+            this->head.store(index + 1, std::memory_order_release);
+        }
+
+        std::uint64_t trace_ring::copy(std::int64_t since, std::vector<trace_event>& out) const {
+            std::vector<trace_event> events;
+            std::uint64_t end = this->head.load(std::memory_order_acquire);
+            std::uint64_t first = end > (std::uint64_t) RING_SIZE ? end - RING_SIZE : 0;
+            std::uint64_t after, valid, start;
+            trace_event event;
+            events.reserve((size_t) (end - first));
+            for (std::uint64_t i = first; i < end; ++i) {
+                const slot& source = this->slots[i % RING_SIZE];
+                event.name = source.name.load(std::memory_order_relaxed);
+                event.start = source.start.load(std::memory_order_relaxed);
+                event.duration = source.duration.load(std::memory_order_relaxed);
+                event.arg = source.arg.load(std::memory_order_relaxed);
+                events.push_back(event);
+            }
+            // slots the owner moved past during the copy may hold newer events, and the slot at head may be half written, drop them.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = this->head.load(std::memory_order_relaxed);
+            valid = after + 1 > (std::uint64_t) RING_SIZE ? after + 1 - RING_SIZE : 0;
+            if (valid < first) { valid = first; }
+            for (std::uint64_t i = valid; i < end; ++i) {
+                const trace_event& copied = events[(size_t) (i - first)];
+                if (copied.start >= since) { out.push_back(copied); }
+            }
+            start = this->startHead.load(std::memory_order_relaxed);
+            return valid > start ? valid - start : 0;
+        }
+
+        void trace_ring::markStart() {
+            this->startHead.store(this->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+        }
+
+        int trace_ring::getTID() const {
+            return this->tid;
+        }
+
+        const char* trace_ring::getName() const {
+            return this->name.load(std::memory_order_relaxed);
+        }
+
+        void trace_ring::setName(const char* name) {
+            this->name.store(name, std::memory_order_relaxed);
+        }
+
+        std::atomic<bool> tracer::enabled(false);
+
+        tracer& tracer::instance() {
+            static tracer trace;
+            return trace;
+        }
+
+        tracer::tracer() : startTime(0), nextTID(1) {}
+
+        void tracer::start() {
+            std::lock_guard<std::mutex> lck(this->ringsLock);
+            // rings only the tracer still holds belong to exited threads.
+            this->rings.erase(std::remove_if(this->rings.begin(), this->rings.end(),
+                [](const std::shared_ptr<trace_ring>& ring) { return ring.use_count() == 1; }), this->rings.end());
+            for (const std::shared_ptr<trace_ring>& ring : this->rings) {
+                ring->markStart();
+            }
+            this->startTime.store(now(), std::memory_order_relaxed);
+            enabled.store(true, std::memory_order_relaxed);
+        }
+
+        void tracer::stop() {
+            enabled.store(false, std::memory_order_relaxed);
+        }
+
+        void tracer::add(const char* name, std::int64_t start, std::int64_t duration, std::int64_t arg) {
+            if (!isEnabled()) { return; }
+            this->localRing().add(name, start, duration, arg);
+        }
+
+        void tracer::setThreadName(const char* name) {
+            threadState.name = name;
+            if (threadState.ring) {
+                threadState.ring->setName(name);
+            }
+        }
+
+        trace_ring& tracer::localRing() {
+            trace_thread_state& state = threadState;
+            if (!state.ring) {
+                std::lock_guard<std::mutex> lck(this->ringsLock);
+                state.ring = std::make_shared<trace_ring>(this->nextTID++, state.name);
+                this->rings.push_back(state.ring);
+            }
+            return *state.ring;
+        }
+
+        std::uint64_t tracer::exportChrome(std::string& out) {
+            std::vector<std::shared_ptr<trace_ring>> copied;
+            std::vector<trace_event> events;
+            std::int64_t since = this->startTime.load(std::memory_order_relaxed);
+            std::uint64_t lost = 0;
+            rapidjson::StringBuffer buffer;
+            rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+            {
+                std::lock_guard<std::mutex> lck(this->ringsLock);
+                copied = this->rings;
+            }
+
+            writer.StartObject();
+            writer.Key("displayTimeUnit");
+            writer.String("ns");
+            writer.Key("traceEvents");
+            writer.StartArray();
+            for (const std::shared_ptr<trace_ring>& ring : copied) {
+                if (ring->getName() != nullptr) {
+                    writer.StartObject();
+                    writer.Key("name");
+                    writer.String("thread_name");
+                    writer.Key("ph");
+                    writer.String("M");
+                    writer.Key("pid");
+                    writer.Int(1);
+                    writer.Key("tid");
+                    writer.Int(ring->getTID());
+                    writer.Key("args");
+                    writer.StartObject();
+                    writer.Key("name");
+                    writer.String(ring->getName());
+                    writer.EndObject();
+                    writer.EndObject();
+                }
+                events.clear();
+                lost += ring->copy(since, events);
+                for (const trace_event& event : events) {
+                    writer.StartObject();
+                    writer.Key("name");
+                    writer.String(event.name != nullptr ? event.name : "");
+                    writer.Key("ph");
+                    writer.String(event.duration < 0 ? "i" : "X");
+                    // Chrome traces count in microseconds.
+                    writer.Key("ts");
+                    writer.Double((event.start - since) / 1000.0);
+                    if (event.duration < 0) {
+                        writer.Key("s");
+                        writer.String("t");
+                    }
+                    else {
+                        writer.Key("dur");
+                        writer.Double(event.duration / 1000.0);
+                    }
+                    writer.Key("pid");
+                    writer.Int(1);
+                    writer.Key("tid");
+                    writer.Int(ring->getTID());
+                    writer.Key("args");
+                    writer.StartObject();
+                    writer.Key("arg");
+                    writer.Int64(event.arg);
+                    writer.EndObject();
+                    writer.EndObject();
+                }
+            }
+            writer.EndArray();
+            writer.Key("otherData");
+            writer.StartObject();
+            writer.Key("lostEvents");
+            writer.Uint64(lost);
+            writer.EndObject();
+            writer.EndObject();
+            out.assign(buffer.GetString(), buffer.GetSize());
+            return lost;
+        }
+    }
+}
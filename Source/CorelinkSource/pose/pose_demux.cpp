@@ -0,0 +1,126 @@
+#include "corelink/pose/pose_demux.h"
+
+namespace CorelinkDLL {
+    namespace Pose {
+        pose_demux::slot::slot(int maxJoints, int history) :
+            state(SLOT_FREE), source(STREAM_DEF), generation(0), exchange(maxJoints, history) {}
+
+        pose_demux::pose_demux(int maxSources, int maxJoints, int history) :
+            slots(), redirect(), freeSlots(), slotCount(0), rejected(0)
+        {
+            for (int i = 0; i < maxSources; ++i) {
+                this->slots.emplace_back(new slot(maxJoints, history));
+                this->freeSlots.push(i);
+            }
+        }
+
+        int pose_demux::publish(const STREAM_ID& source, const char* data, int len, bool keepRaw) {
+            std::unordered_map<STREAM_ID, int>::iterator it;
+            int index;
+            // held while publishing so release and collect cannot hand the slot to another sender mid write.
+            std::lock_guard<std::mutex> lck(this->lock);
+            it = this->redirect.find(source);
+            if (it != this->redirect.end()) {
+                index = it->second;
+            }
+            else {
+                if (this->freeSlots.empty()) {
+                    this->rejected.fetch_add(1, std::memory_order_relaxed);
+                    return -1;
+                }
+                index = this->freeSlots.top();
+                this->freeSlots.pop();
+                this->redirect[source] = index;
+                slot& item = *this->slots[index];
+                item.source.store(source, std::memory_order_relaxed);
+                item.generation.fetch_add(1, std::memory_order_relaxed);
+                item.state.store(SLOT_ACTIVE, std::memory_order_release);
+                if (index >= this->slotCount.load(std::memory_order_relaxed)) {
+                    this->slotCount.store(index + 1, std::memory_order_release);
+                }
+            }
+            pose_exchange& exchange = this->slots[index]->exchange;
+            exchange.beginWrite().generation = this->slots[index]->generation.load(std::memory_order_relaxed);
+            if (!exchange.publish(data, len, keepRaw)) {
+                this->rejected.fetch_add(1, std::memory_order_relaxed);
+                return -1;
+            }
+            return index;
+        }
+
+        int pose_demux::release(const STREAM_ID& source) {
+            std::unordered_map<STREAM_ID, int>::iterator it;
+            int index;
+            std::lock_guard<std::mutex> lck(this->lock);
+            it = this->redirect.find(source);
+            if (it == this->redirect.end()) { return -1; }
+            index = it->second;
+            this->redirect.erase(it);
+            this->slots[index]->state.store(SLOT_RETIRED, std::memory_order_release);
+            return index;
+        }
+
+        int pose_demux::collect() {
+            int freed = 0;
+            int count = this->slotCount.load(std::memory_order_acquire);
+            for (int i = 0; i < count; ++i) {
+                if (this->slots[i]->state.load(std::memory_order_acquire) != SLOT_RETIRED) { continue; }
+                std::lock_guard<std::mutex> lck(this->lock);
+                this->slots[i]->source.store(STREAM_DEF, std::memory_order_relaxed);
+                this->slots[i]->state.store(SLOT_FREE, std::memory_order_release);
+                this->freeSlots.push(i);
+                ++freed;
+            }
+            return freed;
+        }
+
+        int pose_demux::getSlotCount() const {
+            return this->slotCount.load(std::memory_order_acquire);
+        }
+
+        int pose_demux::getMaxSources() const {
+            return (int) this->slots.size();
+        }
+
+        int pose_demux::getState(int index) const {
+            return this->slots[index]->state.load(std::memory_order_acquire);
+        }
+
+        STREAM_ID pose_demux::getSource(int index) const {
+            return this->slots[index]->source.load(std::memory_order_acquire);
+        }
+
+        std::uint32_t pose_demux::getGeneration(int index) const {
+            return this->slots[index]->generation.load(std::memory_order_acquire);
+        }
+
+        bool pose_demux::acquire(int index) {
+            slot& item = *this->slots[index];
+            if (!item.exchange.acquire()) { return false; }
+            // the exchange may still hold the last pose of the sender that had the slot before.
+            return item.exchange.latest().generation == item.generation.load(std::memory_order_acquire);
+        }
+
+        const pose_sample& pose_demux::latest(int index) const {
+            return this->slots[index]->exchange.latest();
+        }
+
+        const pose_sample* pose_demux::next(int index) {
+            slot& item = *this->slots[index];
+            std::uint32_t generation = item.generation.load(std::memory_order_acquire);
+            const pose_sample* sample;
+            while ((sample = item.exchange.next()) != nullptr && sample->generation != generation) {
+                item.exchange.pop();
+            }
+            return sample;
+        }
+
+        void pose_demux::pop(int index) {
+            this->slots[index]->exchange.pop();
+        }
+
+        std::uint64_t pose_demux::getRejected() const {
+            return this->rejected.load(std::memory_order_relaxed);
+        }
+    }
+}
@@ -0,0 +1,112 @@
+#include "corelink/pose/pose_exchange.h"
+#include "corelink/pose/pose_frame.h"
+
+namespace CorelinkDLL {
+    namespace Pose {
+        pose_sample::pose_sample() : positions(), joints(0), frame(0), timestamp(0), received(0), sequence(0), generation(0), raw() {}
+
+        pose_exchange::pose_exchange(int maxJoints, int history) :
+            maxJoints(maxJoints < 0 ? 0 : maxJoints), shared(1), writeIndex(0), readIndex(2), published(0), rejected(0),
+            history(history < 0 ? 0 : history), historyHead(0), historyTail(0), historyDropped(0)
+        {
+            for (int i = 0; i < 3; ++i) {
+                this->slots[i].positions.resize(this->maxJoints * 3);
+            }
+            for (pose_sample& sample : this->history) {
+                sample.positions.resize(this->maxJoints * 3);
+            }
+        }
+
+        int pose_exchange::getMaxJoints() const {
+            return this->maxJoints;
+        }
+
+        pose_sample& pose_exchange::beginWrite() {
+            return this->slots[this->writeIndex];
+        }
+
+        void pose_exchange::publish() {
+            pose_sample& sample = this->slots[this->writeIndex];
+            sample.sequence = ++this->published;
+            sample.received = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            if (!this->history.empty()) {
+                std::uint32_t head = this->historyHead.load(std::memory_order_relaxed);
+                if (head - this->historyTail.load(std::memory_order_acquire) < (std::uint32_t) this->history.size()) {
+                    pose_sample& copy = this->history[head % this->history.size()];
+                    memcpy(copy.positions.data(), sample.positions.data(), sample.joints * 3 * sizeof(float));
+                    copy.joints = sample.joints;
+                    copy.frame = sample.frame;
+                    copy.timestamp = sample.timestamp;
+                    copy.received = sample.received;
+                    copy.sequence = sample.sequence;
+                    copy.generation = sample.generation;
+                    this->historyHead.store(head + 1, std::memory_order_release);
+                }
+                else {
+                    // the newest pose still reaches the reader through the shared slot.
+                    ++this->historyDropped;
+                }
+            }
+            // release the filled slot, take back whichever slot was shared.
+            this->writeIndex = this->shared.exchange(this->writeIndex | NEW_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+        }
+
+        bool pose_exchange::publish(const char* data, int len, bool keepRaw) {
+            pose_sample& sample = beginWrite();
+            pose_frame_view view;
+            int joints = pose_frame::readPositions(data, len, sample.positions.data(), this->maxJoints);
+            if (joints < 0) {
+                ++this->rejected;
+                return false;
+            }
+            sample.joints = joints;
+            if (view.reset(data, len)) {
+                sample.frame = view.getFrame();
+                sample.timestamp = view.getTimestamp();
+            }
+            else {
+                sample.frame = 0;
+                sample.timestamp = 0;
+            }
+            if (keepRaw) {
+                sample.raw.assign(data, len);
+            }
+            else {
+                sample.raw.clear();
+            }
+            publish();
+            return true;
+        }
+
+        std::uint64_t pose_exchange::getRejected() const {
+            return this->rejected;
+        }
+
+        bool pose_exchange::acquire() {
+            if ((this->shared.load(std::memory_order_relaxed) & NEW_BIT) == 0) { return false; }
+            this->readIndex = this->shared.exchange(this->readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+            return true;
+        }
+
+        const pose_sample& pose_exchange::latest() const {
+            return this->slots[this->readIndex];
+        }
+
+        std::uint64_t pose_exchange::getHistoryDropped() const {
+            return this->historyDropped;
+        }
+
+        const pose_sample* pose_exchange::next() const {
+            std::uint32_t tail = this->historyTail.load(std::memory_order_relaxed);
+            if (tail == this->historyHead.load(std::memory_order_acquire)) { return nullptr; }
+            return &this->history[tail % this->history.size()];
+        }
+
+        void pose_exchange::pop() {
+            std::uint32_t tail = this->historyTail.load(std::memory_order_relaxed);
+            if (tail == this->historyHead.load(std::memory_order_acquire)) { return; }
+            // hands the entry back to the writer.
+            this->historyTail.store(tail + 1, std::memory_order_release);
+        }
+    }
+}
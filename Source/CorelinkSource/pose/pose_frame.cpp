@@ -0,0 +1,260 @@
+#include "corelink/pose/pose_frame.h"
+#include "corelink/pose/pose_text.h"
+
+#include <cmath>
+
+namespace CorelinkDLL {
+    namespace Pose {
+        const char pose_frame::META_TAG[] = "pose.bin/1";
+
+        static const float ROTATION_SCALE = 32767.0f;
+        static const float POSITION_STEPS = 65535.0f;
+
+        /**
+         * Converts between host order and the little endian order of the frame. Does nothing on little endian hosts.
+         */
+        template<class T>
+        static inline T toLittleEndian(T val) {
+#ifdef CORELINK_POSE_BIG_ENDIAN
+            char bytes[sizeof(T)];
+            memcpy(bytes, &val, sizeof(T));
+            for (std::size_t i = 0; i < sizeof(T) / 2; ++i) {
+                char tmp = bytes[i];
+                bytes[i] = bytes[sizeof(T) - 1 - i];
+                bytes[sizeof(T) - 1 - i] = tmp;
+            }
+            memcpy(&val, bytes, sizeof(T));
+#endif
+            return val;
+        }
+
+        template<class T>
+        static inline T load(const char* data, int index) {
+            T val;
+            memcpy(&val, data + index * sizeof(T), sizeof(T));
+            return toLittleEndian(val);
+        }
+
+        template<class T>
+        static inline void append(std::string& out, T val) {
+            val = toLittleEndian(val);
+            out.append((const char*) &val, sizeof(T));
+        }
+
+        static inline std::int16_t quantizeRotation(float val) {
+            val = val > 1.0f ? 1.0f : (val < -1.0f ? -1.0f : val);
+            return (std::int16_t) lroundf(val * ROTATION_SCALE);
+        }
+
+        int pose_frame::frameSize(int joints, int flags) {
+            int size = HEADER_SIZE;
+            bool quantized = (flags & FLAG_QUANTIZED) != 0;
+            if (quantized) { size += QUANTIZE_SIZE; }
+            size += joints * 3 * (quantized ? sizeof(std::uint16_t) : sizeof(float));
+            if ((flags & FLAG_ROTATIONS) != 0) {
+                size += joints * 4 * (quantized ? sizeof(std::int16_t) : sizeof(float));
+            }
+            return size;
+        }
+
+        bool pose_frame::encode(std::uint32_t frame, std::uint64_t timestamp, int joints, const float* positions, const float* rotations, bool quantize, std::string& out) {
+            int flags = (rotations != nullptr ? FLAG_ROTATIONS : 0) | (quantize ? FLAG_QUANTIZED : 0);
+            float origin[3], step[3], maxVal;
+            if (joints < 0 || joints > MAX_JOINTS) { return false; }
+
+            out.clear();
+            out.reserve(frameSize(joints, flags));
+            append<std::uint32_t>(out, MAGIC);
+            append<std::uint8_t>(out, VERSION);
+            append<std::uint8_t>(out, (std::uint8_t) flags);
+            append<std::uint16_t>(out, (std::uint16_t) joints);
+            append<std::uint32_t>(out, frame);
+            append<std::uint64_t>(out, timestamp);
+
+            if (!quantize) {
+                for (int axis = 0; axis < 3; ++axis) {
+                    for (int i = 0; i < joints; ++i) { append<float>(out, positions[i * 3 + axis]); }
+                }
+                if (rotations != nullptr) {
+                    for (int axis = 0; axis < 4; ++axis) {
+                        for (int i = 0; i < joints; ++i) { append<float>(out, rotations[i * 4 + axis]); }
+                    }
+                }
+                return true;
+            }
+
+            for (int axis = 0; axis < 3; ++axis) {
+                origin[axis] = joints > 0 ? positions[axis] : 0.0f;
+                maxVal = origin[axis];
+                for (int i = 1; i < joints; ++i) {
+                    if (positions[i * 3 + axis] < origin[axis]) { origin[axis] = positions[i * 3 + axis]; }
+                    if (positions[i * 3 + axis] > maxVal) { maxVal = positions[i * 3 + axis]; }
+                }
+                step[axis] = (maxVal - origin[axis]) / POSITION_STEPS;
+            }
+            for (int axis = 0; axis < 3; ++axis) { append<float>(out, origin[axis]); }
+            for (int axis = 0; axis < 3; ++axis) { append<float>(out, step[axis]); }
+            for (int axis = 0; axis < 3; ++axis) {
+                for (int i = 0; i < joints; ++i) {
+                    long q = step[axis] > 0.0f ? lroundf((positions[i * 3 + axis] - origin[axis]) / step[axis]) : 0;
+                    append<std::uint16_t>(out, (std::uint16_t)(q < 0 ? 0 : (q > 65535 ? 65535 : q)));
+                }
+            }
+            if (rotations != nullptr) {
+                for (int axis = 0; axis < 4; ++axis) {
+                    for (int i = 0; i < joints; ++i) { append<std::int16_t>(out, quantizeRotation(rotations[i * 4 + axis])); }
+                }
+            }
+            return true;
+        }
+
+        bool pose_frame::isFrame(const char* data, int len) {
+            return len >= HEADER_SIZE && load<std::uint32_t>(data, 0) == MAGIC;
+        }
+
+        int pose_frame::readPositions(const char* data, int len, float* positions, int maxJoints) {
+            pose_frame_view view;
+            if (!isFrame(data, len)) {
+                return pose_text::parsePositions(data, len, positions, maxJoints);
+            }
+            if (!view.reset(data, len) || view.getJointCount() > maxJoints) { return -1; }
+            view.copyPositions(positions);
+            return view.getJointCount();
+        }
+
+        bool pose_frame::isAdvertised(const std::string& meta) {
+            return meta.find(META_TAG) != std::string::npos;
+        }
+
+        std::string pose_frame::advertise(const std::string& meta) {
+            if (isAdvertised(meta)) { return meta; }
+            if (meta.empty()) { return META_TAG; }
+            return meta + " " + META_TAG;
+        }
+
+        pose_frame_view::pose_frame_view() :
+            data(nullptr), flags(0), joints(0), frame(0), timestamp(0), positionData(nullptr), rotationData(nullptr)
+        {
+            for (int axis = 0; axis < 3; ++axis) {
+                origin[axis] = 0.0f;
+                step[axis] = 0.0f;
+            }
+        }
+
+        bool pose_frame_view::reset(const char* _data, int len) {
+            int _flags, _joints;
+            this->data = nullptr;
+            this->joints = 0;
+            if (!pose_frame::isFrame(_data, len) || (std::uint8_t) _data[4] != pose_frame::VERSION) { return false; }
+            _flags = (std::uint8_t) _data[5];
+            // frames with flags of a later layout can not be read with this one.
+            if ((_flags & ~(pose_frame::FLAG_ROTATIONS | pose_frame::FLAG_QUANTIZED)) != 0) { return false; }
+            _joints = load<std::uint16_t>(_data + 6, 0);
+            if (len < pose_frame::frameSize(_joints, _flags)) { return false; }
+
+            this->data = _data;
+            this->flags = _flags;
+            this->joints = _joints;
+            this->frame = load<std::uint32_t>(_data + 8, 0);
+            this->timestamp = load<std::uint64_t>(_data + 12, 0);
+            this->positionData = _data + pose_frame::HEADER_SIZE;
+            if (isQuantized()) {
+                for (int axis = 0; axis < 3; ++axis) {
+                    this->origin[axis] = load<float>(this->positionData, axis);
+                    this->step[axis] = load<float>(this->positionData, axis + 3);
+                }
+                this->positionData += pose_frame::QUANTIZE_SIZE;
+            }
+            this->rotationData = hasRotations() ?
+                this->positionData + this->joints * 3 * (isQuantized() ? sizeof(std::uint16_t) : sizeof(float)) : nullptr;
+            return true;
+        }
+
+        bool pose_frame_view::valid() const {
+            return this->data != nullptr;
+        }
+
+        std::uint32_t pose_frame_view::getFrame() const {
+            return this->frame;
+        }
+
+        std::uint64_t pose_frame_view::getTimestamp() const {
+            return this->timestamp;
+        }
+
+        int pose_frame_view::getJointCount() const {
+            return this->joints;
+        }
+
+        bool pose_frame_view::hasRotations() const {
+            return (this->flags & pose_frame::FLAG_ROTATIONS) != 0;
+        }
+
+        bool pose_frame_view::isQuantized() const {
+            return (this->flags & pose_frame::FLAG_QUANTIZED) != 0;
+        }
+
+        void pose_frame_view::getPosition(int joint, float* xyz) const {
+            for (int axis = 0; axis < 3; ++axis) {
+                if (isQuantized()) {
+                    xyz[axis] = this->origin[axis] + load<std::uint16_t>(this->positionData, axis * this->joints + joint) * this->step[axis];
+                }
+                else {
+                    xyz[axis] = load<float>(this->positionData, axis * this->joints + joint);
+                }
+            }
+        }
+
+        void pose_frame_view::getRotation(int joint, float* xyzw) const {
+            if (!hasRotations()) {
+                xyzw[0] = xyzw[1] = xyzw[2] = 0.0f;
+                xyzw[3] = 1.0f;
+                return;
+            }
+            for (int axis = 0; axis < 4; ++axis) {
+                xyzw[axis] = isQuantized() ?
+                    load<std::int16_t>(this->rotationData, axis * this->joints + joint) / ROTATION_SCALE :
+                    load<float>(this->rotationData, axis * this->joints + joint);
+            }
+        }
+
+        void pose_frame_view::copyPositions(float* xyz) const {
+            // one pass per axis keeps the reads sequential.
+            for (int axis = 0; axis < 3; ++axis) {
+                if (isQuantized()) {
+                    const char* axisData = this->positionData + axis * this->joints * sizeof(std::uint16_t);
+                    for (int i = 0; i < this->joints; ++i) {
+                        xyz[i * 3 + axis] = this->origin[axis] + load<std::uint16_t>(axisData, i) * this->step[axis];
+                    }
+                }
+                else {
+                    const char* axisData = this->positionData + axis * this->joints * sizeof(float);
+                    for (int i = 0; i < this->joints; ++i) {
+                        xyz[i * 3 + axis] = load<float>(axisData, i);
+                    }
+                }
+            }
+        }
+
+        void pose_frame_view::copyRotations(float* xyzw) const {
+            if (!hasRotations()) {
+                for (int i = 0; i < this->joints; ++i) { getRotation(i, xyzw + i * 4); }
+                return;
+            }
+            for (int axis = 0; axis < 4; ++axis) {
+                if (isQuantized()) {
+                    const char* axisData = this->rotationData + axis * this->joints * sizeof(std::int16_t);
+                    for (int i = 0; i < this->joints; ++i) {
+                        xyzw[i * 4 + axis] = load<std::int16_t>(axisData, i) / ROTATION_SCALE;
+                    }
+                }
+                else {
+                    const char* axisData = this->rotationData + axis * this->joints * sizeof(float);
+                    for (int i = 0; i < this->joints; ++i) {
+                        xyzw[i * 4 + axis] = load<float>(axisData, i);
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,193 @@
+#include "corelink/pose/pose_text.h"
+
+#include <cstdlib>
+#include <cstdint>
+#ifdef CORELINK_POSE_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace CorelinkDLL {
+    namespace Pose {
+        /// Powers of 10 exactly representable as doubles.
+        static const double POW10[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+            1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+        static const int POW10_MAX = 22;
+        /// Mantissas up to 2^53 convert to double exactly.
+        static const std::uint64_t MANTISSA_MAX = 1ULL << 53;
+        /// Digits kept in the mantissa before the rest only move the exponent.
+        static const int DIGITS_MAX = 19;
+
+        static inline bool isDelimiter(char c) {
+            return c == ',' || c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == ';';
+        }
+
+        static inline bool isDigit(char c) {
+            return (unsigned char)(c - '0') < 10;
+        }
+
+        /**
+         * Reads digits into mantissa. Digits past DIGITS_MAX are counted in dropped instead.
+         * @return End of the digits.
+         */
+        static inline const char* readDigits(const char* p, const char* end, std::uint64_t& mantissa, int& digits, int& dropped) {
+            for (; p < end && isDigit(*p); ++p) {
+                if (digits < DIGITS_MAX) {
+                    mantissa = mantissa * 10 + (std::uint64_t)(*p - '0');
+                    // leading zeros do not use up precision.
+                    if (mantissa != 0) { ++digits; }
+                }
+                else {
+                    ++dropped;
+                }
+            }
+            return p;
+        }
+
+        static bool parseFallback(const char* begin, const char* end, float& out) {
+            char buffer[pose_text::MAX_VALUE_LEN + 1];
+            char* parsedEnd;
+            int len = (int)(end - begin);
+            if (len > pose_text::MAX_VALUE_LEN) { return false; }
+            memcpy(buffer, begin, len);
+            buffer[len] = '\0';
+            out = strtof(buffer, &parsedEnd);
+            return parsedEnd == buffer + len;
+        }
+
+        bool pose_text::parseValue(const char* begin, const char* end, float& out) {
+            const char* p = begin;
+            const char* digitStart;
+            std::uint64_t mantissa = 0;
+            int digits = 0, dropped = 0, scale = 0, exponent = 0;
+            bool negative = false, expNegative = false;
+            double val;
+
+            if (p < end && (*p == '-' || *p == '+')) {
+                negative = *p == '-';
+                ++p;
+            }
+            digitStart = p;
+            p = readDigits(p, end, mantissa, digits, dropped);
+            scale = dropped;
+            if (p < end && *p == '.') {
+                const char* fracStart = ++p;
+                dropped = 0;
+                p = readDigits(p, end, mantissa, digits, dropped);
+                // every fraction digit kept in the mantissa moves the point left.
+                scale -= (int)(p - fracStart) - dropped;
+                if (p == fracStart && fracStart - 1 == digitStart) { return false; }
+            }
+            else if (p == digitStart) {
+                return false;
+            }
+            if (p < end && (*p == 'e' || *p == 'E')) {
+                const char* expStart;
+                ++p;
+                if (p < end && (*p == '-' || *p == '+')) {
+                    expNegative = *p == '-';
+                    ++p;
+                }
+                expStart = p;
+                for (; p < end && isDigit(*p); ++p) {
+                    if (exponent < 10000) { exponent = exponent * 10 + (*p - '0'); }
+                }
+                if (p == expStart) { return false; }
+                if (expNegative) { exponent = -exponent; }
+            }
+            if (p != end) { return false; }
+
+            scale += exponent;
+            if (mantissa > MANTISSA_MAX || scale < -POW10_MAX || scale > POW10_MAX) {
+                return parseFallback(begin, end, out);
+            }
+            // exact mantissa times an exact power of 10 rounds once.
+            val = (double) mantissa;
+            val = scale < 0 ? val / POW10[-scale] : val * POW10[scale];
+            out = (float)(negative ? -val : val);
+            return true;
+        }
+
+        int pose_text::parseScalar(const char* data, int len, float* out, int maxOut) {
+            const char* p = data;
+            const char* end = data + len;
+            const char* valueEnd;
+            int count = 0;
+            while (true) {
+                while (p < end && isDelimiter(*p)) { ++p; }
+                if (p == end) { return count; }
+                for (valueEnd = p; valueEnd < end && !isDelimiter(*valueEnd); ++valueEnd) {}
+                if (count == maxOut || !parseValue(p, valueEnd, out[count])) { return -1; }
+                ++count;
+                p = valueEnd;
+            }
+        }
+
+#ifdef CORELINK_POSE_SSE2
+        static inline int countTrailingZeros(unsigned int mask) {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return (int) index;
+#else
+            return __builtin_ctz(mask);
+#endif
+        }
+
+        /**
+         * Finds the first delimiter at or after p, 16 bytes at a time.
+         */
+        static inline const char* findDelimiter(const char* p, const char* end) {
+            const __m128i comma = _mm_set1_epi8(',');
+            const __m128i semicolon = _mm_set1_epi8(';');
+            const __m128i space = _mm_set1_epi8(' ');
+            // '\t', '\n' and '\r' are matched as the range 9..13, which also stops on '\v' and '\f'.
+            const __m128i controlLow = _mm_set1_epi8(9 - 1);
+            const __m128i controlHigh = _mm_set1_epi8(13 + 1);
+            __m128i block, hits;
+            unsigned int mask;
+            while (end - p >= 16) {
+                block = _mm_loadu_si128((const __m128i*) p);
+                hits = _mm_or_si128(_mm_cmpeq_epi8(block, comma), _mm_cmpeq_epi8(block, semicolon));
+                hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, space));
+                hits = _mm_or_si128(hits, _mm_and_si128(_mm_cmpgt_epi8(block, controlLow), _mm_cmplt_epi8(block, controlHigh)));
+                mask = (unsigned int) _mm_movemask_epi8(hits);
+                if (mask != 0) { return p + countTrailingZeros(mask); }
+                p += 16;
+            }
+            while (p < end && !isDelimiter(*p)) { ++p; }
+            return p;
+        }
+
+        int pose_text::parse(const char* data, int len, float* out, int maxOut) {
+            const char* p = data;
+            const char* end = data + len;
+            const char* valueEnd;
+            int count = 0;
+            while (true) {
+                while (p < end && isDelimiter(*p)) { ++p; }
+                if (p == end) { return count; }
+                valueEnd = findDelimiter(p, end);
+                // a '\v' or '\f' left at valueEnd is not skipped as a delimiter, so the next value is empty and rejected like parseScalar does.
+                if (count == maxOut || !parseValue(p, valueEnd, out[count])) { return -1; }
+                ++count;
+                p = valueEnd;
+            }
+        }
+#else
+        int pose_text::parse(const char* data, int len, float* out, int maxOut) {
+            return parseScalar(data, len, out, maxOut);
+        }
+#endif
+
+        int pose_text::parsePositions(const char* data, int len, float* positions, int maxJoints) {
+            int count = parse(data, len, positions, maxJoints * 3);
+            if (count < 0 || count % 3 != 0) { return -1; }
+            return count / 3;
+        }
+    }
+}
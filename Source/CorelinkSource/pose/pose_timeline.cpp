@@ -0,0 +1,129 @@
+#include "corelink/pose/pose_timeline.h"
+
+#ifdef CORELINK_POSE_SSE2
+#include <xmmintrin.h>
+#endif
+
+namespace CorelinkDLL {
+    namespace Pose {
+        pose_timeline::pose_timeline(int joints, int capacity, double maxExtrapolation) :
+            joints(0), capacity(capacity < 2 ? 2 : capacity), maxExtrapolation(maxExtrapolation < 0 ? 0 : maxExtrapolation),
+            frames(), times(), first(0), count(0)
+        {
+            reset(joints);
+        }
+
+        void pose_timeline::reset(int _joints) {
+            this->joints = _joints < 0 ? 0 : _joints;
+            this->frames.assign((std::size_t) this->capacity * this->joints * 3, 0.0f);
+            this->times.assign(this->capacity, 0.0);
+            this->first = 0;
+            this->count = 0;
+        }
+
+        const float* pose_timeline::frameAt(int index) const {
+            return this->frames.data() + (std::size_t)((this->first + index) % this->capacity) * this->joints * 3;
+        }
+
+        double pose_timeline::timeAt(int index) const {
+            return this->times[(this->first + index) % this->capacity];
+        }
+
+        bool pose_timeline::push(double time, const float* xyz) {
+            int slot;
+            float* frame;
+            if (this->count > 0 && time <= newestTime()) { return false; }
+            if (this->count == this->capacity) {
+                this->first = (this->first + 1) % this->capacity;
+                --this->count;
+            }
+            slot = (this->first + this->count) % this->capacity;
+            frame = this->frames.data() + (std::size_t) slot * this->joints * 3;
+            for (int i = 0; i < this->joints; ++i) {
+                frame[i] = xyz[i * 3];
+                frame[this->joints + i] = xyz[i * 3 + 1];
+                frame[this->joints * 2 + i] = xyz[i * 3 + 2];
+            }
+            this->times[slot] = time;
+            ++this->count;
+            return true;
+        }
+
+        int pose_timeline::sampleSoA(double time, float* soa) const {
+            int len = this->joints * 3;
+            int index;
+            double span;
+            if (this->count == 0) { return SAMPLE_EMPTY; }
+            if (this->count == 1 || time <= oldestTime()) {
+                memcpy(soa, frameAt(0), len * sizeof(float));
+                return SAMPLE_HELD;
+            }
+            if (time > newestTime()) {
+                // keep moving along the last two frames for a short dropout, then hold.
+                span = newestTime() - timeAt(this->count - 2);
+                if (time - newestTime() > this->maxExtrapolation) {
+                    time = newestTime() + this->maxExtrapolation;
+                }
+                lerp(frameAt(this->count - 2), frameAt(this->count - 1), (float)((time - timeAt(this->count - 2)) / span), soa, len);
+                return SAMPLE_EXTRAPOLATED;
+            }
+            // queries are usually just behind the newest frame.
+            for (index = this->count - 2; index > 0 && timeAt(index) > time; --index) {}
+            span = timeAt(index + 1) - timeAt(index);
+            lerp(frameAt(index), frameAt(index + 1), (float)((time - timeAt(index)) / span), soa, len);
+            return SAMPLE_INTERPOLATED;
+        }
+
+        int pose_timeline::sample(double time, float* xyz) const {
+            // one frame worth of scratch per thread so sampling does not allocate after the first call.
+            static thread_local std::vector<float> soa;
+            int result;
+            soa.resize(this->joints * 3);
+            result = sampleSoA(time, soa.data());
+            if (result != SAMPLE_EMPTY) {
+                soaToInterleaved(soa.data(), this->joints, xyz);
+            }
+            return result;
+        }
+
+        int pose_timeline::getJoints() const {
+            return this->joints;
+        }
+
+        int pose_timeline::size() const {
+            return this->count;
+        }
+
+        double pose_timeline::oldestTime() const {
+            return this->count == 0 ? 0.0 : timeAt(0);
+        }
+
+        double pose_timeline::newestTime() const {
+            return this->count == 0 ? 0.0 : timeAt(this->count - 1);
+        }
+
+        void pose_timeline::lerp(const float* a, const float* b, float t, float* out, int len) {
+            int i = 0;
+#ifdef CORELINK_POSE_SSE2
+            const __m128 weight = _mm_set1_ps(t);
+            __m128 va, vb;
+            for (; i + 4 <= len; i += 4) {
+                va = _mm_loadu_ps(a + i);
+                vb = _mm_loadu_ps(b + i);
+                _mm_storeu_ps(out + i, _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(vb, va), weight)));
+            }
+#endif
+            for (; i < len; ++i) {
+                out[i] = a[i] + (b[i] - a[i]) * t;
+            }
+        }
+
+        void pose_timeline::soaToInterleaved(const float* soa, int joints, float* xyz) {
+            for (int i = 0; i < joints; ++i) {
+                xyz[i * 3] = soa[i];
+                xyz[i * 3 + 1] = soa[joints + i];
+                xyz[i * 3 + 2] = soa[joints * 2 + i];
+            }
+        }
+    }
+}
@@ -16,6 +16,11 @@
 #include "CorelinkRecvStream.h"
 #include "CorelinkCallback.h"
 #include "CorelinkRecvData.h"
+#include "CorelinkJsonHeader.h"
+#include "CorelinkCommResponse.h"
+#include "CorelinkHistogram.h"
+#include "CorelinkMetrics.h"
+#include "CorelinkTrace.h"
 
 namespace Corelink {
     
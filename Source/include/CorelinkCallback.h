@@ -9,6 +9,7 @@
 
 namespace Corelink {
     inline void Callback::RecvCallback(STREAM_ID recvID, STREAM_ID sendID, const char* msg, int jsonLen, int msgLen, void* callback) {
+        CORELINK_WRAPPER_TRACE("wrapper callback", sendID);
         Callback* callbackFunc = (Callback*)callback;
         if (callbackFunc == nullptr) { return; }
         callbackFunc->Func(RecvData(recvID, sendID, msg, jsonLen, msgLen));
@@ -29,6 +30,7 @@ namespace Corelink {
     }
 
     inline void CallbackData::RecvCallback(STREAM_ID recvID, STREAM_ID sendID, const char* msg, int jsonLen, int msgLen, void* callback) {
+        CORELINK_WRAPPER_TRACE("wrapper callback", sendID);
         ((CallbackData*)callback)->func(recvID, sendID, msg + jsonLen, msgLen);
     }
 
@@ -50,6 +52,7 @@ namespace Corelink {
     }
 
     inline void CallbackDataVoid::RecvCallback(STREAM_ID recvID, STREAM_ID sendID, const char* msg, int jsonLen, int msgLen, void* callback) {
+        CORELINK_WRAPPER_TRACE("wrapper callback", sendID);
         ((CallbackDataVoid*)callback)->func(((CallbackDataVoid*)callback)->obj, recvID, sendID, msg + jsonLen, msgLen);
     }
 
@@ -64,21 +67,15 @@ namespace Corelink {
     inline CallbackDataJson::~CallbackDataJson() {}
 
     inline void CallbackDataJson::Func(const RecvData& recvData) {
-        rapidjson::Document json;
-        json.SetObject();
-        if (recvData.hdrLen > 0) {
-            json.Parse(recvData.data, recvData.hdrLen);
-        }
-        this->func(recvData.recvID, recvData.sendID, recvData.data + recvData.hdrLen, recvData.msgLen, json);
+        this->header.reset(recvData.data, recvData.hdrLen);
+        this->func(recvData.recvID, recvData.sendID, recvData.data + recvData.hdrLen, recvData.msgLen, this->header.get());
     }
 
     inline void CallbackDataJson::RecvCallback(STREAM_ID recvID, STREAM_ID sendID, const char* msg, int jsonLen, int msgLen, void* callback) {
-        rapidjson::Document json;
-        json.SetObject();
-        if (jsonLen > 0) {
-            json.Parse(msg, jsonLen);
-        }
-        ((CallbackDataJson*)callback)->func(recvID, sendID, msg + jsonLen, msgLen, json);
+        CORELINK_WRAPPER_TRACE("wrapper callback", sendID);
+        CallbackDataJson* callbackData = (CallbackDataJson*)callback;
+        callbackData->header.reset(msg, jsonLen);
+        callbackData->func(recvID, sendID, msg + jsonLen, msgLen, callbackData->header.get());
     }
 
     /**
@@ -95,21 +92,98 @@ namespace Corelink {
     }
 
     inline void CallbackDataJsonVoid::Func(const RecvData& recvData) {
-        rapidjson::Document json;
-        json.SetObject();
-        if (recvData.hdrLen > 0) {
-            json.Parse(recvData.data, recvData.hdrLen);
-        }
-        this->func(this->obj, recvData.recvID, recvData.sendID, recvData.data + recvData.hdrLen, recvData.msgLen, json);
+        this->header.reset(recvData.data, recvData.hdrLen);
+        this->func(this->obj, recvData.recvID, recvData.sendID, recvData.data + recvData.hdrLen, recvData.msgLen, this->header.get());
     }
 
     inline void CallbackDataJsonVoid::RecvCallback(STREAM_ID recvID, STREAM_ID sendID, const char* msg, int jsonLen, int msgLen, void* callback) {
-        rapidjson::Document json;
-        json.SetObject();
-        if (jsonLen > 0) {
-            json.Parse(msg, jsonLen);
-        }
-        ((CallbackDataJsonVoid*)callback)->func(((CallbackDataJsonVoid*)callback)->obj, recvID, sendID, msg + jsonLen, msgLen, json);
+        CORELINK_WRAPPER_TRACE("wrapper callback", sendID);
+        CallbackDataJsonVoid* callbackData = (CallbackDataJsonVoid*)callback;
+        callbackData->header.reset(msg, jsonLen);
+        callbackData->func(callbackData->obj, recvID, sendID, msg + jsonLen, msgLen, callbackData->header.get());
+    }
+
+    /**
+     * CallbackDataHeader
+     */
+
+    inline CallbackDataHeader::CallbackDataHeader(void(*func)(const STREAM_ID&, const STREAM_ID&, const char*, const int&, JsonHeader&)) {
+        this->func = func;
+    }
+
+    inline CallbackDataHeader::~CallbackDataHeader() {}
+
+    inline void CallbackDataHeader::Func(const RecvData& recvData) {
+        this->header.reset(recvData.data, recvData.hdrLen);
+        this->func(recvData.recvID, recvData.sendID, recvData.data + recvData.hdrLen, recvData.msgLen, this->header);
+    }
+
+    inline void CallbackDataHeader::RecvCallback(STREAM_ID recvID, STREAM_ID sendID, const char* msg, int jsonLen, int msgLen, void* callback) {
+        CORELINK_WRAPPER_TRACE("wrapper callback", sendID);
+        CallbackDataHeader* callbackData = (CallbackDataHeader*)callback;
+        callbackData->header.reset(msg, jsonLen);
+        callbackData->func(recvID, sendID, msg + jsonLen, msgLen, callbackData->header);
+    }
+
+    /**
+     * CallbackDataHeaderVoid
+     */
+
+    inline CallbackDataHeaderVoid::CallbackDataHeaderVoid(void(*func)(void*, const STREAM_ID&, const STREAM_ID&, const char*, const int&, JsonHeader&), void* obj) {
+        this->func = func;
+        this->obj = obj;
+    }
+
+    inline CallbackDataHeaderVoid::~CallbackDataHeaderVoid() {
+        this->obj = nullptr;
+    }
+
+    inline void CallbackDataHeaderVoid::Func(const RecvData& recvData) {
+        this->header.reset(recvData.data, recvData.hdrLen);
+        this->func(this->obj, recvData.recvID, recvData.sendID, recvData.data + recvData.hdrLen, recvData.msgLen, this->header);
+    }
+
+    inline void CallbackDataHeaderVoid::RecvCallback(STREAM_ID recvID, STREAM_ID sendID, const char* msg, int jsonLen, int msgLen, void* callback) {
+        CORELINK_WRAPPER_TRACE("wrapper callback", sendID);
+        CallbackDataHeaderVoid* callbackData = (CallbackDataHeaderVoid*)callback;
+        callbackData->header.reset(msg, jsonLen);
+        callbackData->func(callbackData->obj, recvID, sendID, msg + jsonLen, msgLen, callbackData->header);
+    }
+
+    /**
+     * CallbackInline
+     */
+
+    template<typename F, bool Inline>
+    inline void CallbackInline<F, Inline>::Construct(void* slot, void* src) {
+        new (slot) F(std::move(*(F*)src));
+    }
+
+    template<typename F, bool Inline>
+    inline void CallbackInline<F, Inline>::Destroy(void* slot) {
+        ((F*)slot)->~F();
+    }
+
+    template<typename F, bool Inline>
+    inline void CallbackInline<F, Inline>::RecvCallback(STREAM_ID recvID, STREAM_ID sendID, const char* msg, int jsonLen, int msgLen, void* slot) {
+        CORELINK_WRAPPER_TRACE("wrapper callback", sendID);
+        (*(F*)slot)(RecvData(recvID, sendID, msg, jsonLen, msgLen));
+    }
+
+    template<typename F>
+    inline void CallbackInline<F, false>::Construct(void* slot, void* src) {
+        *(F**)slot = new F(std::move(*(F*)src));
+    }
+
+    template<typename F>
+    inline void CallbackInline<F, false>::Destroy(void* slot) {
+        delete *(F**)slot;
+    }
+
+    template<typename F>
+    inline void CallbackInline<F, false>::RecvCallback(STREAM_ID recvID, STREAM_ID sendID, const char* msg, int jsonLen, int msgLen, void* slot) {
+        CORELINK_WRAPPER_TRACE("wrapper callback", sendID);
+        (**(F**)slot)(RecvData(recvID, sendID, msg, jsonLen, msgLen));
     }
 }
 
@@ -8,6 +8,8 @@
 
 #include "CorelinkConst.h"
 #include <stdexcept>
+#include <type_traits>
+#include <new>
 
 namespace Corelink {
     class CorelinkException;
@@ -18,6 +20,13 @@ namespace Corelink {
     class RecvStream;
     class Callback;
     class RecvData;
+    class JsonHeader;
+    class StringView;
+    class CommResponse;
+    class Histogram;
+    class Metrics;
+    class Trace;
+    class TraceScope;
 }
 
 namespace Corelink {
@@ -27,6 +36,7 @@ namespace Corelink {
         friend class StreamData;
         friend class SendStream;
         friend class RecvStream;
+        friend class Trace;
     private:
         CorelinkException(const std::string& msg, const int& code);
 
@@ -155,6 +165,80 @@ namespace Corelink {
     };
 }
 
+namespace Corelink {
+    /**
+     * Read only view of characters owned by someone else.
+     */
+    class StringView {
+    public:
+        StringView();
+        StringView(const char* data, int len);
+
+        const char* data() const;
+        int size() const;
+        bool empty() const;
+
+        /**
+         * Copies the view into a string.
+         */
+        std::string str() const;
+
+        bool operator==(const StringView& rhs) const;
+        bool operator==(const std::string& rhs) const;
+
+    private:
+        const char* ptr;
+        int len;
+    };
+
+    /**
+     * Response data of a server command, read in place from the dll.
+     * The data is released when the response is destroyed, views taken from it are invalid after that.
+     */
+    class CommResponse {
+    public:
+        /**
+         * Takes the response data of the commID from the dll.
+         * @param commID ID used in the function call.
+         */
+        explicit CommResponse(const int& commID);
+        CommResponse(CommResponse&& rhs);
+        ~CommResponse();
+
+        /**
+         * @return Whether the dll had response data for the commID.
+         */
+        bool valid() const;
+
+        /**
+         * @return Number of strings in the response.
+         */
+        int size() const;
+
+        /**
+         * @param index Index of the string in the response.
+         * @return View of the string.
+         */
+        StringView operator[](int index) const;
+
+        /**
+         * @return Unparsed response data.
+         */
+        StringView raw() const;
+
+    private:
+        int commID;
+        const char* data;
+        int len;
+        /// Views of the strings in the response, built once when the data is taken.
+        std::vector<StringView> views;
+
+        CommResponse(const CommResponse&) = delete;
+        CommResponse& operator=(const CommResponse&) = delete;
+        CommResponse& operator=(CommResponse&&) = delete;
+    };
+}
+
 namespace Corelink {
     class Client {
     private:
@@ -166,13 +250,6 @@ namespace Corelink {
          */
         static bool isActive();
 
-        /**
-         * Helper function to parse the data from the dll.
-         * @param data Array to parse to array of strings.
-         * @return Parsed message.
-         */
-        static std::vector<std::string> getCommResponseDataHelper(char* data);
-        
         /**
          * Retrieves the response message for the client and parses it.
          * @param commID ID to retrieve.
@@ -180,6 +257,13 @@ namespace Corelink {
          */
         static std::vector<std::string> getCommResponseData(const int& commID);
 
+        /**
+         * Retrieves the response message for the client and parses it into views without copying.
+         * @param commID ID to retrieve.
+         * @return Response message. Views are valid while it lives.
+         */
+        static CommResponse getCommResponseView(const int& commID);
+
         /**
          * Helper function to convert vector of strings to const char**.
          * @param vec Vector to convert.
@@ -339,6 +423,56 @@ namespace Corelink {
          * @param streamID ID of stream to remove from both server and client.
          */
         static bool rmStream(const STREAM_ID& streamID);
+
+        /**
+         * Records every packet reaching a receiver stream into segment files named path.NNNNNN.clcap.
+         * @param path Prefix of the segment files.
+         * @param segmentSize Bytes per segment file. 0 for the default.
+         */
+        static void startCapture(const std::string& path, int segmentSize = 0);
+
+        /**
+         * Stops the capture and closes its segment files. Must not be called from a receive callback.
+         */
+        static void stopCapture();
+
+        /**
+         * @return Packets the running or last capture could not record.
+         */
+        static unsigned long long getCaptureDropCount();
+
+        /**
+         * Plays a capture into a stream. Receivers get the packets as if the server sent them, senders send them again.
+         * @param path Prefix the capture was started with.
+         * @param streamID Stream to play into.
+         * @param pacing Const::REPLAY_PACING_ORIGINAL, Const::REPLAY_PACING_SCALED or Const::REPLAY_PACING_ASAP.
+         * @param speed Playback speed for Const::REPLAY_PACING_SCALED.
+         * @param startTime Nanoseconds since the unix epoch to start at. 0 plays from the start.
+         */
+        static void startReplay(const std::string& path, const STREAM_ID& streamID, int pacing = Const::REPLAY_PACING_ORIGINAL,
+            double speed = 1.0, long long startTime = 0);
+
+        /**
+         * Stops the replay. Must not be called from a receive callback.
+         */
+        static void stopReplay();
+
+        static bool isReplayPlaying();
+
+        /**
+         * @return Packets played since the replay started.
+         */
+        static unsigned long long getReplayCount();
+
+        /**
+         * @return Capture timestamp of the last packet played.
+         */
+        static long long getReplayPosition();
+
+        /**
+         * Gets the time span of the capture being replayed, in nanoseconds since the unix epoch.
+         */
+        static void getReplayRange(long long& first, long long& last);
     };
 }
 
@@ -525,6 +659,31 @@ namespace Corelink {
          * @return If stream exists on client.
          */
         bool send(const char* msg, int msgLen, const rapidjson::Document& json, bool serverCheck = false, const int& federationID = 0);
+
+        /**
+         * Sets the codec applied to messages sent on the stream.
+         * Consecutive frames that differ only a little are sent as deltas against the last keyframe.
+         * Receivers on this client rebuild the full frame before the callback.
+         * @param codec Codec to use (Const::CODEC_NONE, Const::CODEC_XOR_DELTA).
+         * @param keyInterval Number of frames between keyframes. A lost keyframe drops frames until the next one.
+         * @return If stream exists on client.
+         */
+        bool setCodec(int codec, int keyInterval = 30);
+
+        /**
+         * Sends messages on the calling thread instead of the send thread. UDP streams only.
+         * Messages still queue while the socket buffer is full, order is kept.
+         * @param enable Send on the calling thread.
+         * @return If stream exists on client and supports direct sending.
+         */
+        bool setDirectSend(bool enable);
+
+        /**
+         * Gets the number of messages waiting to be sent.
+         * The queue is shared with every sender stream of the same protocol.
+         * @return Queued messages. -1 if the stream has no sender.
+         */
+        int getQueueDepth();
     };
 }
 
@@ -595,10 +754,125 @@ namespace Corelink {
          */
         void setOnReceive(void(*func)(void*, const STREAM_ID&, const STREAM_ID&, const char*, const int&, const rapidjson::Document&), void* obj);
 
+        /**
+         * Callback with the format:
+         * sendID
+         * recvID
+         * data
+         * data length
+         * json header, parsed only when accessed
+         */
+        void setOnReceive(void(*func)(const STREAM_ID&, const STREAM_ID&, const char*, const int&, JsonHeader&));
+
+        /**
+         * Callback with the format:
+         * obj passed by user
+         * sendID
+         * recvID
+         * data
+         * data length
+         * json header, parsed only when accessed
+         */
+        void setOnReceive(void(*func)(void*, const STREAM_ID&, const STREAM_ID&, const char*, const int&, JsonHeader&), void* obj);
+
+        /**
+         * Callback to any callable taking the received data, lambdas with captures included.
+         * Callables up to CALLBACK_SLOT_SIZE bytes are stored inside the stream without a wrapper object.
+         * Bigger callables are moved to the heap.
+         * @param func Callable with the signature void(const RecvData&).
+         */
+        template<typename F>
+        auto setOnReceive(F&& func) -> decltype(std::declval<typename std::decay<F>::type&>()(std::declval<const RecvData&>()), void());
+
+        /**
+         * Switches the stream between callbacks and polling.
+         * While polling, messages are kept until poll is called instead of calling the callback.
+         * @param capacity Messages held between polls. Set by the first call for the life of the stream. 0 to go back to callbacks.
+         * @return If stream exists on client.
+         */
+        bool setPolling(int capacity);
+
+        /**
+         * Takes every message received since the last poll, e.g. once per game tick.
+         * Only one thread may poll a stream.
+         * @param out Stores the messages. The data is valid until the next poll.
+         * @param max Size of out.
+         * @return Number of messages stored in out. -1 if the stream is not polled.
+         */
+        int poll(RecvData* out, int max);
+
+        /**
+         * @return Messages dropped because the stream was not polled in time.
+         */
+        unsigned long long getPollDropCount();
+
         std::vector<STREAM_ID> listSources();
     };
 }
 
+namespace Corelink {
+    /**
+     * Lazy view of the json header of a received message.
+     * The header is parsed on first access into an arena owned by the view and reused for every message of the stream.
+     * If the header bytes match the last parsed header, the previous result is returned without parsing.
+     * Only valid inside the callback it was passed to.
+     */
+    class JsonHeader {
+    public:
+        JsonHeader();
+        ~JsonHeader();
+
+        /**
+         * Points the view at the header of a new message. Does not parse.
+         * @param data Json header.
+         * @param len Length of the json header.
+         */
+        void reset(const char* data, int len);
+
+        /**
+         * Parses the header on first access.
+         * @return Parsed header. Empty object if the message has no header.
+         */
+        const rapidjson::Document& get();
+
+        /**
+         * @return Unparsed json header.
+         */
+        const char* raw() const;
+
+        /**
+         * @return Length of the unparsed json header.
+         */
+        int size() const;
+
+        bool empty() const;
+
+    private:
+        static const int ARENA_INITIAL_SIZE = 1024;
+
+        const char* data;
+        int len;
+        /// The current message was already parsed or matched the last header.
+        bool parsed;
+        /// Bytes the document was last parsed from.
+        std::string lastHeader;
+        bool lastValid;
+        /// Backing memory of allocator. Grown when a header does not fit.
+        std::vector<char> arena;
+        std::size_t arenaNeeded;
+        std::unique_ptr<rapidjson::MemoryPoolAllocator<>> allocator;
+        std::unique_ptr<rapidjson::Document> document;
+
+        /**
+         * Recreates the allocator and document on an arena of the given size.
+         */
+        void resizeArena(std::size_t size);
+
+        JsonHeader(const JsonHeader&) = delete;
+        JsonHeader& operator=(const JsonHeader&) = delete;
+    };
+}
+
 namespace Corelink {
     class Callback {
     public:
@@ -664,6 +938,9 @@ namespace Corelink {
          */
         void(*func)(const STREAM_ID&, const STREAM_ID&, const char*, const int&, const rapidjson::Document&);
 
+        /// Reused between messages of the stream.
+        JsonHeader header;
+
         CallbackDataJson(void(*func)(const STREAM_ID&, const STREAM_ID&, const char*, const int&, const rapidjson::Document&));
 
         ~CallbackDataJson();
@@ -688,6 +965,9 @@ namespace Corelink {
 
         void* obj;
 
+        /// Reused between messages of the stream.
+        JsonHeader header;
+
         CallbackDataJsonVoid(void(*func)(void*, const STREAM_ID&, const STREAM_ID&, const char*, const int&, const rapidjson::Document&), void* obj);
         
         ~CallbackDataJsonVoid();
@@ -696,11 +976,93 @@ namespace Corelink {
 
         static void RecvCallback(STREAM_ID recvID, STREAM_ID sendID, const char* msg, int jsonLen, int msgLen, void* callback);
     };
+
+    class CallbackDataHeader : public Callback {
+    public:
+        /**
+         * Data order:
+         * sendID
+         * recvID
+         * data
+         * data length
+         * json header
+         */
+        void(*func)(const STREAM_ID&, const STREAM_ID&, const char*, const int&, JsonHeader&);
+
+        /// Reused between messages of the stream.
+        JsonHeader header;
+
+        CallbackDataHeader(void(*func)(const STREAM_ID&, const STREAM_ID&, const char*, const int&, JsonHeader&));
+
+        ~CallbackDataHeader();
+
+        void Func(const RecvData& recvData) override;
+
+        static void RecvCallback(STREAM_ID recvID, STREAM_ID sendID, const char* msg, int jsonLen, int msgLen, void* callback);
+    };
+
+    class CallbackDataHeaderVoid : public Callback {
+    public:
+        /**
+         * Data order:
+         * obj passed by user
+         * sendID
+         * recvID
+         * data
+         * data length
+         * json header
+         */
+        void(*func)(void*, const STREAM_ID&, const STREAM_ID&, const char*, const int&, JsonHeader&);
+
+        void* obj;
+
+        /// Reused between messages of the stream.
+        JsonHeader header;
+
+        CallbackDataHeaderVoid(void(*func)(void*, const STREAM_ID&, const STREAM_ID&, const char*, const int&, JsonHeader&), void* obj);
+
+        ~CallbackDataHeaderVoid();
+
+        void Func(const RecvData& recvData) override;
+
+        static void RecvCallback(STREAM_ID recvID, STREAM_ID sendID, const char* msg, int jsonLen, int msgLen, void* callback);
+    };
+
+    /**
+     * Dispatch for a callable of type F stored in the callback slot of a receiver stream.
+     * Generated per callable so the call into F can be inlined into RecvCallback.
+     */
+    template<typename F, bool Inline = (sizeof(F) <= CorelinkDLL::Object::Stream::CALLBACK_SLOT_SIZE && alignof(F) <= alignof(std::max_align_t))>
+    class CallbackInline {
+    public:
+        /**
+         * Moves the callable at src into slot.
+         */
+        static void Construct(void* slot, void* src);
+
+        static void Destroy(void* slot);
+
+        static void RecvCallback(STREAM_ID recvID, STREAM_ID sendID, const char* msg, int jsonLen, int msgLen, void* slot);
+    };
+
+    /**
+     * Callables too big for the slot. The slot holds a pointer to the callable.
+     */
+    template<typename F>
+    class CallbackInline<F, false> {
+    public:
+        static void Construct(void* slot, void* src);
+
+        static void Destroy(void* slot);
+
+        static void RecvCallback(STREAM_ID recvID, STREAM_ID sendID, const char* msg, int jsonLen, int msgLen, void* slot);
+    };
 }
 
 namespace Corelink {
     class RecvData {
     public:
+        RecvData();
         RecvData(STREAM_ID recvID, STREAM_ID sendID, const char* data, int hdrLen, int msgLen);
         RecvData(const RecvData& rhs);
         ~RecvData();
@@ -713,4 +1075,161 @@ namespace Corelink {
         int msgLen;
     };
 }
+
+namespace Corelink {
+    /**
+     * Log-linear latency histogram kept by the dll.
+     * Any number of threads may record at once without locking or allocating.
+     * Percentiles are upper bounds within 1/32 of the value.
+     */
+    class Histogram {
+    public:
+        Histogram();
+        ~Histogram();
+        Histogram(Histogram&& rhs);
+        Histogram& operator=(Histogram&& rhs);
+
+        /**
+         * @param value Value to count, usually nanoseconds.
+         */
+        void record(unsigned long long value);
+
+        /**
+         * Records the nanoseconds since start.
+         */
+        void recordSince(std::chrono::steady_clock::time_point start);
+
+        /**
+         * Adds the counts of other to this histogram.
+         */
+        void merge(const Histogram& other);
+
+        /**
+         * Adds the counts of an export made by serialize, e.g. one sent by another process.
+         * @return False if data is not a valid export.
+         */
+        bool merge(const std::string& data);
+
+        void reset();
+
+        unsigned long long getCount() const;
+        double getMean() const;
+        unsigned long long getMin() const;
+        unsigned long long getMax() const;
+
+        /**
+         * @param percent Percentile between 0 and 100.
+         */
+        unsigned long long getPercentile(double percent) const;
+
+        /**
+         * @return Compact binary export of the counts.
+         */
+        std::string serialize() const;
+
+        /**
+         * @return Dll handle of the histogram, for the C functions.
+         */
+        void* getHandle() const;
+
+    private:
+        void* handle;
+
+        Histogram(const Histogram&) = delete;
+        Histogram& operator=(const Histogram&) = delete;
+    };
+}
+
+namespace Corelink {
+    /**
+     * Counters, gauges and histograms the dll keeps about its streams, queues, control requests, errors and threads.
+     */
+    class Metrics {
+    private:
+        Metrics() = delete;
+        ~Metrics() = delete;
+    public:
+        /**
+         * @return Json snapshot of every metric:
+         * {"time": microseconds since the unix epoch, "counters": {name: value}, "gauges": {name: value},
+         * "histograms": {name: {"count", "mean", "min", "p50", "p90", "p99", "max"}}}
+         */
+        static std::string snapshot();
+
+        /**
+         * Reads a single counter or gauge, e.g. "stream.<id>.packets" or "send.udp.queue".
+         * @param value Stores the value.
+         * @return False if no counter or gauge is registered under name.
+         */
+        static bool getValue(const std::string& name, long long& value);
+    };
+}
+
+namespace Corelink {
+    /**
+     * Records timed events along the receive, send and control paths, exported for chrome://tracing or Perfetto.
+     * The dll records its own events only when built with CORELINK_TRACE, wrapper events can be added either way.
+     */
+    class Trace {
+    private:
+        Trace() = delete;
+        ~Trace() = delete;
+    public:
+        /**
+         * @return True if the dll was built with its trace points.
+         */
+        static bool isAvailable();
+
+        /**
+         * Drops the events recorded so far and starts recording.
+         */
+        static void start();
+
+        static void stop();
+
+        static bool isEnabled();
+
+        /**
+         * Writes the events recorded since start to a Chrome trace JSON file.
+         * @param path File to write.
+         * @return Events lost because a thread recorded more than its ring holds.
+         */
+        static unsigned long long exportFile(const std::string& path);
+
+        /**
+         * Names the calling thread in the export.
+         * @param name Static string naming the thread.
+         */
+        static void setThreadName(const char* name);
+    };
+
+    /**
+     * Records the lifetime of the scope as an event on the calling thread.
+     * Costs a single dll call while tracing is stopped.
+     */
+    class TraceScope {
+    public:
+        /**
+         * @param name Static string naming the event.
+         * @param arg Value shown with the event.
+         */
+        TraceScope(const char* name, long long arg = 0);
+        ~TraceScope();
+
+    private:
+        const char* name;
+        long long arg;
+        long long start;
+
+        TraceScope(const TraceScope&) = delete;
+        TraceScope& operator=(const TraceScope&) = delete;
+    };
+}
+
+/// Times the rest of the enclosing wrapper scope when built with CORELINK_TRACE.
+#ifdef CORELINK_TRACE
+#define CORELINK_WRAPPER_TRACE(name, arg) Corelink::TraceScope CORELINK_TRACE_CONCAT(wrapperTrace, __LINE__)(name, (long long) (arg))
+#else
+#define CORELINK_WRAPPER_TRACE(name, arg) do {} while (0)
+#endif
 #endif
\ No newline at end of file
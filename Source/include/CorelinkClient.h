@@ -15,41 +15,18 @@ namespace Corelink {
         return CorelinkDLL::getClientState();
     }
 
-    inline std::vector<std::string> Client::getCommResponseDataHelper(char* data) {
-        std::vector<std::string> dataParsed;
-        int* dataCast;
-        int lenHeader;
-        int lenData;
-        dataCast = (int*) data;
-        dataParsed = std::vector<std::string>();
-        dataParsed.resize(dataCast[0]);
-        lenHeader = (dataCast[0] + 1) * sizeof(int);
-        lenData = 0;
-        for (int i = 0; i < dataCast[0]; ++i) {
-            dataParsed[i] = std::string(data + lenHeader + lenData, dataCast[i + 1]);
-            lenData += dataCast[i + 1];
-        }
-        dataCast = nullptr;
-        return dataParsed;
-    }
-
     inline std::vector<std::string> Client::getCommResponseData(const int& commID) {
-        int responseLen;
-        char* responseMsg;
+        CommResponse response(commID);
         std::vector<std::string> data;
-    #ifdef WRAPPER_ALLOC
-        responseLen = CorelinkDLL::getCommDataLen(commID);
-        responseMsg = new char[responseLen];
-        CorelinkDLL::getCommDataStr(commID, responseMsg);
-        data = getCommResponseDataHelper(responseMsg);
-        delete[] responseMsg;
-        return data;
-    #else
-        responseMsg = CorelinkDLL::getCommData(commID, responseLen);
-        data = getCommResponseDataHelper(responseMsg);
-        CorelinkDLL::freeData(responseMsg);
+        data.reserve(response.size());
+        for (int i = 0; i < response.size(); ++i) {
+            data.emplace_back(response[i].data(), response[i].size());
+        }
         return data;
-    #endif
+    }
+
+    inline CommResponse Client::getCommResponseView(const int& commID) {
+        return CommResponse(commID);
     }
 
     inline const char** Client::vecStringToCharArray(const std::vector<std::string>& vec) {
@@ -157,7 +134,6 @@ namespace Corelink {
         rapidjson::StringBuffer buffer;
         rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
         int commID, errorID;
-        std::string jsonStr;
 
         res.SetObject();
         if (!json.IsObject()) {
@@ -165,43 +141,35 @@ namespace Corelink {
         }
 
         json.Accept(writer);
-        jsonStr = buffer.GetString();
-        CorelinkDLL::commGeneric(jsonStr.c_str(), (int) jsonStr.size(), commID, errorID);
+        CorelinkDLL::commGeneric(buffer.GetString(), (int) buffer.GetSize(), commID, errorID);
         CorelinkException::GetDLLException(errorID);
-        jsonStr = getCommResponseData(commID)[0];
-        res.Parse(jsonStr.c_str(), jsonStr.size());
+        CommResponse response(commID);
+        if (response.size() > 0) {
+            res.Parse(response[0].data(), response[0].size());
+        }
         return res;
     }
 
     inline rapidjson::Document Client::genericComm(const std::string& json) {
-        rapidjson::Document res = rapidjson::Document();
-        int commID, errorID;
-        std::string jsonStr;
-        CorelinkDLL::commGeneric(json.c_str(), (int) json.size(), commID, errorID);
-        CorelinkException::GetDLLException(errorID);
-        jsonStr = getCommResponseData(commID)[0];
-        
-        res.SetObject();
-        res.Parse(jsonStr.c_str(), jsonStr.size());
-        return res;
+        return genericComm(json.c_str(), (int) json.size());
     }
 
     inline rapidjson::Document Client::genericComm(const char* json, const int& len) {
         rapidjson::Document res = rapidjson::Document();
         int commID, errorID;
-        std::string jsonStr;
         CorelinkDLL::commGeneric(json, len, commID, errorID);
         CorelinkException::GetDLLException(errorID);
-        jsonStr = getCommResponseData(commID)[0];
+        CommResponse response(commID);
         
         res.SetObject();
-        res.Parse(jsonStr.c_str(), jsonStr.size());
+        if (response.size() > 0) {
+            res.Parse(response[0].data(), response[0].size());
+        }
         return res;
     }
 
     inline std::vector<int> Client::listStreams(const std::vector<std::string>& workspaces, const std::vector<std::string>& types) {
         int commID, errorID;
-        std::vector<std::string> response;
         std::vector<int> data;
         const char** dataWorkspaces = vecStringToCharArray(workspaces);
         const char** dataTypes = vecStringToCharArray(types);
@@ -209,10 +177,10 @@ namespace Corelink {
         delete[] dataWorkspaces;
         delete[] dataTypes;
         CorelinkException::GetDLLException(errorID);
-        response = getCommResponseData(commID);
+        CommResponse response(commID);
         data.resize(response.size());
         for (int i = 0; i < response.size(); ++i) {
-            data[i] = *((int*)response[i].c_str());
+            memcpy(&data[i], response[i].data(), sizeof(int));
         }
         return data;
     }
@@ -253,6 +221,47 @@ namespace Corelink {
         bool output = CorelinkDLL::commDisconnect(streamID);
         return output;
     }
+
+    inline void Client::startCapture(const std::string& path, int segmentSize) {
+        int errorID;
+        CorelinkDLL::startCapture(path.c_str(), segmentSize, errorID);
+        CorelinkException::GetDLLException(errorID);
+    }
+
+    inline void Client::stopCapture() {
+        CorelinkDLL::stopCapture();
+    }
+
+    inline unsigned long long Client::getCaptureDropCount() {
+        return CorelinkDLL::getCaptureDropCount();
+    }
+
+    inline void Client::startReplay(const std::string& path, const STREAM_ID& streamID, int pacing, double speed, long long startTime) {
+        int errorID;
+        CorelinkDLL::startReplay(path.c_str(), CorelinkDLL::getStreamState(streamID), CorelinkDLL::getStreamRef(streamID), streamID,
+            pacing, speed, startTime, errorID);
+        CorelinkException::GetDLLException(errorID);
+    }
+
+    inline void Client::stopReplay() {
+        CorelinkDLL::stopReplay();
+    }
+
+    inline bool Client::isReplayPlaying() {
+        return CorelinkDLL::isReplayPlaying();
+    }
+
+    inline unsigned long long Client::getReplayCount() {
+        return CorelinkDLL::getReplayCount();
+    }
+
+    inline long long Client::getReplayPosition() {
+        return CorelinkDLL::getReplayPosition();
+    }
+
+    inline void Client::getReplayRange(long long& first, long long& last) {
+        CorelinkDLL::getReplayRange(first, last);
+    }
 }
 
 #endif
\ No newline at end of file
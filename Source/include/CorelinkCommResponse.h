@@ -0,0 +1,99 @@
+/**
+ * @file CorelinkCommResponse.h
+ * Views of server command responses stored in the dll.
+ */
+#ifndef CORELINKCOMMRESPONSE_H
+#define CORELINKCOMMRESPONSE_H
+
+#include "CorelinkClasses.h"
+
+namespace Corelink {
+    /**
+     * StringView
+     */
+
+    inline StringView::StringView() : ptr(nullptr), len(0) {}
+
+    inline StringView::StringView(const char* data, int len) : ptr(data), len(len) {}
+
+    inline const char* StringView::data() const {
+        return this->ptr;
+    }
+
+    inline int StringView::size() const {
+        return this->len;
+    }
+
+    inline bool StringView::empty() const {
+        return this->len == 0;
+    }
+
+    inline std::string StringView::str() const {
+        return std::string(this->ptr, this->len);
+    }
+
+    inline bool StringView::operator==(const StringView& rhs) const {
+        return this->len == rhs.len && (this->len == 0 || memcmp(this->ptr, rhs.ptr, this->len) == 0);
+    }
+
+    inline bool StringView::operator==(const std::string& rhs) const {
+        return *this == StringView(rhs.c_str(), (int) rhs.size());
+    }
+
+    /**
+     * CommResponse
+     */
+
+    inline CommResponse::CommResponse(const int& commID) : commID(commID), data(nullptr), len(0), views() {
+        int count, lenHeader, lenData, strLen;
+        this->data = CorelinkDLL::lendCommData(commID, this->len);
+        if (this->data == nullptr || this->len < (int) sizeof(int)) { return; }
+        // Data format: (int) number of strings, (int[]) length of each string, (char[]) string data.
+        memcpy(&count, this->data, sizeof(int));
+        if (count < 0 || count > (this->len / (int) sizeof(int)) - 1) { return; }
+        lenHeader = (count + 1) * sizeof(int);
+        lenData = 0;
+        this->views.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            memcpy(&strLen, this->data + (i + 1) * sizeof(int), sizeof(int));
+            if (strLen < 0 || strLen > this->len - lenHeader - lenData) {
+                this->views.clear();
+                return;
+            }
+            this->views.emplace_back(this->data + lenHeader + lenData, strLen);
+            lenData += strLen;
+        }
+    }
+
+    inline CommResponse::CommResponse(CommResponse&& rhs) :
+        commID(rhs.commID), data(rhs.data), len(rhs.len), views(std::move(rhs.views))
+    {
+        rhs.data = nullptr;
+        rhs.len = 0;
+    }
+
+    inline CommResponse::~CommResponse() {
+        if (this->data != nullptr) {
+            CorelinkDLL::releaseCommData(this->commID);
+            this->data = nullptr;
+        }
+    }
+
+    inline bool CommResponse::valid() const {
+        return this->data != nullptr;
+    }
+
+    inline int CommResponse::size() const {
+        return (int) this->views.size();
+    }
+
+    inline StringView CommResponse::operator[](int index) const {
+        return this->views[index];
+    }
+
+    inline StringView CommResponse::raw() const {
+        return StringView(this->data, this->data == nullptr ? 0 : this->len);
+    }
+}
+
+#endif
@@ -94,6 +94,13 @@ namespace Corelink {
         static const int CALLBACK_SUBSCRIBE = CorelinkDLL::CALLBACK_SUBSCRIBE;
         static const int CALLBACK_UPDATE = CorelinkDLL::CALLBACK_UPDATE;
 
+        static const int CODEC_NONE = CorelinkDLL::CODEC_NONE;
+        static const int CODEC_XOR_DELTA = CorelinkDLL::CODEC_XOR_DELTA;
+
+        static const int REPLAY_PACING_ORIGINAL = CorelinkDLL::REPLAY_PACING_ORIGINAL;
+        static const int REPLAY_PACING_SCALED = CorelinkDLL::REPLAY_PACING_SCALED;
+        static const int REPLAY_PACING_ASAP = CorelinkDLL::REPLAY_PACING_ASAP;
+
         static const std::string ErrorCodeString[6] = {
             errorCodeName(0),
             errorCodeName(1),
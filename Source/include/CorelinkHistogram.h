@@ -0,0 +1,92 @@
+/**
+ * @file CorelinkHistogram.h
+ * Latency histograms recorded in the dll.
+ */
+#ifndef CORELINKHISTOGRAM_H
+#define CORELINKHISTOGRAM_H
+
+#include "CorelinkClasses.h"
+
+namespace Corelink {
+    inline Histogram::Histogram() : handle(CorelinkDLL::createHistogram()) {}
+
+    inline Histogram::~Histogram() {
+        CorelinkDLL::destroyHistogram(this->handle);
+    }
+
+    inline Histogram::Histogram(Histogram&& rhs) : handle(rhs.handle) {
+        rhs.handle = nullptr;
+    }
+
+    inline Histogram& Histogram::operator=(Histogram&& rhs) {
+        std::swap(this->handle, rhs.handle);
+        return *this;
+    }
+
+    inline void Histogram::record(unsigned long long value) {
+        CorelinkDLL::recordHistogram(this->handle, value);
+    }
+
+    inline void Histogram::recordSince(std::chrono::steady_clock::time_point start) {
+        CorelinkDLL::recordHistogram(this->handle,
+            (unsigned long long) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    inline void Histogram::merge(const Histogram& other) {
+        CorelinkDLL::mergeHistogram(this->handle, other.handle);
+    }
+
+    inline bool Histogram::merge(const std::string& data) {
+        return CorelinkDLL::importHistogram(this->handle, data.c_str(), (int) data.size());
+    }
+
+    inline void Histogram::reset() {
+        CorelinkDLL::resetHistogram(this->handle);
+    }
+
+    inline unsigned long long Histogram::getCount() const {
+        return CorelinkDLL::getHistogramCount(this->handle);
+    }
+
+    inline double Histogram::getMean() const {
+        return CorelinkDLL::getHistogramMean(this->handle);
+    }
+
+    inline unsigned long long Histogram::getMin() const {
+        return CorelinkDLL::getHistogramMin(this->handle);
+    }
+
+    inline unsigned long long Histogram::getMax() const {
+        return CorelinkDLL::getHistogramMax(this->handle);
+    }
+
+    inline unsigned long long Histogram::getPercentile(double percent) const {
+        return CorelinkDLL::getHistogramPercentile(this->handle, percent);
+    }
+
+    inline std::string Histogram::serialize() const {
+        std::string data;
+        int len;
+    #ifdef WRAPPER_ALLOC
+        // counts recorded between the calls can make the export longer.
+        len = CorelinkDLL::exportHistogramStr(this->handle, nullptr, 0);
+        do {
+            data.resize(len);
+            len = CorelinkDLL::exportHistogramStr(this->handle, &data[0], (int) data.size());
+        } while (len > (int) data.size());
+        data.resize(len);
+        return data;
+    #else
+        char* buffer = CorelinkDLL::exportHistogram(this->handle, len);
+        data = std::string(buffer, len);
+        CorelinkDLL::freeData(buffer);
+        return data;
+    #endif
+    }
+
+    inline void* Histogram::getHandle() const {
+        return this->handle;
+    }
+}
+
+#endif
@@ -0,0 +1,79 @@
+/**
+ * @file CorelinkJsonHeader.h
+ * Lazy view of the json header of received messages.
+ */
+#ifndef CORELINKJSONHEADER_H
+#define CORELINKJSONHEADER_H
+
+#include "CorelinkClasses.h"
+
+namespace Corelink {
+    inline JsonHeader::JsonHeader() :
+        data(nullptr), len(0), parsed(false), lastHeader(), lastValid(false), arena(), arenaNeeded(0)
+    {
+        resizeArena(ARENA_INITIAL_SIZE);
+    }
+
+    inline JsonHeader::~JsonHeader() {
+        // document refers to allocator.
+        document.reset();
+        allocator.reset();
+    }
+
+    inline void JsonHeader::reset(const char* data, int len) {
+        this->data = data;
+        this->len = len;
+        this->parsed = false;
+    }
+
+    inline const rapidjson::Document& JsonHeader::get() {
+        if (this->parsed) { return *this->document; }
+        this->parsed = true;
+        // senders often attach the same header to every frame.
+        if (this->lastValid && (int) this->lastHeader.size() == this->len && memcmp(this->lastHeader.c_str(), this->data, this->len) == 0) {
+            return *this->document;
+        }
+        // last header spilled out of the arena, parse this one into a bigger one.
+        if (this->arenaNeeded > this->arena.size()) {
+            resizeArena(this->arenaNeeded);
+        }
+        // values of the previous header are dropped with the allocator contents.
+        this->allocator->Clear();
+        if (this->len > 0) {
+            this->document->Parse(this->data, this->len);
+        }
+        else {
+            this->document->SetObject();
+        }
+        this->lastHeader.assign(this->data, this->len);
+        this->lastValid = !this->document->HasParseError();
+        if (this->allocator->Capacity() > this->arena.size()) {
+            this->arenaNeeded = this->allocator->Size() * 2;
+        }
+        return *this->document;
+    }
+
+    inline const char* JsonHeader::raw() const {
+        return this->data;
+    }
+
+    inline int JsonHeader::size() const {
+        return this->len;
+    }
+
+    inline bool JsonHeader::empty() const {
+        return this->len == 0;
+    }
+
+    inline void JsonHeader::resizeArena(std::size_t size) {
+        this->document.reset();
+        this->allocator.reset();
+        this->arena.resize(size);
+        this->allocator.reset(new rapidjson::MemoryPoolAllocator<>(this->arena.data(), this->arena.size()));
+        this->document.reset(new rapidjson::Document(this->allocator.get()));
+        this->document->SetObject();
+        this->lastValid = false;
+    }
+}
+
+#endif
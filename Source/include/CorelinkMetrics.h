@@ -0,0 +1,36 @@
+/**
+ * @file CorelinkMetrics.h
+ * Metrics registry of the dll.
+ */
+#ifndef CORELINKMETRICS_H
+#define CORELINKMETRICS_H
+
+#include "CorelinkClasses.h"
+
+namespace Corelink {
+    inline std::string Metrics::snapshot() {
+        std::string data;
+        int len;
+    #ifdef WRAPPER_ALLOC
+        // metrics registered between the calls can make the snapshot longer.
+        len = CorelinkDLL::snapshotMetricsStr(nullptr, 0);
+        do {
+            data.resize(len);
+            len = CorelinkDLL::snapshotMetricsStr(&data[0], (int) data.size());
+        } while (len > (int) data.size());
+        data.resize(len);
+        return data;
+    #else
+        char* buffer = CorelinkDLL::snapshotMetrics(len);
+        data = std::string(buffer, len);
+        CorelinkDLL::freeData(buffer);
+        return data;
+    #endif
+    }
+
+    inline bool Metrics::getValue(const std::string& name, long long& value) {
+        return CorelinkDLL::getMetricValue(name.c_str(), value);
+    }
+}
+
+#endif
@@ -8,6 +8,10 @@
 #include "CorelinkClasses.h"
 
 namespace Corelink {
+    inline RecvData::RecvData() :
+        recvID(STREAM_DEF), sendID(STREAM_DEF), data(nullptr), hdrLen(0), msgLen(0)
+    {}
+
     inline RecvData::RecvData(STREAM_ID recvID, STREAM_ID sendID, const char* data, int hdrLen, int msgLen) :
         recvID(recvID), sendID(sendID), data(data), hdrLen(hdrLen), msgLen(msgLen)
     {}
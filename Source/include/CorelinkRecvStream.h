@@ -82,6 +82,60 @@ namespace Corelink {
         }
     }
 
+    inline void RecvStream::setOnReceive(void(*func)(const STREAM_ID&, const STREAM_ID&, const char*, const int&, JsonHeader&)) {
+        Callback* oldData = (Callback*)CorelinkDLL::setOnRecv(state, streamRef, streamID, CallbackDataHeader::RecvCallback, new CallbackDataHeader(func));
+        if (oldData != nullptr) {
+            delete oldData;
+        }
+    }
+
+    inline void RecvStream::setOnReceive(void(*func)(void*, const STREAM_ID&, const STREAM_ID&, const char*, const int&, JsonHeader&), void* obj) {
+        Callback* oldData = (Callback*)CorelinkDLL::setOnRecv(state, streamRef, streamID, CallbackDataHeaderVoid::RecvCallback, new CallbackDataHeaderVoid(func, obj));
+        if (oldData != nullptr) {
+            delete oldData;
+        }
+    }
+
+    template<typename F>
+    inline auto RecvStream::setOnReceive(F&& func) -> decltype(std::declval<typename std::decay<F>::type&>()(std::declval<const RecvData&>()), void()) {
+        typedef typename std::decay<F>::type Func;
+        typedef CallbackInline<Func> Dispatch;
+        bool found;
+        Func src(std::forward<F>(func));
+        Callback* oldData = (Callback*)CorelinkDLL::setOnRecvInline(state, streamRef, streamID, Dispatch::RecvCallback, Dispatch::Construct, Dispatch::Destroy, &src, found);
+        if (oldData != nullptr) {
+            delete oldData;
+        }
+    }
+
+    inline bool RecvStream::setPolling(int capacity) {
+        return CorelinkDLL::setRecvPolling(this->state, this->streamRef, this->streamID, capacity);
+    }
+
+    inline int RecvStream::poll(RecvData* out, int max) {
+        // reused between polls so a tick does not allocate.
+        static thread_local std::vector<CorelinkDLL::Object::Stream::recv_message> batch;
+        int count;
+        if (max <= 0) { return 0; }
+        CORELINK_WRAPPER_TRACE("poll", this->streamID);
+        if ((int) batch.size() < max) {
+            batch.resize(max);
+        }
+        count = CorelinkDLL::pollMessages(this->state, this->streamRef, this->streamID, batch.data(), max);
+        for (int i = 0; i < count; ++i) {
+            out[i].recvID = batch[i].recvID;
+            out[i].sendID = batch[i].sendID;
+            out[i].data = batch[i].data;
+            out[i].hdrLen = batch[i].hdrLen;
+            out[i].msgLen = batch[i].msgLen;
+        }
+        return count;
+    }
+
+    inline unsigned long long RecvStream::getPollDropCount() {
+        return CorelinkDLL::getPollDropCount(this->state, this->streamRef, this->streamID);
+    }
+
     inline std::vector<STREAM_ID> RecvStream::listSources() {
         return (this->streamID == STREAM_DEF) ? std::vector<STREAM_ID>() : StreamData::listStreamSources(this->streamID);
     }
@@ -70,6 +70,18 @@ namespace Corelink {
         int len = (int)buffer.GetSize();
         return CorelinkDLL::sendMsgJson(this->state, this->streamRef, this->streamID, federationID, msg, msgLen, buffer.GetString(), len, serverCheck);
     }
+
+    inline bool SendStream::setCodec(int codec, int keyInterval) {
+        return CorelinkDLL::setSendCodec(this->state, this->streamRef, this->streamID, codec, keyInterval);
+    }
+
+    inline bool SendStream::setDirectSend(bool enable) {
+        return CorelinkDLL::setSendDirect(this->state, this->streamRef, this->streamID, enable);
+    }
+
+    inline int SendStream::getQueueDepth() {
+        return CorelinkDLL::getSendQueueDepth(this->state);
+    }
 }
 
 #endif
\ No newline at end of file
@@ -111,8 +111,9 @@ namespace Corelink {
         return stream;
     #else
         data = (char*)CorelinkDLL::getStreamData(streamID, len);
-        if (len == 0) { return StreamData(); }
+        if (data == nullptr) { return StreamData(); }
         stream = parse(data);
+        CorelinkDLL::releaseStreamData(data);
         return stream;
     #endif
     }
@@ -0,0 +1,52 @@
+/**
+ * @file CorelinkTrace.h
+ * Hot path tracing recorded in the dll.
+ */
+#ifndef CORELINKTRACE_H
+#define CORELINKTRACE_H
+
+#include "CorelinkClasses.h"
+
+namespace Corelink {
+    inline bool Trace::isAvailable() {
+        return CorelinkDLL::isTraceAvailable();
+    }
+
+    inline void Trace::start() {
+        CorelinkDLL::startTrace();
+    }
+
+    inline void Trace::stop() {
+        CorelinkDLL::stopTrace();
+    }
+
+    inline bool Trace::isEnabled() {
+        return CorelinkDLL::isTraceEnabled();
+    }
+
+    inline unsigned long long Trace::exportFile(const std::string& path) {
+        int errorID;
+        unsigned long long lost = CorelinkDLL::exportTrace(path.c_str(), errorID);
+        CorelinkException::GetDLLException(errorID);
+        return lost;
+    }
+
+    inline void Trace::setThreadName(const char* name) {
+        CorelinkDLL::setTraceThreadName(name);
+    }
+
+    /**
+     * TraceScope
+     */
+
+    inline TraceScope::TraceScope(const char* name, long long arg) : name(name), arg(arg),
+        start(CorelinkDLL::isTraceEnabled() ? CorelinkDLL::getTraceTime() : -1) {}
+
+    inline TraceScope::~TraceScope() {
+        if (this->start >= 0) {
+            CorelinkDLL::addTraceEvent(this->name, this->start, CorelinkDLL::getTraceTime() - this->start, this->arg);
+        }
+    }
+}
+
+#endif
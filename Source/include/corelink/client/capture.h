@@ -0,0 +1,87 @@
+/**
+ * @file capture.h
+ * @brief Header containing the commands to record the packets reaching receiver streams and play them back.
+ */
+#ifndef CORELINK_CLIENT_CAPTURE_H
+#define CORELINK_CLIENT_CAPTURE_H
+
+#include "corelink/headers/header.h"
+#include "corelink/objects/capture/capture_recorder.h"
+#include "corelink/objects/capture/capture_replay.h"
+
+namespace CorelinkDLL {
+    /**
+     * @private
+     * Stops and closes the replay. Called when the client is cleaned up since the replay may feed its streams.
+     */
+    void stopReplayHelper();
+
+    extern "C" {
+        /**
+         * Starts recording every packet that reaches a receiver stream into memory mapped segment files.
+         * Segment n is written to path.n.clcap, with n padded to 6 digits.
+         * Works with or without a connected client.
+         * @param path Prefix of the segment files.
+         * @param segmentSize Bytes per segment file. 0 for the default of 64 MiB.
+         * @param errorID Stores the error if the capture is already running or the first segment could not be created.
+         */
+        EXPORTED void startCapture(const char* path, int segmentSize, int& errorID);
+
+        /**
+         * Stops the capture and closes its segment files.
+         * Must not be called from a receive callback.
+         */
+        EXPORTED void stopCapture();
+
+        /**
+         * @return Packets the running or last capture could not record because the current segment was full.
+         */
+        EXPORTED unsigned long long getCaptureDropCount();
+
+        /**
+         * Opens a capture and plays it into a stream of the client. Replaces the replay already playing.
+         * Receiver streams get the packets through their callback or polling ring as if the server had sent them.
+         * Sender streams send them again, keeping the json header they were received with.
+         * Must not be called from a receive callback, since the replay being replaced may be the one calling it.
+         * @param path Prefix the capture was started with.
+         * @param protocol Type of the stream.
+         * @param ref Reference of the stream.
+         * @param streamID Stream to play into.
+         * @param pacing REPLAY_PACING_ORIGINAL, REPLAY_PACING_SCALED or REPLAY_PACING_ASAP.
+         * @param speed Playback speed for REPLAY_PACING_SCALED. 2 plays twice as fast.
+         * @param startTime Nanoseconds since the unix epoch to start playing at. 0 plays from the start.
+         * @param errorID Stores the error if the capture could not be opened or the arguments are invalid.
+         */
+        EXPORTED void startReplay(const char* path, int protocol, int ref, const STREAM_ID& streamID, int pacing, double speed,
+            long long startTime, int& errorID);
+
+        /**
+         * Stops the replay and closes its capture. Must not be called from a receive callback.
+         */
+        EXPORTED void stopReplay();
+
+        /**
+         * @return If the replay is still playing.
+         */
+        EXPORTED bool isReplayPlaying();
+
+        /**
+         * @return Packets played since the replay started.
+         */
+        EXPORTED unsigned long long getReplayCount();
+
+        /**
+         * @return Capture timestamp of the last packet played, 0 if none.
+         */
+        EXPORTED long long getReplayPosition();
+
+        /**
+         * Gets the time span of the capture opened by the replay.
+         * @param first Stores the timestamp of the first packet. 0 if no replay is open.
+         * @param last Stores the latest timestamp. 0 if no replay is open.
+         */
+        EXPORTED void getReplayRange(long long& first, long long& last);
+    }
+}
+
+#endif
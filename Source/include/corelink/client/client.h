@@ -8,9 +8,12 @@
 #include "corelink/headers/header.h"
 #include "corelink/objects/init.h"
 #include "corelink/objects/client_main.h"
+#include "corelink/client/capture.h"
 #include "corelink/client/core.h"
 #include "corelink/client/mainStream.h"
 #include "corelink/client/dataStream.h"
+#include "corelink/client/metrics.h"
+#include "corelink/client/trace.h"
 
 namespace CorelinkDLL {
 
@@ -45,15 +45,14 @@ namespace CorelinkDLL {
 
     /**
      * Helper function to send and retrieve json as well as call error messages.
-     * @param fileName File name for error source.
-     * @param funcName Function name for error.
+     * @param location Static string naming the file and function for errors, e.g. "core.cpp commConnect".
      * @param msg Json message to send to server.
      * @param json Stores response json.
      * @param commID Unique identifier to retrieve response.
      * @param checkToken Should token be checked.
      * @result Boolean indicating success.
      */
-    bool getJsonResponse(const std::string& fileName, const std::string& funcName, const std::string& msg,
+    bool getJsonResponse(const char* location, const std::string& msg,
             rapidjson::Document& json, const int& commID, int& errorID, bool checkToken = true);
 
     /**
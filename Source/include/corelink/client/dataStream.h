@@ -27,12 +27,19 @@ namespace CorelinkDLL {
 
         /**
          * Gets the data stored for the specified stream.
+         * The data stays valid, even if the stream is removed, until it is passed to releaseStreamData.
          * @param streamID Stream to obtain data of.
          * @param len store length of data or 0 if not found.
          * @return Stream compacted data or nullptr.
          */
         EXPORTED const char* getStreamData(const STREAM_ID& streamID, int& len);
 
+        /**
+         * Releases data returned by getStreamData.
+         * @param data Data to release. nullptr is ignored.
+         */
+        EXPORTED void releaseStreamData(const char* data);
+
         /**
          * Gets the length of the data stored for the specified stream.
          * @param streamID Stream to obtain data of.
@@ -71,6 +78,38 @@ namespace CorelinkDLL {
          */
         EXPORTED bool sendMsgJson(int protocol, int ref, const STREAM_ID& streamID, int federationID, const char* msg, int msgLen, const char* json, int jsonLen, bool serverCheck);
 
+        /**
+         * Sets the codec applied to messages of a sender stream.
+         * Receivers on this client rebuild codec frames automatically.
+         * @param protocol Type of sender stream.
+         * @param ref Stream to obtain reference of stream.
+         * @param streamID Used to check if stream ref is correct.
+         * @param codec Codec to use. CODEC_NONE sends messages as is.
+         * @param keyInterval Number of frames between keyframes.
+         * @return Whether streamid is in the client stream.
+         */
+        EXPORTED bool setSendCodec(int protocol, int ref, const STREAM_ID& streamID, int codec, int keyInterval);
+
+        /**
+         * Sends messages of a sender stream on the calling thread instead of the send thread.
+         * Messages fall back to the send thread while the socket buffer is full, order is kept.
+         * Only supported by UDP streams.
+         * @param protocol Type of sender stream.
+         * @param ref Stream to obtain reference of stream.
+         * @param streamID Used to check if stream ref is correct.
+         * @param enable Send on the calling thread.
+         * @return Whether streamid is in the client stream and the protocol supports direct sending.
+         */
+        EXPORTED bool setSendDirect(int protocol, int ref, const STREAM_ID& streamID, bool enable);
+
+        /**
+         * Gets the number of messages waiting for the send thread of a protocol.
+         * The queue is shared by every sender stream of the protocol.
+         * @param protocol Type of sender stream.
+         * @return Queued messages. -1 if the protocol has no sender.
+         */
+        EXPORTED int getSendQueueDepth(int protocol);
+
         /**
          * Sets the callback for receiver stream.
          * @param protocol Type of receiver stream.
@@ -81,6 +120,54 @@ namespace CorelinkDLL {
          */
         EXPORTED void* setOnRecv(int protocol, int ref, const STREAM_ID& streamID, CorelinkDLL::Object::Stream::Callback func, void* funcData);
 
+        /**
+         * Sets the callback for receiver stream to a callable stored inside the stream.
+         * The callable must fit in CALLBACK_SLOT_SIZE bytes and is passed to func as the extra data.
+         * @param protocol Type of receiver stream.
+         * @param ref Stream to obtain reference of stream.
+         * @param streamID Used to check if stream ref is correct.
+         * @param func Callback function.
+         * @param construct Moves the callable from src into the slot.
+         * @param destroy Destroys the callable in the slot.
+         * @param src Callable to store. Left untouched if the stream is not found.
+         * @param found Stores whether the stream was found.
+         * @return Extra data created by the wrapper for the previous callback or nullptr if none.
+         */
+        EXPORTED void* setOnRecvInline(int protocol, int ref, const STREAM_ID& streamID, CorelinkDLL::Object::Stream::Callback func,
+            CorelinkDLL::Object::Stream::CallbackConstruct construct, CorelinkDLL::Object::Stream::CallbackDestroy destroy, void* src, bool& found);
+
+        /**
+         * Switches a receiver stream between callbacks and polling.
+         * While polling, messages are kept until pollMessages is called instead of calling the callback.
+         * @param protocol Type of receiver stream.
+         * @param ref Stream to obtain reference of stream.
+         * @param streamID Used to check if stream ref is correct.
+         * @param capacity Messages held between polls, newer messages are dropped when full.
+         * The first call sets the capacity for the life of the stream. 0 to go back to callbacks.
+         * @return Whether streamid is in the client stream.
+         */
+        EXPORTED bool setRecvPolling(int protocol, int ref, const STREAM_ID& streamID, int capacity);
+
+        /**
+         * Takes every message received on a polled stream since the last poll.
+         * Only one thread may poll a stream. Polling releases the views of the previous poll.
+         * @param protocol Type of receiver stream.
+         * @param ref Stream to obtain reference of stream.
+         * @param streamID Used to check if stream ref is correct.
+         * @param out Stores views of the messages. Valid until the next poll or the stream is removed.
+         * @param max Size of out.
+         * @return Number of messages stored in out. -1 if the stream is not found or not polled.
+         */
+        EXPORTED int pollMessages(int protocol, int ref, const STREAM_ID& streamID, CorelinkDLL::Object::Stream::recv_message* out, int max);
+
+        /**
+         * @param protocol Type of receiver stream.
+         * @param ref Stream to obtain reference of stream.
+         * @param streamID Used to check if stream ref is correct.
+         * @return Messages dropped because the stream was not polled in time.
+         */
+        EXPORTED unsigned long long getPollDropCount(int protocol, int ref, const STREAM_ID& streamID);
+
         /**
          * Checks whether a stream is a sender on the client.
          * This does not check for streams on the server.
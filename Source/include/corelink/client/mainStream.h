@@ -77,6 +77,21 @@ namespace CorelinkDLL {
          */
         EXPORTED bool getCommDataStr(const int& commID, char* buffer);
 
+        /**
+         * Polls for response data for the commID and lends it without copying.
+         * Call releaseCommData when done reading.
+         * @param commID ID used in the function call.
+         * @param len Stores length of the data. -1 if the data cannot be retrieved.
+         * @return Read only response data. nullptr if the data cannot be retrieved.
+         */
+        EXPORTED const char* lendCommData(const int& commID, int& len);
+
+        /**
+         * Frees response data taken with lendCommData.
+         * @param commID ID used in the function call.
+         */
+        EXPORTED void releaseCommData(const int& commID);
+
         /**
          * Gets list of functions available on the server.\n 
          * Data format:\n 
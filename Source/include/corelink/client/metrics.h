@@ -0,0 +1,107 @@
+/**
+ * @file metrics.h
+ * @brief Header containing the commands to record and read latency histograms and the metrics registry.
+ * Histograms are passed around as opaque handles so the wrapper and the engine can record and display them.
+ * See metrics_registry.h for the metrics recorded by the dll.
+ */
+#ifndef CORELINK_CLIENT_METRICS_H
+#define CORELINK_CLIENT_METRICS_H
+
+#include "corelink/headers/header.h"
+#include "corelink/objects/generics/latency_histogram.h"
+#include "corelink/objects/metrics_registry.h"
+
+namespace CorelinkDLL {
+    extern "C" {
+        /**
+         * Creates an empty histogram. Works with or without a connected client.
+         * @return Handle of the histogram, released by destroyHistogram.
+         */
+        EXPORTED void* createHistogram();
+
+        /**
+         * @param histogram Handle from createHistogram. nullptr is ignored.
+         */
+        EXPORTED void destroyHistogram(void* histogram);
+
+        /**
+         * Counts a value. Wait-free, any number of threads may record at once.
+         * @param value Value to count, usually nanoseconds.
+         */
+        EXPORTED void recordHistogram(void* histogram, unsigned long long value);
+
+        /**
+         * Adds the counts of other to histogram.
+         */
+        EXPORTED void mergeHistogram(void* histogram, const void* other);
+
+        EXPORTED void resetHistogram(void* histogram);
+
+        EXPORTED unsigned long long getHistogramCount(const void* histogram);
+
+        EXPORTED double getHistogramMean(const void* histogram);
+
+        /**
+         * @return Lower bound of the smallest value. 0 if nothing was recorded.
+         */
+        EXPORTED unsigned long long getHistogramMin(const void* histogram);
+
+        /**
+         * @return Upper bound of the largest value. 0 if nothing was recorded.
+         */
+        EXPORTED unsigned long long getHistogramMax(const void* histogram);
+
+        /**
+         * @param percent Percentile between 0 and 100.
+         * @return Upper bound of the percentile, within 1/32 of the value. 0 if nothing was recorded.
+         */
+        EXPORTED unsigned long long getHistogramPercentile(const void* histogram, double percent);
+
+        /**
+         * Exports the counts, see latency_histogram.h for the format.
+         * @param len Stores the length of the export.
+         * @return Export, released by freeData.
+         */
+        EXPORTED char* exportHistogram(const void* histogram, int& len);
+
+        /**
+         * Exports the counts into a buffer of the caller.
+         * @param buffer Stores the export if it fits.
+         * @param bufferLen Size of buffer.
+         * @return Length of the export. Nothing is written if it is larger than bufferLen.
+         */
+        EXPORTED int exportHistogramStr(const void* histogram, char* buffer, int bufferLen);
+
+        /**
+         * Adds the counts of an export to histogram, e.g. one sent by another process.
+         * @return False if data is not a valid export.
+         */
+        EXPORTED bool importHistogram(void* histogram, const char* data, int len);
+
+        /**
+         * Takes a json snapshot of every registered metric, see metrics_registry::snapshot for the layout.
+         * Works with or without a connected client.
+         * @param len Stores the length of the snapshot.
+         * @return Snapshot, released by freeData.
+         */
+        EXPORTED char* snapshotMetrics(int& len);
+
+        /**
+         * Takes a json snapshot of every registered metric into a buffer of the caller.
+         * @param buffer Stores the snapshot if it fits.
+         * @param bufferLen Size of buffer.
+         * @return Length of the snapshot. Nothing is written if it is larger than bufferLen.
+         */
+        EXPORTED int snapshotMetricsStr(char* buffer, int bufferLen);
+
+        /**
+         * Reads a single counter or gauge without taking a snapshot.
+         * @param name Name of the metric, e.g. "send.udp.queue".
+         * @param value Stores the value.
+         * @return False if no counter or gauge is registered under name.
+         */
+        EXPORTED bool getMetricValue(const char* name, long long& value);
+    }
+}
+
+#endif
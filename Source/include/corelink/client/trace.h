@@ -0,0 +1,59 @@
+/**
+ * @file trace.h
+ * @brief Header containing the commands to trace the hot paths and export the trace.
+ * The dll records its own trace points only when built with CORELINK_TRACE, the wrapper can add events either way.
+ */
+#ifndef CORELINK_CLIENT_TRACE_H
+#define CORELINK_CLIENT_TRACE_H
+
+#include "corelink/headers/header.h"
+#include "corelink/objects/trace_ring.h"
+
+namespace CorelinkDLL {
+    extern "C" {
+        /**
+         * @return True if the dll was built with its trace points.
+         */
+        EXPORTED bool isTraceAvailable();
+
+        /**
+         * Drops the events recorded so far and starts recording. Works with or without a connected client.
+         */
+        EXPORTED void startTrace();
+
+        EXPORTED void stopTrace();
+
+        EXPORTED bool isTraceEnabled();
+
+        /**
+         * Writes the events recorded since startTrace to a Chrome trace JSON file, readable by chrome://tracing and Perfetto.
+         * Tracing may keep running during the export.
+         * @param path File to write.
+         * @param errorID Stores the error if the file could not be written.
+         * @return Number of events lost because a thread recorded more than its ring holds.
+         */
+        EXPORTED unsigned long long exportTrace(const char* path, int& errorID);
+
+        /**
+         * @return Nanoseconds on the steady clock the trace is timed with.
+         */
+        EXPORTED long long getTraceTime();
+
+        /**
+         * Records an event on the calling thread. Ignored while tracing is stopped.
+         * @param name Static string naming the event. Must stay valid until the trace is exported.
+         * @param start Nanoseconds from getTraceTime.
+         * @param duration Nanoseconds, -1 for an instant event.
+         * @param arg Value shown with the event.
+         */
+        EXPORTED void addTraceEvent(const char* name, long long start, long long duration, long long arg);
+
+        /**
+         * Names the calling thread in the export.
+         * @param name Static string naming the thread. Must stay valid until the trace is exported.
+         */
+        EXPORTED void setTraceThreadName(const char* name);
+    }
+}
+
+#endif
@@ -7,4 +7,5 @@
 #define CORELINK_CORELINKDLL_H
 #include "corelink/headers/header.h"
 #include "corelink/client/client.h"
+#include "corelink/pose/pose.h"
 #endif
\ No newline at end of file
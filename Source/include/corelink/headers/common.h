@@ -7,6 +7,7 @@
 #define CORELINK_HEADERS_COMMON_H
 
 #include <string>
+#include <vector>
 #include <sstream>
 #include <queue>
 #include <map>
@@ -16,5 +17,9 @@
 #include <mutex>
 #include <condition_variable>
 #include <functional>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
 
 #endif
\ No newline at end of file
@@ -68,6 +68,30 @@ namespace CorelinkDLL {
         LAST
     };
 
+    /**
+     * Codecs applied to the messages of a data stream.
+     */
+    enum class StreamCodec {
+        // Messages are sent as is.
+        NONE = 0,
+        // Periodic keyframes with XOR delta frames against the last keyframe.
+        XOR_DELTA,
+        LAST
+    };
+
+    /**
+     * Pacing of a capture replay.
+     */
+    enum class ReplayPacing {
+        // Records are played with the gaps they were received with.
+        ORIGINAL = 0,
+        // Gaps are divided by the replay speed.
+        SCALED,
+        // Records are played as fast as possible.
+        ASAP,
+        LAST
+    };
+
     /**
      * Callback codes for external use.
      */
@@ -111,6 +135,13 @@ namespace CorelinkDLL {
         extern EXPORTED const int CALLBACK_STALE;
         extern EXPORTED const int CALLBACK_SUBSCRIBE;
         extern EXPORTED const int CALLBACK_UPDATE;
+
+        extern EXPORTED const int CODEC_NONE;
+        extern EXPORTED const int CODEC_XOR_DELTA;
+
+        extern EXPORTED const int REPLAY_PACING_ORIGINAL;
+        extern EXPORTED const int REPLAY_PACING_SCALED;
+        extern EXPORTED const int REPLAY_PACING_ASAP;
     }
 }
 
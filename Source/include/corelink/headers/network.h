@@ -15,11 +15,13 @@
 #pragma comment (lib,"ws2_32.lib")
 # else
 #include <sys/socket.h>
+#include <sys/select.h>
 #include <sys/time.h>
 #include <unistd.h>
 #include <string.h>
 #include <arpa/inet.h>
 #include <errno.h>
+#include <fcntl.h>
 # endif
 
 #define INVALID_PORT htons(0)
@@ -30,11 +32,13 @@
  */
 # ifdef _WIN32
 #define SOCKET_ERROR_CODE WSAGetLastError()
+#define SOCKET_WOULD_BLOCK(error) ((error) == WSAEWOULDBLOCK)
 #define SOCK_PTR const char*
 static const DWORD recvTimeout = 1 * 1000;
 #define socklen_t int
 # else
 #define SOCKET_ERROR_CODE errno
+#define SOCKET_WOULD_BLOCK(error) ((error) == EAGAIN || (error) == EWOULDBLOCK)
 #define SOCK_PTR const void*
 #define SOCKET int
 #define INVALID_SOCKET 0
@@ -59,6 +63,19 @@ static const timeval recvTimeout = CreateTime(1, 0);
 
 namespace CorelinkDLL {
     void setRecvSocketOpts(SOCKET& sock);
+
+    /**
+     * Switches the socket to non-blocking mode.
+     * @return Success of changing the mode.
+     */
+    bool setSocketNonBlocking(SOCKET& sock);
+
+    /**
+     * Waits until the socket can be written to.
+     * @param timeoutMs Maximum time to wait in milliseconds.
+     * @return Whether the socket is writable.
+     */
+    bool waitSocketWritable(SOCKET sock, int timeoutMs);
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,167 @@
+/**
+ * @file capture_recorder.h
+ * @brief Records the packets reaching receiver streams into memory mapped segment files.
+ * Listener threads append records without locking, a background thread rolls the segments.
+ *
+ * Segment file (path.NNNNNN.clcap):
+ * -capture_segment_header.
+ * -Records back to back, each padded to 8 bytes. A record with size 0 ends the segment.
+ *
+ * Record:
+ * -capture_record_header.
+ * -json header followed by the message, as they were received (codec frames are not decoded).
+ */
+#ifndef CORELINK_OBJECTS_CAPTURE_CAPTURERECORDER_H
+#define CORELINK_OBJECTS_CAPTURE_CAPTURERECORDER_H
+
+#include "corelink/headers/header.h"
+#include <cstdint>
+
+namespace CorelinkDLL {
+    namespace Object {
+        namespace Capture {
+            struct capture_segment_header {
+                static const std::uint32_t MAGIC = 0x50434C43;
+                static const std::uint16_t VERSION = 1;
+
+                std::uint32_t magic;
+                std::uint16_t version;
+                /// Offset of the first record.
+                std::uint16_t headerSize;
+                /// Position of the segment in the capture, starting at 0.
+                std::uint32_t index;
+                std::uint32_t reserved;
+                /// Nanoseconds since the unix epoch when the segment was opened.
+                std::int64_t startTime;
+                /// Bytes of records. Written when the segment is closed, 0 if the process died before that.
+                std::uint64_t dataSize;
+                char pad[32];
+            };
+
+            struct capture_record_header {
+                /// Bytes of the record including this header and the padding. Written last.
+                std::uint32_t size;
+                std::uint32_t hdrLen;
+                std::uint32_t msgLen;
+                std::int32_t recvID;
+                std::int32_t sendID;
+                std::uint32_t reserved;
+                /// Nanoseconds since the unix epoch when the packet reached the stream.
+                std::int64_t timestamp;
+            };
+
+            /**
+             * THREADSAFE
+             * Only one capture runs at a time. Listener threads reach it through capture().
+             */
+            class capture_recorder {
+            public:
+                static const int SEGMENT_SIZE_DEFAULT = 64 << 20;
+                static const int SEGMENT_SIZE_MIN = 1 << 16;
+
+                /**
+                 * Starts a capture. Fails if one is already running.
+                 * @param path Prefix of the segment files.
+                 * @param segmentSize Bytes per segment file. 0 for SEGMENT_SIZE_DEFAULT.
+                 * @param error Stores why the capture could not start.
+                 * @return If the capture started.
+                 */
+                static bool start(const std::string& path, int segmentSize, std::string& error);
+
+                /**
+                 * Stops the running capture and closes its segments.
+                 * Waits for packets being recorded, so it must not be called from a receive callback.
+                 */
+                static void stop();
+
+                /**
+                 * @return Packets not recorded by the running or last capture because a segment was full.
+                 */
+                static unsigned long long getDropped();
+
+                /**
+                 * Records a packet if a capture is running.
+                 * Costs a single atomic load otherwise.
+                 * @param data Json header followed by the message.
+                 */
+                static void capture(const STREAM_ID& recvID, const STREAM_ID& sendID, const char* data, int hdrLen, int msgLen) {
+                    if (active.load(std::memory_order_relaxed) != nullptr) {
+                        captureActive(recvID, sendID, data, hdrLen, msgLen);
+                    }
+                }
+
+                /**
+                 * @return Path of the segment file with the given index.
+                 */
+                static std::string segmentPath(const std::string& path, std::uint32_t index);
+
+                ~capture_recorder();
+
+            private:
+                struct segment {
+                    char* base;
+                    std::uint32_t size;
+                    std::uint32_t index;
+                    /// Bytes handed out to records, including the segment header. Can run past size.
+                    std::atomic<std::uint64_t> reserved;
+                    std::string path;
+#ifdef _WIN32
+                    void* file;
+                    void* mapping;
+#else
+                    int file;
+#endif
+                };
+
+                static std::atomic<capture_recorder*> active;
+                /// Serializes start and stop.
+                static std::mutex controlLock;
+                static std::atomic<unsigned long long> dropped;
+
+                std::string path;
+                std::uint32_t segmentSize;
+                /// Fill at which the rolling thread switches to the spare segment.
+                std::uint64_t highWater;
+                /// Segment records are appended to. Only replaced by the rolling thread.
+                std::atomic<segment*> current;
+                /// Segment opened ahead of time so rolling never waits on the file system. Rolling thread only.
+                segment* spare;
+                std::uint32_t nextIndex;
+
+                std::thread roller;
+                std::mutex rollLock;
+                std::condition_variable rollSignal;
+                std::atomic<bool> running;
+
+                capture_recorder(const std::string& path, std::uint32_t segmentSize);
+
+                static void captureActive(const STREAM_ID& recvID, const STREAM_ID& sendID, const char* data, int hdrLen, int msgLen);
+
+                void record(const STREAM_ID& recvID, const STREAM_ID& sendID, const char* data, int hdrLen, int msgLen);
+
+                /**
+                 * Creates and maps the next segment file.
+                 * @return nullptr if the file could not be created or mapped.
+                 */
+                segment* openSegment(std::string& error);
+
+                /**
+                 * Writes the record size into the segment header, unmaps it and trims the file.
+                 * No writer may still be using the segment.
+                 * @param keep Remove the file instead if false.
+                 */
+                static void closeSegment(segment* seg, bool keep);
+
+                /**
+                 * Rolling thread. Keeps a spare segment ready and swaps it in at the high water mark.
+                 */
+                void roll();
+
+                capture_recorder(const capture_recorder&) = delete;
+                capture_recorder& operator=(const capture_recorder&) = delete;
+            };
+        }
+    }
+}
+
+#endif
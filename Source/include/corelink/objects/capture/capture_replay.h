@@ -0,0 +1,180 @@
+/**
+ * @file capture_replay.h
+ * @brief Reads the segment files written by capture_recorder and plays them back.
+ * Segments are mapped read only. A sparse index built on open makes seeking O(log n) in the number of records.
+ */
+#ifndef CORELINK_OBJECTS_CAPTURE_CAPTUREREPLAY_H
+#define CORELINK_OBJECTS_CAPTURE_CAPTUREREPLAY_H
+
+#include "corelink/headers/header.h"
+#include "corelink/objects/capture/capture_recorder.h"
+
+namespace CorelinkDLL {
+    namespace Object {
+        namespace Capture {
+            /**
+             * View of a recorded packet. Valid while the replay is open.
+             */
+            struct replay_record {
+                std::int64_t timestamp;
+                STREAM_ID recvID;
+                STREAM_ID sendID;
+                /// Json header followed by the message.
+                const char* data;
+                int hdrLen;
+                int msgLen;
+            };
+
+            /**
+             * Reading and seeking are not THREADSAFE, start() hands the replay to its own thread.
+             */
+            class capture_replay {
+            public:
+                /// Records between two index entries, and so the most records a seek scans.
+                static const int INDEX_INTERVAL = 1024;
+
+                /**
+                 * Receives the replayed records on the replay thread.
+                 */
+                typedef std::function<void(const replay_record&)> Sink;
+
+                capture_replay();
+                ~capture_replay();
+
+                /**
+                 * Maps every segment of a capture and indexes it.
+                 * Segments are read from index 0 until one is missing.
+                 * Segments left behind by a crashed recorder are read up to their last complete record.
+                 * @param path Prefix the capture was started with.
+                 * @param error Stores why the capture could not be opened.
+                 * @return If at least one segment was opened.
+                 */
+                bool open(const std::string& path, std::string& error);
+
+                /**
+                 * Stops playback and unmaps the segments.
+                 */
+                void close();
+
+                std::uint64_t getRecordCount() const;
+
+                /**
+                 * @return Timestamp of the first record or 0 if there are none.
+                 */
+                std::int64_t getFirstTime() const;
+
+                /**
+                 * @return Latest timestamp in the capture or 0 if there are none.
+                 */
+                std::int64_t getLastTime() const;
+
+                /**
+                 * Moves the cursor to the first record received at or after time.
+                 * Records of concurrent listeners can be slightly out of order, the cursor never skips a record received after time.
+                 * @param time Nanoseconds since the unix epoch.
+                 * @return False if no record was received at or after time. The cursor is at the end then.
+                 */
+                bool seek(std::int64_t time);
+
+                /**
+                 * Reads the record at the cursor and moves past it.
+                 * @return False at the end of the capture.
+                 */
+                bool next(replay_record& record);
+
+                /**
+                 * Plays the records from the cursor on a new thread.
+                 * @param sink Called with every record.
+                 * @param pacing REPLAY_PACING_ORIGINAL, REPLAY_PACING_SCALED or REPLAY_PACING_ASAP.
+                 * @param speed Playback speed for REPLAY_PACING_SCALED. 2 plays twice as fast.
+                 * @return False if the replay is already playing or the pacing is invalid.
+                 */
+                bool start(const Sink& sink, int pacing, double speed);
+
+                /**
+                 * Stops playback and waits for the replay thread. Must not be called from the sink.
+                 */
+                void stop();
+
+                /**
+                 * THREADSAFE
+                 * @return If the replay thread is still playing records.
+                 */
+                bool isPlaying() const;
+
+                /**
+                 * THREADSAFE
+                 * @return Records handed to the sink since the last start.
+                 */
+                std::uint64_t getReplayed() const;
+
+                /**
+                 * THREADSAFE
+                 * @return Timestamp of the last record handed to the sink, 0 if none.
+                 */
+                std::int64_t getPosition() const;
+
+            private:
+                struct segment {
+                    const char* base;
+                    std::uint64_t size;
+                    /// Offset of the first record.
+                    std::uint64_t start;
+                    /// End of the last complete record.
+                    std::uint64_t end;
+#ifdef _WIN32
+                    void* file;
+                    void* mapping;
+#else
+                    int file;
+#endif
+                };
+
+                struct index_entry {
+                    /// Latest timestamp of the records before the entry. Never decreases along the index.
+                    std::int64_t maxTime;
+                    std::uint32_t segment;
+                    std::uint64_t offset;
+                };
+
+                std::vector<segment> segments;
+                std::vector<index_entry> index;
+                std::uint64_t recordCount;
+                std::int64_t firstTime;
+                std::int64_t lastTime;
+
+                /// Cursor.
+                std::uint32_t curSegment;
+                std::uint64_t curOffset;
+
+                std::thread player;
+                std::atomic<bool> playing;
+                std::atomic<bool> stopping;
+                std::atomic<std::uint64_t> replayed;
+                std::atomic<std::int64_t> position;
+
+                /**
+                 * Maps a segment file.
+                 * @return False if the file is missing or is not a segment.
+                 */
+                static bool mapSegment(const std::string& path, segment& seg);
+                static void unmapSegment(segment& seg);
+
+                /**
+                 * Walks the records of the segments once to find their ends and fill the index.
+                 */
+                void buildIndex();
+
+                /**
+                 * Replay thread.
+                 */
+                void play(Sink sink, int pacing, double speed);
+
+                capture_replay(const capture_replay&) = delete;
+                capture_replay& operator=(const capture_replay&) = delete;
+            };
+        }
+    }
+}
+
+#endif
@@ -11,6 +11,7 @@
 #include "corelink/objects/streams/comm_data_base.h"
 #include "corelink/objects/streams/comm_main_base.h"
 #include "corelink/objects/streams/stream_data.h"
+#include "corelink/objects/streams/stream_snapshot.h"
 
 namespace CorelinkDLL {
     namespace Object {
@@ -52,9 +53,39 @@ namespace CorelinkDLL {
             /// Map of each stream to its data to make retrieval easier and faster.
             std::unordered_map<STREAM_ID, CorelinkDLL::Object::Stream::stream_data> mapStreamData;
 
-            /// Lock to ensure thread safety of mapStreamData.
+            /// Maps each source to the streams on the client it is a source of. Reverse of stream_data::sources.
+            std::unordered_map<STREAM_ID, std::unordered_set<STREAM_ID>> sourceTargets;
+
+            /// Lock to ensure thread safety of mapStreamData and sourceTargets. Also serializes writers of the snapshot.
             std::mutex streamLock;
 
+        private:
+            /// Read only copy of the stream table used by the queries. Replaced on every add or remove.
+            std::atomic<CorelinkDLL::Object::Stream::stream_snapshot*> snapshot;
+
+            /**
+             * Publishes a new snapshot and retires the old one. Must hold streamLock.
+             */
+            void publishSnapshot(CorelinkDLL::Object::Stream::stream_snapshot* next);
+
+            /**
+             * Removes a source from every stream it targets. Must hold streamLock.
+             * @param removed Appends the target and source of every removed pair.
+             */
+            void rmSourceUnlocked(const STREAM_ID& sourceID, std::vector<std::pair<STREAM_ID, STREAM_ID>>& removed);
+
+            /**
+             * Drops the codec state receivers keep for removed sources.
+             * Must not hold streamLock, the receiver may be inside a user callback that queries the client.
+             * @param removed Target and source pairs from rmSourceUnlocked.
+             */
+            void resetSources(const std::vector<std::pair<STREAM_ID, STREAM_ID>>& removed);
+
+            /**
+             * Removes a target from the reverse index of a source. Must hold streamLock.
+             */
+            void rmTarget(const STREAM_ID& sourceID, const STREAM_ID& targetID);
+
         public:
             client_main(const initialization_data& data, int& errorID);
             ~client_main();
@@ -85,28 +116,49 @@ namespace CorelinkDLL {
             void rmStream(const STREAM_ID& streamID);
 
             /**
-             * Gets the stream ref for the specified stream.
+             * THREADSAFE
+             * Gets the stream ref for the specified stream. Does not lock.
              * @param streamID Stream to obtain reference of.
              * @return ref to streamID or -1 if not found.
              */
             int getStreamRef(const STREAM_ID& streamID);
 
             /**
-             * Gets the state for the specified stream.
+             * THREADSAFE
+             * Gets the state for the specified stream. Does not lock.
              * @param streamID Stream to obtain state of.
              * @return protocol or STREAM_STATE_NONE if not found.
              */
             int getStreamState(const STREAM_ID& streamID);
 
             /**
-             * Gets the compacted streamData for the specified stream.
+             * THREADSAFE
+             * Gets the compacted streamData for the specified stream. Does not lock.
              * @param streamID Stream to obtain data of.
              * @return streamData or "" if not found.
              */
             std::string getStreamData(const STREAM_ID& streamID);
 
             /**
-             * Checks if the stream is a type of stream.
+             * THREADSAFE
+             * Gets the compacted streamData without copying it. Does not lock.
+             * The data stays valid, even if the stream is removed, until it is passed to releaseStreamData.
+             * @param streamID Stream to obtain data of.
+             * @param len Stores length of the data or 0 if not found.
+             * @return Null terminated streamData or nullptr if not found.
+             */
+            const char* acquireStreamData(const STREAM_ID& streamID, int& len);
+
+            /**
+             * THREADSAFE
+             * Releases data returned by acquireStreamData.
+             * @param data Data to release. nullptr is ignored.
+             */
+            static void releaseStreamData(const char* data);
+
+            /**
+             * THREADSAFE
+             * Checks if the stream is a type of stream. Does not lock.
              * @param streamID Stream to obtain reference of.
              * @param streamState State to compare stream to.
              * @return Is the stream the following type.
@@ -114,7 +166,8 @@ namespace CorelinkDLL {
             bool streamIsType(const STREAM_ID& streamID, int streamState);
 
             /**
-             * Gets all streams on the client.
+             * THREADSAFE
+             * Gets all streams on the client. Does not lock.
              * @return List of streams on the client.
              */
             std::vector<int> getStreams();
@@ -139,6 +192,12 @@ namespace CorelinkDLL {
              */
             void rmSource(const STREAM_ID& sourceID);
 
+            /**
+             * Removes several sources from all streams on the client under a single lock.
+             * @param sourceIDs IDs to remove.
+             */
+            void rmSources(const std::vector<STREAM_ID>& sourceIDs);
+
             /**
              * Removes a source from a target stream on the client.
              * @param targetID ID to remove source from.
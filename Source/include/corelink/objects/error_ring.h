@@ -0,0 +1,94 @@
+/**
+ * @file error_ring.h
+ * @brief Fixed size ring of error records passed from the dll to the wrapper.
+ * Recording an error never allocates. Records are overwritten once the ring wraps around,
+ * records overwritten before anyone read them are counted as dropped.
+ */
+#ifndef CORELINK_OBJECTS_ERRORRING_H
+#define CORELINK_OBJECTS_ERRORRING_H
+
+#include "corelink/headers/header.h"
+
+namespace CorelinkDLL {
+    namespace Object {
+        /**
+         * Copy of a single error.
+         */
+        struct error_record {
+            static const int MESSAGE_SIZE = 96;
+
+            /// ID handed to the wrapper. 0 if the record is empty.
+            unsigned int id;
+            int code;
+            /// Static string naming where the error happened. Never freed.
+            const char* location;
+            /// errno/WSAGetLastError value or 0.
+            int sysError;
+            /// Microseconds since the unix epoch.
+            long long timestamp;
+            int msgLen;
+            char msg[MESSAGE_SIZE];
+
+            /**
+             * Formats the record as "location: msg Error code: sysError" followed by the error code as a char.
+             * @param buffer Buffer to write to. nullptr only computes the length.
+             * @return Length of the formatted record.
+             */
+            int format(char* buffer) const;
+        };
+
+        /**
+         * THREADSAFE
+         * Each slot is guarded by a sequence number that is odd while the slot is written.
+         * Readers copy the slot and retry if the sequence changed.
+         */
+        class error_ring {
+        public:
+            static const int RING_SIZE = 256;
+
+            error_ring();
+
+            /**
+             * Records an error. Messages longer than error_record::MESSAGE_SIZE are truncated.
+             * @param location Static string naming where the error happened.
+             * @param msg Message of the error.
+             * @param msgLen Length of msg.
+             * @param code Error code (ERROR_CODE_*).
+             * @param sysError errno/WSAGetLastError value or 0.
+             * @return ID of the error. Never 0.
+             */
+            unsigned int add(const char* location, const char* msg, int msgLen, int code, int sysError);
+
+            /**
+             * Copies an error.
+             * @param id ID of the error.
+             * @param record Stores the copy.
+             * @param consume Mark the error as read.
+             * @return False if the error is unknown or already overwritten.
+             */
+            bool get(unsigned int id, error_record& record, bool consume);
+
+            /**
+             * @return Number of errors overwritten before they were read.
+             */
+            unsigned long long getDropped() const;
+
+        private:
+            struct slot {
+                std::atomic<unsigned int> seq;
+                /// ID of the last record read from the slot.
+                std::atomic<unsigned int> consumedID;
+                error_record record;
+            };
+
+            slot slots[RING_SIZE];
+            std::atomic<unsigned int> nextID;
+            std::atomic<unsigned long long> dropped;
+
+            error_ring(const error_ring&) = delete;
+            error_ring& operator=(const error_ring&) = delete;
+        };
+    }
+}
+
+#endif
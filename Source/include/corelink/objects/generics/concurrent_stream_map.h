@@ -0,0 +1,408 @@
+/**
+ * @file concurrent_stream_map.h
+ * @brief Stream map that can be read while streams are added and removed.
+ * Lookups by index and by stream id are wait-free and never take a lock.
+ * Elements live in a segmented array so growing never moves them.
+ * Removed elements are reclaimed through the epoch_manager once no reader can see them.
+ * Writers (add/remove) are serialized by a mutex.
+ * Type T is the data stored in the stream map.
+ */
+#ifndef CORELINK_OBJECTS_GENERICS_CONCURRENTSTREAMMAP_H
+#define CORELINK_OBJECTS_GENERICS_CONCURRENTSTREAMMAP_H
+#include "corelink/headers/header.h"
+#include "corelink/objects/generics/epoch_manager.h"
+
+namespace CorelinkDLL {
+    namespace Object {
+        namespace Generic {
+            template <class T>
+            class concurrent_stream_map
+            {
+            private:
+                /// Element of the map. Replaced as a whole so readers never see a half written stream.
+                struct node {
+                    STREAM_ID stream;
+                    T value;
+                    node(const STREAM_ID& stream, const T& value) : stream(stream), value(value) {}
+                };
+
+                /**
+                 * Open addressing table from STREAM_ID to index.
+                 * Entries pack the stream id in the high 32 bits and the index in the low 32 bits.
+                 */
+                struct id_table {
+                    int cap;
+                    /// Live entries and tombstones. Only used by writers.
+                    int used;
+                    std::atomic<unsigned long long>* entries;
+                    id_table(int cap);
+                    ~id_table();
+                };
+
+                static const int MAX_SEGMENTS = 24;
+                static const unsigned long long ENTRY_EMPTY = ~0ull;
+                static const unsigned long long ENTRY_TOMBSTONE = ~0ull - 1;
+
+                // segment k holds baseSize << k slots. Segments are never moved or freed before the map.
+                std::atomic<std::atomic<node*>*> segments[MAX_SEGMENTS];
+                int baseSize;
+                int segmentCount;
+
+                // number of slots in the allocated segments.
+                std::atomic<int> cap;
+
+                // maps from STREAM_ID to the index of data
+                std::atomic<id_table*> table;
+
+                // stores the next available index to store new stream in.
+                std::priority_queue<int, std::vector<int>, std::greater<int>> slots;
+
+                mutable std::mutex m;
+
+                /**
+                 * @return Slot at index or nullptr if index is out of bounds.
+                 */
+                std::atomic<node*>* slotAt(int index) const;
+
+                /**
+                 * Allocates the next segment.
+                 * @return False if the map is full.
+                 */
+                bool grow();
+
+                static unsigned int hash(const STREAM_ID& stream);
+                static int findIndex(const id_table* idTable, const STREAM_ID& stream);
+
+                /**
+                 * Writer side. Adds the stream to the id table, rebuilding it when it gets too full.
+                 */
+                void insertID(const STREAM_ID& stream, int index);
+
+                /**
+                 * Writer side. Removes the stream from the id table.
+                 */
+                void eraseID(const STREAM_ID& stream);
+
+                /**
+                 * Writer side. Unlinks the node at index.
+                 * @return Unlinked node or nullptr.
+                 */
+                node* unlinkIndex(int index);
+
+                concurrent_stream_map(const concurrent_stream_map&) = delete;
+                concurrent_stream_map& operator=(const concurrent_stream_map&) = delete;
+            public:
+                /**
+                 * @param size Initial number of indicies to allocate.
+                 */
+                concurrent_stream_map(const int& size = 2);
+
+                ~concurrent_stream_map();
+
+                /**
+                 * THREADSAFE
+                 * Insert an element in the map and data.
+                 * @param stream Stream used as unique key.
+                 * @param t Value to store.
+                 * @return -1 if stream already exists. Otherwise, index value is stored at.
+                 */
+                int addObject(const STREAM_ID& stream, const T& t);
+
+                /**
+                 * THREADSAFE
+                 * Remove element at an index. Does nothing if index is out of bounds or nothing is stored at index.
+                 * The element is freed after readers currently holding it are done.
+                 * @param index Index of element to remove.
+                 */
+                void rmObjectIndex(int index);
+
+                /**
+                 * THREADSAFE
+                 * Remove element using stream as key. Does nothing if key does not exist.
+                 * The element is freed after readers currently holding it are done.
+                 * @param stream Key of element to remove.
+                 */
+                void rmObjectID(const STREAM_ID& stream);
+
+                /**
+                 * THREADSAFE
+                 * Gets stream at index.
+                 * @param index Index to get stream.
+                 * @return STREAM_DEF if index is out of bounds or nothing is stored at index.
+                 * @return Streamid at index.
+                 */
+                STREAM_ID getStream(int index) const;
+
+                /**
+                 * THREADSAFE
+                 * Gets index to reference stream data quickly.
+                 * @param stream Stream used as unique key.
+                 * @return -1 if stream does not exist.
+                 * @return Index to get stream data.
+                 */
+                int getStreamRedirect(const STREAM_ID& stream) const;
+
+                /**
+                 * THREADSAFE
+                 * Gets all streams in the map at the moment it is called.
+                 * @return Vector of stream ids, each one being a unique key in the map.
+                 */
+                std::vector<STREAM_ID> listStreams() const;
+
+                /**
+                 * THREADSAFE
+                 * Gets value at index if it belongs to the stream.
+                 * The caller must hold an epoch_manager::read_guard for as long as it uses the value.
+                 * @param index Index to get element.
+                 * @param stream Stream expected at the index.
+                 * @return nullptr if index is out of bounds or holds another stream.
+                 * @return Element at index.
+                 */
+                T* get(int index, const STREAM_ID& stream) const;
+
+                /**
+                 * THREADSAFE
+                 * Gets the reference number of the next available slot.
+                 * @return Next available reference value.
+                 */
+                int nextSlot() const;
+            };
+
+        }
+    }
+}
+
+// Implementation
+namespace CorelinkDLL {
+    namespace Object {
+        namespace Generic {
+            template<class T>
+            concurrent_stream_map<T>::id_table::id_table(int cap) : cap(cap), used(0) {
+                entries = new std::atomic<unsigned long long>[cap];
+                for (int i = 0; i < cap; ++i) {
+                    entries[i].store(ENTRY_EMPTY, std::memory_order_relaxed);
+                }
+            }
+
+            template<class T>
+            concurrent_stream_map<T>::id_table::~id_table() {
+                delete[] entries;
+                entries = nullptr;
+            }
+
+            template<class T>
+            concurrent_stream_map<T>::concurrent_stream_map(const int& size) : segmentCount(0), cap(0) {
+                baseSize = 2;
+                while (baseSize < size) { baseSize *= 2; }
+                for (int i = 0; i < MAX_SEGMENTS; ++i) {
+                    segments[i].store(nullptr, std::memory_order_relaxed);
+                }
+                table.store(new id_table(16), std::memory_order_relaxed);
+                grow();
+            }
+
+            template<class T>
+            concurrent_stream_map<T>::~concurrent_stream_map() {
+                std::atomic<node*>* segment;
+                for (int i = 0; i < segmentCount; ++i) {
+                    segment = segments[i].load(std::memory_order_relaxed);
+                    for (int j = 0; j < (baseSize << i); ++j) {
+                        delete segment[j].load(std::memory_order_relaxed);
+                    }
+                    delete[] segment;
+                }
+                delete table.load(std::memory_order_relaxed);
+            }
+
+            template<class T>
+            inline std::atomic<typename concurrent_stream_map<T>::node*>* concurrent_stream_map<T>::slotAt(int index) const {
+                int segment = 0;
+                int start = 0;
+                if (index < 0 || index >= cap.load(std::memory_order_acquire)) { return nullptr; }
+                // segment k starts at baseSize * (2^k - 1).
+                while (index - start >= (baseSize << segment)) {
+                    start += baseSize << segment;
+                    ++segment;
+                }
+                return segments[segment].load(std::memory_order_acquire) + (index - start);
+            }
+
+            template<class T>
+            bool concurrent_stream_map<T>::grow() {
+                if (segmentCount >= MAX_SEGMENTS) { return false; }
+                int size = baseSize << segmentCount;
+                int start = cap.load(std::memory_order_relaxed);
+                std::atomic<node*>* segment = new std::atomic<node*>[size];
+                for (int i = 0; i < size; ++i) {
+                    segment[i].store(nullptr, std::memory_order_relaxed);
+                    slots.emplace(start + i);
+                }
+                segments[segmentCount++].store(segment, std::memory_order_release);
+                cap.store(start + size, std::memory_order_release);
+                return true;
+            }
+
+            template<class T>
+            inline unsigned int concurrent_stream_map<T>::hash(const STREAM_ID& stream) {
+                return (unsigned int) stream * 2654435761u;
+            }
+
+            template<class T>
+            inline int concurrent_stream_map<T>::findIndex(const id_table* idTable, const STREAM_ID& stream) {
+                unsigned int mask = idTable->cap - 1;
+                unsigned int pos = hash(stream) & mask;
+                unsigned long long entry;
+                for (int i = 0; i < idTable->cap; ++i, pos = (pos + 1) & mask) {
+                    entry = idTable->entries[pos].load(std::memory_order_acquire);
+                    if (entry == ENTRY_EMPTY) { return -1; }
+                    if (entry != ENTRY_TOMBSTONE && (unsigned int)(entry >> 32) == (unsigned int) stream) {
+                        return (int)(entry & 0xFFFFFFFFull);
+                    }
+                }
+                return -1;
+            }
+
+            template<class T>
+            void concurrent_stream_map<T>::insertID(const STREAM_ID& stream, int index) {
+                id_table* idTable = table.load(std::memory_order_relaxed);
+                unsigned long long entry;
+                unsigned int mask, pos;
+                // keep the table at most half full so probes stay short and always end on an empty entry.
+                if ((idTable->used + 1) * 2 > idTable->cap) {
+                    int live = 0;
+                    int newCap = 16;
+                    for (int i = 0; i < idTable->cap; ++i) {
+                        entry = idTable->entries[i].load(std::memory_order_relaxed);
+                        if (entry != ENTRY_EMPTY && entry != ENTRY_TOMBSTONE) { ++live; }
+                    }
+                    while (newCap < (live + 1) * 4) { newCap *= 2; }
+                    id_table* newTable = new id_table(newCap);
+                    mask = newCap - 1;
+                    for (int i = 0; i < idTable->cap; ++i) {
+                        entry = idTable->entries[i].load(std::memory_order_relaxed);
+                        if (entry == ENTRY_EMPTY || entry == ENTRY_TOMBSTONE) { continue; }
+                        pos = hash((STREAM_ID)(entry >> 32)) & mask;
+                        while (newTable->entries[pos].load(std::memory_order_relaxed) != ENTRY_EMPTY) { pos = (pos + 1) & mask; }
+                        newTable->entries[pos].store(entry, std::memory_order_relaxed);
+                        ++newTable->used;
+                    }
+                    table.store(newTable, std::memory_order_release);
+                    epoch_manager::instance().retire(idTable);
+                    idTable = newTable;
+                }
+                mask = idTable->cap - 1;
+                pos = hash(stream) & mask;
+                while ((entry = idTable->entries[pos].load(std::memory_order_relaxed)) != ENTRY_EMPTY && entry != ENTRY_TOMBSTONE) {
+                    pos = (pos + 1) & mask;
+                }
+                if (entry == ENTRY_EMPTY) { ++idTable->used; }
+                idTable->entries[pos].store(((unsigned long long)(unsigned int) stream << 32) | (unsigned int) index, std::memory_order_release);
+            }
+
+            template<class T>
+            void concurrent_stream_map<T>::eraseID(const STREAM_ID& stream) {
+                id_table* idTable = table.load(std::memory_order_relaxed);
+                unsigned int mask = idTable->cap - 1;
+                unsigned int pos = hash(stream) & mask;
+                unsigned long long entry;
+                for (int i = 0; i < idTable->cap; ++i, pos = (pos + 1) & mask) {
+                    entry = idTable->entries[pos].load(std::memory_order_relaxed);
+                    if (entry == ENTRY_EMPTY) { return; }
+                    if (entry != ENTRY_TOMBSTONE && (unsigned int)(entry >> 32) == (unsigned int) stream) {
+                        idTable->entries[pos].store(ENTRY_TOMBSTONE, std::memory_order_release);
+                        return;
+                    }
+                }
+            }
+
+            template<class T>
+            typename concurrent_stream_map<T>::node* concurrent_stream_map<T>::unlinkIndex(int index) {
+                std::atomic<node*>* slot = slotAt(index);
+                node* old;
+                if (slot == nullptr || (old = slot->exchange(nullptr, std::memory_order_acq_rel)) == nullptr) { return nullptr; }
+                eraseID(old->stream);
+                slots.emplace(index);
+                return old;
+            }
+
+            template<class T>
+            int concurrent_stream_map<T>::addObject(const STREAM_ID& stream, const T& t) {
+                std::lock_guard<std::mutex> lock(m);
+                //don't accept duplicate streams
+                if (findIndex(table.load(std::memory_order_relaxed), stream) != -1) { return -1; }
+                if (slots.empty() && !grow()) { return -1; }
+                int slot = slots.top();
+                slots.pop();
+                // publish the element before the id so lookups by id always find it.
+                slotAt(slot)->store(new node(stream, t), std::memory_order_release);
+                insertID(stream, slot);
+                return slot;
+            }
+
+            template<class T>
+            inline void concurrent_stream_map<T>::rmObjectIndex(int index) {
+                node* old;
+                {
+                    std::lock_guard<std::mutex> lock(m);
+                    old = unlinkIndex(index);
+                }
+                epoch_manager::instance().retire(old);
+            }
+
+            template<class T>
+            inline void concurrent_stream_map<T>::rmObjectID(const STREAM_ID& stream) {
+                node* old;
+                {
+                    std::lock_guard<std::mutex> lock(m);
+                    int index = findIndex(table.load(std::memory_order_relaxed), stream);
+                    if (index == -1) { return; }
+                    old = unlinkIndex(index);
+                }
+                epoch_manager::instance().retire(old);
+            }
+
+            template<class T>
+            inline STREAM_ID concurrent_stream_map<T>::getStream(int index) const {
+                epoch_manager::read_guard guard;
+                std::atomic<node*>* slot = slotAt(index);
+                node* current;
+                if (slot == nullptr || (current = slot->load(std::memory_order_acquire)) == nullptr) { return STREAM_DEF; }
+                return current->stream;
+            }
+
+            template<class T>
+            inline int concurrent_stream_map<T>::getStreamRedirect(const STREAM_ID& stream) const {
+                epoch_manager::read_guard guard;
+                return findIndex(table.load(std::memory_order_acquire), stream);
+            }
+
+            template<class T>
+            inline std::vector<STREAM_ID> concurrent_stream_map<T>::listStreams() const {
+                // nodes are only retired under the lock, so they stay valid while it is held.
+                std::lock_guard<std::mutex> lock(m);
+                std::vector<STREAM_ID> output;
+                node* current;
+                int size = cap.load(std::memory_order_relaxed);
+                for (int i = 0; i < size; ++i) {
+                    if ((current = slotAt(i)->load(std::memory_order_relaxed)) != nullptr) { output.push_back(current->stream); }
+                }
+                return output;
+            }
+
+            template<class T>
+            inline T* concurrent_stream_map<T>::get(int index, const STREAM_ID& stream) const {
+                std::atomic<node*>* slot = slotAt(index);
+                node* current;
+                if (slot == nullptr || (current = slot->load(std::memory_order_acquire)) == nullptr || current->stream != stream) { return nullptr; }
+                return &current->value;
+            }
+
+            template<class T>
+            inline int concurrent_stream_map<T>::nextSlot() const {
+                std::lock_guard<std::mutex> lock(m);
+                return slots.empty() ? cap.load(std::memory_order_relaxed) : slots.top();
+            }
+        }
+    }
+}
+#endif
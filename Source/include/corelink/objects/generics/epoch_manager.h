@@ -0,0 +1,122 @@
+/**
+ * @file epoch_manager.h
+ * @brief Epoch based memory reclamation for lock-free readers.
+ * Readers announce the epoch they entered in while they hold a read_guard.
+ * Writers retire memory they unlinked instead of deleting it.
+ * Retired memory is freed once no reader that could still see it is left.
+ */
+#ifndef CORELINK_OBJECTS_GENERICS_EPOCHMANAGER_H
+#define CORELINK_OBJECTS_GENERICS_EPOCHMANAGER_H
+
+#include "corelink/headers/header.h"
+
+namespace CorelinkDLL {
+    namespace Object {
+        namespace Generic {
+            class epoch_manager {
+            public:
+                /// Number of threads that can hold their own reader slot. Further threads share a slot that blocks reclamation.
+                static const int MAX_READERS = 256;
+
+                typedef void(*Deleter)(void*);
+
+                /**
+                 * THREADSAFE
+                 * Keeps memory retired after the guard was created alive until the guard is destroyed.
+                 * Guards can be nested on the same thread.
+                 */
+                class read_guard {
+                public:
+                    read_guard();
+                    ~read_guard();
+                private:
+                    read_guard(const read_guard&) = delete;
+                    read_guard& operator=(const read_guard&) = delete;
+                };
+
+                /**
+                 * Epoch manager shared by every lock-free structure in the dll.
+                 */
+                static epoch_manager& instance();
+
+                ~epoch_manager();
+
+                /**
+                 * THREADSAFE
+                 * Frees ptr once all readers active at the time of the call have left.
+                 * ptr must already be unreachable for new readers.
+                 * @param ptr Memory to free.
+                 * @param deleter Function freeing ptr.
+                 */
+                void retire(void* ptr, Deleter deleter);
+
+                /**
+                 * THREADSAFE
+                 * Deletes ptr once all readers active at the time of the call have left.
+                 */
+                template <class U>
+                void retire(U* ptr) {
+                    this->retire(ptr, &epoch_manager::deleteObject<U>);
+                }
+
+                /**
+                 * THREADSAFE
+                 * Frees retired memory no reader can see anymore.
+                 */
+                void collect();
+
+                /**
+                 * THREADSAFE
+                 * Waits until every reader active at the time of the call has left.
+                 * Must not be called while holding a read_guard.
+                 */
+                void synchronize();
+
+            private:
+                struct reader_slot {
+                    /// Epoch the reader entered in. 0 when the reader is not active.
+                    std::atomic<unsigned long long> epoch;
+                    std::atomic<bool> used;
+                    /// Keeps each reader on its own cache line.
+                    char pad[64 - sizeof(std::atomic<unsigned long long>) - sizeof(std::atomic<bool>)];
+                };
+
+                struct retired_ptr {
+                    void* ptr;
+                    Deleter deleter;
+                    unsigned long long epoch;
+                };
+
+                reader_slot readers[MAX_READERS];
+                std::atomic<unsigned long long> globalEpoch;
+                /// Readers without a slot. Nothing is freed while there are any.
+                std::atomic<int> overflowReaders;
+                std::vector<retired_ptr> limbo;
+                std::mutex limboLock;
+
+                epoch_manager();
+                epoch_manager(const epoch_manager&) = delete;
+                epoch_manager& operator=(const epoch_manager&) = delete;
+
+                template <class U>
+                static void deleteObject(void* ptr) {
+                    delete (U*) ptr;
+                }
+
+                void enter();
+                void leave();
+
+                /**
+                 * @return Index of a free reader slot or -1 if all are taken.
+                 */
+                int claimSlot();
+                void releaseSlot(int slot);
+
+                friend class read_guard;
+                friend struct epoch_thread_state;
+            };
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,142 @@
+/**
+ * @file latency_histogram.h
+ * @brief Fixed size log-linear histogram of 64 bit values, usually latencies in nanoseconds.
+ * Values below SUB_COUNT get their own bucket. Every power of 2 above is split into SUB_COUNT linear buckets,
+ * so a bucket is never wider than 1/SUB_COUNT of its values (about 3%).
+ * Recording is one atomic add on the bucket, without locks or allocation.
+ *
+ * Export format. Varints hold 7 bits per byte, lowest first, with the high bit set on all but the last byte.
+ * -(uint32) MAGIC, little endian on every host.
+ * -(uint8) VERSION.
+ * -(uint8) SUB_BITS.
+ * -For each bucket with values: (varint) empty buckets skipped since the last one, (varint) count.
+ */
+#ifndef CORELINK_OBJECTS_GENERICS_LATENCYHISTOGRAM_H
+#define CORELINK_OBJECTS_GENERICS_LATENCYHISTOGRAM_H
+
+#include "corelink/headers/header.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace CorelinkDLL {
+    namespace Object {
+        namespace Generic {
+            /**
+             * THREADSAFE
+             * Queries read the buckets one at a time, values recorded during a query may be partly included.
+             */
+            class latency_histogram {
+            public:
+                /// "CLHG" in an export.
+                static const std::uint32_t MAGIC = 0x47484C43;
+                static const int VERSION = 1;
+                static const int SUB_BITS = 5;
+                static const int SUB_COUNT = 1 << SUB_BITS;
+                static const int BUCKETS = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+                latency_histogram();
+
+                /**
+                 * Wait-free.
+                 * @param value Value to count.
+                 */
+                void record(std::uint64_t value);
+
+                /**
+                 * Adds the counts of other to this histogram.
+                 */
+                void merge(const latency_histogram& other);
+
+                /**
+                 * Clears every count. Values recorded during the reset may survive it.
+                 */
+                void reset();
+
+                std::uint64_t getCount() const;
+
+                /**
+                 * Mean of the bucket midpoints. No sum is kept so recording stays a single atomic add.
+                 * @return 0 if nothing was recorded.
+                 */
+                double getMean() const;
+
+                /**
+                 * @return Lowest value of the bucket holding the smallest recorded value. 0 if nothing was recorded.
+                 */
+                std::uint64_t getMin() const;
+
+                /**
+                 * @return Highest value of the bucket holding the largest recorded value. 0 if nothing was recorded.
+                 */
+                std::uint64_t getMax() const;
+
+                /**
+                 * @param percent Percentile between 0 and 100.
+                 * @return Highest value of the bucket the percentile falls in, so it never understates a latency. 0 if nothing was recorded.
+                 */
+                std::uint64_t getPercentile(double percent) const;
+
+                /**
+                 * Encodes the counts in the export format.
+                 * @param out Stores the export.
+                 */
+                void serialize(std::string& out) const;
+
+                /**
+                 * Adds the counts of an export to this histogram.
+                 * @return False if data is not a valid export. Nothing is added then.
+                 */
+                bool deserialize(const char* data, int len);
+
+                /**
+                 * @return Bucket counting value.
+                 */
+                static int bucketIndex(std::uint64_t value);
+
+                /**
+                 * @return Lowest value counted by the bucket.
+                 */
+                static std::uint64_t bucketLow(int index);
+
+                /**
+                 * @return Highest value counted by the bucket.
+                 */
+                static std::uint64_t bucketHigh(int index);
+
+            private:
+                std::atomic<std::uint64_t> counts[BUCKETS];
+
+                static int highestBit(std::uint64_t value);
+
+                latency_histogram(const latency_histogram&) = delete;
+                latency_histogram& operator=(const latency_histogram&) = delete;
+            };
+
+            inline int latency_histogram::highestBit(std::uint64_t value) {
+#ifdef _MSC_VER
+                unsigned long index;
+                _BitScanReverse64(&index, value);
+                return (int) index;
+#else
+                return 63 - __builtin_clzll(value);
+#endif
+            }
+
+            inline int latency_histogram::bucketIndex(std::uint64_t value) {
+                int shift;
+                if (value < (std::uint64_t) SUB_COUNT) { return (int) value; }
+                // the SUB_BITS bits below the highest set bit pick the linear bucket.
+                shift = highestBit(value) - SUB_BITS;
+                return ((shift + 1) << SUB_BITS) + (int) ((value >> shift) & (SUB_COUNT - 1));
+            }
+
+            inline void latency_histogram::record(std::uint64_t value) {
+                this->counts[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+#endif
@@ -6,6 +6,7 @@
 #define CORELINK_OBJECTS_GENERICS_MESSAGEHANDLER_H
 #include "corelink/headers/header.h"
 #include "corelink/objects/counter.h"
+#include "corelink/objects/packet_pool.h"
 
 namespace CorelinkDLL {
     namespace Object {
@@ -72,13 +73,16 @@ namespace CorelinkDLL {
     namespace Object {
         namespace Generic {
             /**
-             * Specialization for strings.
+             * Specialization for strings. Messages are kept in pooled buffers.
              */
             template<>
             class message_handler<std::string> {
             private:
                 // Stores messages in a map structure
-                std::map<unsigned int, std::string> messages;
+                std::map<unsigned int, CorelinkDLL::Object::packet_buffer> messages;
+
+                // Messages lent out with lend() until they are released.
+                std::map<unsigned int, CorelinkDLL::Object::packet_buffer> lent;
                 
                 // Gets unique identifiers using the counter.
                 CorelinkDLL::Object::counter counter;
@@ -100,28 +104,28 @@ namespace CorelinkDLL {
 
                 /**
                  * Adds message to the handler.
-                 * @param msg Message to store.
+                 * @param msg Buffer holding the message to store.
                  * @param index Optional index if reserve() was called earlier
                  * @return Index used to store and retrieve the message. 0 if stopped.
                  */
-                unsigned int add(const std::string& msg, unsigned int index = 0);
+                unsigned int add(CorelinkDLL::Object::packet_buffer msg, unsigned int index = 0);
 
                 /**
-                 * Adds message to the handler.
+                 * Adds a copy of the message to the handler.
                  * @param msg Message to store.
                  * @param msgLen Length of data to store.
                  * @param index Optional index if reserve() was called earlier
                  * @return Index used to store and retrieve the message. 0 if stopped.
                  */
-                unsigned int add(char* msg, int msgLen, unsigned int index = 0);
+                unsigned int add(const char* msg, int msgLen, unsigned int index = 0);
 
                 /**
-                 * Gets the string at the index.
+                 * Gets the string at the index and removes it.
                  * @param index Key to retrieve string from.
                  * @param wait Should it retrieve value immediately or poll for data.
-                 * @return message stored for the index.
+                 * @return Buffer holding the message stored for the index. Empty buffer if the data cannot be retrieved.
                  */
-                std::string get(unsigned int index, bool wait = true);
+                CorelinkDLL::Object::packet_buffer get(unsigned int index, bool wait = true);
 
                 /**
                  * Gets the length of string at the index.
@@ -145,9 +149,24 @@ namespace CorelinkDLL {
                  */
                 void remove(unsigned int index);
 
+                /**
+                 * Takes the string at the index without copying it.
+                 * The buffer stays valid until release() is called, clear() keeps it.
+                 * @param index Key to retrieve string from.
+                 * @param wait Should it retrieve value immediately or poll for data.
+                 * @return Lent message. nullptr if the data cannot be retrieved.
+                 */
+                const CorelinkDLL::Object::packet_buffer* lend(unsigned int index, bool wait = true);
+
+                /**
+                 * Frees a string taken with lend().
+                 * @param index Key the string was lent with.
+                 */
+                void release(unsigned int index);
+
                 /**
                  * THREADSAFE
-                 * Stops all retrievals and empties the handler.
+                 * Stops all retrievals and empties the handler. Lent messages are kept until released.
                  */
                 void clear();
 
@@ -247,24 +266,24 @@ namespace CorelinkDLL {
                 return counter.get();
             }
 
-            inline unsigned int message_handler<std::string>::add(const std::string& msg, unsigned int index) {
+            inline unsigned int message_handler<std::string>::add(CorelinkDLL::Object::packet_buffer msg, unsigned int index) {
                 if (index == 0) { index = counter.get(); }
                 {
                     std::lock_guard<std::mutex> lck(lock);
                     if (!running) { return 0; }
-                    messages.insert(std::pair<unsigned int, std::string>(index, msg));
+                    messages.insert(std::pair<unsigned int, CorelinkDLL::Object::packet_buffer>(index, std::move(msg)));
                 }
                 c.notify_all();
                 return index;
             }
 
-            inline unsigned int message_handler<std::string>::add(char* msg, int msgLen, unsigned int index) {
-                return add(std::string(msg, msgLen), index);
+            inline unsigned int message_handler<std::string>::add(const char* msg, int msgLen, unsigned int index) {
+                return add(CorelinkDLL::Object::packet_pool::instance().acquire(msg, msgLen), index);
             }
 
-            inline std::string message_handler<std::string>::get(unsigned int index, bool wait) {
-                std::string ret = "";
-                typename std::map<unsigned int, std::string>::iterator it = messages.end();
+            inline CorelinkDLL::Object::packet_buffer message_handler<std::string>::get(unsigned int index, bool wait) {
+                CorelinkDLL::Object::packet_buffer ret;
+                typename std::map<unsigned int, CorelinkDLL::Object::packet_buffer>::iterator it = messages.end();
                 if (!wait) {
                     it = messages.find(index);
                 }
@@ -278,7 +297,7 @@ namespace CorelinkDLL {
                 {
                     std::lock_guard<std::mutex> lck(lock);
                     if (it != messages.end()) {
-                        ret = it->second;
+                        ret = std::move(it->second);
                         messages.erase(it);
                     }
                 }
@@ -287,7 +306,7 @@ namespace CorelinkDLL {
 
             inline int message_handler<std::string>::getLen(unsigned int index, bool wait) {
                 int ret = -1;
-                typename std::map<unsigned int, std::string>::iterator it = messages.end();
+                typename std::map<unsigned int, CorelinkDLL::Object::packet_buffer>::iterator it = messages.end();
                 if (!wait) {
                     it = messages.find(index);
                 }
@@ -308,11 +327,11 @@ namespace CorelinkDLL {
             }
 
             inline bool message_handler<std::string>::getStr(unsigned int index, char* buffer) {
-                std::map<unsigned int, std::string>::iterator it;
+                std::map<unsigned int, CorelinkDLL::Object::packet_buffer>::iterator it;
                 std::lock_guard<std::mutex> lck(lock);
                 it = messages.find(index);
                 if (it == messages.end()) { return false; }
-                memcpy(buffer, it->second.c_str(), it->second.size());
+                memcpy(buffer, it->second.data(), it->second.size());
                 return true;
             }
 
@@ -321,9 +340,34 @@ namespace CorelinkDLL {
                 messages.erase(index);
             }
 
+            inline const CorelinkDLL::Object::packet_buffer* message_handler<std::string>::lend(unsigned int index, bool wait) {
+                std::map<unsigned int, CorelinkDLL::Object::packet_buffer>::iterator it = messages.end();
+                std::unique_lock<std::mutex> lck(lock);
+                if (wait) {
+                    while (running && (it = messages.find(index)) == messages.end()) {
+                        c.wait(lck);
+                    }
+                }
+                else {
+                    it = messages.find(index);
+                }
+                if (it == messages.end()) { return nullptr; }
+                // map nodes do not move, so the buffer can be handed out while other messages come and go.
+                CorelinkDLL::Object::packet_buffer& lentMsg = lent[index];
+                lentMsg = std::move(it->second);
+                messages.erase(it);
+                return &lentMsg;
+            }
+
+            inline void message_handler<std::string>::release(unsigned int index) {
+                std::lock_guard<std::mutex> lck(lock);
+                lent.erase(index);
+            }
+
             inline void message_handler<std::string>::clear() {
                 {
                     std::lock_guard<std::mutex> lck(lock);
+                    // lent messages may still be read, they stay until release() or the handler is destroyed.
                     messages.clear();
                     running = false;
                 }
@@ -1,6 +1,8 @@
 /**
  * @file safe_queue.h
  * @brief A threadsafe-queue copied and modified from stack overflow for threadsafe transfer of data.
+ * Elements are kept in a ring that doubles when full and never shrinks, so a queue that stays below
+ * its largest size does not allocate.
  */
 #ifndef CORELINK_OBJECTS_GENERICS_SAFEQUEUE_H
 #define CORELINK_OBJECTS_GENERICS_SAFEQUEUE_H
@@ -13,7 +15,7 @@ namespace CorelinkDLL {
             template <class T>
             class safe_queue {
             public:
-                safe_queue(): q(), m(), c() {}
+                safe_queue(): ring(), head(0), count(0), m(), c() {}
                 ~safe_queue() {}
 
                 /**
@@ -23,7 +25,7 @@ namespace CorelinkDLL {
                  */
                 void enqueue(T t) {
                     std::lock_guard<std::mutex> lock(m);
-                    q.push(t);
+                    push(std::move(t));
                     c.notify_one();
                 }
 
@@ -36,11 +38,10 @@ namespace CorelinkDLL {
                     std::unique_lock<std::mutex> lock(m);
                     T val;
 
-                    while (q.empty()) {
+                    while (count == 0) {
                         c.wait(lock);
                     }
-                    val = q.front();
-                    q.pop();
+                    pop(val);
                     return val;
                 }
 
@@ -50,8 +51,7 @@ namespace CorelinkDLL {
                  */
                 T dequeue_unsafe() {
                     T val;
-                    val = q.front();
-                    q.pop();
+                    pop(val);
                     return val;
                 }
 
@@ -65,7 +65,7 @@ namespace CorelinkDLL {
                  */
                 void front(T& val, const T& def) {
                     std::lock_guard<std::mutex> lock(m);
-                    val = q.empty() ? def : q.front();
+                    val = count == 0 ? def : ring[head];
                 }
 
                 /**
@@ -74,7 +74,7 @@ namespace CorelinkDLL {
                  * @return Element of type T from the front of the queue. Undefined behavior if queue is empty.
                  */
                 void front_unsafe(T& val) const {
-                    val = q.front();
+                    val = ring[head];
                 }
 
                 /**
@@ -82,11 +82,10 @@ namespace CorelinkDLL {
                  * Removes all elements and clears queue.
                  */
                 void clear() {
-                    size_t size;
+                    T val;
                     std::lock_guard<std::mutex> lock(m);
 
-                    size = q.size();
-                    for (std::size_t i = 0; i < size; ++i) { q.pop(); }
+                    while (count > 0) { pop(val); }
                 }
 
                 /**
@@ -95,13 +94,12 @@ namespace CorelinkDLL {
                  * Calls delete to prevent memory leaks from pointer types.
                  */
                 void clearDelete() {
-                    size_t size;
+                    T val;
                     std::lock_guard<std::mutex> lock(m);
                     
-                    size = q.size();
-                    for (int i = 0; i < size; ++i) {
-                        delete q.front();
-                        q.pop();
+                    while (count > 0) {
+                        pop(val);
+                        delete val;
                     }
                 }
 
@@ -112,7 +110,7 @@ namespace CorelinkDLL {
                  */
                 size_t size() {
                     std::lock_guard<std::mutex> lock(m);
-                    return q.size();
+                    return count;
                 }
 
                 /**
@@ -120,12 +118,36 @@ namespace CorelinkDLL {
                  * @return Size of queue.
                  */
                 size_t size_unsafe() const {
-                    return q.size();
+                    return count;
                 }
             private:
-                std::queue<T> q;
+                /// Elements in a ring with a power of 2 size, head is the front element.
+                std::vector<T> ring;
+                std::size_t head;
+                std::size_t count;
                 mutable std::mutex m;
                 std::condition_variable c;
+
+                void push(T&& t) {
+                    if (count == ring.size()) {
+                        std::vector<T> grown(ring.empty() ? 16 : ring.size() * 2);
+                        for (std::size_t i = 0; i < count; ++i) {
+                            grown[i] = std::move(ring[(head + i) & (ring.size() - 1)]);
+                        }
+                        ring.swap(grown);
+                        head = 0;
+                    }
+                    ring[(head + count) & (ring.size() - 1)] = std::move(t);
+                    ++count;
+                }
+
+                void pop(T& val) {
+                    val = std::move(ring[head]);
+                    // leave a default value behind so the slot does not keep resources alive.
+                    ring[head] = T();
+                    head = (head + 1) & (ring.size() - 1);
+                    --count;
+                }
             };
         }
     }
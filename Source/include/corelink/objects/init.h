@@ -8,6 +8,7 @@
 
 #include "corelink/headers/header.h"
 #include "corelink/objects/initialization_data.h"
+#include "corelink/objects/error_ring.h"
 
 /*
  * Initialization logic here.
@@ -133,21 +134,36 @@ namespace CorelinkDLL {
  * Error handling logic here.
  */
 namespace CorelinkDLL {
+    /**
+     * Records an error without allocating.
+     * @param location Static string naming where the error happened ("file.cpp function").
+     * @param msg Static or short message. Truncated to error_record::MESSAGE_SIZE.
+     * @param errorCode Error code (ERROR_CODE_*).
+     * @param sysError errno/WSAGetLastError value or 0.
+     * @return ID of the error.
+     */
+    unsigned int addError(const char* location, const char* msg, int errorCode, int sysError = 0);
+
+    /**
+     * Records an error built at runtime. Truncated to error_record::MESSAGE_SIZE.
+     * @return ID of the error.
+     */
     unsigned int addError(const std::string& error, int errorCode);
 
     extern "C" {
         /**
          * Gets error message from the dll to the client
+         * Errors are kept in a fixed size ring and are lost once enough newer errors are recorded.
          * @param errorID ID of the error to get.
-         * @param errorLen Length of the error message.
-         * @return error message.
+         * @param errorLen Length of the error message. 0 if the error is no longer available.
+         * @return error message. nullptr if the error is no longer available.
          */
         EXPORTED char* getError(const unsigned int& errorID, int& errorLen);
 
         /**
          * Gets length of the error message from the dll to the client
          * @param errorID ID of the error length to get.
-         * @return length of error message.
+         * @return length of error message. -1 if the error is no longer available.
          */
         EXPORTED int getErrorLen(const unsigned int& errorID);
 
@@ -158,6 +174,28 @@ namespace CorelinkDLL {
          * @return Succeed in retrieving error message.
          */
         EXPORTED bool getErrorStr(const unsigned int& errorID, char* buffer);
+
+        /**
+         * Gets the structured fields of an error without consuming it.
+         * @param errorID ID of the error to get.
+         * @param code Stores the error code.
+         * @param sysError Stores the errno/WSAGetLastError value or 0.
+         * @param timestamp Stores the time of the error in microseconds since the unix epoch.
+         * @return Succeed in retrieving the error.
+         */
+        EXPORTED bool getErrorInfo(const unsigned int& errorID, int& code, int& sysError, long long& timestamp);
+
+        /**
+         * Marks an error as read without copying it.
+         * @param errorID ID of the error.
+         */
+        EXPORTED void discardError(const unsigned int& errorID);
+
+        /**
+         * Gets the number of errors overwritten before they were read.
+         * @return Number of dropped errors.
+         */
+        EXPORTED unsigned long long getErrorDropCount();
     }
 }
 
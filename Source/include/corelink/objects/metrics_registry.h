@@ -0,0 +1,230 @@
+/**
+ * @file metrics_registry.h
+ * @brief Registry of named counters, gauges and histograms shared by the whole dll.
+ * Counters are split into shards on separate cache lines and threads are handed a shard round robin,
+ * so up to SHARDS threads never write to the same line, more threads share shards. Reads sum the shards.
+ * Gauges hold a single value or are sampled from a function when a snapshot is taken.
+ *
+ * Names used by the dll:
+ * -stream.<id>.packets/bytes/drops Messages of a stream, their json header and message bytes, and messages it lost
+ *  (invalid packets, frames waiting on a keyframe, full polling ring, rejected udp sends).
+ * -send.udp.queue/send.tcp.queue Messages waiting for the send thread.
+ * -control.inflight Control requests waiting for their response.
+ * -control.rtt Histogram of control round trips in nanoseconds.
+ * -control.callback.queue Server callbacks waiting for the callback thread.
+ * -errors.<code> Errors recorded per error code.
+ * -threads.<role> Running threads of the role.
+ * -pool.* Packet buffer pool, see packet_pool.h.
+ */
+#ifndef CORELINK_OBJECTS_METRICSREGISTRY_H
+#define CORELINK_OBJECTS_METRICSREGISTRY_H
+
+#include "corelink/headers/header.h"
+#include "corelink/objects/generics/latency_histogram.h"
+
+namespace CorelinkDLL {
+    namespace Object {
+        /**
+         * THREADSAFE
+         * Wait-free sharded counter.
+         */
+        class metric_counter {
+        public:
+            static const int SHARDS = 8;
+
+            metric_counter();
+
+            void add(std::int64_t value = 1);
+
+            /**
+             * @return Sum of the shards. Adds racing with the read may be partly included.
+             */
+            std::int64_t get() const;
+
+        private:
+            /// Padded so the values of two shards never share a cache line.
+            struct shard {
+                std::atomic<std::int64_t> value;
+                char pad[64 - sizeof(std::atomic<std::int64_t>)];
+            };
+
+            shard shards[SHARDS];
+
+            static std::atomic<int> nextShard;
+
+            /**
+             * @return Shard of the calling thread, picked round robin on its first add.
+             */
+            static int shardIndex();
+
+            metric_counter(const metric_counter&) = delete;
+            metric_counter& operator=(const metric_counter&) = delete;
+        };
+
+        /**
+         * THREADSAFE
+         * Single value, for values written rarely or counted up and down.
+         */
+        class metric_gauge {
+        public:
+            metric_gauge();
+
+            void set(std::int64_t value);
+            void add(std::int64_t value);
+            std::int64_t get() const;
+
+        private:
+            std::atomic<std::int64_t> value;
+
+            metric_gauge(const metric_gauge&) = delete;
+            metric_gauge& operator=(const metric_gauge&) = delete;
+        };
+
+        /**
+         * THREADSAFE
+         */
+        class metrics_registry {
+        public:
+            typedef std::function<std::int64_t()> Sampler;
+
+            /**
+             * Registry shared by the whole dll.
+             */
+            static metrics_registry& instance();
+
+            /**
+             * @return Counter registered under name, created if missing.
+             * A detached counter if name is taken by another kind of metric.
+             */
+            std::shared_ptr<metric_counter> counter(const std::string& name);
+
+            /**
+             * @return Gauge registered under name, created if missing.
+             * A detached gauge if name is taken by another kind of metric.
+             */
+            std::shared_ptr<metric_gauge> gauge(const std::string& name);
+
+            /**
+             * @return Histogram registered under name, created if missing.
+             * A detached histogram if name is taken by another kind of metric.
+             */
+            std::shared_ptr<CorelinkDLL::Object::Generic::latency_histogram> histogram(const std::string& name);
+
+            /**
+             * Registers a gauge read by calling sampler, replacing the metric registered under name.
+             * The sampler is called with the registry locked, so it must not use the registry.
+             * Whatever the sampler reads must stay valid until it is removed.
+             */
+            void addSampler(const std::string& name, Sampler sampler);
+
+            /**
+             * Unregisters a metric. Holders of the metric can keep using it.
+             * Waits for a snapshot sampling the metric to finish.
+             */
+            void remove(const std::string& name);
+
+            /**
+             * Unregisters every metric whose name starts with prefix.
+             */
+            void removePrefix(const std::string& prefix);
+
+            /**
+             * @param value Stores the value of the counter or gauge.
+             * @return False if no counter or gauge is registered under name.
+             */
+            bool getValue(const std::string& name, std::int64_t& value);
+
+            /**
+             * Writes every metric as json:
+             * {"time": microseconds since the unix epoch, "counters": {name: value}, "gauges": {name: value},
+             * "histograms": {name: {"count", "mean", "min", "p50", "p90", "p99", "max"}}}
+             * @param out Stores the json.
+             */
+            void snapshot(std::string& out);
+
+        private:
+            enum class MetricKind {
+                COUNTER,
+                GAUGE,
+                SAMPLER,
+                HISTOGRAM
+            };
+
+            struct metric_entry {
+                MetricKind kind;
+                std::shared_ptr<metric_counter> counter;
+                std::shared_ptr<metric_gauge> gauge;
+                Sampler sampler;
+                std::shared_ptr<CorelinkDLL::Object::Generic::latency_histogram> histogram;
+            };
+
+            std::mutex lock;
+            /// Ordered so snapshots list related metrics together.
+            std::map<std::string, metric_entry> metrics;
+
+            metrics_registry() = default;
+
+            metrics_registry(const metrics_registry&) = delete;
+            metrics_registry& operator=(const metrics_registry&) = delete;
+        };
+
+        /**
+         * Packet counters of a stream, registered as stream.<id>.packets/bytes/drops.
+         * Copies share the counters.
+         */
+        struct stream_counters {
+            std::shared_ptr<metric_counter> packets;
+            std::shared_ptr<metric_counter> bytes;
+            std::shared_ptr<metric_counter> drops;
+
+            /**
+             * Creates detached counters so the stream can count before it is attached.
+             */
+            stream_counters();
+
+            /**
+             * Switches to the counters registered for the stream.
+             */
+            void attach(const STREAM_ID& streamID);
+
+            /**
+             * Unregisters the counters of the stream.
+             */
+            static void detach(const STREAM_ID& streamID);
+
+            void count(int len) const {
+                this->packets->add(1);
+                this->bytes->add(len);
+            }
+        };
+
+        /**
+         * Counts the calling thread in threads.<role> while it exists.
+         */
+        class thread_metric {
+        public:
+            /**
+             * @param role Name of the role.
+             */
+            explicit thread_metric(const char* role);
+            ~thread_metric();
+
+        private:
+            std::shared_ptr<metric_gauge> gauge;
+
+            thread_metric(const thread_metric&) = delete;
+            thread_metric& operator=(const thread_metric&) = delete;
+        };
+
+        inline int metric_counter::shardIndex() {
+            static thread_local int index = nextShard.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+            return index;
+        }
+
+        inline void metric_counter::add(std::int64_t value) {
+            this->shards[shardIndex()].value.fetch_add(value, std::memory_order_relaxed);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,273 @@
+/**
+ * @file packet_pool.h
+ * @brief Size classed pool of packet buffers shared by the send and receive paths.
+ * Buffers are handed out as refcounted handles and go back to the pool when the last handle lets go.
+ * Every thread keeps a small cache of free blocks per size class. A thread that frees more than its cache holds
+ * moves half of it to a locked list shared by every thread, a thread that runs out takes a batch from that list,
+ * so a producer and a consumer thread trade blocks without touching the allocator once the pool is warm.
+ * Blocks bigger than the largest class are allocated and freed directly.
+ *
+ * Metrics:
+ * -pool.hits/misses/oversize Buffers served from free blocks, from new blocks, and from blocks too big to pool.
+ * -pool.in_use Buffers handed out and not returned yet.
+ * -pool.blocks/bytes Pooled blocks allocated, in use or free, and their capacity in bytes.
+ */
+#ifndef CORELINK_OBJECTS_PACKETPOOL_H
+#define CORELINK_OBJECTS_PACKETPOOL_H
+
+#include "corelink/headers/header.h"
+#include "corelink/objects/metrics_registry.h"
+
+namespace CorelinkDLL {
+    namespace Object {
+        /**
+         * Header in front of the data of every block.
+         */
+        struct packet_block {
+            std::atomic<int> refs;
+            /// Size class of the block, -1 if it is not pooled.
+            int sizeClass;
+            int capacity;
+            int length;
+            /// Next free block while the block sits in a free list.
+            packet_block* next;
+        };
+
+        /**
+         * Handle to a pooled buffer. Copies share the buffer, the last handle to go returns it to the pool.
+         * Handles may be copied and dropped from any thread, the data must not be written once the buffer is shared.
+         */
+        class packet_buffer {
+        public:
+            /**
+             * Empty handle without a buffer.
+             */
+            packet_buffer();
+            ~packet_buffer();
+
+            packet_buffer(const packet_buffer& rhs);
+            packet_buffer(packet_buffer&& rhs);
+            packet_buffer& operator=(const packet_buffer& rhs);
+            packet_buffer& operator=(packet_buffer&& rhs);
+
+            /**
+             * @return nullptr for an empty handle.
+             */
+            char* data();
+            const char* data() const;
+
+            /**
+             * @return Length of the data. 0 for an empty handle.
+             */
+            int size() const;
+
+            /**
+             * @return Bytes the buffer can hold. 0 for an empty handle.
+             */
+            int capacity() const;
+
+            /**
+             * Changes the length of the data without touching it.
+             * @param len New length. Must not exceed capacity().
+             */
+            void resize(int len);
+
+            /**
+             * @return True if the handle holds a buffer.
+             */
+            bool valid() const;
+
+            /**
+             * Lets go of the buffer, leaving the handle empty.
+             */
+            void reset();
+
+        private:
+            friend class packet_pool;
+
+            packet_block* block;
+
+            explicit packet_buffer(packet_block* block);
+        };
+
+        /**
+         * THREADSAFE
+         */
+        class packet_pool {
+        public:
+            static const int CLASSES = 7;
+            /// Capacity of the smallest class. Every class is 4 times bigger than the last, up to 256K.
+            static const int MIN_CLASS_SIZE = 64;
+            /// Most free blocks of a class a thread keeps for itself.
+            static const int CACHE_LIMIT = 64;
+            /// Bytes of free blocks of a class a thread keeps for itself, limits the cache of the bigger classes.
+            static const int CACHE_BYTES = 1 << 20;
+            /// The shared list of a class holds this many thread caches before it frees blocks.
+            static const int SHARED_CACHES = 16;
+
+            /**
+             * Pool shared by the whole dll.
+             */
+            static packet_pool& instance();
+
+            /**
+             * @param len Length of the data. The content is left uninitialized.
+             * @return Buffer of at least len bytes.
+             */
+            packet_buffer acquire(int len);
+
+            /**
+             * @return Buffer holding a copy of len bytes of data.
+             */
+            packet_buffer acquire(const char* data, int len);
+
+            /**
+             * @return Buffers handed out and not returned yet.
+             */
+            std::int64_t getInUse() const;
+
+            static int classSize(int sizeClass);
+
+        private:
+            friend class packet_buffer;
+
+            /**
+             * Free blocks of the calling thread.
+             */
+            struct thread_cache {
+                packet_block* heads[CLASSES];
+                int counts[CLASSES];
+                /// Set once the thread exits, blocks freed after that go straight to the shared lists.
+                bool closed;
+                thread_cache();
+                ~thread_cache();
+            };
+
+            /**
+             * Free blocks shared by every thread.
+             */
+            struct shared_list {
+                std::mutex lock;
+                packet_block* head;
+                int count;
+                shared_list() : head(nullptr), count(0) {}
+            };
+
+            shared_list shared[CLASSES];
+
+            std::shared_ptr<metric_counter> hits;
+            std::shared_ptr<metric_counter> misses;
+            std::shared_ptr<metric_counter> oversize;
+            std::shared_ptr<metric_counter> released;
+            std::shared_ptr<metric_gauge> blocks;
+            std::shared_ptr<metric_gauge> bytes;
+
+            packet_pool();
+            ~packet_pool();
+
+            static thread_cache& localCache();
+
+            /**
+             * @return Most free blocks of the class a thread keeps.
+             */
+            static int cacheLimit(int sizeClass);
+
+            packet_block* allocate(int sizeClass, int capacity);
+            void deallocate(packet_block* block);
+
+            /**
+             * Takes the block back once its last handle is gone.
+             */
+            void recycle(packet_block* block);
+
+            /**
+             * Moves free blocks of the class from the thread cache to the shared list until keep are left.
+             */
+            void flush(thread_cache& cache, int sizeClass, int keep);
+
+            /**
+             * Moves a batch of free blocks of the class from the shared list to the thread cache.
+             */
+            void refill(thread_cache& cache, int sizeClass);
+
+            packet_pool(const packet_pool&) = delete;
+            packet_pool& operator=(const packet_pool&) = delete;
+        };
+
+        inline packet_buffer::packet_buffer() : block(nullptr) {}
+
+        inline packet_buffer::packet_buffer(packet_block* block) : block(block) {}
+
+        inline packet_buffer::~packet_buffer() {
+            this->reset();
+        }
+
+        inline packet_buffer::packet_buffer(const packet_buffer& rhs) : block(rhs.block) {
+            if (this->block != nullptr) {
+                this->block->refs.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        inline packet_buffer::packet_buffer(packet_buffer&& rhs) : block(rhs.block) {
+            rhs.block = nullptr;
+        }
+
+        inline packet_buffer& packet_buffer::operator=(const packet_buffer& rhs) {
+            if (rhs.block != nullptr) {
+                rhs.block->refs.fetch_add(1, std::memory_order_relaxed);
+            }
+            this->reset();
+            this->block = rhs.block;
+            return *this;
+        }
+
+        inline packet_buffer& packet_buffer::operator=(packet_buffer&& rhs) {
+            if (this != &rhs) {
+                this->reset();
+                this->block = rhs.block;
+                rhs.block = nullptr;
+            }
+            return *this;
+        }
+
+        inline char* packet_buffer::data() {
+            return this->block == nullptr ? nullptr : (char*)(this->block + 1);
+        }
+
+        inline const char* packet_buffer::data() const {
+            return this->block == nullptr ? nullptr : (const char*)(this->block + 1);
+        }
+
+        inline int packet_buffer::size() const {
+            return this->block == nullptr ? 0 : this->block->length;
+        }
+
+        inline int packet_buffer::capacity() const {
+            return this->block == nullptr ? 0 : this->block->capacity;
+        }
+
+        inline void packet_buffer::resize(int len) {
+            this->block->length = len;
+        }
+
+        inline bool packet_buffer::valid() const {
+            return this->block != nullptr;
+        }
+
+        inline void packet_buffer::reset() {
+            if (this->block == nullptr) { return; }
+            // a single owner can skip the atomic decrement, nobody else can add a reference.
+            if (this->block->refs.load(std::memory_order_acquire) == 1 ||
+                this->block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                packet_pool::instance().recycle(this->block);
+            }
+            this->block = nullptr;
+        }
+
+        inline int packet_pool::classSize(int sizeClass) {
+            return MIN_CLASS_SIZE << (2 * sizeClass);
+        }
+    }
+}
+
+#endif
@@ -9,10 +9,14 @@
 #include "corelink/objects/generics/safe_queue.h"
 #include "corelink/objects/generics/stream_map.h"
 #include "corelink/objects/init.h"
+#include "corelink/objects/packet_pool.h"
 
 namespace CorelinkDLL {
     namespace Object {
         namespace Stream {
+            /// Bytes of the lengths and stream id in front of the json header of a packet.
+            static const int PACKET_HEADER_SIZE = 8;
+
             class comm_data_base {
             public:
                 virtual ~comm_data_base() = default;
@@ -42,12 +46,15 @@ namespace CorelinkDLL {
                  * Packages the data in a format to send to the server.
                  * @param streamID Stream sending the data.
                  * @param federationID Server to send data to.
-                 * @param msg String message to send to server.
+                 * @param msg Message to send to server.
+                 * @param msgLen Length of the message.
                  * @param json Json string to attach with the message.
+                 * @param jsonLen Length of the json.
                  * @param serverCheck Should server check the json.
-                 * @return String that the server is able reciever and interpret.
+                 * @return Pooled buffer that the server is able reciever and interpret.
                  */
-                static std::string packageSend(const STREAM_ID& streamID, const int& federationID, const std::string& msg, const std::string& json = "", bool serverCheck = false);
+                static CorelinkDLL::Object::packet_buffer packageSend(const STREAM_ID& streamID, const int& federationID, const char* msg, int msgLen,
+                    const char* json = "", int jsonLen = 0, bool serverCheck = false);
             };
         }
     }
@@ -6,6 +6,11 @@
 #define CORELINK_OBJECTS_STREAMS_COMMDATARECVBASE_H
 
 #include "corelink/objects/streams/comm_data_base.h"
+#include "corelink/objects/streams/stream_codec.h"
+#include "corelink/objects/streams/recv_ring.h"
+#include "corelink/objects/capture/capture_recorder.h"
+#include "corelink/objects/metrics_registry.h"
+#include "corelink/objects/generics/concurrent_stream_map.h"
 
 namespace CorelinkDLL {
     namespace Object {
@@ -19,6 +24,19 @@ namespace CorelinkDLL {
              * extra Data added in addition to the callback.
              */
             typedef void(*Callback)(STREAM_ID receiver, STREAM_ID source, const char* msg, int jsonLen, int msgLen, void* extra);
+
+            /**
+             * Moves a callable from src into the uninitialized callback slot.
+             */
+            typedef void(*CallbackConstruct)(void* slot, void* src);
+
+            /**
+             * Destroys the callable stored in the callback slot.
+             */
+            typedef void(*CallbackDestroy)(void* slot);
+
+            /// Bytes available to callables stored inside the stream data.
+            static const int CALLBACK_SLOT_SIZE = 64;
             
             /**
              * @class recv_stream_data_base
@@ -26,6 +44,9 @@ namespace CorelinkDLL {
              */
             class recv_stream_data_base {
             public:
+                /**
+                 * Copies do not carry a callable stored in the callback slot or the polling ring.
+                 */
                 recv_stream_data_base();
 
                 recv_stream_data_base(const recv_stream_data_base& rhs);
@@ -41,15 +62,65 @@ namespace CorelinkDLL {
                  */
                 void* changeFunc(Callback funcPointer, void* funcExtra);
 
+                /**
+                 * Switches callback function to a callable stored inside the stream data.
+                 * The callback gets the slot as extra data.
+                 * @param construct Moves the callable into the slot.
+                 * @param destroy Destroys the callable when it is replaced or the stream is removed.
+                 * @param src Callable to move into the slot.
+                 * @return Extra data of the previous callback, nullptr if there was none or it was stored in the slot.
+                 */
+                void* changeFuncInline(Callback funcPointer, CallbackConstruct construct, CallbackDestroy destroy, void* src);
+
                 /**
                  * Calls the callback function.
+                 * The packet is counted, and recorded as received if a capture is running.
+                 * Codec frames are rebuilt into the full message first and dropped while waiting on a keyframe.
                  */
                 void callFunc(const STREAM_ID& recvID, const STREAM_ID& sendID, const char* data, const int& jsonLen, const int& msgLen);
 
+                /**
+                 * Forgets the codec keyframe of a sender.
+                 */
+                void resetSource(const STREAM_ID& sendID);
+
+                /**
+                 * Switches between callbacks and polling.
+                 * While polling, messages are queued in a ring instead of calling the callback.
+                 * The ring is created on the first switch and keeps its capacity for the life of the stream.
+                 * @param capacity Messages held by the ring. 0 to go back to callbacks.
+                 */
+                void setPolling(int capacity);
+
+                /**
+                 * Only one thread may poll a stream.
+                 * @return Polling ring or nullptr if the stream is not polled.
+                 */
+                recv_ring* getRing();
+
+                /// Shared with copies of the stream data.
+                CorelinkDLL::Object::stream_counters counters;
+
+                /// injectMsg calls running outside the epoch guard. The stream is only retired once it drops to 0.
+                std::atomic<int> injecting;
+
             private:
+                /**
+                 * Destroys the callable in the slot, if any. funcLock must be held.
+                 * @return Whether the slot held a callable.
+                 */
+                bool clearSlot();
+
                 Callback funcPointer;
                 void* funcExtra;
+                /// Set while funcSlot holds a callable.
+                CallbackDestroy funcSlotDestroy;
+                alignas(std::max_align_t) unsigned char funcSlot[CALLBACK_SLOT_SIZE];
                 std::mutex funcLock;
+                /// Keyframes of the senders using a codec. Not copied with the stream data.
+                stream_decoder decoder;
+                std::unique_ptr<recv_ring> ring;
+                std::atomic<bool> polling;
             };
 
             class comm_data_recv_base : public comm_data_base {
@@ -63,13 +134,62 @@ namespace CorelinkDLL {
                  */
                 void* setRecvCallback(int ref, const STREAM_ID& streamID, Callback recvCallback, void* callbackData);
 
+                /**
+                 * Sets the callback to use with a callable stored inside the stream data.
+                 * @param found Stores whether the stream was found. src is left untouched otherwise.
+                 * @return Wrapper side data of the previous callback (or nullptr) for the wrapper to clean up.
+                 */
+                void* setRecvCallbackInline(int ref, const STREAM_ID& streamID, Callback recvCallback, CallbackConstruct construct, CallbackDestroy destroy, void* src, bool& found);
+
+                /**
+                 * Switches the stream between callbacks and polling.
+                 * @param capacity Messages held until the stream is polled. 0 to go back to callbacks.
+                 * @return If the stream exists.
+                 */
+                bool setRecvPolling(int ref, const STREAM_ID& streamID, int capacity);
+
+                /**
+                 * Takes the messages received since the last poll.
+                 * The views of the last poll are released, so only one thread may poll a stream.
+                 * @param out Stores views of the messages. Valid until the next poll or the stream is removed.
+                 * @param max Size of out.
+                 * @return Number of messages stored in out. -1 if the stream does not exist or is not polled.
+                 */
+                int pollMessages(int ref, const STREAM_ID& streamID, recv_message* out, int max);
+
+                /**
+                 * @return Messages dropped because the polling ring was full. 0 if the stream is not polled.
+                 */
+                unsigned long long getPollDropped(int ref, const STREAM_ID& streamID);
+
+                /**
+                 * Hands a message to the stream as if it had been received from the server.
+                 * The callback runs outside the epoch guard, rmStream waits for it.
+                 * @param sendID Sender the message is attributed to.
+                 * @param data Json header followed by the message.
+                 * @return If the stream exists.
+                 */
+                bool injectMsg(int ref, const STREAM_ID& streamID, const STREAM_ID& sendID, const char* data, int jsonLen, int msgLen);
+
+                /**
+                 * Forgets the codec keyframe a stream keeps for a sender, e.g. once the sender went stale.
+                 * Does nothing if the stream does not exist.
+                 */
+                void resetSource(int ref, const STREAM_ID& streamID, const STREAM_ID& sendID);
+
             private:
             protected:
+                /**
+                 * Waits for the injectMsg calls still running on a stream that was unlinked from streamMap.
+                 * Must not be called while holding a read_guard.
+                 */
+                static void waitInjected(recv_stream_data_base* streamData);
+
                 /**
                  * Maps stream ids to their respective sender.
                  * Also used to quickly reference streamids.
                  */
-                CorelinkDLL::Object::Generic::stream_map<recv_stream_data_base*> streamMap;
+                CorelinkDLL::Object::Generic::concurrent_stream_map<recv_stream_data_base*> streamMap;
             };
         }
     }
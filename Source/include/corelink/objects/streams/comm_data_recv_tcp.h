@@ -7,7 +7,6 @@
 #define CORELINK_OBJECTS_STREAMS_COMMDATARECVTCP_H
 
 #include "corelink/objects/streams/comm_data_recv_base.h"
-#include "corelink/objects/generics/stream_map.h"
 
 namespace CorelinkDLL {
     namespace Object {
@@ -39,10 +38,10 @@ namespace CorelinkDLL {
                 /**
                  * Waits for socket to recieve data before running the callback function.
                  * TODO: Use select() to improve performance of socket blocking and reduce number of threads.
-                 * TODO: Place this function inside the struct and use this instead of streamMap.at(ref) for clarity and minor performance improvement.
-                 * @param ref Quick refecrence that this thread is running on.
+                 * @param streamData Stream this thread is running on. Stays valid until the thread is joined.
+                 * @param streamID Id of the stream.
                  */
-                void recvFunc(int ref);
+                void recvFunc(recv_stream_data_tcp* streamData, STREAM_ID streamID);
             protected:
             };
         }
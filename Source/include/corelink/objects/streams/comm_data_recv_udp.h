@@ -7,7 +7,6 @@
 #define CORELINK_OBJECTS_STREAMS_COMMDATARECVUDP_H
 
 #include "corelink/objects/streams/comm_data_recv_base.h"
-#include "corelink/objects/generics/stream_map.h"
 
 namespace CorelinkDLL {
     namespace Object {
@@ -40,11 +39,11 @@ namespace CorelinkDLL {
                  * Waits for socket to recieve data before running the callback function.
                  * TODO: replace use of streamMap with udp recv. Data is recieved in packets so it is either an entire message or none.
                  * TODO: Use select() to improve performance of socket blocking and reduce number of threads.
-                 * TODO: Place this function inside the struct and use this instead of streamMap.at(ref) for clarity and minor performance improvement.
-                 * @param ref Quick refecrence that this thread is running on.
+                 * @param streamData Stream this thread is running on. Stays valid until the thread is joined.
+                 * @param streamID Id of the stream.
                  * @param ip Server ip address.
                  */
-                void recvFunc(int ref, const std::string& ip);
+                void recvFunc(recv_stream_data_udp* streamData, STREAM_ID streamID, const std::string& ip);
             protected:
             };
         }
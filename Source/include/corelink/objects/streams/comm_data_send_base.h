@@ -6,6 +6,7 @@
 #define CORELINK_OBJECTS_STREAMS_COMMDATASENDBASE_H
 
 #include "corelink/objects/streams/comm_data_base.h"
+#include "corelink/objects/streams/stream_codec.h"
 
 namespace CorelinkDLL {
     namespace Object {
@@ -20,9 +21,10 @@ namespace CorelinkDLL {
                  * @param streamID Stream to verify that the correct stream was retrieved.
                  * @param federationID Target server to send data to.
                  * @param msg Message to send to server.
+                 * @param msgLen Length of the message.
                  * @return Stream successfully found.
                  */
-                virtual bool sendMsg(int ref, const STREAM_ID& streamID, const int& federationID, const std::string& msg) = 0;
+                virtual bool sendMsg(int ref, const STREAM_ID& streamID, const int& federationID, const char* msg, int msgLen) = 0;
                 
                 /**
                  * Sends data from the client to the server.
@@ -30,13 +32,55 @@ namespace CorelinkDLL {
                  * @param streamID Stream to verify that the correct stream was retrieved.
                  * @param federationID Target server to send data to.
                  * @param msg Message to send to server.
+                 * @param msgLen Length of the message.
                  * @param json Json to attach with message.
+                 * @param jsonLen Length of the json.
                  * @param serverCheck Should server check the json.
                  * @return Stream successfully found.
                  */
-                virtual bool sendMsg(int ref, const STREAM_ID& streamID, const int& federationID, const std::string& msg, const std::string& json, bool serverCheck) = 0;
+                virtual bool sendMsg(int ref, const STREAM_ID& streamID, const int& federationID, const char* msg, int msgLen,
+                    const char* json, int jsonLen, bool serverCheck) = 0;
+
+                /**
+                 * Sets the codec applied to messages of the stream.
+                 * @param ref Reference to quickly access stream.
+                 * @param streamID Stream to verify that the correct stream was retrieved.
+                 * @param codec Codec to use. CODEC_NONE sends messages as is.
+                 * @param keyInterval Number of frames between keyframes.
+                 * @return Stream successfully found.
+                 */
+                virtual bool setCodec(int ref, const STREAM_ID& streamID, int codec, int keyInterval) = 0;
+
+                /**
+                 * Lets the calling thread send messages of the stream directly instead of going through the send thread.
+                 * @param ref Reference to quickly access stream.
+                 * @param streamID Stream to verify that the correct stream was retrieved.
+                 * @param enable Send on the calling thread.
+                 * @return Stream successfully found and protocol supports direct sending.
+                 */
+                virtual bool setDirectSend(int ref, const STREAM_ID& streamID, bool enable);
+
+                /**
+                 * THREADSAFE
+                 * @return Messages waiting for the send thread, shared by every stream of the protocol.
+                 */
+                virtual int getQueueDepth() = 0;
             private:
             protected:
+                /**
+                 * Packages the data and applies the codec of the stream if there is one.
+                 * Messages longer than stream_codec::MAX_MESSAGE_SIZE are packaged without the codec.
+                 * @param encoder Codec state of the stream. nullptr if the stream does not use a codec.
+                 * @return Pooled buffer that the server is able reciever and interpret.
+                 */
+                static CorelinkDLL::Object::packet_buffer packageSendCodec(const std::shared_ptr<stream_encoder>& encoder, const STREAM_ID& streamID, const int& federationID,
+                    const char* msg, int msgLen, const char* json = "", int jsonLen = 0, bool serverCheck = false);
+
+                /**
+                 * Creates the codec state for a stream.
+                 * @return nullptr for CODEC_NONE or invalid codecs.
+                 */
+                static std::shared_ptr<stream_encoder> createEncoder(int codec, int keyInterval);
             };
         }
     }
@@ -14,8 +14,9 @@
  */
 
 #include "corelink/objects/streams/comm_data_send_base.h"
-#include "corelink/objects/generics/stream_map.h"
+#include "corelink/objects/generics/concurrent_stream_map.h"
 #include "corelink/objects/generics/safe_queue.h"
+#include "corelink/objects/metrics_registry.h"
 
 namespace CorelinkDLL {
     namespace Object {
@@ -29,8 +30,11 @@ namespace CorelinkDLL {
                 int getStreamRef(const STREAM_ID& streamID) override;
                 void rmStream(const STREAM_ID& streamID) override;
 
-                bool sendMsg(int ref, const STREAM_ID& streamID, const int& federationID, const std::string& msg) override;
-                bool sendMsg(int ref, const STREAM_ID& streamID, const int& federationID, const std::string& msg, const std::string& json, bool serverCheck) override;
+                bool sendMsg(int ref, const STREAM_ID& streamID, const int& federationID, const char* msg, int msgLen) override;
+                bool sendMsg(int ref, const STREAM_ID& streamID, const int& federationID, const char* msg, int msgLen,
+                    const char* json, int jsonLen, bool serverCheck) override;
+                bool setCodec(int ref, const STREAM_ID& streamID, int codec, int keyInterval) override;
+                int getQueueDepth() override;
             private:
                 /**
                  * @private
@@ -39,6 +43,9 @@ namespace CorelinkDLL {
                 struct DataSenderTCP {
                     SOCKET sock;
                     sockaddr_in hint;
+                    /// Codec state. nullptr if messages are sent as is.
+                    std::shared_ptr<stream_encoder> encoder;
+                    stream_counters counters;
 
                     DataSenderTCP(const std::string& serverIP = "0.0.0.0", int port = 0) {
                         sock = INVALID_SOCKET;
@@ -61,7 +68,7 @@ namespace CorelinkDLL {
                  * Maps stream ids to their respective sender.
                  * Also used to quickly reference streamids.
                  */
-                CorelinkDLL::Object::Generic::stream_map<DataSenderTCP> streamMap;
+                CorelinkDLL::Object::Generic::concurrent_stream_map<DataSenderTCP> streamMap;
 
                 /**
                  * Socket for sending UDP packets.
@@ -71,7 +78,7 @@ namespace CorelinkDLL {
                 /**
                  * Passes data (socket, message pair) from client to send thread.
                  */
-                CorelinkDLL::Object::Generic::safe_queue<std::pair<SOCKET, std::string>> sendQueue;
+                CorelinkDLL::Object::Generic::safe_queue<std::pair<SOCKET, CorelinkDLL::Object::packet_buffer>> sendQueue;
 
                 /**
                  * Sender thread for sendFunc.
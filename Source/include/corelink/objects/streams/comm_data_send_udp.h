@@ -6,8 +6,9 @@
 #define CORELINK_OBJECTS_STREAMS_COMMDATASENDUDP_H
 
 #include "corelink/objects/streams/comm_data_send_base.h"
-#include "corelink/objects/generics/stream_map.h"
+#include "corelink/objects/generics/concurrent_stream_map.h"
 #include "corelink/objects/generics/safe_queue.h"
+#include "corelink/objects/metrics_registry.h"
 
 namespace CorelinkDLL {
     namespace Object {
@@ -21,16 +22,38 @@ namespace CorelinkDLL {
                 int getStreamRef(const STREAM_ID& streamID) override;
                 void rmStream(const STREAM_ID& streamID) override;
 
-                bool sendMsg(int ref, const STREAM_ID& streamID, const int& federationID, const std::string& msg) override;
-                bool sendMsg(int ref, const STREAM_ID& streamID, const int& federationID, const std::string& msg, const std::string& json, bool serverCheck) override;
+                bool sendMsg(int ref, const STREAM_ID& streamID, const int& federationID, const char* msg, int msgLen) override;
+                bool sendMsg(int ref, const STREAM_ID& streamID, const int& federationID, const char* msg, int msgLen,
+                    const char* json, int jsonLen, bool serverCheck) override;
+                bool setCodec(int ref, const STREAM_ID& streamID, int codec, int keyInterval) override;
+                bool setDirectSend(int ref, const STREAM_ID& streamID, bool enable) override;
+                int getQueueDepth() override;
             private:
+                /**
+                 * @private
+                 * Direct send state shared between a stream and its messages in the send queue.
+                 */
+                struct DirectState {
+                    /// Send on the calling thread when nothing of the stream is queued.
+                    std::atomic<bool> enabled;
+                    /// Messages of the stream in the send queue. Direct sends wait for it to drain to keep messages in order.
+                    std::atomic<int> queued;
+                    /// Messages of the stream the socket rejected. Same counter as the stream's counters.drops.
+                    std::shared_ptr<metric_counter> drops;
+                    DirectState() : enabled(false), queued(0) {}
+                };
+
                 /**
                  * @private
                  * UDP Sender data stored by dll for a stream.
                  */
                 struct DataSenderUDP {
                     int nsPort;
-                    DataSenderUDP(int port = 0) {
+                    /// Codec state. nullptr if messages are sent as is.
+                    std::shared_ptr<stream_encoder> encoder;
+                    std::shared_ptr<DirectState> direct;
+                    stream_counters counters;
+                    DataSenderUDP(int port = 0) : direct(std::make_shared<DirectState>()) {
                         nsPort = INVALID_PORT;
                         if (port > 0 && port <= 65535) {
                             nsPort = htons(port);
@@ -38,11 +61,22 @@ namespace CorelinkDLL {
                     }
                     ~DataSenderUDP() {}
                 };
+
+                /**
+                 * @private
+                 * Message waiting in the send queue.
+                 */
+                struct QueuedMsg {
+                    int nsPort;
+                    CorelinkDLL::Object::packet_buffer msg;
+                    /// Direct send state of the stream. Released once the message is sent.
+                    std::shared_ptr<DirectState> direct;
+                };
                 /**
                  * Maps stream ids to their respective sender.
                  * Also used to quickly reference streamids.
                  */
-                CorelinkDLL::Object::Generic::stream_map<DataSenderUDP> streamMap;
+                CorelinkDLL::Object::Generic::concurrent_stream_map<DataSenderUDP> streamMap;
 
                 /* TODO:
                 * Should compare performance with using individual thread, sockets, and queues per sender.
@@ -55,9 +89,14 @@ namespace CorelinkDLL {
                 SOCKET sock = INVALID_SOCKET;
 
                 /**
-                 * Passes data (port, message pair) from client to send thread.
+                 * Server address used by the socket. Port is set per message.
+                 */
+                sockaddr_in serverHint;
+
+                /**
+                 * Passes data from client to send thread.
                  */
-                CorelinkDLL::Object::Generic::safe_queue<std::pair<int, std::string>> sendQueue;
+                CorelinkDLL::Object::Generic::safe_queue<QueuedMsg> sendQueue;
 
                 /**
                  * Sender thread for sendFunc.
@@ -68,7 +107,14 @@ namespace CorelinkDLL {
                  * Polls data from the send queue and sends the data.
                  * @param serverIP ipv4 address of the server. (Currently does not support individual ips per connection)
                  */
-                void sendFunc(const std::string& serverIP);
+                void sendFunc();
+
+                /**
+                 * Sends the packet on the calling thread if the stream allows it, otherwise queues it.
+                 * @param sender Stream to send on.
+                 * @param package Packaged message.
+                 */
+                void send(const DataSenderUDP& sender, CorelinkDLL::Object::packet_buffer&& package);
 
             protected:
             };
@@ -7,6 +7,7 @@
 
 #include "corelink/headers/header.h"
 #include "corelink/objects/client_main.h"
+#include "corelink/objects/metrics_registry.h"
 
 
 namespace CorelinkDLL {
@@ -30,6 +31,11 @@ namespace CorelinkDLL {
                 /// Thread for server callback.
                 std::thread threadCallback;
 
+                /// Requests waiting in sendRecv.
+                std::shared_ptr<metric_gauge> inflight;
+                /// Nanoseconds from sending a request to its response.
+                std::shared_ptr<CorelinkDLL::Object::Generic::latency_histogram> roundTrip;
+
                 comm_main_base() = delete;
                 comm_main_base(client_main* clientRef);
 
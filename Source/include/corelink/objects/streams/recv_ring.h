@@ -0,0 +1,93 @@
+/**
+ * @file recv_ring.h
+ * @brief Single producer single consumer ring for polled receiver streams.
+ * The listener thread of the stream pushes, the thread polling the stream consumes.
+ */
+#ifndef CORELINK_OBJECTS_STREAMS_RECVRING_H
+#define CORELINK_OBJECTS_STREAMS_RECVRING_H
+
+#include "corelink/headers/header.h"
+
+namespace CorelinkDLL {
+    namespace Object {
+        namespace Stream {
+            /**
+             * View of a polled message.
+             * data points at the json header followed by the message.
+             * Valid until the next poll of the stream.
+             */
+            struct recv_message {
+                STREAM_ID recvID;
+                STREAM_ID sendID;
+                const char* data;
+                int hdrLen;
+                int msgLen;
+            };
+
+            /**
+             * THREADSAFE for one producer and one consumer.
+             * Slot buffers are kept between messages so pushing stops allocating once they reach the usual message size.
+             * Messages pushed while the ring is full are dropped.
+             */
+            class recv_ring {
+            private:
+                struct slot {
+                    STREAM_ID recvID;
+                    STREAM_ID sendID;
+                    int hdrLen;
+                    int msgLen;
+                    std::vector<char> buffer;
+                };
+
+                std::vector<slot> slots;
+                unsigned int mask;
+
+                /// Next slot to write. Written by the producer.
+                std::atomic<unsigned int> head;
+                char headPad[64 - sizeof(std::atomic<unsigned int>)];
+                /// First slot still held by the consumer. Written by the consumer.
+                std::atomic<unsigned int> tail;
+                char tailPad[64 - sizeof(std::atomic<unsigned int>)];
+
+                /// Producer side copy of tail, reloaded only when the ring looks full.
+                unsigned int cachedTail;
+                /// Consumer side copy of tail.
+                unsigned int readTail;
+                /// Slots handed out by the last poll.
+                unsigned int pending;
+                std::atomic<unsigned long long> dropped;
+            public:
+                /**
+                 * @param capacity Number of messages held. Rounded up to a power of 2.
+                 */
+                explicit recv_ring(int capacity);
+
+                /**
+                 * Producer only.
+                 * Copies the message into the next slot.
+                 * @return False if the ring is full and the message was dropped.
+                 */
+                bool push(const STREAM_ID& recvID, const STREAM_ID& sendID, const char* data, int hdrLen, int msgLen);
+
+                /**
+                 * Consumer only.
+                 * Returns the slots of the last poll to the producer, then hands out everything pushed since.
+                 * @param out Stores views of the messages.
+                 * @param max Size of out.
+                 * @return Number of messages stored in out.
+                 */
+                int poll(recv_message* out, int max);
+
+                int getCapacity() const;
+
+                unsigned long long getDropped() const;
+
+            private:
+                recv_ring(const recv_ring&) = delete;
+                recv_ring& operator=(const recv_ring&) = delete;
+            };
+        }
+    }
+}
+
+#endif
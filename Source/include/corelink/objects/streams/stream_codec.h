@@ -0,0 +1,145 @@
+/**
+ * @file stream_codec.h
+ * @brief Optional codec stage for data streams.
+ * Senders emit periodic keyframes and XOR delta frames against the last keyframe.
+ * Receivers rebuild the full frame before it reaches the callback.
+ *
+ * Codec frame (placed in the message part of a packet):
+ * -1 byte frame type (FRAME_KEY or FRAME_DELTA).
+ * -2 bytes keyframe sequence the frame belongs to.
+ * -2 bytes length of the original message.
+ * -payload. Raw message for keyframes, run length encoded XOR against the keyframe for deltas.
+ *
+ * The json header of every codec frame starts with {"codec":id} so receivers unaware of the codec can tell what they are getting.
+ * Receivers remove the codec id again before the header reaches the callback.
+ * Messages too long for a codec frame are sent raw.
+ */
+#ifndef CORELINK_OBJECTS_STREAMS_STREAMCODEC_H
+#define CORELINK_OBJECTS_STREAMS_STREAMCODEC_H
+
+#include "corelink/headers/header.h"
+
+namespace CorelinkDLL {
+    namespace Object {
+        namespace Stream {
+            class stream_codec {
+            public:
+                static const int FRAME_KEY = 0;
+                static const int FRAME_DELTA = 1;
+                static const int FRAME_HEADER_SIZE = 5;
+                /// Longest message that fits a codec frame in the 16 bit data length of a packet.
+                static const int MAX_MESSAGE_SIZE = 0xFFFF - FRAME_HEADER_SIZE;
+
+                /**
+                 * Builds the json header for a codec frame.
+                 * @param codec Codec used on the frame.
+                 * @param json Json the user attached to the message. Members are kept after the codec id.
+                 * @param jsonLen Length of the json.
+                 * @param out Stores the json header to send with the frame.
+                 */
+                static void header(int codec, const char* json, int jsonLen, std::string& out);
+
+                /**
+                 * Reads the codec id from a json header.
+                 * @param json Json header of the message.
+                 * @param jsonLen Length of the json header.
+                 * @return Codec id or CODEC_NONE if the header does not mark a codec frame.
+                 */
+                static int parseHeader(const char* json, int jsonLen);
+
+                /**
+                 * Removes the codec id from a json header marked by header().
+                 * @param out Stores the json header the user attached.
+                 */
+                static void stripHeader(const char* json, int jsonLen, std::string& out);
+
+                /**
+                 * Run length encodes msg XOR key.
+                 * Format is repeated (varint zero run, varint literal run, literal bytes).
+                 * @param out Appends the encoded data.
+                 */
+                static void xorEncode(const char* key, int keyLen, const char* msg, int msgLen, std::string& out);
+
+                /**
+                 * Reverses xorEncode.
+                 * @param out Buffer of msgLen bytes to store the rebuilt message.
+                 * @return False if the data is malformed.
+                 */
+                static bool xorDecode(const char* key, int keyLen, const char* data, int dataLen, char* out, int msgLen);
+            };
+
+            /**
+             * THREADSAFE
+             * Sender side state of the codec for a single stream.
+             */
+            class stream_encoder {
+            private:
+                int codec;
+                /// Number of frames between keyframes.
+                int keyInterval;
+                /// Frames sent since the last keyframe.
+                int sinceKey;
+                unsigned short keySeq;
+                std::string keyFrame;
+                std::mutex lock;
+            public:
+                stream_encoder(int codec, int keyInterval);
+
+                int getCodec() const;
+
+                /**
+                 * Encodes the message and builds the matching json header.
+                 * @param msg Message the user is sending.
+                 * @param msgLen Length of the message.
+                 * @param json Json the user attached to the message.
+                 * @param jsonLen Length of the json.
+                 * @param frame Stores the encoded frame.
+                 * @param frameJson Stores the json header to send.
+                 */
+                void encode(const char* msg, int msgLen, const char* json, int jsonLen, std::string& frame, std::string& frameJson);
+
+            private:
+                stream_encoder(const stream_encoder&) = delete;
+                stream_encoder& operator=(const stream_encoder&) = delete;
+            };
+
+            /**
+             * Receiver side state of the codec. Keeps the last keyframe of each source.
+             * Only used from the listener thread of the stream.
+             */
+            class stream_decoder {
+            private:
+                struct source_state {
+                    bool valid;
+                    unsigned short keySeq;
+                    std::string keyFrame;
+                    source_state() : valid(false), keySeq(0) {}
+                };
+                std::unordered_map<STREAM_ID, source_state> sources;
+                /// Rebuilt json header and message handed to the callback.
+                std::string frame;
+                /// Json header without the codec id.
+                std::string json;
+            public:
+                stream_decoder();
+
+                /**
+                 * Rebuilds the full frame.
+                 * @param source Sender of the frame.
+                 * @param data Json header followed by the codec frame.
+                 * @param jsonLen Length of the json header. Stores the length of the header without the codec id.
+                 * @param msgLen Length of the codec frame. Stores the length of the rebuilt message.
+                 * @return Json header without the codec id followed by the rebuilt message. nullptr if the frame should be dropped until the next keyframe.
+                 */
+                const char* decode(const STREAM_ID& source, const char* data, int& jsonLen, int& msgLen);
+
+                /**
+                 * Forgets the keyframe of a source, e.g. once it went stale.
+                 */
+                void reset(const STREAM_ID& source);
+            };
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,99 @@
+/**
+ * @file stream_snapshot.h
+ * @brief Immutable copy of the client stream table for lock-free readers.
+ * Writers copy the current snapshot, change the copy and publish it.
+ * Old snapshots are retired through the epoch_manager.
+ */
+#ifndef CORELINK_OBJECTS_STREAMS_STREAMSNAPSHOT_H
+#define CORELINK_OBJECTS_STREAMS_STREAMSNAPSHOT_H
+
+#include "corelink/headers/header.h"
+#include "corelink/objects/streams/stream_data.h"
+
+namespace CorelinkDLL {
+    namespace Object {
+        namespace Stream {
+            /**
+             * THREADSAFE
+             * Read only data of a stream.
+             * The compacted stream data is stored right after the record so it can be handed out and released by pointer.
+             */
+            class stream_record {
+            public:
+                STREAM_ID streamID;
+                int state;
+                int stateIndex;
+                /// Reference of the stream in its data stream.
+                int ref;
+                /// Length of the compacted stream data.
+                int dataLen;
+
+                /**
+                 * Creates a record with a single reference.
+                 */
+                static stream_record* create(const stream_data& streamData, int ref);
+
+                /**
+                 * Gets the record owning the compacted data returned by data().
+                 */
+                static stream_record* fromData(const char* data);
+
+                /**
+                 * @return Compacted stream data, null terminated.
+                 */
+                const char* data() const;
+
+                void acquire();
+
+                /**
+                 * Frees the record when the last reference is released.
+                 */
+                void release();
+
+            private:
+                std::atomic<int> refs;
+
+                stream_record(const stream_data& streamData, int ref);
+                ~stream_record() = default;
+                stream_record(const stream_record&) = delete;
+                stream_record& operator=(const stream_record&) = delete;
+            };
+
+            /**
+             * Stream table at a point in time. Holds a reference to each record.
+             */
+            class stream_snapshot {
+            public:
+                stream_snapshot();
+
+                /**
+                 * Copies the table and takes a reference to each record.
+                 */
+                stream_snapshot(const stream_snapshot& rhs);
+
+                ~stream_snapshot();
+
+                /**
+                 * @return Record of the stream or nullptr.
+                 */
+                const stream_record* find(const STREAM_ID& streamID) const;
+
+                /**
+                 * Takes ownership of the reference held by record.
+                 */
+                void add(stream_record* record);
+
+                void remove(const STREAM_ID& streamID);
+
+                const std::unordered_map<STREAM_ID, stream_record*>& getStreams() const;
+
+            private:
+                std::unordered_map<STREAM_ID, stream_record*> streams;
+
+                stream_snapshot& operator=(const stream_snapshot&) = delete;
+            };
+        }
+    }
+}
+
+#endif
@@ -6,6 +6,7 @@
 #define CORELINK_OBJECTS_STREAMS_TCPRECVHANDLER_H
 
 #include "corelink/headers/header.h"
+#include "corelink/objects/packet_pool.h"
 
 namespace CorelinkDLL {
     namespace Object {
@@ -51,9 +52,17 @@ namespace CorelinkDLL {
                  * Gets the data of length specified.
                  * @param len Amount of data to retrieve.
                  * @param buffer Amount of trailing 0s in returned array.
-                 * @return nullptr if not enough data is in buffer. Otherwise, pointer on heap of length len + buffer containing data requested followed by buffer of 0s.
+                 * @return Empty buffer if not enough data is in buffer. Otherwise, pooled buffer of length len + buffer containing data requested followed by buffer of 0s.
                  */
-                char* getData(int len, int buffer = 0);
+                CorelinkDLL::Object::packet_buffer getData(int len, int buffer = 0);
+
+                /**
+                 * Gets the data of length specified.
+                 * @param out Array of at least len bytes to store the data in.
+                 * @param len Amount of data to retrieve.
+                 * @return False if not enough data is in buffer.
+                 */
+                bool getData(char* out, int len);
 
             private:
                 void resize();
@@ -0,0 +1,211 @@
+/**
+ * @file trace_ring.h
+ * @brief Per thread rings of timed events along the hot paths, exported in the Chrome trace format.
+ * Trace points compile to nothing unless CORELINK_TRACE is defined.
+ * With CORELINK_TRACE defined a trace point costs one relaxed load while tracing is stopped,
+ * and two clock reads plus a few stores into the ring of the calling thread while it runs.
+ * Rings are fixed size, old events are overwritten once a ring wraps around.
+ */
+#ifndef CORELINK_OBJECTS_TRACERING_H
+#define CORELINK_OBJECTS_TRACERING_H
+
+#include "corelink/headers/header.h"
+
+namespace CorelinkDLL {
+    namespace Object {
+        /**
+         * Copy of a single event.
+         */
+        struct trace_event {
+            /// Static string naming the event. Never freed.
+            const char* name;
+            /// Nanoseconds on the steady clock.
+            std::int64_t start;
+            /// Nanoseconds, -1 for an instant event.
+            std::int64_t duration;
+            /// Value shown with the event, usually a stream ID or a length.
+            std::int64_t arg;
+        };
+
+        /**
+         * Only the owning thread adds events. Any thread may copy them.
+         * Slots are atomics so a copy racing with the owner is well defined, events overwritten during the copy are discarded.
+         */
+        class trace_ring {
+        public:
+            static const int RING_SIZE = 8192;
+
+            /**
+             * @param tid ID the thread is shown with.
+             * @param name Static string naming the thread. nullptr if unnamed.
+             */
+            trace_ring(int tid, const char* name);
+
+            /**
+             * Owner thread only.
+             */
+            void add(const char* name, std::int64_t start, std::int64_t duration, std::int64_t arg);
+
+            /**
+             * Any thread. Events added before the call are not counted as lost by copy.
+             */
+            void markStart();
+
+            /**
+             * Copies the events that started at or after since, oldest first.
+             * @param out Events are appended here.
+             * @return Number of events added after markStart that were lost to wrap around.
+             */
+            std::uint64_t copy(std::int64_t since, std::vector<trace_event>& out) const;
+
+            int getTID() const;
+            const char* getName() const;
+            void setName(const char* name);
+
+        private:
+            struct slot {
+                std::atomic<const char*> name;
+                std::atomic<std::int64_t> start;
+                std::atomic<std::int64_t> duration;
+                std::atomic<std::int64_t> arg;
+            };
+
+            slot slots[RING_SIZE];
+            /// Number of events ever added.
+            std::atomic<std::uint64_t> head;
+            /// head at the last markStart.
+            std::atomic<std::uint64_t> startHead;
+            int tid;
+            std::atomic<const char*> name;
+
+            trace_ring(const trace_ring&) = delete;
+            trace_ring& operator=(const trace_ring&) = delete;
+        };
+
+        /**
+         * THREADSAFE
+         * Owns the rings of every thread that recorded an event. Rings outlive their threads until the next start.
+         */
+        class tracer {
+        public:
+            /**
+             * Tracer shared by the whole dll.
+             */
+            static tracer& instance();
+
+            /**
+             * Relaxed flag checked by every trace point.
+             */
+            static bool isEnabled();
+
+            /**
+             * @return Nanoseconds on the steady clock.
+             */
+            static std::int64_t now();
+
+            /**
+             * Drops the events recorded so far and the rings of exited threads, then starts recording.
+             */
+            void start();
+
+            void stop();
+
+            /**
+             * Records an event on the ring of the calling thread. Ignored while stopped.
+             * @param name Static string naming the event.
+             * @param duration Nanoseconds, -1 for an instant event.
+             */
+            void add(const char* name, std::int64_t start, std::int64_t duration, std::int64_t arg);
+
+            /**
+             * Names the calling thread in exports. Does not allocate a ring.
+             * @param name Static string naming the thread.
+             */
+            void setThreadName(const char* name);
+
+            /**
+             * Writes the events recorded since the last start as Chrome trace JSON, readable by chrome://tracing and Perfetto.
+             * @param out Stores the JSON.
+             * @return Number of events lost to wrap around.
+             */
+            std::uint64_t exportChrome(std::string& out);
+
+        private:
+            static std::atomic<bool> enabled;
+
+            std::mutex ringsLock;
+            std::vector<std::shared_ptr<trace_ring>> rings;
+            std::atomic<std::int64_t> startTime;
+            int nextTID;
+
+            tracer();
+
+            /**
+             * @return Ring of the calling thread, created on the first event.
+             */
+            trace_ring& localRing();
+
+            tracer(const tracer&) = delete;
+            tracer& operator=(const tracer&) = delete;
+        };
+
+        /**
+         * Records the lifetime of the scope as a single event.
+         */
+        class trace_scope {
+        public:
+            trace_scope(const char* name, std::int64_t arg = 0) : name(name), arg(arg),
+                start(tracer::isEnabled() ? tracer::now() : -1) {}
+
+            ~trace_scope() {
+                if (this->start >= 0) {
+                    tracer::instance().add(this->name, this->start, tracer::now() - this->start, this->arg);
+                }
+            }
+
+        private:
+            const char* name;
+            std::int64_t arg;
+            std::int64_t start;
+
+            trace_scope(const trace_scope&) = delete;
+            trace_scope& operator=(const trace_scope&) = delete;
+        };
+
+        inline bool tracer::isEnabled() {
+            return enabled.load(std::memory_order_relaxed);
+        }
+
+        inline std::int64_t tracer::now() {
+            return (std::int64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+    }
+}
+
+#define CORELINK_TRACE_CONCAT_(a, b) a##b
+#define CORELINK_TRACE_CONCAT(a, b) CORELINK_TRACE_CONCAT_(a, b)
+
+#ifdef CORELINK_TRACE
+/// Times the rest of the enclosing scope.
+#define CORELINK_TRACE_SCOPE(name) \
+    CorelinkDLL::Object::trace_scope CORELINK_TRACE_CONCAT(traceScope, __LINE__)(name)
+#define CORELINK_TRACE_SCOPE_ARG(name, arg) \
+    CorelinkDLL::Object::trace_scope CORELINK_TRACE_CONCAT(traceScope, __LINE__)(name, (std::int64_t) (arg))
+/// Records a point in time.
+#define CORELINK_TRACE_INSTANT(name, arg) \
+    do { \
+        if (CorelinkDLL::Object::tracer::isEnabled()) { \
+            CorelinkDLL::Object::tracer::instance().add(name, CorelinkDLL::Object::tracer::now(), -1, (std::int64_t) (arg)); \
+        } \
+    } while (0)
+/// Names the calling thread in exports.
+#define CORELINK_TRACE_THREAD(name) CorelinkDLL::Object::tracer::instance().setThreadName(name)
+#else
+#define CORELINK_TRACE_SCOPE(name) do {} while (0)
+#define CORELINK_TRACE_SCOPE_ARG(name, arg) do {} while (0)
+#define CORELINK_TRACE_INSTANT(name, arg) do {} while (0)
+#define CORELINK_TRACE_THREAD(name) do {} while (0)
+#endif
+
+#endif
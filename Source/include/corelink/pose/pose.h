@@ -0,0 +1,14 @@
+/**
+ * @file pose.h
+ * @brief Header combining the pose files.
+ */
+#ifndef CORELINK_POSE_POSE_H
+#define CORELINK_POSE_POSE_H
+
+#include "corelink/pose/pose_text.h"
+#include "corelink/pose/pose_frame.h"
+#include "corelink/pose/pose_exchange.h"
+#include "corelink/pose/pose_demux.h"
+#include "corelink/pose/pose_timeline.h"
+
+#endif
@@ -0,0 +1,21 @@
+/**
+ * @file pose_common.h
+ * @brief Definitions shared by the pose files.
+ */
+#ifndef CORELINK_POSE_POSECOMMON_H
+#define CORELINK_POSE_POSECOMMON_H
+
+#include "corelink/headers/header.h"
+
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CORELINK_POSE_SSE2 1
+#endif
+
+// MSVC only targets little endian hosts.
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define CORELINK_POSE_BIG_ENDIAN 1
+#endif
+
+#endif
@@ -0,0 +1,134 @@
+/**
+ * @file pose_demux.h
+ * @brief Splits the poses arriving on one receiver by sender into dense slots.
+ * Like stream_map, each sender gets the lowest free index, so the consumer walks a small array instead of looking senders up.
+ */
+#ifndef CORELINK_POSE_POSEDEMUX_H
+#define CORELINK_POSE_POSEDEMUX_H
+
+#include "corelink/pose/pose_exchange.h"
+
+namespace CorelinkDLL {
+    namespace Pose {
+        /**
+         * THREADSAFE for one publishing thread (the listener of the receiver), one consuming thread, and any thread calling release.
+         * Slots own a pose_exchange each, allocated up front.
+         * A released slot is handed to a new sender only after the consumer has seen it go, see collect.
+         */
+        class pose_demux {
+        public:
+            static const int SLOT_FREE = 0;
+            static const int SLOT_ACTIVE = 1;
+            /// Released, waiting for the consumer to collect it.
+            static const int SLOT_RETIRED = 2;
+
+        private:
+            struct slot {
+                std::atomic<int> state;
+                std::atomic<STREAM_ID> source;
+                /// Incremented every time a sender takes the slot.
+                std::atomic<std::uint32_t> generation;
+                pose_exchange exchange;
+
+                slot(int maxJoints, int history);
+            };
+
+            std::vector<std::unique_ptr<slot>> slots;
+            /// Maps senders to slots. Guarded by lock.
+            std::unordered_map<STREAM_ID, int> redirect;
+            /// Free slots, lowest first. Guarded by lock.
+            std::priority_queue<int, std::vector<int>, std::greater<int>> freeSlots;
+            /// Highest slot ever used plus one.
+            std::atomic<int> slotCount;
+            /// Packets from senders that found no free slot or failed to decode.
+            std::atomic<std::uint64_t> rejected;
+            mutable std::mutex lock;
+        public:
+            /**
+             * @param maxSources Senders tracked at the same time.
+             * @param maxJoints Joints kept per pose.
+             * @param history Poses each slot keeps for next(). 0 to only keep the newest.
+             */
+            pose_demux(int maxSources, int maxJoints, int history = 0);
+
+            /**
+             * Publisher only.
+             * Decodes the pose into the slot of the sender, assigning one on the first packet.
+             * @param keepRaw Also copy the payload into the slot.
+             * @return Slot the pose was published to. -1 if there is no free slot or the pose does not decode.
+             */
+            int publish(const STREAM_ID& source, const char* data, int len, bool keepRaw = false);
+
+            /**
+             * Frees the slot of a sender, e.g. from the stale callback. Does nothing for unknown senders.
+             * @return Slot the sender held, -1 if none.
+             */
+            int release(const STREAM_ID& source);
+
+            /**
+             * Consumer only.
+             * Makes retired slots free again. Call once the consumer stopped using them, e.g. at the start of a tick.
+             * @return Number of slots freed.
+             */
+            int collect();
+
+            /**
+             * @return Number of slots to walk. Slots above it were never used.
+             */
+            int getSlotCount() const;
+
+            int getMaxSources() const;
+
+            /**
+             * @return SLOT_FREE, SLOT_ACTIVE or SLOT_RETIRED.
+             */
+            int getState(int index) const;
+
+            /**
+             * @return Sender holding the slot. STREAM_DEF if free.
+             */
+            STREAM_ID getSource(int index) const;
+
+            /**
+             * Changes whenever a new sender takes the slot. Compare to tell the sender apart from the previous one.
+             */
+            std::uint32_t getGeneration(int index) const;
+
+            /**
+             * Consumer only. Takes the newest pose of the slot.
+             * @return Whether latest(index) changed to a pose of the current sender. Poses left over from the previous sender are dropped.
+             */
+            bool acquire(int index);
+
+            /**
+             * Consumer only.
+             * @return Pose taken by the last acquire of the slot. Only belongs to the current sender once acquire returned true after a generation change.
+             */
+            const pose_sample& latest(int index) const;
+
+            /**
+             * Consumer only. The pose stays valid until pop(index).
+             * @return Oldest pose of the current sender in the history of the slot, in publish order. nullptr if there is none.
+             * Poses left over from the previous sender are dropped.
+             */
+            const pose_sample* next(int index);
+
+            /**
+             * Consumer only.
+             * Removes the pose returned by next(index) from the history of the slot.
+             */
+            void pop(int index);
+
+            /**
+             * @return Packets dropped because no slot was free or the pose did not decode.
+             */
+            std::uint64_t getRejected() const;
+
+        private:
+            pose_demux(const pose_demux&) = delete;
+            pose_demux& operator=(const pose_demux&) = delete;
+        };
+    }
+}
+
+#endif
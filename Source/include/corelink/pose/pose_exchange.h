@@ -0,0 +1,137 @@
+/**
+ * @file pose_exchange.h
+ * @brief Hands the newest pose from the network thread to the game thread.
+ * Triple buffer: the writer fills its own slot and swaps it with the shared one, the reader swaps the shared slot for its own when it is newer.
+ * Neither side waits and neither side allocates once the slots have grown to the frame size.
+ * The exchange can also keep every published pose in a bounded history, for readers that need all frames and not only the newest.
+ */
+#ifndef CORELINK_POSE_POSEEXCHANGE_H
+#define CORELINK_POSE_POSEEXCHANGE_H
+
+#include "corelink/pose/pose_common.h"
+
+namespace CorelinkDLL {
+    namespace Pose {
+        /**
+         * Pose held by a slot of the exchange.
+         */
+        struct pose_sample {
+            /// Interleaved x,y,z of each joint. Sized for the maximum joint count of the exchange.
+            std::vector<float> positions;
+            int joints;
+            /// Frame number and timestamp of binary frames. 0 for text frames.
+            std::uint32_t frame;
+            std::uint64_t timestamp;
+            /// Steady clock time in microseconds when the pose was published.
+            std::uint64_t received;
+            /// Number of poses published up to and including this one. Gaps mean the reader skipped poses.
+            std::uint64_t sequence;
+            /// Left to the writer, e.g. pose_demux tags samples with the generation of the slot.
+            std::uint32_t generation;
+            /// Payload the pose was decoded from.
+            std::string raw;
+
+            pose_sample();
+        };
+
+        /**
+         * THREADSAFE for one writer and one reader.
+         */
+        class pose_exchange {
+        private:
+            static const unsigned int INDEX_MASK = 3;
+            /// Set on the shared slot index when the writer published into it since the last acquire.
+            static const unsigned int NEW_BIT = 4;
+
+            pose_sample slots[3];
+            int maxJoints;
+            /// Index of the shared slot and NEW_BIT.
+            std::atomic<unsigned int> shared;
+            /// Slot owned by the writer.
+            unsigned int writeIndex;
+            /// Slot owned by the reader.
+            unsigned int readIndex;
+            /// Poses published so far. Writer only.
+            std::uint64_t published;
+            /// Payloads that failed to decode. Writer only.
+            std::uint64_t rejected;
+            /// Copies of the published poses without the raw payload, written at head and read at tail.
+            std::vector<pose_sample> history;
+            std::atomic<std::uint32_t> historyHead;
+            std::atomic<std::uint32_t> historyTail;
+            /// Poses left out of the full history. Writer only.
+            std::uint64_t historyDropped;
+        public:
+            /**
+             * @param maxJoints Joints kept per pose. Frames with more joints are rejected.
+             * @param history Poses kept for next(). 0 to only keep the newest.
+             */
+            explicit pose_exchange(int maxJoints, int history = 0);
+
+            int getMaxJoints() const;
+
+            /**
+             * Writer only.
+             * @return Slot to fill before calling publish(). Only valid until publish().
+             */
+            pose_sample& beginWrite();
+
+            /**
+             * Writer only.
+             * Makes the slot returned by beginWrite() the newest pose.
+             */
+            void publish();
+
+            /**
+             * Writer only.
+             * Decodes a binary pose frame or a text frame and publishes it.
+             * @param keepRaw Also copy the payload into the slot.
+             * @return False if the payload is not a pose of at most maxJoints joints. Nothing is published in that case.
+             */
+            bool publish(const char* data, int len, bool keepRaw = false);
+
+            /**
+             * Writer only.
+             * @return Payloads publish() failed to decode.
+             */
+            std::uint64_t getRejected() const;
+
+            /**
+             * Writer only.
+             * @return Poses left out of the history because the reader did not keep up.
+             */
+            std::uint64_t getHistoryDropped() const;
+
+            /**
+             * Reader only.
+             * Takes the newest published pose if there is one since the last acquire.
+             * @return Whether latest() changed.
+             */
+            bool acquire();
+
+            /**
+             * Reader only.
+             * @return Pose taken by the last acquire(). Empty before the first pose arrives.
+             */
+            const pose_sample& latest() const;
+
+            /**
+             * Reader only. The pose stays valid until pop().
+             * @return Oldest published pose in the history, in publish order. nullptr if the history is empty. raw is always empty.
+             */
+            const pose_sample* next() const;
+
+            /**
+             * Reader only.
+             * Removes the pose returned by next() from the history.
+             */
+            void pop();
+
+        private:
+            pose_exchange(const pose_exchange&) = delete;
+            pose_exchange& operator=(const pose_exchange&) = delete;
+        };
+    }
+}
+
+#endif
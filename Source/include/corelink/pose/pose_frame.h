@@ -0,0 +1,142 @@
+/**
+ * @file pose_frame.h
+ * @brief Binary pose frame "pose.bin/1" and its encoder and decoder.
+ * Senders advertise the format by adding META_TAG to the stream meta. Receivers still accept text frames,
+ * a payload is treated as binary only when it starts with MAGIC.
+ *
+ * Frame format, every value little endian (big endian hosts swap on encode and decode):
+ * -(uint32) MAGIC.
+ * -(uint8) VERSION.
+ * -(uint8) Flags, FLAG_ROTATIONS and FLAG_QUANTIZED.
+ * -(uint16) Number of joints n.
+ * -(uint32) Frame number.
+ * -(uint64) Timestamp in microseconds.
+ * -Quantized frames only: (float[3]) origin and (float[3]) step of each position axis.
+ * -Positions as structure of arrays: x[n], y[n], z[n].
+ *  float32, or uint16 where position = origin + q * step.
+ * -Rotations (FLAG_ROTATIONS) as unit quaternions: x[n], y[n], z[n], w[n].
+ *  float32, or int16 where component = q / 32767.
+ *
+ * For 52 joints in pose_bench, a text frame is 1172 B, a float32 frame 644 B and a quantized frame 356 B, 3.3x smaller than text.
+ * This is short of 4x because quantized positions keep 16 bit steps, about 0.06 mm over a 4 m range, so they are never coarser than
+ * the 4 decimals of text frames. 12 bit steps would reach 4.2x but round to about 1 mm.
+ */
+#ifndef CORELINK_POSE_POSEFRAME_H
+#define CORELINK_POSE_POSEFRAME_H
+
+#include "corelink/pose/pose_common.h"
+
+namespace CorelinkDLL {
+    namespace Pose {
+        class pose_frame {
+        public:
+            /// "CLPS" in memory.
+            static const std::uint32_t MAGIC = 0x53504C43;
+            static const int VERSION = 1;
+            static const int FLAG_ROTATIONS = 1;
+            static const int FLAG_QUANTIZED = 2;
+            static const int HEADER_SIZE = 20;
+            static const int QUANTIZE_SIZE = 24;
+            static const int MAX_JOINTS = 65535;
+            /// Added to the stream meta by senders of binary frames.
+            static const char META_TAG[];
+
+            /**
+             * @return Size of a frame with the given layout.
+             */
+            static int frameSize(int joints, int flags);
+
+            /**
+             * Encodes a frame.
+             * @param frame Frame number.
+             * @param timestamp Capture time in microseconds.
+             * @param joints Number of joints.
+             * @param positions Interleaved x,y,z of each joint.
+             * @param rotations Interleaved x,y,z,w of each joint. nullptr to send positions only.
+             * @param quantize Store positions as 16 bit steps between the per axis minimum and maximum, rotations as 16 bit components.
+             * @param out Stores the frame.
+             * @return False if joints is out of range.
+             */
+            static bool encode(std::uint32_t frame, std::uint64_t timestamp, int joints, const float* positions, const float* rotations, bool quantize, std::string& out);
+
+            /**
+             * @return Whether data starts like a binary frame.
+             */
+            static bool isFrame(const char* data, int len);
+
+            /**
+             * Reads joint positions from a binary frame, or from a text frame through pose_text.
+             * @param positions Stores interleaved x,y,z of up to maxJoints joints.
+             * @return Number of joints read. -1 if the frame is malformed or has more than maxJoints joints.
+             */
+            static int readPositions(const char* data, int len, float* positions, int maxJoints);
+
+            /**
+             * @return Whether the stream meta advertises binary frames.
+             */
+            static bool isAdvertised(const std::string& meta);
+
+            /**
+             * @return meta with META_TAG added.
+             */
+            static std::string advertise(const std::string& meta);
+        };
+
+        /**
+         * Read only view of a binary frame. Does not copy the payload, which must outlive the view.
+         * The payload does not need to be aligned.
+         */
+        class pose_frame_view {
+        private:
+            const char* data;
+            int flags;
+            int joints;
+            std::uint32_t frame;
+            std::uint64_t timestamp;
+            float origin[3];
+            float step[3];
+            const char* positionData;
+            const char* rotationData;
+        public:
+            pose_frame_view();
+
+            /**
+             * Points the view at a frame and checks its layout.
+             * @return False if data is not a complete binary frame or has flags other than FLAG_ROTATIONS and FLAG_QUANTIZED.
+             * The view is empty in that case.
+             */
+            bool reset(const char* data, int len);
+
+            bool valid() const;
+            std::uint32_t getFrame() const;
+            std::uint64_t getTimestamp() const;
+            int getJointCount() const;
+            bool hasRotations() const;
+            bool isQuantized() const;
+
+            /**
+             * @param xyz Stores the position of the joint.
+             */
+            void getPosition(int joint, float* xyz) const;
+
+            /**
+             * Identity if the frame has no rotations.
+             * @param xyzw Stores the rotation of the joint.
+             */
+            void getRotation(int joint, float* xyzw) const;
+
+            /**
+             * @param xyz Stores interleaved x,y,z of every joint.
+             */
+            void copyPositions(float* xyz) const;
+
+            /**
+             * Identity for every joint if the frame has no rotations.
+             * @param xyzw Stores interleaved x,y,z,w of every joint.
+             */
+            void copyRotations(float* xyzw) const;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,57 @@
+/**
+ * @file pose_text.h
+ * @brief Parser for pose frames sent as delimited float text, e.g. "x,y,z,x,y,z".
+ * Values are decoded straight from the received payload into a float array the caller owns.
+ * Independent of the engine and of the client.
+ */
+#ifndef CORELINK_POSE_POSETEXT_H
+#define CORELINK_POSE_POSETEXT_H
+
+#include "corelink/pose/pose_common.h"
+
+namespace CorelinkDLL {
+    namespace Pose {
+        /**
+         * Values are separated by any run of ',', ';', ' ', '\t', '\r' or '\n'.
+         * Each value has the form [+-]digits[.digits][(e|E)[+-]digits].
+         * Values with at most 15 significant digits and a small exponent are converted without strtof.
+         * Other values fall back to strtof.
+         */
+        class pose_text {
+        public:
+            /// Longest value handed to the strtof fallback.
+            static const int MAX_VALUE_LEN = 63;
+
+            /**
+             * Parses every value in the text.
+             * Uses SSE2 to find the end of each value when available.
+             * @param data Text to parse. Does not need to be null terminated.
+             * @param len Length of data.
+             * @param out Stores the values.
+             * @param maxOut Size of out.
+             * @return Number of values parsed. -1 if a value is malformed or there are more than maxOut values.
+             */
+            static int parse(const char* data, int len, float* out, int maxOut);
+
+            /**
+             * Same as parse without any vector instructions.
+             */
+            static int parseScalar(const char* data, int len, float* out, int maxOut);
+
+            /**
+             * Parses positions stored as x,y,z triples.
+             * @param positions Stores 3 * maxJoints floats.
+             * @return Number of joints parsed. -1 if the text is malformed, too long or not made of whole triples.
+             */
+            static int parsePositions(const char* data, int len, float* positions, int maxJoints);
+
+            /**
+             * Parses a single value spanning the whole range.
+             * @return False if the range is not a valid value.
+             */
+            static bool parseValue(const char* begin, const char* end, float& out);
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,93 @@
+/**
+ * @file pose_timeline.h
+ * @brief Keeps the last frames of a single source and samples them at any time.
+ * Lets the render loop read poses on its own clock instead of the rate they arrive at.
+ */
+#ifndef CORELINK_POSE_POSETIMELINE_H
+#define CORELINK_POSE_POSETIMELINE_H
+
+#include "corelink/pose/pose_common.h"
+
+namespace CorelinkDLL {
+    namespace Pose {
+        /**
+         * Frames are stored as structure of arrays, x[joints], y[joints], z[joints], so one kernel call blends a whole frame.
+         * Not threadsafe, fill and sample it from the same thread.
+         */
+        class pose_timeline {
+        public:
+            /// Results of sample.
+            static const int SAMPLE_EMPTY = -1;
+            static const int SAMPLE_INTERPOLATED = 0;
+            /// Query past the newest frame, moved along the last two frames for at most maxExtrapolation.
+            static const int SAMPLE_EXTRAPOLATED = 1;
+            /// Query before the oldest frame or with a single frame, the nearest frame is returned.
+            static const int SAMPLE_HELD = 2;
+
+        private:
+            int joints;
+            int capacity;
+            double maxExtrapolation;
+            /// capacity frames of 3 * joints floats.
+            std::vector<float> frames;
+            std::vector<double> times;
+            /// Slot of the oldest frame.
+            int first;
+            int count;
+
+            const float* frameAt(int index) const;
+            double timeAt(int index) const;
+        public:
+            /**
+             * @param joints Joints per frame.
+             * @param capacity Frames kept. The oldest frame is dropped when full.
+             * @param maxExtrapolation Longest time in seconds a pose is moved past the newest frame.
+             */
+            pose_timeline(int joints, int capacity, double maxExtrapolation);
+
+            /**
+             * Empties the timeline and changes the joint count.
+             */
+            void reset(int joints);
+
+            /**
+             * Adds a frame.
+             * @param time Time of the frame in seconds. Frames not newer than the newest frame are dropped.
+             * @param xyz Interleaved x,y,z of every joint.
+             * @return False if the frame was dropped.
+             */
+            bool push(double time, const float* xyz);
+
+            /**
+             * Samples the joint positions at a time.
+             * @param time Time to sample in seconds, on the same clock as push.
+             * @param xyz Stores interleaved x,y,z of every joint.
+             * @return One of the SAMPLE_ results. xyz is untouched for SAMPLE_EMPTY.
+             */
+            int sample(double time, float* xyz) const;
+
+            /**
+             * Same as sample, stores x[joints], y[joints], z[joints].
+             */
+            int sampleSoA(double time, float* soa) const;
+
+            int getJoints() const;
+            int size() const;
+            double oldestTime() const;
+            double newestTime() const;
+
+            /**
+             * out[i] = a[i] + (b[i] - a[i]) * t. t past 1 extrapolates.
+             * Uses SSE2 when available.
+             */
+            static void lerp(const float* a, const float* b, float t, float* out, int len);
+
+            /**
+             * Converts x[joints], y[joints], z[joints] to interleaved x,y,z.
+             */
+            static void soaToInterleaved(const float* soa, int joints, float* xyz);
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,427 @@
+/**
+ * @file corelink_bench.cpp
+ * @brief End to end benchmark of the client against a loopback server. Writes the results as json.
+ *
+ * -data: UDP and TCP messages per second and send to callback latency percentiles for each payload size.
+ * -control: subscribe and listStreams round trips per second.
+ * -scaling: stream creation and messages per second from 1 to 256 sender streams feeding one receiver.
+ *
+ * Throughput runs keep at most --window messages in flight so the client queues stay bounded.
+ * Messages missing when the window stalls are counted as lost.
+ * Latency runs send at --rate messages per second so queueing does not hide the per message cost.
+ *
+ * Usage: corelink_bench [options]
+ *   --server ip:port  Use a running server instead of starting loopback_server in process.
+ *   --duration s      Seconds per throughput run. Default 2.
+ *   --sizes list      Payload sizes in bytes. Default 16,256,1024,8192.
+ *   --streams list    Sender counts for the scaling runs. Default 1,4,16,64,256.
+ *   --samples n       Latency samples per run. Default 2000.
+ *   --rate n          Messages per second of the latency runs. Default 2000.
+ *   --window n        Messages in flight during throughput runs. Default 1024.
+ *   --ops n           Round trips per control run. Default 1000.
+ *   --out file        Write the json there instead of stdout.
+ */
+#include "Corelink.h"
+#include "loopback_server.h"
+#include "rapidjson/prettywriter.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using CorelinkDLL::Tools::loopback_server;
+
+typedef rapidjson::PrettyWriter<rapidjson::StringBuffer> JsonWriter;
+
+static const char* BENCH_WORKSPACE = "Bench";
+static const int TIMESTAMP_SIZE = sizeof(long long);
+/// A throughput window that does not move for this long has lost its messages.
+static const std::chrono::milliseconds WINDOW_STALL(20);
+/// Received count must stay still this long before a run is over.
+static const std::chrono::milliseconds DRAIN_QUIET(200);
+
+struct bench_options {
+    std::string serverIP;
+    int serverPort;
+    double duration;
+    std::vector<int> sizes;
+    std::vector<int> streams;
+    int samples;
+    int rate;
+    int window;
+    int ops;
+    std::string out;
+
+    bench_options() : serverIP(), serverPort(0), duration(2), sizes({ 16, 256, 1024, 8192 }),
+        streams({ 1, 4, 16, 64, 256 }), samples(2000), rate(2000), window(1024), ops(1000), out() {}
+};
+
+/**
+ * Filled by the receive callback, which runs on the listener thread of every receiver.
+ */
+struct recv_state {
+    std::atomic<unsigned long long> received;
+    std::atomic<long long> lastRecv;
+    std::atomic<bool> recording;
+    std::atomic<std::size_t> sampleCount;
+    std::vector<long long> samples;
+};
+
+static recv_state state;
+
+static long long nowNs() {
+    return (long long) std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void onReceive(const STREAM_ID&, const STREAM_ID&, const char* msg, const int& msgLen) {
+    long long now = nowNs();
+    long long sent;
+    std::size_t index;
+    state.received.fetch_add(1, std::memory_order_relaxed);
+    state.lastRecv.store(now, std::memory_order_relaxed);
+    if (!state.recording.load(std::memory_order_relaxed) || msgLen < TIMESTAMP_SIZE) { return; }
+    memcpy(&sent, msg, TIMESTAMP_SIZE);
+    index = state.sampleCount.fetch_add(1, std::memory_order_relaxed);
+    if (index < state.samples.size()) {
+        state.samples[index] = now - sent;
+    }
+}
+
+static void resetState() {
+    state.recording.store(false);
+    state.received.store(0);
+    state.lastRecv.store(0);
+    state.sampleCount.store(0);
+}
+
+static std::string makePayload(int size) {
+    std::string payload(std::max(size, TIMESTAMP_SIZE), 'x');
+    for (std::size_t i = TIMESTAMP_SIZE; i < payload.size(); ++i) {
+        payload[i] = (char) ('a' + i % 26);
+    }
+    return payload;
+}
+
+static void stamp(std::string& payload) {
+    long long now = nowNs();
+    memcpy(&payload[0], &now, TIMESTAMP_SIZE);
+}
+
+/**
+ * Waits until no message arrived for DRAIN_QUIET or everything sent arrived.
+ */
+static void drain(unsigned long long sent) {
+    unsigned long long seen = state.received.load();
+    std::chrono::steady_clock::time_point quiet = std::chrono::steady_clock::now();
+    while (state.received.load() < sent && std::chrono::steady_clock::now() - quiet < DRAIN_QUIET) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        if (state.received.load() != seen) {
+            seen = state.received.load();
+            quiet = std::chrono::steady_clock::now();
+        }
+    }
+}
+
+/**
+ * Sends round robin over the senders as fast as the window allows and writes the throughput object.
+ */
+static void runThroughput(std::vector<Corelink::SendStream>& senders, int size, const bench_options& options, JsonWriter& writer) {
+    std::string payload = makePayload(size);
+    unsigned long long sent = 0, presumedLost = 0, received;
+    unsigned long long progress;
+    std::chrono::steady_clock::time_point stall;
+    long long start, end;
+    double seconds;
+
+    resetState();
+    start = nowNs();
+    end = start + (long long) (options.duration * 1e9);
+    while (nowNs() < end) {
+        for (int i = 0; i < 64; ++i) {
+            stamp(payload);
+            senders[sent % senders.size()].send(payload);
+            ++sent;
+        }
+        progress = state.received.load(std::memory_order_relaxed);
+        stall = std::chrono::steady_clock::now();
+        while (sent - presumedLost - state.received.load(std::memory_order_relaxed) >= (unsigned long long) options.window) {
+            if (state.received.load(std::memory_order_relaxed) != progress) {
+                progress = state.received.load(std::memory_order_relaxed);
+                stall = std::chrono::steady_clock::now();
+            }
+            else if (std::chrono::steady_clock::now() - stall > WINDOW_STALL) {
+                presumedLost = sent - progress;
+                break;
+            }
+            std::this_thread::yield();
+        }
+    }
+    drain(sent);
+    received = state.received.load();
+    seconds = ((state.lastRecv.load() > start ? state.lastRecv.load() : nowNs()) - start) / 1e9;
+
+    writer.Key("throughput");
+    writer.StartObject();
+    writer.Key("sent");
+    writer.Uint64(sent);
+    writer.Key("received");
+    writer.Uint64(received);
+    writer.Key("seconds");
+    writer.Double(seconds);
+    writer.Key("msgsPerSec");
+    writer.Double(received / seconds);
+    writer.Key("mbytesPerSec");
+    writer.Double(received * (double) payload.size() / seconds / 1e6);
+    writer.Key("lossRate");
+    writer.Double(sent == 0 ? 0 : (double) (sent - std::min(sent, received)) / sent);
+    writer.EndObject();
+}
+
+/**
+ * Sends paced messages and writes the latency percentiles in microseconds.
+ */
+static void runLatency(Corelink::SendStream& sender, int size, const bench_options& options, JsonWriter& writer) {
+    const double percentiles[] = { 0.5, 0.9, 0.99, 0.999 };
+    const char* names[] = { "p50", "p90", "p99", "p999" };
+    std::string payload = makePayload(size);
+    std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+    std::chrono::nanoseconds interval((long long) (1e9 / std::max(options.rate, 1)));
+    std::vector<long long> samples;
+    std::size_t count;
+
+    resetState();
+    state.samples.assign(options.samples, 0);
+    state.recording.store(true);
+    for (int i = 0; i < options.samples; ++i) {
+        while (std::chrono::steady_clock::now() < next) {
+            if (next - std::chrono::steady_clock::now() > std::chrono::milliseconds(1)) {
+                std::this_thread::sleep_for(std::chrono::microseconds(500));
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+        next += interval;
+        stamp(payload);
+        sender.send(payload);
+    }
+    drain(options.samples);
+    state.recording.store(false);
+    count = std::min(state.sampleCount.load(), state.samples.size());
+    samples.assign(state.samples.begin(), state.samples.begin() + count);
+    std::sort(samples.begin(), samples.end());
+
+    writer.Key("latencyUs");
+    writer.StartObject();
+    writer.Key("count");
+    writer.Uint64(count);
+    for (int i = 0; i < 4; ++i) {
+        writer.Key(names[i]);
+        writer.Double(samples.empty() ? 0 : samples[(std::size_t) (percentiles[i] * (samples.size() - 1))] / 1e3);
+    }
+    writer.Key("max");
+    writer.Double(samples.empty() ? 0 : samples.back() / 1e3);
+    writer.EndObject();
+}
+
+static void runData(int protocol, const char* name, const bench_options& options, JsonWriter& writer) {
+    Corelink::RecvStream receiver = Corelink::Client::createReceiver(BENCH_WORKSPACE, { name }, "corelink_bench", true, false,
+        protocol & Corelink::Const::STREAM_STATE_RECV);
+    std::vector<Corelink::SendStream> senders;
+    receiver.setOnReceive(&onReceive);
+    senders.push_back(Corelink::Client::createSender(BENCH_WORKSPACE, name, "corelink_bench", true, false,
+        protocol & Corelink::Const::STREAM_STATE_SEND));
+    Corelink::Client::subscribe(receiver, senders[0]);
+    // the receiver registers its address with its first packet.
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    for (int size : options.sizes) {
+        fprintf(stderr, "data %s %d bytes\n", name, size);
+        writer.StartObject();
+        writer.Key("proto");
+        writer.String(name);
+        writer.Key("payload");
+        writer.Int(std::max(size, TIMESTAMP_SIZE));
+        runThroughput(senders, size, options, writer);
+        runLatency(senders[0], size, options, writer);
+        writer.EndObject();
+    }
+    Corelink::Client::rmStream(senders[0]);
+    Corelink::Client::rmStream(receiver);
+}
+
+/**
+ * Times ops calls of func and writes them as an object named key.
+ */
+static void runOps(const char* key, int ops, const std::function<void()>& func, JsonWriter& writer) {
+    long long start = nowNs();
+    double seconds;
+    for (int i = 0; i < ops; ++i) {
+        func();
+    }
+    seconds = (nowNs() - start) / 1e9;
+    writer.Key(key);
+    writer.StartObject();
+    writer.Key("ops");
+    writer.Int(ops);
+    writer.Key("opsPerSec");
+    writer.Double(ops / seconds);
+    writer.Key("usPerOp");
+    writer.Double(seconds * 1e6 / ops);
+    writer.EndObject();
+}
+
+static void runControl(const bench_options& options, JsonWriter& writer) {
+    Corelink::SendStream sender = Corelink::Client::createSender(BENCH_WORKSPACE, "control", "corelink_bench", true, false, Corelink::Const::STREAM_STATE_SEND_UDP);
+    Corelink::RecvStream receiver = Corelink::Client::createReceiver(BENCH_WORKSPACE, { "control" }, "corelink_bench", true, false, Corelink::Const::STREAM_STATE_RECV_UDP);
+    fprintf(stderr, "control\n");
+    writer.StartObject();
+    runOps("subscribe", options.ops, [&]() { Corelink::Client::subscribe(receiver, sender); }, writer);
+    runOps("listStreams", options.ops, [&]() { Corelink::Client::listStreams({ BENCH_WORKSPACE }); }, writer);
+    writer.EndObject();
+    Corelink::Client::rmStream(sender);
+    Corelink::Client::rmStream(receiver);
+}
+
+static void runScaling(const bench_options& options, JsonWriter& writer) {
+    for (int count : options.streams) {
+        std::vector<Corelink::SendStream> senders;
+        long long start;
+        double createSeconds;
+        fprintf(stderr, "scaling %d streams\n", count);
+
+        start = nowNs();
+        for (int i = 0; i < count; ++i) {
+            senders.push_back(Corelink::Client::createSender(BENCH_WORKSPACE, "scale", "corelink_bench", true, false, Corelink::Const::STREAM_STATE_SEND_UDP));
+        }
+        createSeconds = (nowNs() - start) / 1e9;
+        // created last so the server subscribes it to every sender.
+        Corelink::RecvStream receiver = Corelink::Client::createReceiver(BENCH_WORKSPACE, { "scale" }, "corelink_bench", true, false, Corelink::Const::STREAM_STATE_RECV_UDP);
+        receiver.setOnReceive(&onReceive);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        writer.StartObject();
+        writer.Key("streams");
+        writer.Int(count);
+        writer.Key("createPerSec");
+        writer.Double(count / createSeconds);
+        runThroughput(senders, 64, options, writer);
+        runOps("listStreams", std::max(options.ops / 10, 1), [&]() { Corelink::Client::listStreams({ BENCH_WORKSPACE }); }, writer);
+        writer.EndObject();
+
+        Corelink::Client::rmStream(receiver);
+        for (Corelink::SendStream& sender : senders) {
+            Corelink::Client::rmStream(sender);
+        }
+    }
+}
+
+static std::vector<int> parseList(const char* arg) {
+    std::vector<int> values;
+    std::stringstream ss(arg);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (atoi(item.c_str()) > 0) {
+            values.push_back(atoi(item.c_str()));
+        }
+    }
+    return values;
+}
+
+static bool parseOptions(int argc, char** argv, bench_options& options) {
+    std::string arg;
+    std::size_t colon;
+    for (int i = 1; i < argc; ++i) {
+        arg = argv[i];
+        if (i + 1 >= argc) { return false; }
+        if (arg == "--server") {
+            arg = argv[++i];
+            if ((colon = arg.rfind(':')) == std::string::npos) { return false; }
+            options.serverIP = arg.substr(0, colon);
+            options.serverPort = atoi(arg.c_str() + colon + 1);
+        }
+        else if (arg == "--duration") { options.duration = atof(argv[++i]); }
+        else if (arg == "--sizes") { options.sizes = parseList(argv[++i]); }
+        else if (arg == "--streams") { options.streams = parseList(argv[++i]); }
+        else if (arg == "--samples") { options.samples = atoi(argv[++i]); }
+        else if (arg == "--rate") { options.rate = atoi(argv[++i]); }
+        else if (arg == "--window") { options.window = atoi(argv[++i]); }
+        else if (arg == "--ops") { options.ops = atoi(argv[++i]); }
+        else if (arg == "--out") { options.out = argv[++i]; }
+        else { return false; }
+    }
+    return options.duration > 0 && options.samples > 0 && options.window > 0 && options.ops > 0;
+}
+
+int main(int argc, char** argv) {
+    bench_options options;
+    loopback_server server;
+    rapidjson::StringBuffer buffer;
+    JsonWriter writer(buffer);
+    std::string error;
+    FILE* out;
+
+    if (!parseOptions(argc, argv, options)) {
+        fprintf(stderr, "usage: corelink_bench [--server ip:port] [--duration s] [--sizes list] [--streams list]\n"
+            "                      [--samples n] [--rate n] [--window n] [--ops n] [--out file]\n");
+        return 1;
+    }
+    if (options.serverIP.empty()) {
+        if (!server.start("127.0.0.1", 0, 0, error)) {
+            fprintf(stderr, "corelink_bench: %s\n", error.c_str());
+            return 1;
+        }
+        options.serverIP = "127.0.0.1";
+        options.serverPort = server.getControlPort();
+    }
+
+    writer.StartObject();
+    writer.Key("benchmark");
+    writer.String("corelink_bench");
+    writer.Key("server");
+    writer.String(server.getControlPort() != 0 ? "loopback" : (options.serverIP + ":" + std::to_string(options.serverPort)).c_str());
+    writer.Key("durationSec");
+    writer.Double(options.duration);
+    writer.Key("window");
+    writer.Int(options.window);
+    writer.Key("latencyRate");
+    writer.Int(options.rate);
+    try {
+        Corelink::DLLInit::Init();
+        Corelink::DLLInit::setServerCredentials("Testuser", "Testpassword");
+        Corelink::Client::connect(options.serverIP, options.serverPort);
+
+        writer.Key("data");
+        writer.StartArray();
+        runData(Corelink::Const::STREAM_STATE_UDP, "udp", options, writer);
+        runData(Corelink::Const::STREAM_STATE_TCP, "tcp", options, writer);
+        writer.EndArray();
+
+        writer.Key("control");
+        runControl(options, writer);
+
+        writer.Key("scaling");
+        writer.StartArray();
+        runScaling(options, writer);
+        writer.EndArray();
+
+        Corelink::Client::cleanup();
+    }
+    catch (const Corelink::CorelinkException& e) {
+        fprintf(stderr, "corelink_bench: %s\n", e.msg.c_str());
+        return 1;
+    }
+    writer.EndObject();
+    server.stop();
+
+    out = options.out.empty() ? stdout : fopen(options.out.c_str(), "w");
+    if (out == nullptr) {
+        fprintf(stderr, "corelink_bench: could not open %s\n", options.out.c_str());
+        return 1;
+    }
+    fprintf(out, "%s\n", buffer.GetString());
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
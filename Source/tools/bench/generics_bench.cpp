@@ -0,0 +1,558 @@
+/**
+ * @file generics_bench.cpp
+ * @brief Microbenchmarks of the containers on the data path, reporting ns and heap allocations per operation.
+ * -safe_queue: enqueue and dequeue with 1 to 8 producers and one consumer.
+ * -stream_map and concurrent_stream_map: redirect lookups at several map sizes and add/remove churn.
+ * -message_handler: response correlation with many threads waiting on their own request.
+ * -tcp_recv_handler: framing relayed messages out of a loopback TCP connection like comm_data_recv_tcp.
+ * -recv_ring: push and poll between the listener and the polling thread.
+ * -packet_pool: buffers acquired on one thread and dropped on the same or another thread, like the send queues.
+ * -latency_histogram: recording from 1 to 4 threads.
+ * Allocations are counted by replacing the global operator new, so they include everything the operation touches.
+ * A replacement container should be compared against the numbers of the one it replaces.
+ *
+ * Usage: generics_bench [ops]
+ */
+#include "corelink/objects/generics/concurrent_stream_map.h"
+#include "corelink/objects/generics/latency_histogram.h"
+#include "corelink/objects/generics/message_handler.h"
+#include "corelink/objects/generics/safe_queue.h"
+#include "corelink/objects/generics/stream_map.h"
+#include "corelink/objects/packet_pool.h"
+#include "corelink/objects/streams/recv_ring.h"
+#include "corelink/objects/streams/tcp_recv_handler.h"
+
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <new>
+#include <random>
+
+using CorelinkDLL::Object::Generic::concurrent_stream_map;
+using CorelinkDLL::Object::Generic::epoch_manager;
+using CorelinkDLL::Object::Generic::latency_histogram;
+using CorelinkDLL::Object::Generic::message_handler;
+using CorelinkDLL::Object::Generic::safe_queue;
+using CorelinkDLL::Object::Generic::stream_map;
+using CorelinkDLL::Object::packet_buffer;
+using CorelinkDLL::Object::packet_pool;
+using CorelinkDLL::Object::Stream::recv_message;
+using CorelinkDLL::Object::Stream::recv_ring;
+using CorelinkDLL::Object::Stream::tcp_recv_handler;
+
+static std::atomic<unsigned long long> allocations(0);
+
+// every replacement below goes through these two, so the compiler pairs each free with a malloc.
+static void* countedAlloc(std::size_t size) {
+    void* ptr;
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) { throw std::bad_alloc(); }
+    return ptr;
+}
+
+static void countedFree(void* ptr) noexcept {
+    free(ptr);
+}
+
+void* operator new(std::size_t size) {
+    return countedAlloc(size);
+}
+
+void* operator new[](std::size_t size) {
+    return countedAlloc(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    countedFree(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    countedFree(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    countedFree(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    countedFree(ptr);
+}
+
+/**
+ * Time and allocations between start() and stop(), divided by the operations done.
+ */
+class probe {
+private:
+    std::chrono::steady_clock::time_point begin;
+    unsigned long long allocBegin;
+public:
+    double ns;
+    double allocs;
+
+    probe() : allocBegin(0), ns(0), allocs(0) {}
+
+    void start() {
+        this->allocBegin = allocations.load(std::memory_order_relaxed);
+        this->begin = std::chrono::steady_clock::now();
+    }
+
+    void stop(unsigned long long ops) {
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        this->allocs = (double) (allocations.load(std::memory_order_relaxed) - this->allocBegin) / ops;
+        this->ns = std::chrono::duration<double, std::nano>(end - this->begin).count() / ops;
+    }
+};
+
+/**
+ * Holds started threads until every one of them is ready, so thread creation is not measured.
+ */
+class start_gate {
+private:
+    std::atomic<int> ready;
+    std::atomic<bool> open;
+public:
+    start_gate() : ready(0), open(false) {}
+
+    void arrive() {
+        this->ready.fetch_add(1);
+        while (!this->open.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+
+    void release(int threads) {
+        while (this->ready.load() < threads) {
+            std::this_thread::yield();
+        }
+        this->open.store(true, std::memory_order_release);
+    }
+};
+
+/**
+ * Enqueues ops elements over producers threads and dequeues them on the calling thread.
+ */
+template <class T>
+static probe queueRun(int producers, unsigned long long ops, const T& value) {
+    safe_queue<T> queue;
+    start_gate gate;
+    std::vector<std::thread> threads;
+    unsigned long long perProducer = ops / producers;
+    probe result;
+    for (int i = 0; i < producers; ++i) {
+        threads.emplace_back([&queue, &gate, &value, perProducer]() {
+            gate.arrive();
+            for (unsigned long long j = 0; j < perProducer; ++j) {
+                queue.enqueue(value);
+            }
+        });
+    }
+    gate.release(producers);
+    result.start();
+    for (unsigned long long i = 0; i < perProducer * producers; ++i) {
+        queue.dequeue();
+    }
+    result.stop(perProducer * producers);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    return result;
+}
+
+static void benchQueue(unsigned long long ops) {
+    const int producerCounts[] = { 1, 2, 4, 8 };
+    // element of the TCP send queue: socket and a pooled frame.
+    std::pair<SOCKET, packet_buffer> frame(0, packet_pool::instance().acquire(64));
+    printf("safe_queue: enqueue + dequeue, one consumer\n");
+    printf("%10s %12s %12s %12s %12s\n", "producers", "int ns", "int alloc", "frame ns", "frame alloc");
+    for (int producers : producerCounts) {
+        probe small = queueRun<int>(producers, ops, 1);
+        probe large = queueRun<std::pair<SOCKET, packet_buffer>>(producers, ops / 4, frame);
+        printf("%10d %12.1f %12.2f %12.1f %12.2f\n", producers, small.ns, small.allocs, large.ns, large.allocs);
+    }
+}
+
+static std::vector<STREAM_ID> makeIDs(int count, std::mt19937& rng) {
+    std::vector<STREAM_ID> ids;
+    for (int i = 0; i < count; ++i) {
+        // sparse like server assigned ids.
+        ids.push_back(1000 + i * 37);
+    }
+    std::shuffle(ids.begin(), ids.end(), rng);
+    return ids;
+}
+
+static void benchMapLookup(unsigned long long ops, std::mt19937& rng) {
+    const int sizes[] = { 4, 64, 1024, 16384 };
+    printf("\nredirect lookup of a present stream\n");
+    printf("%8s %14s %14s %14s %12s\n", "streams", "stream_map ns", "concurrent ns", "+ get ns", "get alloc");
+    for (int size : sizes) {
+        stream_map<int> locked(-1, 2);
+        concurrent_stream_map<int> concurrent;
+        std::vector<STREAM_ID> ids = makeIDs(size, rng);
+        std::vector<STREAM_ID> order = ids;
+        probe lockedTime, concurrentTime, getTime;
+        long long checksum = 0;
+        int index;
+        for (STREAM_ID id : ids) {
+            locked.addObject(id, id);
+            concurrent.addObject(id, id);
+        }
+        std::shuffle(order.begin(), order.end(), rng);
+        unsigned long long rounds = ops / size + 1;
+
+        lockedTime.start();
+        for (unsigned long long r = 0; r < rounds; ++r) {
+            for (STREAM_ID id : order) {
+                checksum += locked.getStreamRedirect(id);
+            }
+        }
+        lockedTime.stop(rounds * size);
+
+        concurrentTime.start();
+        for (unsigned long long r = 0; r < rounds; ++r) {
+            for (STREAM_ID id : order) {
+                checksum += concurrent.getStreamRedirect(id);
+            }
+        }
+        concurrentTime.stop(rounds * size);
+
+        // receiver path: redirect, then read the element under a guard.
+        getTime.start();
+        for (unsigned long long r = 0; r < rounds; ++r) {
+            for (STREAM_ID id : order) {
+                epoch_manager::read_guard guard;
+                index = concurrent.getStreamRedirect(id);
+                int* value = concurrent.get(index, id);
+                checksum += value == nullptr ? -1 : *value;
+            }
+        }
+        getTime.stop(rounds * size);
+        printf("%8d %14.1f %14.1f %14.1f %12.2f%s\n", size, lockedTime.ns, concurrentTime.ns, getTime.ns, getTime.allocs,
+            checksum == 0 ? " !" : "");
+    }
+}
+
+template <class Map>
+static probe churnRun(Map& map, const std::vector<STREAM_ID>& ids, unsigned long long ops) {
+    std::size_t live = ids.size() / 2;
+    probe result;
+    for (std::size_t i = 0; i < live; ++i) {
+        map.addObject(ids[i], (int) i);
+    }
+    result.start();
+    // add the next id and remove the oldest, so the map keeps its size and reuses slots.
+    for (unsigned long long i = 0; i < ops; ++i) {
+        map.addObject(ids[(i + live) % ids.size()], (int) i);
+        map.rmObjectID(ids[i % ids.size()]);
+    }
+    result.stop(ops);
+    return result;
+}
+
+static void benchMapChurn(unsigned long long ops, std::mt19937& rng) {
+    const int sizes[] = { 4, 64, 1024 };
+    printf("\nadd + remove at constant size\n");
+    printf("%8s %14s %14s %14s %14s\n", "streams", "stream_map ns", "alloc", "concurrent ns", "alloc");
+    for (int size : sizes) {
+        stream_map<int> locked(-1, 2);
+        concurrent_stream_map<int> concurrent;
+        std::vector<STREAM_ID> ids = makeIDs(size * 2, rng);
+        probe lockedTime = churnRun(locked, ids, ops / 4);
+        probe concurrentTime = churnRun(concurrent, ids, ops / 4);
+        epoch_manager::instance().collect();
+        printf("%8d %14.1f %14.2f %14.1f %14.2f\n", size, lockedTime.ns, lockedTime.allocs, concurrentTime.ns, concurrentTime.allocs);
+    }
+}
+
+/**
+ * Each waiter reserves an id, hands it to the responder thread and blocks on its response,
+ * like a control request sent through the main channel and answered by its listener.
+ */
+static probe correlationRun(int waiters, unsigned long long ops) {
+    message_handler<std::shared_ptr<rapidjson::Document>> handler(std::shared_ptr<rapidjson::Document>(nullptr));
+    safe_queue<unsigned int> requests;
+    std::shared_ptr<rapidjson::Document> response = std::make_shared<rapidjson::Document>();
+    std::atomic<unsigned long long> missing(0);
+    std::vector<std::thread> threads;
+    start_gate gate;
+    unsigned long long perWaiter = ops / waiters;
+    probe result;
+    if (perWaiter == 0) { perWaiter = 1; }
+    std::thread responder([&]() {
+        gate.arrive();
+        for (unsigned long long i = 0; i < perWaiter * waiters; ++i) {
+            handler.add(response, requests.dequeue());
+        }
+    });
+    for (int i = 0; i < waiters; ++i) {
+        threads.emplace_back([&]() {
+            unsigned int id;
+            gate.arrive();
+            for (unsigned long long j = 0; j < perWaiter; ++j) {
+                id = handler.reserve();
+                requests.enqueue(id);
+                if (handler.get(id, true) == nullptr) { missing.fetch_add(1); }
+            }
+        });
+    }
+    gate.release(waiters + 1);
+    result.start();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    result.stop(perWaiter * waiters);
+    responder.join();
+    if (missing.load() > 0) {
+        printf("  %llu responses not delivered\n", missing.load());
+    }
+    return result;
+}
+
+static void benchCorrelation(unsigned long long ops) {
+    const int waiterCounts[] = { 1, 8, 64, 256 };
+    printf("\nmessage_handler: reserve, respond, get\n");
+    printf("%10s %12s %12s\n", "waiters", "ns", "alloc");
+    for (int waiters : waiterCounts) {
+        // every response wakes every waiter, so fewer round trips keep the large runs short.
+        probe result = correlationRun(waiters, ops / 8 / (1 + waiters / 16));
+        printf("%10d %12.1f %12.2f\n", waiters, result.ns, result.allocs);
+    }
+}
+
+/**
+ * Opens a connected pair of loopback TCP sockets.
+ */
+static bool socketPair(SOCKET& writer, SOCKET& reader) {
+    sockaddr_in addr;
+    socklen_t addrLen = sizeof(addr);
+    SOCKET listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    bool ok = false;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    if (bind(listener, (sockaddr*) &addr, sizeof(addr)) == 0 && listen(listener, 1) == 0 &&
+        getsockname(listener, (sockaddr*) &addr, &addrLen) == 0) {
+        writer = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (connect(writer, (sockaddr*) &addr, sizeof(addr)) == 0) {
+            reader = accept(listener, nullptr, nullptr);
+            ok = true;
+        }
+    }
+    closesocket(listener);
+    return ok;
+}
+
+static void benchTCPRecv(unsigned long long ops) {
+    const int sizes[] = { 16, 256, 4096 };
+    const int framesPerWrite = 64;
+    printf("\ntcp_recv_handler: relayed frames out of a loopback connection\n");
+    printf("%8s %12s %12s %12s\n", "payload", "ns", "alloc", "MB/s");
+    for (int size : sizes) {
+        SOCKET writer, reader;
+        std::string chunk;
+        std::string header = "{}";
+        unsigned long long frames = ops / 8 / (1 + size / 256);
+        unsigned long long received = 0;
+        unsigned char dataArr[4];
+        packet_buffer body;
+        int hdrLen = 0, msgLen = 0, totLen = -1, len;
+        probe result;
+        if (!socketPair(writer, reader)) {
+            printf("%8d could not open a loopback connection\n", size);
+            continue;
+        }
+        for (int i = 0; i < framesPerWrite; ++i) {
+            chunk += (char) header.size();
+            chunk += (char) 0;
+            chunk += (char) (size & 255);
+            chunk += (char) (size >> 8);
+            chunk.append(4, (char) 1);
+            chunk += header;
+            chunk.append(size, 'x');
+        }
+        frames -= frames % framesPerWrite;
+        std::thread sender([writer, &chunk, frames]() {
+            int sent;
+            for (unsigned long long i = 0; i < frames / framesPerWrite; ++i) {
+                for (std::size_t off = 0; off < chunk.size(); off += sent) {
+                    sent = send(writer, chunk.c_str() + off, (int) (chunk.size() - off), 0);
+                    if (sent <= 0) { return; }
+                }
+            }
+        });
+        {
+            tcp_recv_handler recvHandler(reader);
+            result.start();
+            // same framing as the comm_data_recv_tcp listener.
+            while (received < frames) {
+                if (totLen == -1 && recvHandler.size() > 4) {
+                    recvHandler.getData((char*) dataArr, 4);
+                    hdrLen = dataArr[0] + (dataArr[1] << 8);
+                    msgLen = dataArr[2] + (dataArr[3] << 8);
+                    totLen = hdrLen + msgLen + 4;
+                }
+                if (totLen > 0 && totLen <= recvHandler.size()) {
+                    recvHandler.getData((char*) dataArr, 4);
+                    body = recvHandler.getData(hdrLen + msgLen, 0);
+                    body.reset();
+                    totLen = -1;
+                    ++received;
+                    continue;
+                }
+                if (recvHandler.recvData(len) == nullptr) { break; }
+            }
+            result.stop(frames);
+        }
+        sender.join();
+        closesocket(writer);
+        closesocket(reader);
+        printf("%8d %12.1f %12.2f %12.1f%s\n", size, result.ns, result.allocs, (size + 10) * 1000.0 / result.ns,
+            received == frames ? "" : " incomplete");
+    }
+}
+
+static void benchRing(unsigned long long ops) {
+    const int sizes[] = { 16, 256, 4096 };
+    const int batch = 64;
+    printf("\nrecv_ring: push on the listener, poll in batches of %d\n", batch);
+    printf("%8s %12s %12s %12s\n", "payload", "ns", "alloc", "full waits");
+    for (int size : sizes) {
+        recv_ring ring(1024);
+        std::vector<char> data(size + 2, 'x');
+        std::vector<recv_message> out(batch);
+        unsigned long long messages = ops / (1 + size / 256);
+        unsigned long long polled = 0;
+        std::atomic<unsigned long long> fullWaits(0);
+        start_gate gate;
+        probe result;
+        int count;
+        std::thread producer([&]() {
+            unsigned long long waits = 0;
+            gate.arrive();
+            for (unsigned long long i = 0; i < messages; ++i) {
+                while (!ring.push(1, 2, data.data(), 2, size)) {
+                    ++waits;
+                    std::this_thread::yield();
+                }
+            }
+            fullWaits.store(waits);
+        });
+        gate.release(1);
+        result.start();
+        while (polled < messages) {
+            count = ring.poll(out.data(), batch);
+            if (count == 0) {
+                std::this_thread::yield();
+            }
+            polled += count;
+        }
+        result.stop(messages);
+        producer.join();
+        printf("%8d %12.1f %12.2f %12llu\n", size, result.ns, result.allocs, fullWaits.load());
+    }
+}
+
+static void benchPool(unsigned long long ops) {
+    const int sizes[] = { 64, 1024, 16384, 65536 };
+    // the producer waits past this depth, like a send queue the socket keeps up with.
+    const std::size_t depth = 64;
+    printf("\npacket_pool: acquire + drop on one thread, and acquire on a producer dropped by the consumer\n");
+    printf("%8s %12s %12s %12s %12s\n", "size", "local ns", "local alloc", "handoff ns", "handoff alloc");
+    for (int size : sizes) {
+        unsigned long long count = ops / (1 + size / 4096);
+        safe_queue<packet_buffer> queue;
+        start_gate gate;
+        probe local;
+        probe handoff;
+        // warm the caches so only the steady state is measured.
+        for (std::size_t i = 0; i < depth * 2; ++i) {
+            queue.enqueue(packet_pool::instance().acquire(size));
+        }
+        queue.clear();
+        local.start();
+        for (unsigned long long i = 0; i < count; ++i) {
+            packet_buffer buffer = packet_pool::instance().acquire(size);
+            buffer.data()[0] = 1;
+        }
+        local.stop(count);
+        std::thread producer([&queue, &gate, size, count, depth]() {
+            gate.arrive();
+            for (unsigned long long i = 0; i < count; ++i) {
+                while (queue.size() >= depth) {
+                    std::this_thread::yield();
+                }
+                queue.enqueue(packet_pool::instance().acquire(size));
+            }
+        });
+        gate.release(1);
+        handoff.start();
+        for (unsigned long long i = 0; i < count; ++i) {
+            queue.dequeue();
+        }
+        handoff.stop(count);
+        producer.join();
+        printf("%8d %12.1f %12.2f %12.1f %12.2f\n", size, local.ns, local.allocs, handoff.ns, handoff.allocs);
+    }
+}
+
+static void benchHistogram(unsigned long long ops) {
+    const int threadCounts[] = { 1, 2, 4 };
+    printf("\nlatency_histogram: record, every thread on the same histogram\n");
+    printf("%10s %12s %12s\n", "threads", "ns", "alloc");
+    for (int threadCount : threadCounts) {
+        latency_histogram histogram;
+        std::vector<std::thread> threads;
+        start_gate gate;
+        unsigned long long perThread = ops * 4 / threadCount;
+        probe result;
+        for (int i = 0; i < threadCount; ++i) {
+            threads.emplace_back([&histogram, &gate, perThread, i]() {
+                gate.arrive();
+                for (unsigned long long j = 0; j < perThread; ++j) {
+                    // spread over the buckets like latencies from a few us to a few ms.
+                    histogram.record(1000 + ((j * 2654435761ULL + i) & 0x3FFFFF));
+                }
+            });
+        }
+        gate.release(threadCount);
+        result.start();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        result.stop(perThread * threadCount);
+        printf("%10d %12.1f %12.2f%s\n", threadCount, result.ns, result.allocs,
+            histogram.getCount() == perThread * threadCount ? "" : " lost counts");
+    }
+}
+
+int main(int argc, char** argv) {
+    unsigned long long ops = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    std::mt19937 rng(1234);
+    if (ops < 1024) { ops = 1024; }
+#ifdef _WIN32
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 0), &wsaData) != 0) {
+        fprintf(stderr, "generics_bench: WSAStartup failed\n");
+        return 1;
+    }
+#else
+    signal(SIGPIPE, SIG_IGN);
+#endif
+
+    printf("%llu operations per run, %u hardware threads\n\n", ops, std::thread::hardware_concurrency());
+    benchQueue(ops);
+    benchMapLookup(ops, rng);
+    benchMapChurn(ops, rng);
+    benchCorrelation(ops);
+    benchTCPRecv(ops);
+    benchRing(ops);
+    benchPool(ops);
+    benchHistogram(ops);
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return 0;
+}
@@ -0,0 +1,149 @@
+/**
+ * @file pose_bench.cpp
+ * @brief Compares pose_text with strtof and with the FString path the actor used (copy, widen, split, Atof).
+ * The FString path is modelled with std::wstring so the benchmark builds without the engine.
+ * Then compares the size and decode time of text frames with binary pose frames.
+ *
+ * Usage: pose_bench [frames]
+ */
+#include "corelink/pose/pose.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cwchar>
+#include <random>
+#include <vector>
+
+using CorelinkDLL::Pose::pose_text;
+using CorelinkDLL::Pose::pose_frame;
+
+static std::string makeFrame(std::mt19937& rng, int joints) {
+    std::uniform_real_distribution<float> dist(-2.0f, 2.0f);
+    std::string frame;
+    char value[32];
+    for (int i = 0; i < joints * 3; ++i) {
+        snprintf(value, sizeof(value), i == 0 ? "%.4f" : ",%.4f", dist(rng));
+        frame += value;
+    }
+    return frame;
+}
+
+static int parseStrtof(const char* data, int len, float* out, int maxOut) {
+    std::string text(data, len);
+    const char* p = text.c_str();
+    char* end;
+    int count = 0;
+    while (*p != '\0' && count < maxOut) {
+        out[count++] = strtof(p, &end);
+        if (end == p) { return -1; }
+        p = *end == ',' ? end + 1 : end;
+    }
+    return count;
+}
+
+static int readFrame(const char* data, int len, float* out, int maxOut) {
+    int joints = pose_frame::readPositions(data, len, out, maxOut / 3);
+    return joints < 0 ? -1 : joints * 3;
+}
+
+static int parseFString(const char* data, int len, float* out, int maxOut) {
+    // UTF8_TO_TCHAR(std::string(msg, msgLen).c_str()), ParseIntoArray(","), FCString::Atof.
+    std::string text(data, len);
+    std::wstring wide(text.begin(), text.end());
+    std::vector<std::wstring> parts;
+    std::size_t start = 0, comma;
+    int count = 0;
+    while ((comma = wide.find(L',', start)) != std::wstring::npos) {
+        parts.push_back(wide.substr(start, comma - start));
+        start = comma + 1;
+    }
+    parts.push_back(wide.substr(start));
+    for (const std::wstring& part : parts) {
+        if (count == maxOut) { return -1; }
+        out[count++] = wcstof(part.c_str(), nullptr);
+    }
+    return count;
+}
+
+typedef int(*ParseFunc)(const char*, int, float*, int);
+
+static double run(ParseFunc func, const std::vector<std::string>& frames, std::vector<float>& out, int repeat, float& checksum) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    checksum = 0;
+    for (int r = 0; r < repeat; ++r) {
+        for (const std::string& frame : frames) {
+            int count = func(frame.c_str(), (int) frame.size(), out.data(), (int) out.size());
+            checksum += count > 0 ? out[count - 1] : -1.0f;
+        }
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / ((double) repeat * frames.size());
+}
+
+/**
+ * @return Values where pose_text differs from strtof by more than 1 ulp.
+ */
+static int verify(const std::vector<std::string>& frames, int values) {
+    std::vector<float> expected(values), actual(values);
+    int mismatches = 0;
+    for (const std::string& frame : frames) {
+        parseStrtof(frame.c_str(), (int) frame.size(), expected.data(), values);
+        if (pose_text::parse(frame.c_str(), (int) frame.size(), actual.data(), values) != values) { return values; }
+        for (int i = 0; i < values; ++i) {
+            if (expected[i] != actual[i] && std::nextafter(expected[i], actual[i]) != actual[i]) { ++mismatches; }
+        }
+    }
+    return mismatches;
+}
+
+int main(int argc, char** argv) {
+    const int jointCounts[] = { 25, 52, 128 };
+    const int framesPerSet = 256;
+    int repeat = argc > 1 ? atoi(argv[1]) / framesPerSet : 200;
+    std::mt19937 rng(1234);
+    if (repeat < 1) { repeat = 1; }
+
+#ifdef CORELINK_POSE_SSE2
+    printf("pose_text vector path: SSE2\n");
+#else
+    printf("pose_text vector path: none (scalar)\n");
+#endif
+    printf("%8s %8s %14s %14s %14s %14s %10s\n", "joints", "bytes", "pose_text ns", "scalar ns", "strtof ns", "fstring ns", "mismatch");
+    for (int joints : jointCounts) {
+        std::vector<std::string> frames;
+        std::vector<float> out(joints * 3);
+        std::size_t bytes = 0;
+        float checksum;
+        double simd, scalar, strtofTime, fstring;
+        for (int i = 0; i < framesPerSet; ++i) {
+            frames.push_back(makeFrame(rng, joints));
+            bytes += frames.back().size();
+        }
+        simd = run(pose_text::parse, frames, out, repeat, checksum);
+        scalar = run(pose_text::parseScalar, frames, out, repeat, checksum);
+        strtofTime = run(parseStrtof, frames, out, repeat, checksum);
+        fstring = run(parseFString, frames, out, repeat, checksum);
+        printf("%8d %8zu %14.0f %14.0f %14.0f %14.0f %10d\n", joints, bytes / framesPerSet, simd, scalar, strtofTime, fstring, verify(frames, joints * 3));
+    }
+
+    printf("\n%8s %10s %10s %10s %12s %12s %12s\n", "joints", "text B", "float32 B", "quant B", "text ns", "float32 ns", "quant ns");
+    for (int joints : jointCounts) {
+        std::vector<std::string> text, binary, quantized;
+        std::vector<float> positions(joints * 3), out(joints * 3);
+        float checksum;
+        double textTime, binaryTime, quantizedTime;
+        for (int i = 0; i < framesPerSet; ++i) {
+            text.push_back(makeFrame(rng, joints));
+            pose_text::parse(text.back().c_str(), (int) text.back().size(), positions.data(), (int) positions.size());
+            binary.emplace_back();
+            pose_frame::encode(i, i * 16667ULL, joints, positions.data(), nullptr, false, binary.back());
+            quantized.emplace_back();
+            pose_frame::encode(i, i * 16667ULL, joints, positions.data(), nullptr, true, quantized.back());
+        }
+        textTime = run(readFrame, text, out, repeat, checksum);
+        binaryTime = run(readFrame, binary, out, repeat, checksum);
+        quantizedTime = run(readFrame, quantized, out, repeat, checksum);
+        printf("%8d %10zu %10zu %10zu %12.0f %12.0f %12.0f\n", joints, text[0].size(), binary[0].size(), quantized[0].size(),
+            textTime, binaryTime, quantizedTime);
+    }
+    return 0;
+}
@@ -0,0 +1,347 @@
+/**
+ * @file corelink_loadgen.cpp
+ * @brief Synthetic mocap load. Creates one sender stream per performer and sends animated skeleton frames
+ * like a Motive rig would, so stage load can be reproduced against a local server.
+ *
+ * Every performer is captured on the same rig clock. Frame k is due at k / rate seconds.
+ * --burst holds frames back and sends them n at a time when the last of them is due, keeping the average rate.
+ * --jitter delays every send by a random amount. Late sends do not shift the schedule of later frames.
+ * Each line reports the achieved rate, how late frames left, and the send queue depth sampled every millisecond.
+ *
+ * Usage: corelink_loadgen [options]
+ *   --server ip:port  Server to send to. Default 127.0.0.1:20010 (corelink_server).
+ *   --proto p         udp or tcp. Default udp.
+ *   --performers n    Sender streams. Default 30.
+ *   --joints n        Joints per skeleton. Default 52.
+ *   --rate hz         Frames per second of each performer. Default 120.
+ *   --format f        text (X,Y,Z values), binary or quantized (pose.bin/1). Default text.
+ *   --header 0|1      Attach a json header with the frame number through sendMsgJson. Default 0.
+ *   --jitter ms       Extra random delay of every send up to ms. Default 0.
+ *   --burst n         Frames sent back to back at a time. Default 1.
+ *   --threads n       Threads sharing the performers. Default 1.
+ *   --duration s      Seconds to run, 0 until interrupted. Default 10.
+ *   --report s        Seconds between report lines. Default 1.
+ *   --workspace name  Workspace of the streams. Default Loadgen.
+ */
+#include "Corelink.h"
+#include "corelink/pose/pose.h"
+
+#include <algorithm>
+#include <cmath>
+#include <csignal>
+#include <cstdlib>
+#include <random>
+
+using CorelinkDLL::Pose::pose_frame;
+
+static const char* LOADGEN_TYPE = "pose";
+/// Interval of the send queue depth samples.
+static const std::chrono::milliseconds DEPTH_SAMPLE(1);
+
+static std::atomic<bool> interrupted(false);
+
+static void onSignal(int) {
+    interrupted.store(true);
+}
+
+enum class FrameFormat {
+    TEXT,
+    BINARY,
+    QUANTIZED
+};
+
+struct loadgen_options {
+    std::string serverIP;
+    int serverPort;
+    int protocol;
+    int performers;
+    int joints;
+    double rate;
+    FrameFormat format;
+    bool header;
+    double jitterMs;
+    int burst;
+    int threads;
+    double duration;
+    double report;
+    std::string workspace;
+
+    loadgen_options() : serverIP("127.0.0.1"), serverPort(20010), protocol(Corelink::Const::STREAM_STATE_SEND_UDP),
+        performers(30), joints(52), rate(120), format(FrameFormat::TEXT), header(false), jitterMs(0), burst(1),
+        threads(1), duration(10), report(1), workspace("Loadgen") {}
+};
+
+/**
+ * Counters shared by the send threads and the reporter.
+ */
+struct loadgen_stats {
+    std::atomic<unsigned long long> frames;
+    std::atomic<unsigned long long> bytes;
+    std::atomic<unsigned long long> failed;
+    /// Largest delay between a frame being due and leaving, in microseconds. Reset by every report.
+    std::atomic<long long> maxLagUs;
+    std::atomic<long long> lagSumUs;
+    std::atomic<int> maxDepth;
+
+    loadgen_stats() : frames(0), bytes(0), failed(0), maxLagUs(0), lagSumUs(0), maxDepth(0) {}
+};
+
+static loadgen_stats stats;
+
+/**
+ * One skeleton walking in a circle with swinging limbs.
+ */
+class performer {
+private:
+    Corelink::SendStream stream;
+    std::vector<float> rest;
+    std::vector<float> positions;
+    float phase;
+    std::string payload;
+    rapidjson::Document json;
+public:
+    std::uint32_t frame;
+
+    performer(const Corelink::SendStream& stream, int joints, int index, std::mt19937& rng) :
+        stream(stream), rest(joints * 3), positions(joints * 3), phase(index * 0.7f), frame(0) {
+        std::uniform_real_distribution<float> offset(-0.3f, 0.3f);
+        this->json.SetObject();
+        this->json.AddMember("frame", 0, this->json.GetAllocator());
+        for (int i = 0; i < joints; ++i) {
+            // joints stacked from the floor to head height.
+            this->rest[i * 3] = offset(rng);
+            this->rest[i * 3 + 1] = 1.8f * i / joints;
+            this->rest[i * 3 + 2] = offset(rng);
+        }
+    }
+
+    /**
+     * Poses the skeleton at time t and sends the frame.
+     * @return Bytes sent, 0 if the stream is gone.
+     */
+    int send(double t, const loadgen_options& options) {
+        const float angle = (float) (t * 0.5) + this->phase;
+        const float centerX = 3.0f * std::cos(angle);
+        const float centerZ = 3.0f * std::sin(angle);
+        const int joints = (int) this->rest.size() / 3;
+        char value[32];
+        int len;
+        bool ok;
+        for (int i = 0; i < joints; ++i) {
+            float swing = 0.2f * std::sin((float) (t * 6.0) + i);
+            this->positions[i * 3] = centerX + this->rest[i * 3] + swing;
+            this->positions[i * 3 + 1] = this->rest[i * 3 + 1];
+            this->positions[i * 3 + 2] = centerZ + this->rest[i * 3 + 2] - swing;
+        }
+        if (options.format == FrameFormat::TEXT) {
+            this->payload.clear();
+            for (int i = 0; i < joints * 3; ++i) {
+                len = snprintf(value, sizeof(value), i == 0 ? "%.4f" : ",%.4f", this->positions[i]);
+                this->payload.append(value, len);
+            }
+        }
+        else {
+            pose_frame::encode(this->frame, (std::uint64_t) (t * 1000000), joints, this->positions.data(), nullptr,
+                options.format == FrameFormat::QUANTIZED, this->payload);
+        }
+        if (options.header) {
+            this->json["frame"].SetUint(this->frame);
+            ok = this->stream.send(this->payload.c_str(), (int) this->payload.size(), this->json);
+        }
+        else {
+            ok = this->stream.send(this->payload.c_str(), (int) this->payload.size());
+        }
+        ++this->frame;
+        return ok ? (int) this->payload.size() : 0;
+    }
+
+    Corelink::SendStream& getStream() {
+        return this->stream;
+    }
+};
+
+static void updateMax(std::atomic<long long>& target, long long value) {
+    long long current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+/**
+ * Sends the frames of the performers assigned to one thread.
+ * All of them share the rig clock, so one wait covers the whole group.
+ */
+static void sendFunc(std::vector<performer>* group, const loadgen_options* options, std::chrono::steady_clock::time_point start,
+        std::chrono::steady_clock::time_point end, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> jitter(0, options->jitterMs * 1000.0);
+    const double periodUs = 1000000.0 / options->rate;
+    std::chrono::steady_clock::time_point due, now;
+    long long lagUs;
+    int bytes;
+    for (unsigned long long k = options->burst - 1; !interrupted.load(std::memory_order_relaxed); k += options->burst) {
+        // frame k is the last of its burst, the burst leaves when it is captured.
+        due = start + std::chrono::microseconds((long long) (k * periodUs + (options->jitterMs > 0 ? jitter(rng) : 0)));
+        if (due >= end) { break; }
+        std::this_thread::sleep_until(due);
+        for (int b = options->burst - 1; b >= 0; --b) {
+            for (performer& p : *group) {
+                bytes = p.send((k - b) * periodUs / 1000000.0, *options);
+                if (bytes == 0) {
+                    stats.failed.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                stats.frames.fetch_add(1, std::memory_order_relaxed);
+                stats.bytes.fetch_add(bytes, std::memory_order_relaxed);
+            }
+        }
+        now = std::chrono::steady_clock::now();
+        lagUs = std::chrono::duration_cast<std::chrono::microseconds>(now - due).count();
+        stats.lagSumUs.fetch_add(lagUs, std::memory_order_relaxed);
+        updateMax(stats.maxLagUs, lagUs);
+    }
+}
+
+static bool parseOptions(int argc, char** argv, loadgen_options& options) {
+    std::string arg, value;
+    std::size_t colon;
+    for (int i = 1; i < argc; ++i) {
+        arg = argv[i];
+        if (i + 1 >= argc) { return false; }
+        value = argv[++i];
+        if (arg == "--server") {
+            if ((colon = value.rfind(':')) == std::string::npos) { return false; }
+            options.serverIP = value.substr(0, colon);
+            options.serverPort = atoi(value.c_str() + colon + 1);
+        }
+        else if (arg == "--proto") {
+            if (value == "udp") { options.protocol = Corelink::Const::STREAM_STATE_SEND_UDP; }
+            else if (value == "tcp") { options.protocol = Corelink::Const::STREAM_STATE_SEND_TCP; }
+            else { return false; }
+        }
+        else if (arg == "--format") {
+            if (value == "text") { options.format = FrameFormat::TEXT; }
+            else if (value == "binary") { options.format = FrameFormat::BINARY; }
+            else if (value == "quantized") { options.format = FrameFormat::QUANTIZED; }
+            else { return false; }
+        }
+        else if (arg == "--performers") { options.performers = atoi(value.c_str()); }
+        else if (arg == "--joints") { options.joints = atoi(value.c_str()); }
+        else if (arg == "--rate") { options.rate = atof(value.c_str()); }
+        else if (arg == "--header") { options.header = value != "0"; }
+        else if (arg == "--jitter") { options.jitterMs = atof(value.c_str()); }
+        else if (arg == "--burst") { options.burst = atoi(value.c_str()); }
+        else if (arg == "--threads") { options.threads = atoi(value.c_str()); }
+        else if (arg == "--duration") { options.duration = atof(value.c_str()); }
+        else if (arg == "--report") { options.report = atof(value.c_str()); }
+        else if (arg == "--workspace") { options.workspace = value; }
+        else { return false; }
+    }
+    return options.performers > 0 && options.joints > 0 && options.joints <= pose_frame::MAX_JOINTS && options.rate > 0 &&
+        options.jitterMs >= 0 && options.burst > 0 && options.threads > 0 && options.duration >= 0 && options.report > 0;
+}
+
+static const char* formatName(FrameFormat format) {
+    return format == FrameFormat::TEXT ? "text" : format == FrameFormat::BINARY ? "binary" : "quantized";
+}
+
+int main(int argc, char** argv) {
+    loadgen_options options;
+    std::vector<std::vector<performer>> groups;
+    std::vector<std::thread> threads;
+    std::mt19937 rng(1234);
+    std::chrono::steady_clock::time_point start, end, nextReport, now;
+    unsigned long long frames, lastFrames = 0, bytes, lastBytes = 0, lagCount;
+    double elapsed, interval, lastElapsed = 0;
+    int depth;
+
+    if (!parseOptions(argc, argv, options)) {
+        fprintf(stderr, "usage: corelink_loadgen [--server ip:port] [--proto udp|tcp] [--performers n] [--joints n] [--rate hz]\n"
+            "                        [--format text|binary|quantized] [--header 0|1] [--jitter ms] [--burst n]\n"
+            "                        [--threads n] [--duration s] [--report s] [--workspace name]\n");
+        return 1;
+    }
+    options.threads = std::min(options.threads, options.performers);
+
+#ifndef _WIN32
+    signal(SIGPIPE, SIG_IGN);
+#endif
+    signal(SIGINT, &onSignal);
+    signal(SIGTERM, &onSignal);
+
+    try {
+        Corelink::DLLInit::Init();
+        Corelink::DLLInit::setServerCredentials("Testuser", "Testpassword");
+        Corelink::Client::connect(options.serverIP, options.serverPort);
+        Corelink::Client::addWorkspace(options.workspace);
+
+        groups.resize(options.threads);
+        for (std::vector<performer>& group : groups) {
+            group.reserve(options.performers / options.threads + 1);
+        }
+        for (int i = 0; i < options.performers; ++i) {
+            std::string meta = "performer " + std::to_string(i);
+            if (options.format != FrameFormat::TEXT) {
+                meta = pose_frame::advertise(meta);
+            }
+            groups[i % options.threads].emplace_back(
+                Corelink::Client::createSender(options.workspace, LOADGEN_TYPE, meta, false, false, options.protocol),
+                options.joints, i, rng);
+        }
+        printf("%d performers x %d joints at %.1f Hz, %s %s, burst %d, jitter %.1fms to %s:%d\n", options.performers,
+            options.joints, options.rate, options.protocol == Corelink::Const::STREAM_STATE_SEND_UDP ? "udp" : "tcp",
+            formatName(options.format), options.burst, options.jitterMs, options.serverIP.c_str(), options.serverPort);
+        fflush(stdout);
+
+        start = std::chrono::steady_clock::now();
+        end = options.duration > 0 ? start + std::chrono::microseconds((long long) (options.duration * 1000000)) :
+            std::chrono::steady_clock::time_point::max();
+        for (int i = 0; i < options.threads; ++i) {
+            threads.emplace_back(&sendFunc, &groups[i], &options, start, end, 100 + i);
+        }
+
+        nextReport = start + std::chrono::microseconds((long long) (options.report * 1000000));
+        while (!interrupted.load() && (now = std::chrono::steady_clock::now()) < end) {
+            depth = groups[0][0].getStream().getQueueDepth();
+            if (depth > stats.maxDepth.load(std::memory_order_relaxed)) {
+                stats.maxDepth.store(depth, std::memory_order_relaxed);
+            }
+            if (now >= nextReport) {
+                elapsed = std::chrono::duration<double>(now - start).count();
+                interval = elapsed - lastElapsed;
+                frames = stats.frames.load();
+                bytes = stats.bytes.load();
+                // one lag sample per burst and thread.
+                lagCount = (frames - lastFrames) / std::max(options.burst * (options.performers / options.threads), 1);
+                printf("%6.1fs %9.0f frames/s %7.1f Hz/performer %8.2f MB/s | lag avg %.2fms max %.2fms | queue now %d max %d | failed %llu\n",
+                    elapsed, (frames - lastFrames) / interval, (frames - lastFrames) / interval / options.performers,
+                    (bytes - lastBytes) / interval / 1000000.0, lagCount > 0 ? stats.lagSumUs.exchange(0) / 1000.0 / lagCount : 0.0,
+                    stats.maxLagUs.exchange(0) / 1000.0, depth, stats.maxDepth.exchange(0), stats.failed.load());
+                fflush(stdout);
+                lastFrames = frames;
+                lastBytes = bytes;
+                lastElapsed = elapsed;
+                nextReport += std::chrono::microseconds((long long) (options.report * 1000000));
+            }
+            std::this_thread::sleep_for(DEPTH_SAMPLE);
+        }
+        interrupted.store(true);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        frames = stats.frames.load();
+        printf("total %llu frames in %.1fs, %.1f Hz/performer of %.1f Hz target, %.2f MB/s, %llu failed\n", frames, elapsed,
+            frames / elapsed / options.performers, options.rate, stats.bytes.load() / elapsed / 1000000.0, stats.failed.load());
+
+        for (std::vector<performer>& group : groups) {
+            for (performer& p : group) {
+                Corelink::Client::rmStream(p.getStream());
+            }
+        }
+        Corelink::Client::cleanup();
+    }
+    catch (const Corelink::CorelinkException& e) {
+        fprintf(stderr, "corelink_loadgen: %s\n", e.msg.c_str());
+        return 1;
+    }
+    return 0;
+}
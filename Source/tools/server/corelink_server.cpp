@@ -0,0 +1,95 @@
+/**
+ * @file corelink_server.cpp
+ * @brief Runs loopback_server until interrupted, printing the relay counters every few seconds.
+ *
+ * Usage: corelink_server [options]
+ *   --ip address      Address to listen on. Default 127.0.0.1.
+ *   --port n          Control port. Default 20010.
+ *   --data-port n     UDP and TCP data port. Default 20012.
+ *   --latency ms      Delay of every relayed frame.
+ *   --jitter ms       Extra random delay up to ms.
+ *   --loss p          Probability a frame is dropped.
+ *   --reorder p       Probability a frame is held back so later frames overtake it.
+ *   --gap ms          How long reordered frames are held back. Default 5.
+ *   --script file     Impairment script, see loopback_server::runScript.
+ *   --stats s         Seconds between counter lines, 0 for none. Default 5.
+ */
+#include "loopback_server.h"
+
+#include <csignal>
+#include <cstdlib>
+
+using CorelinkDLL::Tools::impairment;
+using CorelinkDLL::Tools::loopback_server;
+
+static std::atomic<bool> interrupted(false);
+
+static void onSignal(int) {
+    interrupted.store(true);
+}
+
+static void usage() {
+    fprintf(stderr, "usage: corelink_server [--ip address] [--port n] [--data-port n] [--latency ms] [--jitter ms]\n"
+        "                       [--loss p] [--reorder p] [--gap ms] [--script file] [--stats s]\n");
+}
+
+int main(int argc, char** argv) {
+    loopback_server server;
+    impairment link;
+    std::string ip = "127.0.0.1";
+    std::string script;
+    std::string error;
+    std::string arg;
+    int port = 20010;
+    int dataPort = 20012;
+    int stats = 5;
+    int elapsed = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        arg = argv[i];
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        if (arg == "--ip") { ip = argv[++i]; }
+        else if (arg == "--port") { port = atoi(argv[++i]); }
+        else if (arg == "--data-port") { dataPort = atoi(argv[++i]); }
+        else if (arg == "--script") { script = argv[++i]; }
+        else if (arg == "--stats") { stats = atoi(argv[++i]); }
+        else if (arg.compare(0, 2, "--") != 0 || !link.set(arg.substr(2), argv[++i])) {
+            usage();
+            return 1;
+        }
+    }
+
+#ifndef _WIN32
+    signal(SIGPIPE, SIG_IGN);
+#endif
+    signal(SIGINT, &onSignal);
+    signal(SIGTERM, &onSignal);
+
+    server.setImpairment(link);
+    if (!server.start(ip, port, dataPort, error)) {
+        fprintf(stderr, "corelink_server: %s\n", error.c_str());
+        return 1;
+    }
+    if (!script.empty() && !server.runScript(script, error)) {
+        fprintf(stderr, "corelink_server: %s\n", error.c_str());
+        return 1;
+    }
+    printf("listening on %s control %d data %d\n", ip.c_str(), server.getControlPort(), server.getDataPort());
+    fflush(stdout);
+
+    while (!interrupted.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (stats > 0 && ++elapsed % (stats * 10) == 0) {
+            link = server.getImpairment();
+            printf("received %llu relayed %llu lost %llu reordered %llu | latency %.1fms jitter %.1fms loss %.3f reorder %.3f\n",
+                server.getReceived(), server.getRelayed(), server.getLost(), server.getReordered(),
+                link.latencyUs / 1000.0, link.jitterUs / 1000.0, link.loss, link.reorder);
+            fflush(stdout);
+        }
+    }
+    server.stop();
+    return 0;
+}
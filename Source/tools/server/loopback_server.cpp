@@ -0,0 +1,999 @@
+#include "loopback_server.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+
+# ifndef _WIN32
+#include <netinet/tcp.h>
+# endif
+
+namespace CorelinkDLL {
+    namespace Tools {
+#ifdef MSG_NOSIGNAL
+        // a client closing its end must not kill the server with SIGPIPE.
+        static const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+        static const int SEND_FLAGS = 0;
+#endif
+        static const int FRAME_HEADER_SIZE = 8;
+        static const int UDP_RECV_BUFFER = 4 << 20;
+        /// Longest a listener blocks before it checks if the server is stopping.
+        static const int RECV_TIMEOUT_MS = 100;
+        /// Stream ids travel in 2 bytes of the frame header.
+        static const STREAM_ID MAX_STREAM_ID = 65535;
+
+        static const std::vector<const char*> functionNames = {
+            "auth", "sender", "receiver", "subscribe", "unsubscribe", "listStreams", "streamInfo", "disconnect",
+            "listFunctions", "describeFunction", "listWorkspaces", "addWorkspace", "rmWorkspace"
+        };
+
+        static bool sendAll(SOCKET sock, const char* data, int len) {
+            int sent;
+            while (len > 0) {
+                sent = (int) ::send(sock, data, len, SEND_FLAGS);
+                if (sent <= 0) { return false; }
+                data += sent;
+                len -= sent;
+            }
+            return true;
+        }
+
+        static void setRecvTimeout(SOCKET sock, int timeoutMs) {
+#ifdef _WIN32
+            DWORD timeout = timeoutMs;
+#else
+            timeval timeout = CreateTime(timeoutMs / 1000, (timeoutMs % 1000) * 1000);
+#endif
+            setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (SOCK_PTR)&timeout, sizeof(timeout));
+        }
+
+        static bool validSocket(SOCKET sock) {
+#ifdef _WIN32
+            return sock != INVALID_SOCKET;
+#else
+            // INVALID_SOCKET is 0 here, socket calls fail with -1.
+            return sock > 0;
+#endif
+        }
+
+        static std::string toJson(const rapidjson::Value& value) {
+            rapidjson::StringBuffer buffer;
+            rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+            value.Accept(writer);
+            return std::string(buffer.GetString(), buffer.GetSize());
+        }
+
+        static std::string readString(const rapidjson::Value& json, const char* key) {
+            rapidjson::Value::ConstMemberIterator iter = json.FindMember(key);
+            if (iter == json.MemberEnd() || !iter->value.IsString()) { return ""; }
+            return std::string(iter->value.GetString(), iter->value.GetStringLength());
+        }
+
+        static bool readBool(const rapidjson::Value& json, const char* key) {
+            rapidjson::Value::ConstMemberIterator iter = json.FindMember(key);
+            return iter != json.MemberEnd() && iter->value.IsBool() && iter->value.GetBool();
+        }
+
+        /**
+         * The client sends stream ids as numbers or as strings.
+         */
+        static bool readStreamID(const rapidjson::Value& value, STREAM_ID& streamID) {
+            char* end;
+            long parsed;
+            if (value.IsInt()) {
+                streamID = value.GetInt();
+                return true;
+            }
+            if (!value.IsString() || value.GetStringLength() == 0) { return false; }
+            parsed = strtol(value.GetString(), &end, 10);
+            if (*end != '\0') { return false; }
+            streamID = (STREAM_ID) parsed;
+            return true;
+        }
+
+        /**
+         * Reads a member holding a stream id or an array of them.
+         */
+        static std::vector<STREAM_ID> readStreamIDs(const rapidjson::Value& json, const char* key) {
+            std::vector<STREAM_ID> streamIDs;
+            STREAM_ID streamID;
+            rapidjson::Value::ConstMemberIterator iter = json.FindMember(key);
+            if (iter == json.MemberEnd()) { return streamIDs; }
+            if (!iter->value.IsArray()) {
+                if (readStreamID(iter->value, streamID)) {
+                    streamIDs.push_back(streamID);
+                }
+                return streamIDs;
+            }
+            for (const rapidjson::Value& value : iter->value.GetArray()) {
+                if (readStreamID(value, streamID)) {
+                    streamIDs.push_back(streamID);
+                }
+            }
+            return streamIDs;
+        }
+
+        static std::vector<std::string> readStrings(const rapidjson::Value& json, const char* key) {
+            std::vector<std::string> strings;
+            rapidjson::Value::ConstMemberIterator iter = json.FindMember(key);
+            if (iter == json.MemberEnd()) { return strings; }
+            if (iter->value.IsString()) {
+                strings.push_back(std::string(iter->value.GetString(), iter->value.GetStringLength()));
+            }
+            else if (iter->value.IsArray()) {
+                for (const rapidjson::Value& value : iter->value.GetArray()) {
+                    if (value.IsString()) {
+                        strings.push_back(std::string(value.GetString(), value.GetStringLength()));
+                    }
+                }
+            }
+            return strings;
+        }
+
+        static void addString(rapidjson::Value& json, const char* key, const std::string& value, rapidjson::Document::AllocatorType& alloc) {
+            json.AddMember(rapidjson::StringRef(key), rapidjson::Value(value.c_str(), (rapidjson::SizeType) value.size(), alloc), alloc);
+        }
+
+        impairment::impairment() : latencyUs(0), jitterUs(0), loss(0), reorder(0), reorderUs(5000) {}
+
+        bool impairment::none() const {
+            return this->latencyUs <= 0 && this->jitterUs <= 0 && this->loss <= 0 && this->reorder <= 0;
+        }
+
+        bool impairment::set(const std::string& key, const std::string& value) {
+            char* end;
+            double parsed = strtod(value.c_str(), &end);
+            if (value.empty() || *end != '\0' || parsed < 0) { return false; }
+            if (key == "latency") { this->latencyUs = (int) (parsed * 1000); }
+            else if (key == "jitter") { this->jitterUs = (int) (parsed * 1000); }
+            else if (key == "gap") { this->reorderUs = (int) (parsed * 1000); }
+            else if (key == "loss" && parsed <= 1) { this->loss = parsed; }
+            else if (key == "reorder" && parsed <= 1) { this->reorder = parsed; }
+            else { return false; }
+            return true;
+        }
+
+        void loopback_server::control_conn::send(const std::string& msg) {
+            std::lock_guard<std::mutex> lck(this->sendLock);
+            if (!validSocket(this->sock)) { return; }
+            sendAll(this->sock, msg.c_str(), (int) msg.size());
+        }
+
+        void loopback_server::tcp_peer::send(const std::string& frame) {
+            std::lock_guard<std::mutex> lck(this->sendLock);
+            if (!validSocket(this->sock)) { return; }
+            sendAll(this->sock, frame.c_str(), (int) frame.size());
+        }
+
+        loopback_server::loopback_server() :
+            running(false), controlSock(INVALID_SOCKET), dataSock(INVALID_SOCKET), udpSock(INVALID_SOCKET), controlPort(0), dataPort(0),
+            nextStreamID(1), nextToken(0), rng(std::random_device()()), nextSeq(0), scriptRun(0),
+            received(0), relayed(0), lost(0), reordered(0)
+        {}
+
+        loopback_server::~loopback_server() {
+            this->stop();
+        }
+
+        SOCKET loopback_server::listenTCP(const std::string& ip, int& port, std::string& error) {
+            sockaddr_in hint;
+            socklen_t len = sizeof(hint);
+            int reuse = 1;
+            SOCKET sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            if (!validSocket(sock)) {
+                error = "could not create socket";
+                return INVALID_SOCKET;
+            }
+            setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (SOCK_PTR)&reuse, sizeof(reuse));
+            memset(&hint, 0, sizeof(hint));
+            hint.sin_family = AF_INET;
+            hint.sin_port = htons((u_short) port);
+            if (inet_pton(AF_INET, ip.c_str(), &hint.sin_addr) != 1) {
+                error = "invalid address " + ip;
+                closesocket(sock);
+                return INVALID_SOCKET;
+            }
+            if (bind(sock, (sockaddr*)&hint, sizeof(hint)) != 0 || listen(sock, 64) != 0) {
+                error = "could not listen on " + ip + ":" + std::to_string(port);
+                closesocket(sock);
+                return INVALID_SOCKET;
+            }
+            getsockname(sock, (sockaddr*)&hint, &len);
+            port = ntohs(hint.sin_port);
+            return sock;
+        }
+
+        bool loopback_server::start(const std::string& ip, int controlPort, int dataPort, std::string& error) {
+            sockaddr_in hint;
+            int recvBuffer = UDP_RECV_BUFFER;
+            if (this->running.load()) {
+                error = "server already running";
+                return false;
+            }
+#ifdef _WIN32
+            WSADATA data;
+            if (WSAStartup(MAKEWORD(2, 0), &data) != 0) {
+                error = "winsock initialization error";
+                return false;
+            }
+#endif
+            this->controlPort = controlPort;
+            this->controlSock = listenTCP(ip, this->controlPort, error);
+            if (!validSocket(this->controlSock)) {
+#ifdef _WIN32
+                WSACleanup();
+#endif
+                return false;
+            }
+            // UDP takes the port the data listener got. Any free port may be taken for UDP, so try a few.
+            for (int attempt = 0; attempt < 8; ++attempt) {
+                this->dataPort = dataPort;
+                this->dataSock = listenTCP(ip, this->dataPort, error);
+                if (!validSocket(this->dataSock)) { break; }
+                this->udpSock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+                memset(&hint, 0, sizeof(hint));
+                hint.sin_family = AF_INET;
+                hint.sin_port = htons((u_short) this->dataPort);
+                inet_pton(AF_INET, ip.c_str(), &hint.sin_addr);
+                if (validSocket(this->udpSock) && bind(this->udpSock, (sockaddr*)&hint, sizeof(hint)) == 0) { break; }
+                error = "could not bind UDP to " + ip + ":" + std::to_string(this->dataPort);
+                if (validSocket(this->udpSock)) {
+                    closesocket(this->udpSock);
+                }
+                closesocket(this->dataSock);
+                this->udpSock = INVALID_SOCKET;
+                this->dataSock = INVALID_SOCKET;
+                if (dataPort != 0) { break; }
+            }
+            if (!validSocket(this->udpSock)) {
+                closesocket(this->controlSock);
+                this->controlSock = INVALID_SOCKET;
+#ifdef _WIN32
+                WSACleanup();
+#endif
+                return false;
+            }
+            setsockopt(this->udpSock, SOL_SOCKET, SO_RCVBUF, (SOCK_PTR)&recvBuffer, sizeof(recvBuffer));
+            setRecvTimeout(this->udpSock, RECV_TIMEOUT_MS);
+            error.clear();
+
+            this->running.store(true);
+            this->controlAccept = std::thread(&loopback_server::acceptFunc, this, this->controlSock, &loopback_server::controlFunc);
+            this->dataAccept = std::thread(&loopback_server::acceptFunc, this, this->dataSock, &loopback_server::tcpDataFunc);
+            this->udpListener = std::thread(&loopback_server::udpFunc, this);
+            this->deliverer = std::thread(&loopback_server::deliverFunc, this);
+            return true;
+        }
+
+        void loopback_server::stop() {
+            std::vector<std::thread> threads;
+            {
+                std::lock_guard<std::mutex> lck(this->scriptLock);
+                ++this->scriptRun;
+            }
+            this->scriptSignal.notify_all();
+            if (this->scripter.joinable()) {
+                this->scripter.join();
+            }
+            if (!this->running.exchange(false)) { return; }
+
+            shutdown(this->controlSock, SD_BOTH);
+            closesocket(this->controlSock);
+            shutdown(this->dataSock, SD_BOTH);
+            closesocket(this->dataSock);
+            shutdown(this->udpSock, SD_BOTH);
+            this->controlAccept.join();
+            this->dataAccept.join();
+            this->udpListener.join();
+            closesocket(this->udpSock);
+            this->controlSock = INVALID_SOCKET;
+            this->dataSock = INVALID_SOCKET;
+            this->udpSock = INVALID_SOCKET;
+
+            // no connection can be added anymore, wake the ones still open.
+            {
+                std::lock_guard<std::mutex> lck(this->connLock);
+                for (SOCKET sock : this->connSocks) {
+                    shutdown(sock, SD_BOTH);
+                }
+                threads.swap(this->connThreads);
+                this->finishedConns.clear();
+            }
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+
+            {
+                std::lock_guard<std::mutex> lck(this->delayLock);
+            }
+            this->delaySignal.notify_all();
+            this->deliverer.join();
+            this->delayed = std::priority_queue<pending, std::vector<pending>, std::greater<pending>>();
+
+            std::lock_guard<std::mutex> lck(this->lock);
+            this->streams.clear();
+            this->workspaces.clear();
+#ifdef _WIN32
+            WSACleanup();
+#endif
+        }
+
+        int loopback_server::getControlPort() const {
+            return this->controlPort;
+        }
+
+        int loopback_server::getDataPort() const {
+            return this->dataPort;
+        }
+
+        void loopback_server::setImpairment(const impairment& link) {
+            std::lock_guard<std::mutex> lck(this->linkLock);
+            this->link = link;
+        }
+
+        impairment loopback_server::getImpairment() const {
+            std::lock_guard<std::mutex> lck(this->linkLock);
+            return this->link;
+        }
+
+        bool loopback_server::runScript(const std::string& path, std::string& error) {
+            std::ifstream file(path);
+            std::vector<std::pair<double, impairment>> phases;
+            impairment phase = this->getImpairment();
+            std::string line, token;
+            std::size_t equals;
+            double time;
+            char* end;
+            int lineNum = 0;
+            int run;
+            if (!file) {
+                error = "could not open " + path;
+                return false;
+            }
+            while (std::getline(file, line)) {
+                ++lineNum;
+                std::istringstream tokens(line);
+                if (!(tokens >> token) || token[0] == '#') { continue; }
+                time = strtod(token.c_str(), &end);
+                if (*end != '\0' || time < 0 || (!phases.empty() && time < phases.back().first)) {
+                    error = path + ":" + std::to_string(lineNum) + ": invalid time " + token;
+                    return false;
+                }
+                while (tokens >> token) {
+                    equals = token.find('=');
+                    if (equals == std::string::npos || !phase.set(token.substr(0, equals), token.substr(equals + 1))) {
+                        error = path + ":" + std::to_string(lineNum) + ": invalid setting " + token;
+                        return false;
+                    }
+                }
+                phases.push_back(std::make_pair(time, phase));
+            }
+            {
+                std::lock_guard<std::mutex> lck(this->scriptLock);
+                run = ++this->scriptRun;
+            }
+            this->scriptSignal.notify_all();
+            if (this->scripter.joinable()) {
+                this->scripter.join();
+            }
+            this->scripter = std::thread(&loopback_server::scriptFunc, this, run, std::move(phases));
+            return true;
+        }
+
+        unsigned long long loopback_server::getReceived() const {
+            return this->received.load(std::memory_order_relaxed);
+        }
+
+        unsigned long long loopback_server::getRelayed() const {
+            return this->relayed.load(std::memory_order_relaxed);
+        }
+
+        unsigned long long loopback_server::getLost() const {
+            return this->lost.load(std::memory_order_relaxed);
+        }
+
+        unsigned long long loopback_server::getReordered() const {
+            return this->reordered.load(std::memory_order_relaxed);
+        }
+
+        void loopback_server::acceptFunc(SOCKET listener, void (loopback_server::*func)(SOCKET, std::string)) {
+            sockaddr_in addr;
+            socklen_t len;
+            char ip[INET_ADDRSTRLEN];
+            SOCKET sock;
+            std::vector<std::thread> finished;
+            std::vector<std::thread>::iterator it;
+            while (this->running.load()) {
+                len = sizeof(addr);
+                sock = accept(listener, (sockaddr*)&addr, &len);
+                if (!validSocket(sock)) {
+                    if (this->running.load()) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(RECV_TIMEOUT_MS));
+                    }
+                    continue;
+                }
+                if (!this->running.load()) {
+                    closesocket(sock);
+                    break;
+                }
+                inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+                {
+                    std::lock_guard<std::mutex> lck(this->connLock);
+                    // long runs see many short connections, so finished threads are not left until stop.
+                    for (const std::thread::id& id : this->finishedConns) {
+                        for (it = this->connThreads.begin(); it != this->connThreads.end(); ++it) {
+                            if (it->get_id() == id) {
+                                finished.push_back(std::move(*it));
+                                this->connThreads.erase(it);
+                                break;
+                            }
+                        }
+                    }
+                    this->finishedConns.clear();
+                    this->connSocks.push_back(sock);
+                    this->connThreads.push_back(std::thread(func, this, sock, std::string(ip)));
+                }
+                for (std::thread& thread : finished) {
+                    thread.join();
+                }
+                finished.clear();
+            }
+        }
+
+        void loopback_server::closeConnection(SOCKET sock) {
+            std::lock_guard<std::mutex> lck(this->connLock);
+            this->connSocks.erase(std::remove(this->connSocks.begin(), this->connSocks.end(), sock), this->connSocks.end());
+            closesocket(sock);
+            this->finishedConns.push_back(std::this_thread::get_id());
+        }
+
+        void loopback_server::controlFunc(SOCKET sock, std::string ip) {
+            std::shared_ptr<control_conn> conn = std::make_shared<control_conn>();
+            std::vector<push> pushes;
+            std::vector<STREAM_ID> owned;
+            std::string buffer;
+            char chunk[4096];
+            std::size_t scanned = 0, start = 0;
+            int depth = 0;
+            int got;
+            bool inString = false, escaped = false;
+            char c;
+
+            conn->sock = sock;
+            conn->ip = ip;
+            while ((got = (int) recv(sock, chunk, sizeof(chunk), 0)) > 0) {
+                buffer.append(chunk, got);
+                // split on the outer braces, braces inside strings do not count.
+                for (; scanned < buffer.size(); ++scanned) {
+                    c = buffer[scanned];
+                    if (inString) {
+                        if (escaped) { escaped = false; }
+                        else if (c == '\\') { escaped = true; }
+                        else if (c == '"') { inString = false; }
+                    }
+                    else if (c == '"') {
+                        inString = depth > 0;
+                    }
+                    else if (c == '{') {
+                        if (depth++ == 0) {
+                            start = scanned;
+                        }
+                    }
+                    else if (c == '}' && depth > 0 && --depth == 0) {
+                        this->onRequest(conn, buffer.c_str() + start, scanned + 1 - start);
+                    }
+                }
+                if (depth == 0) {
+                    buffer.clear();
+                    scanned = 0;
+                }
+                else if (start > 0) {
+                    buffer.erase(0, start);
+                    scanned -= start;
+                    start = 0;
+                }
+            }
+
+            // a client that goes away takes its streams with it.
+            {
+                std::lock_guard<std::mutex> lck(this->lock);
+                for (const std::pair<const STREAM_ID, std::shared_ptr<stream>>& entry : this->streams) {
+                    if (entry.second->owner == conn) {
+                        owned.push_back(entry.first);
+                    }
+                }
+                for (STREAM_ID streamID : owned) {
+                    this->removeStream(streamID, pushes);
+                }
+            }
+            for (const push& msg : pushes) {
+                msg.conn->send(msg.msg);
+            }
+            {
+                std::lock_guard<std::mutex> lck(conn->sendLock);
+                conn->sock = INVALID_SOCKET;
+            }
+            this->closeConnection(sock);
+        }
+
+        void loopback_server::onRequest(const std::shared_ptr<control_conn>& conn, const char* data, std::size_t len) {
+            rapidjson::Document request;
+            rapidjson::Document response;
+            rapidjson::Value::ConstMemberIterator id;
+            std::vector<push> pushes;
+            std::string error;
+
+            request.Parse(data, len);
+            if (request.HasParseError() || !request.IsObject()) { return; }
+            response.SetObject();
+            {
+                std::lock_guard<std::mutex> lck(this->lock);
+                error = this->handle(conn, readString(request, "function"), request, response, pushes);
+            }
+            if ((id = request.FindMember("ID")) != request.MemberEnd() && id->value.IsInt()) {
+                if (!error.empty()) {
+                    response.SetObject();
+                    addString(response, "message", error, response.GetAllocator());
+                }
+                response.AddMember("statusCode", error.empty() ? 0 : 1, response.GetAllocator());
+                response.AddMember("ID", id->value.GetInt(), response.GetAllocator());
+                conn->send(toJson(response));
+            }
+            // after the response, so the client knows its stream before pushes mention it.
+            for (const push& msg : pushes) {
+                msg.conn->send(msg.msg);
+            }
+        }
+
+        std::string loopback_server::handle(const std::shared_ptr<control_conn>& conn, const std::string& function,
+                const rapidjson::Document& request, rapidjson::Document& response, std::vector<push>& pushes) {
+            rapidjson::Document::AllocatorType& alloc = response.GetAllocator();
+            std::map<STREAM_ID, std::shared_ptr<stream>>::iterator iter;
+
+            // describes a stream in stream lists and pushes.
+            auto describe = [&alloc](const stream& data, rapidjson::Value& json) {
+                rapidjson::Value types(rapidjson::kArrayType);
+                json.AddMember("streamID", data.streamID, alloc);
+                addString(json, "workspace", data.workspace, alloc);
+                addString(json, "meta", data.meta, alloc);
+                addString(json, "user", data.owner->user, alloc);
+                addString(json, "proto", data.proto, alloc);
+                if (data.sender) {
+                    addString(json, "type", data.types.empty() ? "" : data.types[0], alloc);
+                    return;
+                }
+                for (const std::string& type : data.types) {
+                    types.PushBack(rapidjson::Value(type.c_str(), (rapidjson::SizeType) type.size(), alloc), alloc);
+                }
+                json.AddMember("type", types, alloc);
+            };
+            auto matches = [](const stream& receiver, const stream& sender) {
+                return receiver.workspace == sender.workspace && !sender.types.empty() && (receiver.types.empty() ||
+                    std::find(receiver.types.begin(), receiver.types.end(), sender.types[0]) != receiver.types.end());
+            };
+
+            if (function == "auth") {
+                conn->user = request.HasMember("token") ? "plugin" : readString(request, "username");
+                conn->token = "loopback" + std::to_string(++this->nextToken);
+                addString(response, "token", conn->token, alloc);
+                addString(response, "IP", conn->ip, alloc);
+                return "";
+            }
+            if (conn->token.empty() || readString(request, "token") != conn->token) {
+                return "invalid token";
+            }
+
+            if (function == "sender" || function == "receiver") {
+                std::shared_ptr<stream> created = std::make_shared<stream>();
+                rapidjson::Value streamList(rapidjson::kArrayType);
+                created->sender = function == "sender";
+                created->proto = readString(request, "proto");
+                created->workspace = readString(request, "workspace");
+                created->meta = readString(request, "meta");
+                created->types = readStrings(request, "type");
+                created->echo = readBool(request, "echo");
+                created->alert = readBool(request, "alert");
+                created->owner = conn;
+                created->hasAddr = false;
+                if (created->proto != "udp" && created->proto != "tcp") {
+                    return "unsupported protocol " + created->proto;
+                }
+                if (created->workspace.empty()) {
+                    return "workspace required";
+                }
+                if (created->sender && created->types.size() != 1) {
+                    return "sender needs a single type";
+                }
+                if (this->nextStreamID > MAX_STREAM_ID) {
+                    return "out of stream ids";
+                }
+                created->streamID = this->nextStreamID++;
+                this->workspaces.insert(created->workspace);
+                this->streams[created->streamID] = created;
+
+                response.AddMember("streamID", created->streamID, alloc);
+                response.AddMember("port", this->dataPort, alloc);
+                response.AddMember("MTU", MTU, alloc);
+                for (const std::pair<const STREAM_ID, std::shared_ptr<stream>>& entry : this->streams) {
+                    stream& other = *entry.second;
+                    if (other.sender == created->sender) { continue; }
+                    if (created->sender && other.alert && matches(other, *created)) {
+                        rapidjson::Document msg;
+                        rapidjson::Document::AllocatorType& pushAlloc = msg.GetAllocator();
+                        msg.SetObject();
+                        addString(msg, "function", "update", pushAlloc);
+                        msg.AddMember("receiverID", other.streamID, pushAlloc);
+                        addString(msg, "workspace", created->workspace, pushAlloc);
+                        addString(msg, "type", created->types[0], pushAlloc);
+                        addString(msg, "meta", created->meta, pushAlloc);
+                        addString(msg, "user", conn->user, pushAlloc);
+                        msg.AddMember("streamID", created->streamID, pushAlloc);
+                        pushes.push_back(push{ other.owner, toJson(msg) });
+                    }
+                    // receivers start out subscribed to the senders they match.
+                    else if (!created->sender && matches(*created, other)) {
+                        rapidjson::Value entryJson(rapidjson::kObjectType);
+                        this->linkStreams(*created, other, pushes);
+                        describe(other, entryJson);
+                        streamList.PushBack(entryJson, alloc);
+                    }
+                }
+                if (!created->sender) {
+                    response.AddMember("streamList", streamList, alloc);
+                }
+                return "";
+            }
+
+            if (function == "subscribe" || function == "unsubscribe") {
+                rapidjson::Value streamList(rapidjson::kArrayType);
+                std::vector<STREAM_ID> receiverIDs = readStreamIDs(request, "receiverID");
+                std::map<STREAM_ID, std::shared_ptr<stream>>::iterator senderIter;
+                if (receiverIDs.size() != 1 || (iter = this->streams.find(receiverIDs[0])) == this->streams.end() ||
+                    iter->second->sender || iter->second->owner != conn) {
+                    return "unknown receiver";
+                }
+                stream& receiver = *iter->second;
+                for (STREAM_ID senderID : readStreamIDs(request, "streamIDs")) {
+                    if ((senderIter = this->streams.find(senderID)) == this->streams.end() || !senderIter->second->sender) { continue; }
+                    if (function == "subscribe") {
+                        this->linkStreams(receiver, *senderIter->second, pushes);
+                    }
+                    else if (receiver.links.erase(senderID) > 0) {
+                        senderIter->second->links.erase(receiver.streamID);
+                    }
+                    else {
+                        continue;
+                    }
+                    streamList.PushBack(rapidjson::Value(senderID), alloc);
+                }
+                response.AddMember("streamList", streamList, alloc);
+                return "";
+            }
+
+            if (function == "listStreams") {
+                rapidjson::Value senderList(rapidjson::kArrayType);
+                std::vector<std::string> workspaceFilter = readStrings(request, "workspaces");
+                std::vector<std::string> typeFilter = readStrings(request, "types");
+                for (const std::pair<const STREAM_ID, std::shared_ptr<stream>>& entry : this->streams) {
+                    const stream& data = *entry.second;
+                    if (!data.sender ||
+                        (!workspaceFilter.empty() && std::find(workspaceFilter.begin(), workspaceFilter.end(), data.workspace) == workspaceFilter.end()) ||
+                        (!typeFilter.empty() && std::find(typeFilter.begin(), typeFilter.end(), data.types[0]) == typeFilter.end())) {
+                        continue;
+                    }
+                    rapidjson::Value entryJson(rapidjson::kObjectType);
+                    describe(data, entryJson);
+                    senderList.PushBack(entryJson, alloc);
+                }
+                response.AddMember("senderList", senderList, alloc);
+                return "";
+            }
+
+            if (function == "streamInfo") {
+                rapidjson::Value info(rapidjson::kObjectType);
+                std::vector<STREAM_ID> streamIDs = readStreamIDs(request, "streamID");
+                if (streamIDs.size() != 1 || (iter = this->streams.find(streamIDs[0])) == this->streams.end()) {
+                    return "unknown stream";
+                }
+                describe(*iter->second, info);
+                addString(info, "direction", iter->second->sender ? "source" : "target", alloc);
+                info.AddMember("MTU", MTU, alloc);
+                response.AddMember("info", info, alloc);
+                return "";
+            }
+
+            if (function == "disconnect") {
+                rapidjson::Value streamList(rapidjson::kArrayType);
+                for (STREAM_ID streamID : readStreamIDs(request, "streamIDs")) {
+                    if ((iter = this->streams.find(streamID)) == this->streams.end() || iter->second->owner != conn) { continue; }
+                    this->removeStream(streamID, pushes);
+                    streamList.PushBack(rapidjson::Value(streamID), alloc);
+                }
+                response.AddMember("streamList", streamList, alloc);
+                return "";
+            }
+
+            if (function == "listFunctions") {
+                rapidjson::Value functionList(rapidjson::kArrayType);
+                for (const char* name : functionNames) {
+                    functionList.PushBack(rapidjson::StringRef(name), alloc);
+                }
+                response.AddMember("functionList", functionList, alloc);
+                return "";
+            }
+
+            if (function == "describeFunction") {
+                rapidjson::Value description(rapidjson::kObjectType);
+                std::string name = readString(request, "functionName");
+                if (std::find_if(functionNames.begin(), functionNames.end(), [&name](const char* known) { return name == known; }) == functionNames.end()) {
+                    return "unknown function " + name;
+                }
+                addString(description, "name", name, alloc);
+                addString(description, "description", "loopback stand-in for the Corelink server", alloc);
+                addString(description, "version", "1.0", alloc);
+                addString(description, "author", "", alloc);
+                addString(description, "email", "", alloc);
+                addString(description, "doc_href", "", alloc);
+                response.AddMember("description", description, alloc);
+                return "";
+            }
+
+            if (function == "listWorkspaces") {
+                rapidjson::Value workspaceList(rapidjson::kArrayType);
+                for (const std::string& workspace : this->workspaces) {
+                    workspaceList.PushBack(rapidjson::Value(workspace.c_str(), (rapidjson::SizeType) workspace.size(), alloc), alloc);
+                }
+                response.AddMember("workspaceList", workspaceList, alloc);
+                return "";
+            }
+
+            if (function == "addWorkspace") {
+                if (!this->workspaces.insert(readString(request, "workspace")).second) {
+                    return "workspace already exists";
+                }
+                return "";
+            }
+
+            if (function == "rmWorkspace") {
+                if (this->workspaces.erase(readString(request, "workspace")) == 0) {
+                    return "unknown workspace";
+                }
+                return "";
+            }
+
+            return "unknown function " + function;
+        }
+
+        void loopback_server::removeStream(STREAM_ID streamID, std::vector<push>& pushes) {
+            std::map<STREAM_ID, std::shared_ptr<stream>>::iterator iter = this->streams.find(streamID);
+            std::shared_ptr<stream> removed;
+            if (iter == this->streams.end()) { return; }
+            removed = iter->second;
+            this->streams.erase(iter);
+            for (STREAM_ID linkedID : removed->links) {
+                if ((iter = this->streams.find(linkedID)) == this->streams.end()) { continue; }
+                stream& other = *iter->second;
+                rapidjson::Document msg;
+                msg.SetObject();
+                other.links.erase(streamID);
+                // stale tells a receiver its sender is gone, dropped tells a sender its receiver is gone.
+                addString(msg, "function", removed->sender ? "stale" : "dropped", msg.GetAllocator());
+                msg.AddMember("streamID", streamID, msg.GetAllocator());
+                msg.AddMember(rapidjson::StringRef(removed->sender ? "receiverID" : "senderID"), other.streamID, msg.GetAllocator());
+                pushes.push_back(push{ other.owner, toJson(msg) });
+            }
+        }
+
+        bool loopback_server::linkStreams(stream& receiver, stream& sender, std::vector<push>& pushes) {
+            rapidjson::Document msg;
+            rapidjson::Value types(rapidjson::kArrayType);
+            if (!receiver.links.insert(sender.streamID).second) { return false; }
+            sender.links.insert(receiver.streamID);
+            if (!sender.alert) { return true; }
+            msg.SetObject();
+            rapidjson::Document::AllocatorType& alloc = msg.GetAllocator();
+            addString(msg, "function", "subscriber", alloc);
+            msg.AddMember("senderID", sender.streamID, alloc);
+            msg.AddMember("receiverID", receiver.streamID, alloc);
+            addString(msg, "workspace", receiver.workspace, alloc);
+            addString(msg, "meta", receiver.meta, alloc);
+            addString(msg, "user", receiver.owner->user, alloc);
+            for (const std::string& type : receiver.types) {
+                types.PushBack(rapidjson::Value(type.c_str(), (rapidjson::SizeType) type.size(), alloc), alloc);
+            }
+            msg.AddMember("type", types, alloc);
+            pushes.push_back(push{ sender.owner, toJson(msg) });
+            return true;
+        }
+
+        void loopback_server::tcpDataFunc(SOCKET sock, std::string) {
+            std::shared_ptr<tcp_peer> peer = std::make_shared<tcp_peer>();
+            std::vector<char> buffer;
+            std::size_t used = 0, offset, frameLen;
+            const unsigned char* bytes;
+            int got;
+
+            int noDelay = 1;
+
+            // relayed frames are small, do not let them wait for acks.
+            setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (SOCK_PTR)&noDelay, sizeof(noDelay));
+            peer->sock = sock;
+            buffer.resize(SOCKET_RECV_BUFFER_SIZE * 2);
+            while ((got = (int) recv(sock, &buffer[used], (int) (buffer.size() - used), 0)) > 0) {
+                used += got;
+                offset = 0;
+                while (used - offset >= FRAME_HEADER_SIZE) {
+                    bytes = (const unsigned char*) &buffer[offset];
+                    frameLen = FRAME_HEADER_SIZE + (bytes[0] + ((bytes[1] & 127) << 8)) + (bytes[2] + (bytes[3] << 8));
+                    if (used - offset < frameLen) { break; }
+                    this->onFrame(&buffer[offset], (int) frameLen, nullptr, peer);
+                    offset += frameLen;
+                }
+                if (offset > 0) {
+                    memmove(&buffer[0], &buffer[offset], used - offset);
+                    used -= offset;
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lck(this->lock);
+                for (const std::pair<const STREAM_ID, std::shared_ptr<stream>>& entry : this->streams) {
+                    if (entry.second->peer == peer) {
+                        entry.second->peer.reset();
+                    }
+                }
+            }
+            {
+                std::lock_guard<std::mutex> lck(peer->sendLock);
+                peer->sock = INVALID_SOCKET;
+            }
+            this->closeConnection(sock);
+        }
+
+        void loopback_server::udpFunc() {
+            std::vector<char> buffer(SOCKET_RECV_BUFFER_SIZE);
+            sockaddr_in from;
+            socklen_t len;
+            int got;
+            while (this->running.load(std::memory_order_relaxed)) {
+                len = sizeof(from);
+                got = (int) recvfrom(this->udpSock, &buffer[0], (int) buffer.size(), 0, (sockaddr*)&from, &len);
+                if (got <= 0) { continue; }
+                this->onFrame(&buffer[0], got, &from, nullptr);
+            }
+        }
+
+        void loopback_server::onFrame(const char* frame, int len, const sockaddr_in* addr, const std::shared_ptr<tcp_peer>& peer) {
+            const unsigned char* bytes = (const unsigned char*) frame;
+            std::vector<data_target> targets;
+            std::map<STREAM_ID, std::shared_ptr<stream>>::iterator iter;
+            std::string relayFrame;
+            STREAM_ID streamID;
+            data_target target;
+
+            if (len < FRAME_HEADER_SIZE ||
+                FRAME_HEADER_SIZE + (bytes[0] + ((bytes[1] & 127) << 8)) + (bytes[2] + (bytes[3] << 8)) != len) {
+                return;
+            }
+            streamID = bytes[4] + (bytes[5] << 8);
+            {
+                std::lock_guard<std::mutex> lck(this->lock);
+                if ((iter = this->streams.find(streamID)) == this->streams.end()) { return; }
+                stream& source = *iter->second;
+                if (!source.sender) {
+                    if (peer) {
+                        source.peer = peer;
+                    }
+                    else if (addr != nullptr) {
+                        source.addr = *addr;
+                        source.hasAddr = true;
+                    }
+                    return;
+                }
+                for (STREAM_ID receiverID : source.links) {
+                    if ((iter = this->streams.find(receiverID)) == this->streams.end()) { continue; }
+                    const stream& receiver = *iter->second;
+                    if (receiver.owner == source.owner && !receiver.echo) { continue; }
+                    if (receiver.peer) {
+                        target.peer = receiver.peer;
+                    }
+                    else if (receiver.hasAddr) {
+                        target.addr = receiver.addr;
+                        target.peer.reset();
+                    }
+                    else {
+                        continue;
+                    }
+                    targets.push_back(target);
+                }
+            }
+            this->received.fetch_add(1, std::memory_order_relaxed);
+            if (targets.empty()) { return; }
+
+            // receivers get the sender id where the stream and federation ids were.
+            relayFrame.assign(frame, len);
+            relayFrame[1] = (char) (bytes[1] & 127);
+            relayFrame[4] = (char) (streamID >> 0);
+            relayFrame[5] = (char) (streamID >> 8);
+            relayFrame[6] = (char) (streamID >> 16);
+            relayFrame[7] = (char) (streamID >> 24);
+            for (const data_target& receiver : targets) {
+                this->deliver(receiver, relayFrame);
+            }
+        }
+
+        void loopback_server::deliver(const data_target& target, const std::string& frame) {
+            std::chrono::microseconds delay(0);
+            {
+                std::lock_guard<std::mutex> lck(this->linkLock);
+                if (!this->link.none()) {
+                    std::uniform_real_distribution<double> chance(0, 1);
+                    if (this->link.loss > 0 && chance(this->rng) < this->link.loss) {
+                        this->lost.fetch_add(1, std::memory_order_relaxed);
+                        return;
+                    }
+                    delay = std::chrono::microseconds(this->link.latencyUs);
+                    if (this->link.jitterUs > 0) {
+                        delay += std::chrono::microseconds(std::uniform_int_distribution<int>(0, this->link.jitterUs)(this->rng));
+                    }
+                    if (this->link.reorder > 0 && chance(this->rng) < this->link.reorder) {
+                        delay += std::chrono::microseconds(this->link.reorderUs);
+                        this->reordered.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            }
+            if (delay.count() == 0) {
+                this->sendNow(target, frame);
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lck(this->delayLock);
+                this->delayed.push(pending{ std::chrono::steady_clock::now() + delay, this->nextSeq++, target, frame });
+            }
+            this->delaySignal.notify_one();
+        }
+
+        void loopback_server::sendNow(const data_target& target, const std::string& frame) {
+            if (target.peer) {
+                target.peer->send(frame);
+            }
+            else if (sendto(this->udpSock, frame.c_str(), (int) frame.size(), 0, (const sockaddr*)&target.addr, sizeof(target.addr)) < 0) {
+                return;
+            }
+            this->relayed.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void loopback_server::deliverFunc() {
+            pending next;
+            std::unique_lock<std::mutex> lck(this->delayLock);
+            while (this->running.load(std::memory_order_relaxed)) {
+                if (this->delayed.empty()) {
+                    this->delaySignal.wait(lck);
+                    continue;
+                }
+                if (this->delayed.top().due > std::chrono::steady_clock::now()) {
+                    this->delaySignal.wait_until(lck, this->delayed.top().due);
+                    continue;
+                }
+                next = this->delayed.top();
+                this->delayed.pop();
+                lck.unlock();
+                this->sendNow(next.target, next.frame);
+                lck.lock();
+            }
+        }
+
+        void loopback_server::scriptFunc(int run, std::vector<std::pair<double, impairment>> phases) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            std::unique_lock<std::mutex> lck(this->scriptLock);
+            for (const std::pair<double, impairment>& phase : phases) {
+                if (this->scriptSignal.wait_until(lck, start + std::chrono::microseconds((long long) (phase.first * 1000000)),
+                        [this, run]() { return this->scriptRun.load() != run; })) {
+                    return;
+                }
+                this->setImpairment(phase.second);
+            }
+        }
+    }
+}
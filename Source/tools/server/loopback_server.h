@@ -0,0 +1,287 @@
+/**
+ * @file loopback_server.h
+ * @brief Stand-in for the Corelink server so integration tests and benchmarks run without a network.
+ * Speaks the part of the protocol the client uses and relays stream data between its own clients.
+ *
+ * Control channel (TCP): json requests answered with their ID and a statusCode.
+ * -auth, sender, receiver, subscribe, unsubscribe, listStreams, streamInfo, disconnect.
+ * -listFunctions, describeFunction, listWorkspaces, addWorkspace, rmWorkspace.
+ * -update, subscriber, stale and dropped are pushed without an ID.
+ *
+ * Data channel (UDP and TCP on the same port):
+ * -Clients send packageSend frames: 2 bytes header length, 2 bytes message length, 2 bytes stream id, 2 bytes federation id.
+ * -A frame from a receiver registers the address (UDP) or connection (TCP) the receiver listens on.
+ * -A frame from a sender is relayed to its subscribers with the 4 byte sender id in place of the stream and federation ids.
+ *
+ * Relayed frames go through an impairment stage that adds latency, jitter, loss and reordering.
+ * Accepts any credentials and creates workspaces on first use.
+ */
+#ifndef CORELINK_TOOLS_SERVER_LOOPBACKSERVER_H
+#define CORELINK_TOOLS_SERVER_LOOPBACKSERVER_H
+
+#include "corelink/headers/header.h"
+
+#include <random>
+#include <set>
+
+namespace CorelinkDLL {
+    namespace Tools {
+        /**
+         * Impairment applied to every relayed frame.
+         */
+        struct impairment {
+            /// Delay added to every frame.
+            int latencyUs;
+            /// Extra delay drawn uniformly from [0, jitterUs].
+            int jitterUs;
+            /// Probability a frame is dropped.
+            double loss;
+            /// Probability a frame is held back by reorderUs so the frames after it overtake it.
+            double reorder;
+            int reorderUs;
+
+            impairment();
+
+            /**
+             * @return If frames are relayed as they arrive.
+             */
+            bool none() const;
+
+            /**
+             * Sets one value from a key=value pair. Times are in milliseconds.
+             * Keys: latency, jitter, loss, reorder, gap (reorderUs).
+             * @return False if the key is unknown or the value is invalid.
+             */
+            bool set(const std::string& key, const std::string& value);
+        };
+
+        /**
+         * THREADSAFE
+         */
+        class loopback_server {
+        public:
+            static const int MTU = 20000;
+
+            loopback_server();
+            ~loopback_server();
+
+            /**
+             * Opens the sockets and starts serving.
+             * @param ip Address to listen on.
+             * @param controlPort Port of the control channel, 0 for any free port.
+             * @param dataPort Port of the UDP and TCP data channels, 0 for any free port.
+             * @param error Stores why the server could not start.
+             * @return If the server started.
+             */
+            bool start(const std::string& ip, int controlPort, int dataPort, std::string& error);
+
+            /**
+             * Closes every connection and waits for the server threads.
+             */
+            void stop();
+
+            int getControlPort() const;
+            int getDataPort() const;
+
+            void setImpairment(const impairment& link);
+            impairment getImpairment() const;
+
+            /**
+             * Runs an impairment script on its own thread. Replaces a running script.
+             * Each line is a time in seconds from the start of the script followed by key=value pairs (see impairment::set).
+             * A phase starts from the impairment of the phase before it. Empty lines and lines starting with # are skipped.
+             *   0 latency=20 jitter=5
+             *   10 loss=0.05 reorder=0.01 gap=8
+             *   20 latency=0 jitter=0 loss=0 reorder=0
+             * @param error Stores the file or line that could not be read.
+             * @return If the script was read and started.
+             */
+            bool runScript(const std::string& path, std::string& error);
+
+            /// Data frames received from senders.
+            unsigned long long getReceived() const;
+            /// Frames handed to receivers.
+            unsigned long long getRelayed() const;
+            /// Frames dropped by the impairment stage.
+            unsigned long long getLost() const;
+            /// Frames held back by the impairment stage to be reordered.
+            unsigned long long getReordered() const;
+
+        private:
+            /**
+             * Control connection of a client.
+             */
+            struct control_conn {
+                SOCKET sock;
+                std::mutex sendLock;
+                std::string ip;
+                std::string token;
+                std::string user;
+
+                /**
+                 * Sends a json message. Pushes and responses can come from different threads.
+                 */
+                void send(const std::string& msg);
+            };
+
+            /**
+             * Data connection a TCP receiver listens on.
+             */
+            struct tcp_peer {
+                SOCKET sock;
+                std::mutex sendLock;
+
+                void send(const std::string& frame);
+            };
+
+            struct stream {
+                STREAM_ID streamID;
+                bool sender;
+                std::string proto;
+                std::string workspace;
+                std::string meta;
+                std::vector<std::string> types;
+                bool echo;
+                bool alert;
+                std::shared_ptr<control_conn> owner;
+                /// Subscribed receivers of a sender, senders a receiver is subscribed to.
+                std::set<STREAM_ID> links;
+                /// Where a UDP receiver listens. Set by its first frame.
+                bool hasAddr;
+                sockaddr_in addr;
+                /// Connection a TCP receiver listens on. Set by its first frame.
+                std::shared_ptr<tcp_peer> peer;
+            };
+
+            struct data_target {
+                sockaddr_in addr;
+                /// nullptr for UDP receivers.
+                std::shared_ptr<tcp_peer> peer;
+            };
+
+            struct pending {
+                std::chrono::steady_clock::time_point due;
+                unsigned long long seq;
+                data_target target;
+                std::string frame;
+
+                bool operator>(const pending& rhs) const {
+                    return due != rhs.due ? due > rhs.due : seq > rhs.seq;
+                }
+            };
+
+            struct push {
+                std::shared_ptr<control_conn> conn;
+                std::string msg;
+            };
+
+            std::atomic<bool> running;
+            SOCKET controlSock;
+            SOCKET dataSock;
+            SOCKET udpSock;
+            int controlPort;
+            int dataPort;
+
+            std::thread controlAccept;
+            std::thread dataAccept;
+            std::thread udpListener;
+            std::thread deliverer;
+            /// Connection threads. Finished ones are joined when the next connection is accepted, the rest on stop.
+            std::vector<std::thread> connThreads;
+            /// Connection threads past closeConnection, waiting to be joined.
+            std::vector<std::thread::id> finishedConns;
+            std::vector<SOCKET> connSocks;
+            std::mutex connLock;
+
+            /// Streams, workspaces and tokens.
+            std::mutex lock;
+            std::map<STREAM_ID, std::shared_ptr<stream>> streams;
+            std::set<std::string> workspaces;
+            STREAM_ID nextStreamID;
+            int nextToken;
+
+            mutable std::mutex linkLock;
+            impairment link;
+            std::mt19937 rng;
+
+            /// Frames waiting for their delivery time.
+            std::priority_queue<pending, std::vector<pending>, std::greater<pending>> delayed;
+            unsigned long long nextSeq;
+            std::mutex delayLock;
+            std::condition_variable delaySignal;
+
+            std::thread scripter;
+            std::atomic<int> scriptRun;
+            std::mutex scriptLock;
+            std::condition_variable scriptSignal;
+
+            std::atomic<unsigned long long> received;
+            std::atomic<unsigned long long> relayed;
+            std::atomic<unsigned long long> lost;
+            std::atomic<unsigned long long> reordered;
+
+            static SOCKET listenTCP(const std::string& ip, int& port, std::string& error);
+
+            /**
+             * Accepts connections and starts a thread running func for each.
+             * Joins the connection threads that finished since the last accept.
+             */
+            void acceptFunc(SOCKET listener, void (loopback_server::*func)(SOCKET, std::string));
+
+            /**
+             * Forgets and closes the socket of a finished connection thread and marks the thread finished.
+             * Must be the last call of a connection thread.
+             */
+            void closeConnection(SOCKET sock);
+
+            /**
+             * Control connection thread. Splits the byte stream into json objects.
+             */
+            void controlFunc(SOCKET sock, std::string ip);
+
+            /**
+             * Answers a request and sends the pushes it caused.
+             */
+            void onRequest(const std::shared_ptr<control_conn>& conn, const char* data, std::size_t len);
+
+            /**
+             * Handles a request and fills the response members other than ID and statusCode.
+             * @return Empty on success, otherwise the message of the error response.
+             */
+            std::string handle(const std::shared_ptr<control_conn>& conn, const std::string& function,
+                const rapidjson::Document& request, rapidjson::Document& response, std::vector<push>& pushes);
+
+            /**
+             * Removes a stream and its subscriptions. this->lock must be held.
+             * Receivers of a removed sender get stale, senders of a removed receiver get dropped.
+             */
+            void removeStream(STREAM_ID streamID, std::vector<push>& pushes);
+
+            /**
+             * Subscribes a receiver to a sender. this->lock must be held.
+             * @return If both streams exist and were not linked yet.
+             */
+            bool linkStreams(stream& receiver, stream& sender, std::vector<push>& pushes);
+
+            void tcpDataFunc(SOCKET sock, std::string ip);
+            void udpFunc();
+
+            /**
+             * Registers a receiver or relays the frame of a sender.
+             * @param frame Frame as the client sent it.
+             */
+            void onFrame(const char* frame, int len, const sockaddr_in* addr, const std::shared_ptr<tcp_peer>& peer);
+
+            void deliver(const data_target& target, const std::string& frame);
+            void sendNow(const data_target& target, const std::string& frame);
+            void deliverFunc();
+
+            void scriptFunc(int run, std::vector<std::pair<double, impairment>> phases);
+
+            loopback_server(const loopback_server&) = delete;
+            loopback_server& operator=(const loopback_server&) = delete;
+        };
+    }
+}
+
+#endif